@@ -276,6 +276,14 @@ public:
    map<string, vector<double> > sysConsts;    // vector of constants
    map<string, vector<string> > sysObsids;    // parallel vector of RinexObsIDs
 
+   /// one term, compiled for one system and header by Compile()
+   class Term {
+   public:
+      int index;                    // of the obs in the data, -1 if unavailable
+      double coef;                  // constant
+      int band;                     // frequency band for phase, else 0
+   };
+
    /// Constructor
    LinCom() : value(0), limit0(false), label(string("Undef")) { }
 
@@ -286,6 +294,14 @@ public:
    double Compute(const RinexSatID sat, Rinex3ObsHeader& Rhead,
                   const vector<RinexDatum>& vrdata);
 
+   /// compile the terms for system sys1 (1-char) and header Rhead, for use by
+   /// Compute(sat,terms,vrdata); return false if there are none for sys1
+   bool Compile(const string& sys1, Rinex3ObsHeader& Rhead, vector<Term>& terms);
+
+   /// compute the linear combination, as Compute() above, from compiled terms
+   double Compute(const RinexSatID& sat, const vector<Term>& terms,
+                  const vector<RinexDatum>& vrdata);
+
    /// remove a bias if jump larger than limit occurs
    bool removeBias(const RinexSatID& sat);
 
@@ -294,6 +310,22 @@ public:
 /// dump the object to an output stream
 ostream& operator<<(ostream& os, LinCom& lc);
 
+//------------------------------------------------------------------------------------
+// satellite-dependent non-obs data, in the order of Configuration::NonObsTags
+enum NonObsType { RNGnot=0, TRPnot, RELnot, SCLnot, ELEnot, AZInot, LATnot, LONnot,
+                  SVXnot, SVYnot, SVZnot, SVAnot, SVOnot, SVHnot };
+
+//------------------------------------------------------------------------------------
+// Output plan for the satellites of one system, compiled from the header by
+// PlanFor(), so that the loop over epochs need only index the data.
+class SysPlan {
+public:
+   bool allowed;                    // system is in InputSyss
+   vector<int> index;               // per InputTag: index of the obs in the data, or -1
+   vector<bool> haveTerms;          // per Combos: the combo is defined for the system
+   vector< vector<LinCom::Term> > terms;    // per Combos: the terms
+};
+
 //------------------------------------------------------------------------------------
 // Object for command line input and global data
 class Configuration : public Singleton<Configuration> {
@@ -381,6 +413,11 @@ public:
    vector<string> AuxTags;    // POS,RCL
    // list of all (2-char) linear combination tags
    vector<string> LinComTags;
+   // what each InputTag is: a NonObsType, or one of these
+   enum { auxTag=-3, obsTag=-2, noTag=-1 };
+   vector<int> tagTypes;
+   // output plans for the current header, per system (1-char)
+   map<char, SysPlan> plans;
 
    // stores
       /// High level nav store interface.
@@ -430,9 +467,8 @@ const string Configuration::longfmt = calfmt + " = " + gpsfmt;
 // prototypes
 int Initialize(string& errors);
 int ProcessFiles(void);
-double getObsData(string tag, RinexSatID sat, Rinex3ObsHeader& Rhead,
-                  const vector<RinexDatum>& vrdata);
-double getNonObsData(string tag, RinexSatID sat, const CommonTime& time);
+double getNonObsData(int type, RinexSatID sat, const CommonTime& time);
+SysPlan& PlanFor(char sys, Rinex3ObsHeader& Rhead);
 
 //------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------
@@ -824,7 +860,7 @@ try {
       }
    }
 
-   // -------- set flags for output convenience
+   // -------- set flags for output convenience, and the type of each tag
    for(i=0; i<C.InputTags.size(); i++) {
       string tag(C.InputTags[i]);
       if(tag == string("RCL"))
@@ -835,6 +871,17 @@ try {
          C.haveObs = true;
       else if(find(C.NonObsTags.begin(),C.NonObsTags.end(),tag) != C.NonObsTags.end())
          C.haveNonObs = true;
+
+      vector<string>::const_iterator jt;
+      if(find(C.AuxTags.begin(),C.AuxTags.end(),tag) != C.AuxTags.end())
+         C.tagTypes.push_back(Configuration::auxTag);
+      else if(isValidRinexObsID(tag))
+         C.tagTypes.push_back(Configuration::obsTag);
+      else if((jt = find(C.NonObsTags.begin(),C.NonObsTags.end(),tag))
+                                                         != C.NonObsTags.end())
+         C.tagTypes.push_back(jt - C.NonObsTags.begin());
+      else
+         C.tagTypes.push_back(Configuration::noTag);
    }
    if(C.Combos.size() > 0) C.haveCombo = true;
 
@@ -952,6 +999,7 @@ void Configuration::SetDefaults(void)
    help = verbose = noHeader = dumpHeader = doTECU = false;
    debug = -1;
 
+   // NB same order as enum NonObsType
    NonObsTags.push_back("RNG");
    NonObsTags.push_back("TRP");
    NonObsTags.push_back("REL");
@@ -1829,6 +1877,7 @@ try {
       }
 
       if(C.useVersion == 0.0) C.useVersion = Rhead.version;
+      C.plans.clear();                    // compile new output plans for Rhead
       LOG(INFO) << "# RINEX version: file " << fixed << setprecision(2)
          << Rhead.version << " / output " << C.useVersion;
 
@@ -2043,14 +2092,8 @@ try {
                   }
 
                   // is system allowed?
-                  bool ok(false);
-                  for(i=0; i<C.InputSyss.size(); i++) {
-                     if(sat.systemChar() == C.map3to1Sys[C.InputSyss[i]][0]) {
-                        ok = true;
-                        break;
-                     }
-                  }
-                  if(!ok) {
+                  const SysPlan& plan(PlanFor(sat.systemChar(), Rhead));
+                  if(!plan.allowed) {
                      //LOG(WARNING) << "Warning - system " << sat << " not allowed.";
                      continue;
                   }
@@ -2059,7 +2102,7 @@ try {
                   const vector<RinexDatum>& vrdata(it->second);
 
                   // don't output all zero's, or elev > elevlimit
-                  ok = false;                // reuse ok; if one datum is good, output
+                  bool ok(false);            // if one datum is good, output
                   bool badele(false);
 
                   // output the sat ID
@@ -2069,22 +2112,23 @@ try {
                   // output the data, in order (zero-filled)
                   for(i=0; i<C.InputTags.size(); i++) {
                      double data(0);
-                     tag = C.InputTags[i];
+                     int type(C.tagTypes[i]);
 
                      // skip AuxTags
-                     if(find(C.AuxTags.begin(),C.AuxTags.end(),tag)!=C.AuxTags.end())
+                     if(type == Configuration::auxTag)
                         continue;
 
-                     else if(isValidRinexObsID(tag))     // tag = RINEX Obs ID
-                        data = getObsData(tag, sat, Rhead, vrdata);
+                     else if(type == Configuration::obsTag) {  // tag = RINEX Obs ID
+                        if(plan.index[i] > -1)
+                           data = vrdata[plan.index[i]].data;
+                     }
 
-                     else if(find(C.NonObsTags.begin(),  // tag = Sat-dep non-obs type
-                                 C.NonObsTags.end(), tag) != C.NonObsTags.end())
-                        data = getNonObsData(tag, sat, Rdata.time);
+                     else if(type != Configuration::noTag)  // tag = Sat-dep non-obs
+                        data = getNonObsData(type, sat, Rdata.time);
 
                      oss << " " << setw(width) << data;
                      if(data != 0.0) ok=true;
-                     if(tag==string("ELE") && C.elevlimit > 0.0 && data < C.elevlimit)
+                     if(type == ELEnot && C.elevlimit > 0.0 && data < C.elevlimit)
                         badele = true;
                   }
                   if(badele) continue;    // don't compute lincombos due to removeBias
@@ -2092,7 +2136,11 @@ try {
                   // output linear combinations
                   vector<string> resets;     // check for reset of bias on any lc
                   for(i=0; i<C.Combos.size(); i++) {
-                     C.Combos[i].Compute(sat, Rhead, vrdata);  // member value
+                     // compute member value; the uncompiled version traces each term
+                     if(LOGlevel >= DEBUG2)
+                        C.Combos[i].Compute(sat, Rhead, vrdata);
+                     else if(plan.haveTerms[i])   // else value is left, as Compute()
+                        C.Combos[i].Compute(sat, plan.terms[i], vrdata);
                      if(C.Combos[i].value && C.Combos[i].removeBias(sat))
                         resets.push_back(C.Combos[i].label);
                      oss << " " << setw(width) << C.Combos[i].value;
@@ -2136,43 +2184,70 @@ catch(Exception& e) { GNSSTK_RETHROW(e); }
 }  // end ProcessFiles()
 
 //------------------------------------------------------------------------------------
-double getObsData(string tag, RinexSatID sat, Rinex3ObsHeader& Rhead,
-                   const vector<RinexDatum>& vrdata)
+// Return the output plan for satellites of system sys in the current header,
+// compiling it the first time: whether the system is allowed, the index in the
+// data of each RINEX obs tag and the terms of each linear combination.
+SysPlan& PlanFor(char sys, Rinex3ObsHeader& Rhead)
 {
    try {
       Configuration& C(Configuration::Instance());
-      double data(0);
-      string sys(1,sat.systemChar());              // system of this sat
+      size_t i;
+
+      map<char, SysPlan>::iterator pt(C.plans.find(sys));
+      if(pt != C.plans.end())
+         return pt->second;
+
+      SysPlan& plan(C.plans[sys]);
+      string sys1(1,sys);
 
-      if(tag.size() == 4 && tag[0] != sys[0])
-         return 0;                                 // system does not match
-      if(tag.size() == 3) {
-         tag = sys + tag;                          // add system char to tag
-         if(!isValidRinexObsID(tag))
-            return 0;                              // system+tag is not valid
+      plan.allowed = false;
+      for(i=0; i<C.InputSyss.size(); i++) {
+         if(sys == C.map3to1Sys[C.InputSyss[i]][0]) {
+            plan.allowed = true;
+            break;
+         }
       }
 
-      RinexObsID obsid(tag, C.useVersion);         // ObsID for this tag
+      const vector<RinexObsID>& obstypes(Rhead.mapObsTypes[sys1]);
+      plan.index = vector<int>(C.InputTags.size(), -1);
+      for(i=0; i<C.InputTags.size(); i++) {
+         if(C.tagTypes[i] != Configuration::obsTag)
+            continue;
 
-      // find it in the header
-      vector<RinexObsID>::const_iterator jt(
-         find(Rhead.mapObsTypes[sys].begin(),Rhead.mapObsTypes[sys].end(),obsid));
-      if(jt != Rhead.mapObsTypes[sys].end()) {     // its in the header
-         int j = jt - Rhead.mapObsTypes[sys].begin();
-         data = vrdata[j].data;
+         string tag(C.InputTags[i]);
+         if(tag.size() == 4 && tag[0] != sys)
+            continue;                              // system does not match
+         if(tag.size() == 3) {
+            tag = sys1 + tag;                      // add system char to tag
+            if(!isValidRinexObsID(tag))
+               continue;                           // system+tag is not valid
+         }
+
+         // find it in the header
+         RinexObsID obsid(tag, C.useVersion);
+         vector<RinexObsID>::const_iterator jt(
+            find(obstypes.begin(),obstypes.end(),obsid));
+         if(jt != obstypes.end())                  // its in the header
+            plan.index[i] = jt - obstypes.begin();
       }
 
-      return data;
+      plan.haveTerms = vector<bool>(C.Combos.size(), false);
+      plan.terms = vector< vector<LinCom::Term> >(C.Combos.size());
+      for(i=0; i<C.Combos.size(); i++)
+         plan.haveTerms[i] = C.Combos[i].Compile(sys1, Rhead, plan.terms[i]);
+
+      return plan;
    }
    catch(Exception& e) { GNSSTK_RETHROW(e); }
-}  // end getObsData()
+}  // end PlanFor()
 
 //------------------------------------------------------------------------------------
-double getNonObsData(string tag, RinexSatID sat, const CommonTime& time)
+double getNonObsData(int type, RinexSatID sat, const CommonTime& time)
 {
    try {
       double data(0);
       Configuration& C(Configuration::Instance());
+      const string& tag(C.NonObsTags[type]);
       // need the CER for this sat?
       if(C.mapSatCER.find(sat) == C.mapSatCER.end()) {
          CorrectedEphemerisRange CER;
@@ -2189,41 +2264,41 @@ double getNonObsData(string tag, RinexSatID sat, const CommonTime& time)
       }
 
       // compute the thing
-      if(tag == string("RNG"))
+      if(type == RNGnot)
          data = C.mapSatCER[sat].rawrange;
-      else if(tag == string("TRP")) {
+      else if(type == TRPnot) {
          Position SV(C.mapSatCER[sat].svPosVel.x, Position::Cartesian);
          data = C.pTrop->correction(C.knownPos,SV,time);
       }
-      else if(tag == string("REL"))
+      else if(type == RELnot)
          data = C.mapSatCER[sat].relativity;
-      else if(tag == string("SCL"))
+      else if(type == SCLnot)
          data = C.mapSatCER[sat].svclkbias;
-      else if(tag == string("ELE"))
+      else if(type == ELEnot)
          data = C.mapSatCER[sat].elevationGeodetic;
-      else if(tag == string("AZI"))
+      else if(type == AZInot)
          data = C.mapSatCER[sat].azimuthGeodetic;
-      else if(tag == string("LAT")) {
+      else if(type == LATnot) {
          // TD
       }
-      else if(tag == string("LON")) {
+      else if(type == LONnot) {
          // TD
       }
-      else if(tag == string("SVX"))
+      else if(type == SVXnot)
          data = C.mapSatCER[sat].svPosVel.x[0];
-      else if(tag == string("SVY"))
+      else if(type == SVYnot)
          data = C.mapSatCER[sat].svPosVel.x[1];
-      else if(tag == string("SVZ"))
+      else if(type == SVZnot)
          data = C.mapSatCER[sat].svPosVel.x[2];
-      else if(tag == string("SVA")) {
+      else if(type == SVAnot) {
          Position pos(C.mapSatCER[sat].svPosVel.x, Position::Cartesian);
          data = pos.geodeticLatitude();
       }
-      else if(tag == string("SVO")) {
+      else if(type == SVOnot) {
          Position pos(C.mapSatCER[sat].svPosVel.x, Position::Cartesian);
          data = pos.longitude();
       }
-      else if(tag == string("SVH")) {
+      else if(type == SVHnot) {
          Position pos(C.mapSatCER[sat].svPosVel.x, Position::Cartesian);
          data = pos.height();
       }
@@ -2684,6 +2759,97 @@ double LinCom::Compute(const RinexSatID sat, Rinex3ObsHeader& Rhead,
    return value;     // also member data
 }
 
+//------------------------------------------------------------------------------------
+// Resolve each term of the combination for system sys1 as Compute() does, to the
+// index of its obs in the header. A term that cannot be resolved ends the list:
+// Compute() stops there.
+bool LinCom::Compile(const string& sys1, Rinex3ObsHeader& Rhead, vector<Term>& terms)
+{
+   Configuration& C(Configuration::Instance());
+
+   terms.clear();
+   if(sysConsts.count(sys1) == 0) return false;
+
+   string sys3(C.map1to3Sys[sys1]);
+   const vector<RinexObsID>& obstypes(Rhead.mapObsTypes[sys1]);
+
+   for(size_t i=0; i<sysConsts[sys1].size(); i++) {
+      Term term;
+      term.index = -1;
+      term.coef = sysConsts[sys1][i];
+      term.band = 0;
+
+      string obsid(sysObsids[sys1][i]);
+      if(obsid.size() == 3) obsid = sys1 + obsid;
+      if(obsid[0] != sys1[0] || !isValidRinexObsID(obsid)) {
+         terms.push_back(term);
+         break;
+      }
+
+      // all possible codes, in order
+      vector<RinexObsID> allObsIDs;
+      if(obsid[3] == '*') {
+         for(size_t j=0; j<C.mapSysCodes[sys3].size(); j++) {
+            string oi(obsid.substr(0,3)+string(1,C.mapSysCodes[sys3][j]));
+            if(isValidRinexObsID(oi))
+               allObsIDs.push_back(RinexObsID(oi, C.useVersion));
+         }
+      }
+      else
+         allObsIDs.push_back(RinexObsID(obsid, C.useVersion));
+
+      // the first one in the header is used
+      for(size_t k=0; k<allObsIDs.size(); k++) {
+         vector<RinexObsID>::const_iterator jt;
+         jt = find(obstypes.begin(), obstypes.end(), allObsIDs[k]);
+         if(jt == obstypes.end()) continue;
+
+         string oi(sys1 + allObsIDs[k].asString());
+         term.index = jt - obstypes.begin();
+         if(oi[1] == 'L') term.band = asInt(string(1,oi[2]));
+         break;
+      }
+
+      terms.push_back(term);
+      if(term.index < 0) break;
+   }
+
+   return true;
+}
+
+//------------------------------------------------------------------------------------
+double LinCom::Compute(const RinexSatID& sat, const vector<Term>& terms,
+                       const vector<RinexDatum>& vrdata)
+{
+   Configuration& C(Configuration::Instance());
+
+   value = 0.0;      // member
+   for(size_t i=0; i<terms.size(); i++) {
+      if(terms[i].index < 0) return 0.0;           // no data
+
+      double data(vrdata[terms[i].index].data);
+      if(data == 0.0) { value = 0.0; return value; }
+
+      // if this is phase data, multiply by the wavelength
+      if(terms[i].band > 0) {
+         int N(0);
+         if(sat.system == SatelliteSystem::Glonass) {
+            map<RinexSatID,int>::const_iterator it(C.GLOfreqChan.find(sat));
+            if(it == C.GLOfreqChan.end()) {
+               LOG(WARNING) << "No frequency channel for GLO sat " << sat;
+               return 0.0;
+            }
+            N = it->second;
+         }
+         data *= getWavelength(sat.system, terms[i].band, N);
+      }
+
+      value += terms[i].coef * data;
+   }
+
+   return value;     // also member data
+}
+
 //------------------------------------------------------------------------------------
 // Reset bias when jump in value exceeds limit.
 // Set initial bias to 0 if initial value is < limit, otherwise to value.
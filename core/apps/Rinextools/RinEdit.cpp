@@ -234,6 +234,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <list>
 #include <iostream>
 #include <fstream>
 #include <algorithm>
@@ -321,6 +322,11 @@ public:
    inline bool isValid(void) noexcept
    { return (type != invalidCT); }
 
+      /// key shared by matching '+' and '-' commands: type, sat and obs
+   string key(void) const
+   { return StringUtils::asString(int(type)) + " " + sat.toString() + " "
+            + obs.asString(); }
+
       /** dump, with optional message at front
        * @throw Exception */
    string asString(string msg=string());
@@ -374,6 +380,9 @@ private:
       debug = -1;
 
       messHDdc = messHDda = false;
+
+      nextCmd = 0;
+      nepochs = nedits = 0;
    }  // end Configuration::SetDefaults()
 
 public:
@@ -415,8 +424,14 @@ public:
    ofstream logstrm;
    static const string calfmt,gpsfmt,longfmt;
 
-      // handle commands
-   vector<EditCmd> vecCmds, currCmds;
+      // handle commands: vecCmds is sorted on time and vecCmds[nextCmd] is the
+      // next to be executed; currCmds are in effect, in the order they started,
+      // and activeCmds indexes them on EditCmd::key()
+   vector<EditCmd> vecCmds;
+   size_t nextCmd;
+   list<EditCmd> currCmds;
+   map<string, list<list<EditCmd>::iterator> > activeCmds;
+   long nepochs, nedits;         // for the edit throughput
    Rinex3ObsStream ostrm;        // RINEX output
 
 }; // end class Configuration
@@ -443,8 +458,9 @@ int processOneEpoch(Rinex3ObsHeader& Rhead, Rinex3ObsHeader& RHout,
                     Rinex3ObsData& Rdata, Rinex3ObsData& RDout);
 /**
  * @throw Exception */
-int executeEditCmd(const vector<EditCmd>::iterator& it, Rinex3ObsHeader& Rhead,
-                   Rinex3ObsData& Rdata);
+int executeEditCmd(EditCmd& cmd, Rinex3ObsHeader& Rhead, Rinex3ObsData& Rdata);
+void addCurrentCmd(const EditCmd& cmd);
+list<EditCmd>::iterator removeCurrentCmd(list<EditCmd>::iterator it);
 
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
@@ -495,6 +511,17 @@ int main(int argc, char **argv)
              << double(totaltime)/double(CLOCKS_PER_SEC) << " sec, wallclock: "
              << setprecision(0) << (wallclkend-wallclkbeg) << " sec.";
          LOG(INFO) << oss.str();
+
+         if(C.verbose) {
+            double sec(double(totaltime)/double(CLOCKS_PER_SEC));
+            oss.str("");
+            oss << C.prgmName << " edits: " << C.nedits << " commands executed on "
+                << C.nepochs << " epochs";
+            if(sec > 0.0)
+               oss << " = " << setprecision(0) << double(C.nedits)/sec
+                   << " edits/sec";
+            LOG(INFO) << oss.str();
+         }
       }
 
       if (C.help)
@@ -548,6 +575,8 @@ int initialize(string& errors)
                //LOG(VERBOSE) << "Full output file name is " << C.vecCmds[i].field;
          }
       }
+         // processOneEpoch() relies on the commands being in time order
+      stable_sort(C.vecCmds.begin(), C.vecCmds.end(), EditCmdLessThan());
 
          // ------ compute and save a reference time for decimation
       if(C.decimate > 0.0) {
@@ -649,7 +678,7 @@ int processFiles(void)
          }
             // we have to set the time system of all the timetags using ttag from file
          vector<EditCmd>::iterator jt;
-         for (jt=C.vecCmds.begin(); jt != C.vecCmds.end(); ++jt)
+         for (jt=C.vecCmds.begin()+C.nextCmd; jt != C.vecCmds.end(); ++jt)
             jt->ttag.setTimeSystem(Rhead.firstObs.getTimeSystem());
             // -----------------------------------------------------------------
             // generate output header from input header and DO,DS commands
@@ -658,7 +687,7 @@ int processFiles(void)
 
          RHout = Rhead;
          vector<EditCmd>::iterator it;
-         for (it = C.vecCmds.begin(); it != C.vecCmds.end(); it++)
+         for (it = C.vecCmds.begin()+C.nextCmd; it != C.vecCmds.end(); it++)
          {
             LOG(DEBUG) << "Killing " << it->asString() << " " << it->sat;
 
@@ -916,43 +945,41 @@ int processOneEpoch(Rinex3ObsHeader& Rhead, Rinex3ObsHeader& RHout,
 
       else
       {                              // regular data
-         vector<EditCmd>::iterator it, jt;
+         list<EditCmd>::iterator it;
          vector<EditCmd> toCurr;
+         C.nepochs++;
 
-            // for cmds with ttag <= now either execute and delete, or move to current
-         it = C.vecCmds.begin();
-         while(it != C.vecCmds.end())
+            // execute cmds with ttag <= now, in time order, keeping those that
+            // stay in effect to make them current after this epoch
+         while(C.nextCmd < C.vecCmds.size())
          {
-            if (it->ttag <= now || ::fabs(it->ttag - now) < C.timetol)
-            {
-               LOG(DEBUG) << "Execute vec cmd " << it->asString();
-                  // delete one-time cmds, move others to curr and delete
-               iret = executeEditCmd(it, RHout, RDout);
-               if(iret < 0) return iret;              // fatal error
+            EditCmd& cmd(C.vecCmds[C.nextCmd]);
+            if (!(cmd.ttag <= now || ::fabs(cmd.ttag - now) < C.timetol))
+               break;
 
-                  // keep this command on the current list
-               if (iret > 0) toCurr.push_back(*it); // C.currCmds.push_back(*it);
+            LOG(DEBUG) << "Execute vec cmd " << cmd.asString();
+            iret = executeEditCmd(cmd, RHout, RDout);
+            C.nedits++;
+            if(iret < 0) return iret;              // fatal error
 
-                  // if this is a '-' cmd to be deleted, find matching '+' and delete
-                  // note fixEditCmdList() forced every - to have a corresponding +
-               if (iret == 0 && it->sign == -1)
+               // keep this command on the current list
+            if (iret > 0) toCurr.push_back(cmd);
+
+               // if this is a '-' cmd to be deleted, find matching '+' and delete
+               // note fixEditCmdList() forced every - to have a corresponding +
+            if (iret == 0 && cmd.sign == -1)
+            {
+               map<string, list<list<EditCmd>::iterator> >::iterator kt;
+               kt = C.activeCmds.find(cmd.key());
+               if (kt == C.activeCmds.end())
                {
-                  for (jt = C.currCmds.begin(); jt != C.currCmds.end(); ++jt)
-                     if (jt->type==it->type && jt->sat==it->sat && jt->obs==it->obs)
-                        break;
-                  if (jt == C.currCmds.end())
-                  {
-                     Exception e(string("Execute failed to find + cmd matching ")+it->asString());
-                     GNSSTK_THROW(e);
-                  }
-                  C.currCmds.erase(jt);
+                  Exception e(string("Execute failed to find + cmd matching ")+cmd.asString());
+                  GNSSTK_THROW(e);
                }
-
-                  // remove from vecCmds
-               it = C.vecCmds.erase(it);              // erase vector element
+               removeCurrentCmd(kt->second.front());
             }
-            else
-               ++it;
+
+            C.nextCmd++;
          }
 
             // apply current commands, deleting obsolete ones
@@ -961,18 +988,19 @@ int processOneEpoch(Rinex3ObsHeader& Rhead, Rinex3ObsHeader& RHout,
          {
             LOG(DEBUG) << "Execute current cmd " << it->asString();
                // execute command; delete obsolete commands
-            iret = executeEditCmd(it, RHout, RDout);
+            iret = executeEditCmd(*it, RHout, RDout);
+            C.nedits++;
             if(iret < 0)
                return iret;
 
             if(iret == 0)
-               it = C.currCmds.erase(it);              // erase vector element
+               it = removeCurrentCmd(it);
             else
                ++it;
          }
 
-         for (it = toCurr.begin(); it != toCurr.end(); ++it)
-            C.currCmds.push_back(*it);
+         for (size_t i=0; i<toCurr.size(); i++)
+            addCurrentCmd(toCurr[i]);
       }
 
       return 0;
@@ -980,12 +1008,36 @@ int processOneEpoch(Rinex3ObsHeader& Rhead, Rinex3ObsHeader& RHout,
    catch(Exception& e) { GNSSTK_RETHROW(e); }
 }  // end processOneEpoch()
 
+//------------------------------------------------------------------------------
+// put cmd at the end of the current list, and index it
+void addCurrentCmd(const EditCmd& cmd)
+{
+   Configuration& C(Configuration::Instance());
+   list<EditCmd>::iterator it(C.currCmds.insert(C.currCmds.end(), cmd));
+   C.activeCmds[cmd.key()].push_back(it);
+}
+
+//------------------------------------------------------------------------------
+// remove *it from the current list and from the index; return the next one
+list<EditCmd>::iterator removeCurrentCmd(list<EditCmd>::iterator it)
+{
+   Configuration& C(Configuration::Instance());
+   map<string, list<list<EditCmd>::iterator> >::iterator kt;
+   kt = C.activeCmds.find(it->key());
+   if(kt != C.activeCmds.end())
+   {
+      kt->second.remove(it);
+      if(kt->second.empty())
+         C.activeCmds.erase(kt);
+   }
+   return C.currCmds.erase(it);
+}
+
 
 //------------------------------------------------------------------------------
 // return >0 to put/keep the command on the 'current' queue
 // return <0 for fatal error
-int executeEditCmd(const vector<EditCmd>::iterator& it, Rinex3ObsHeader& Rhead,
-                                                        Rinex3ObsData& Rdata)
+int executeEditCmd(EditCmd& cmd, Rinex3ObsHeader& Rhead, Rinex3ObsData& Rdata)
 {
    Configuration& C(Configuration::Instance());
    size_t i,j;
@@ -996,32 +1048,32 @@ int executeEditCmd(const vector<EditCmd>::iterator& it, Rinex3ObsHeader& Rhead,
 
    try
    {
-      if(it->type == EditCmd::invalidCT)
+      if(cmd.type == EditCmd::invalidCT)
       {
-         LOG(DEBUG) << " Invalid command " << it->asString();
+         LOG(DEBUG) << " Invalid command " << cmd.asString();
          return 0;
       }
 
          // OF output file --------------------------------------------------------
-      else if(it->type == EditCmd::ofCT)
+      else if(cmd.type == EditCmd::ofCT)
       {
             // close the old file
          if(C.ostrm.is_open()) { C.ostrm.close(); C.ostrm.clear(); }
 
             // open the new file
-         C.ostrm.open(it->field.c_str(),ios::out);
+         C.ostrm.open(cmd.field.c_str(),ios::out);
          if(!C.ostrm.is_open())
          {
-            LOG(ERROR) << "Error : could not open output file " << it->field;
+            LOG(ERROR) << "Error : could not open output file " << cmd.field;
             return -1;
          }
          C.ostrm.exceptions(ios::failbit);
 
-         LOG(INFO) << " Opened output file " << it->field << " at time "
+         LOG(INFO) << " Opened output file " << cmd.field << " at time "
                    << printTime(Rdata.time,C.longfmt);
 
             // if this is the first file, apply the header commands
-         if(it->ttag == CommonTime::BEGINNING_OF_TIME)
+         if(cmd.ttag == CommonTime::BEGINNING_OF_TIME)
          {
             Rhead.fileProgram = C.prgmName;
             if(!C.messHDp.empty()) Rhead.fileProgram = C.messHDp;
@@ -1078,14 +1130,14 @@ int executeEditCmd(const vector<EditCmd>::iterator& it, Rinex3ObsHeader& Rhead,
       }
 
          // DA delete all ---------------------------------------------------------------
-      else if(it->type == EditCmd::daCT)
+      else if(cmd.type == EditCmd::daCT)
       {
-         switch(it->sign)
+         switch(cmd.sign)
          {
             case 1: case 0:
                Rdata.numSVs = 0;                   // clear this data, keep the cmd
                Rdata.obs.clear();
-               if(it->sign == 0) return 0;
+               if(cmd.sign == 0) return 0;
                break;
             case -1:
                return 0;                           // delete the (-) command
@@ -1097,31 +1149,31 @@ int executeEditCmd(const vector<EditCmd>::iterator& it, Rinex3ObsHeader& Rhead,
          // This is handled above where output header is created w/o the deleted
          // obs type in it. The data isn't actually deleted from the obs data objects
          // but just doesn't get written out
-      else if (it->type == EditCmd::doCT)
+      else if (cmd.type == EditCmd::doCT)
          return 0;
 
          // DS delete satellite ---------------------------------------------------------
-      else if(it->type == EditCmd::dsCT)
+      else if(cmd.type == EditCmd::dsCT)
       {
          vector<RinexSatID> sats;
-         if (it->sign == -1)
+         if (cmd.sign == -1)
             return 0;                 // delete the (-) command
 
-         LOG(DEBUG) << " Delete sat " << it->asString();
-         if (it->sat.id > 0)
+         LOG(DEBUG) << " Delete sat " << cmd.asString();
+         if (cmd.sat.id > 0)
          {
                // Find a specific satellite
-            kt = Rdata.obs.find(it->sat);
+            kt = Rdata.obs.find(cmd.sat);
             if (kt != Rdata.obs.end())                // found the SV
                sats.push_back(kt->first);
             else
-               LOG(DEBUG) << " Execute: sat " << it->sat << " not found in data";
+               LOG(DEBUG) << " Execute: sat " << cmd.sat << " not found in data";
          }
          else
          {
                // Delete all with the specified system
             for (kt=Rdata.obs.begin(); kt!=Rdata.obs.end(); ++kt)
-               if (kt->first.system == it->sat.system)
+               if (kt->first.system == cmd.sat.system)
                   sats.push_back(kt->first);
          }
 
@@ -1132,7 +1184,7 @@ int executeEditCmd(const vector<EditCmd>::iterator& it, Rinex3ObsHeader& Rhead,
 
          Rdata.numSVs = Rdata.obs.size();
 
-         if (it->sign == 0)
+         if (cmd.sign == 0)
             return 0;                  // delete the one-time command
       }
 
@@ -1142,43 +1194,43 @@ int executeEditCmd(const vector<EditCmd>::iterator& it, Rinex3ObsHeader& Rhead,
       {
          vector<RinexSatID> sats;
 
-         if(it->sign == -1) return 0;                 // delete the (-) command
+         if(cmd.sign == -1) return 0;                 // delete the (-) command
 
-         sys = asString(it->sat.systemChar());        // find the system
+         sys = asString(cmd.sat.systemChar());        // find the system
 
             // find the OT in the header map, and get index into vector
          jt = find(Rhead.mapObsTypes[sys].begin(),
-                   Rhead.mapObsTypes[sys].end(), it->obs);
+                   Rhead.mapObsTypes[sys].end(), cmd.obs);
          if (jt == Rhead.mapObsTypes[sys].end()) {     // ObsID not found
                // TD message? user error: ask to delete one that's not there
-            LOG(DEBUG) << " Execute: obstype " << it->obs << " not found in header";
+            LOG(DEBUG) << " Execute: obstype " << cmd.obs << " not found in header";
             return 0;                                 // delete the cmd
          }
 
          i = (jt - Rhead.mapObsTypes[sys].begin());   // index into vector
 
             // find the sat
-         if(it->sat.id > 0)
+         if(cmd.sat.id > 0)
          {
-            if(Rdata.obs.find(it->sat)==Rdata.obs.end())
+            if(Rdata.obs.find(cmd.sat)==Rdata.obs.end())
             { // sat not found
-               LOG(DEBUG) << " Execute: sat " << it->sat << " not found in data";
+               LOG(DEBUG) << " Execute: sat " << cmd.sat << " not found in data";
             }
             else
-               sats.push_back(it->sat);
+               sats.push_back(cmd.sat);
          }
          else
          {
             for(kt=Rdata.obs.begin(); kt!=Rdata.obs.end(); ++kt)
             {
-               if(kt->first.system == it->sat.system)
+               if(kt->first.system == cmd.sat.system)
                   sats.push_back(kt->first);
             }
          }
 
          for(j=0; j<sats.size(); j++)
          {
-            switch(it->type)
+            switch(cmd.type)
             {
                   // DD delete data -----------------------------------------------------
                case EditCmd::ddCT:
@@ -1188,28 +1240,28 @@ int executeEditCmd(const vector<EditCmd>::iterator& it, Rinex3ObsHeader& Rhead,
                   break;
                      // SD set data --------------------------------------------------------
                case EditCmd::sdCT:
-                  Rdata.obs[sats[j]][i].data = it->data;
+                  Rdata.obs[sats[j]][i].data = cmd.data;
                   break;
                      // SS set SSI ---------------------------------------------------------
                case EditCmd::ssCT:
-                  Rdata.obs[sats[j]][i].ssi = it->idata;
+                  Rdata.obs[sats[j]][i].ssi = cmd.idata;
                   break;
                      // SL set LLI ---------------------------------------------------------
                case EditCmd::slCT:
-                  Rdata.obs[sats[j]][i].lli = it->idata;
+                  Rdata.obs[sats[j]][i].lli = cmd.idata;
                   break;
                      // BD bias data -------------------------------------------------------
                case EditCmd::bdCT:     // do not bias
                   if(Rdata.obs[sats[j]][i].data != 0.0 || C.messBZ)
-                     Rdata.obs[sats[j]][i].data += it->data;
+                     Rdata.obs[sats[j]][i].data += cmd.data;
                   break;
                      // BS bias SSI --------------------------------------------------------
                case EditCmd::bsCT:
-                  Rdata.obs[sats[j]][i].ssi += it->idata;
+                  Rdata.obs[sats[j]][i].ssi += cmd.idata;
                   break;
                      // BL bias LLI --------------------------------------------------------
                case EditCmd::blCT:
-                  Rdata.obs[sats[j]][i].lli += it->idata;
+                  Rdata.obs[sats[j]][i].lli += cmd.idata;
                   break;
                      // never reached ------------------------------------------------------
                default:
@@ -1218,7 +1270,7 @@ int executeEditCmd(const vector<EditCmd>::iterator& it, Rinex3ObsHeader& Rhead,
             }
          }
 
-         if(it->sign == 0)
+         if(cmd.sign == 0)
             return 0;                  // delete the one-time command
       }
 
@@ -91,6 +91,8 @@
  * \dicdef{Assume v2.11 P mean Y (don't)}
  * \dicterm{\--quiet}
  * \dicdef{Make output a little quieter (don't)}
+ * \dicterm{\--threads \argarg{N}}
+ * \dicdef{Summarize files, or chunks of one RINEX 3 file, on \argarg{N} threads (1)}
  * \dicterm{\--verbose}
  * \dicdef{Print extended output, including cmdline summary (don't)}
  * \dicterm{\--debug\argarg{N}}
@@ -126,6 +128,11 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 
 // GNSSTK
 #include <gnsstk/Exception.hpp>
@@ -199,6 +206,7 @@ private:
       doCurrRversion = false;
       Rversion = 0.0;
       vres = 0;
+      nthreads = 1;
    }  // end Configuration::SetDefaults()
 
 public:
@@ -211,7 +219,7 @@ public:
       // start command line input
    bool help, verbose, brief, nohead, notab, gpstime, sorttime, dogaps, doms,
       vistab, ycode, quiet;
-   int debug, vres;
+   int debug, vres, nthreads;
    double dt;
    double Rversion;              // RINEX version of output (default=header.version)
    bool doCurrRversion;          // set Rversion to Rinex3ObsBase::currentVersion
@@ -230,7 +238,6 @@ public:
 
       // end of command line input
 
-   vector<int> gapcount;               // for counting gaps
    string msg;
    static const string calfmt,gpsfmt,longfmt;
    ofstream logstrm;
@@ -285,6 +292,64 @@ public:
    { return d1.begin < d2.begin; }
 };
 
+//-----------------------------------------------------------------------------
+// One line of the output of a file, written to S when it goes out of scope.
+// The output of each file (and chunk) is collected this way, so that they can
+// be summarized concurrently and printed in order; use SLOG(S,level) like LOG.
+class SumLine
+{
+public:
+   SumLine(ostringstream& s) : sum(s) {}
+   ~SumLine() { line << endl; sum << line.str(); }
+   ostringstream& get() { return line; }
+private:
+   ostringstream& sum;
+   ostringstream line;
+};
+
+#define SLOG(S,level) \
+   if(level > LOGlevel) ; \
+   else SumLine(S).get()
+
+//-----------------------------------------------------------------------------
+// Counts accumulated while reading the epochs of a file, or of one chunk of it
+struct FileCounts
+{
+   int iret;                           // 0 ok, 3 failed to read data
+   bool hitEnd;                        // reached the --stop time
+   int nepochs, nauxheads;
+   vector<TableData> table;            // table of counts per sat,obs
+   map<char, vector<int> > totals;     // totals per system,obs
+   vector<int> gapcount;               // for counting gaps, all sats
+   vector<pair<double,int> > steps;    // time steps, as runs (dt,number)
+   CommonTime firstObsTime, lastObsTime, prevObsTime;
+   CommonTime firstTime;               // time of the first epoch counted
+   int firstFlag;                      // epoch flag of the first epoch counted
+      // the out-of-time-order records
+   vector<CommonTime> cachetime;
+   vector<vector<Rinex3ObsData> > cache;
+   ostringstream log;                  // output while reading
+
+   FileCounts() { reset(); }
+
+   void reset()
+   {
+      iret = 0;
+      hitEnd = false;
+      nepochs = nauxheads = 0;
+      table.clear();
+      totals.clear();
+      gapcount.clear();
+      steps.clear();
+      firstObsTime = lastObsTime = prevObsTime = CommonTime::BEGINNING_OF_TIME;
+      firstTime = CommonTime::BEGINNING_OF_TIME;
+      firstFlag = -1;
+      cachetime.clear();
+      cache.clear();
+      log.str("");
+   }
+};
+
 //-----------------------------------------------------------------------------
 // prototypes
 /**
@@ -293,6 +358,18 @@ int Initialize(string& errors);
 /**
  * @throw Exception */
 int ProcessFiles(void);
+/**
+ * @throw Exception */
+int SummarizeFile(size_t nfile, double outputVersion, size_t nver, int nchunks,
+                  ostringstream& S);
+/**
+ * @throw Exception */
+void ReadEpochs(Rinex3ObsStream& istrm, Rinex3ObsHeader& Rhead, long long stop,
+                bool fixTS, vector<string>& msots, int nmaxobs, FileCounts& fc);
+/**
+ * @throw Exception */
+bool ReadChunks(const string& filename, Rinex3ObsHeader& Rhead, long long begin,
+                int nchunks, int nmaxobs, FileCounts& fc);
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -589,6 +666,8 @@ string Configuration::BuildCommandLine(void) noexcept
             "Assume v2.11 P mean Y");
    opts.Add('q', "quiet", "", false, false, &quiet, "",
             "Make output a little quieter");
+   opts.Add(0, "threads", "n", false, false, &nthreads, "",
+            "Summarize files, or chunks of one RINEX 3 file, on n threads");
 
    // CommandLine adds automatically
    //opts.Add(0, "verbose", "", false, false, &verbose, "# Help:",
@@ -744,6 +823,14 @@ int Configuration::ExtraProcessing(string& errors, string& extras) noexcept
       ossx << "Warning - Option --vtab requires that --vis <n> be given\n";
       vistab = false;
    }
+      // threads
+   if(nthreads < 1)
+   {
+      ossx << "Warning - Option --threads requires a positive n; using 1\n";
+      nthreads = 1;
+   }
+   if(nthreads > 1 && (doms || debug > -1))
+      ossx << "Warning - Option --threads is ignored with --milli and --debug\n";
 
       // add new errors to the list
    msg = oss.str();
@@ -758,1053 +845,1483 @@ int Configuration::ExtraProcessing(string& errors, string& extras) noexcept
 } // end Configuration::ExtraProcessing(string& errors) noexcept
 
 //-----------------------------------------------------------------------------
-// Return 0 ok, >0 number of files successfully read, <0 fatal error
-int ProcessFiles()
+// Add n time steps dt to the histogram (bestdt,ndt) of the most common steps;
+// when all ndtmax slots are in use, the least common one is replaced.
+void AddTimeStep(double dt, int n, double *bestdt, int *ndt, size_t ndtmax)
+{
+   size_t i,j;
+   int k;
+   for(i=0; i<ndtmax; i++)
+   {
+      if(ndt[i] <= 0)
+      {
+         bestdt[i]=dt;
+         ndt[i]=n;
+         break;
+      }
+      if(fabs(dt-bestdt[i]) < 0.0001)
+      {
+         ndt[i] += n;
+         break;
+      }
+      if(i == ndtmax-1)
+      {
+         k = 0;
+         int nleast = ndt[k];
+         for(j=1; j<ndtmax; j++)
+         {
+            if(ndt[j] <= nleast)
+            {
+               k = j;
+               nleast = ndt[j];
+            }
+         }
+         ndt[k] = n;
+         bestdt[k] = dt;
+      }
+   }
+}  // end AddTimeStep()
+
+//-----------------------------------------------------------------------------
+// Read epochs from istrm, adding them to fc, until the end of the file, the
+// --stop time or file position stop (if >= 0). If fixTS, the header time systems
+// are fixed to match the first epoch.
+void ReadEpochs(Rinex3ObsStream& istrm, Rinex3ObsHeader& Rhead, long long stop,
+                bool fixTS, vector<string>& msots, int nmaxobs, FileCounts& fc)
 {
    try
    {
       Configuration& C(Configuration::Instance());
-      int iret,ii,k;
-      size_t i,j,nfile,nfiles;
+      size_t i;
       string tag;
-      CommonTime lastObsTime, prevObsTime, firstObsTime;
-      RinexSatID sat;
-      Rinex3ObsStream ostrm;
       ostringstream oss;
+      Rinex3ObsData Rdata;
+      bool cacheon(false);
 
-      // output in header.version, unless user requests otherwise
-      double outputVersion(C.Rversion);
-      if(C.doCurrRversion) outputVersion = Rinex3ObsBase::currentVersion;
-
-         // estimate time step
-      const size_t ndtmax=15;
-      double dt, bestdt[ndtmax];
-      int ndt[ndtmax];
-         // cache the out-of-time-order records
-      bool cacheon;
-      vector<CommonTime> cachetime;
-      vector<vector<Rinex3ObsData> > cache;
-
-      for(nfiles=0,nfile=0; nfile<C.InputObsFiles.size(); nfile++)
+      while(1)
       {
-         Rinex3ObsStream istrm;
-         Rinex3ObsHeader Rhead, Rheadout;
-         Rinex3ObsData Rdata;
+            // end of the chunk
+         if(stop >= 0 && static_cast<long long>(istrm.tellg()) >= stop)
+            break;
 
-            // If command line specified P1/P2 are to be considered
-            // as Y-code, set the Rinex3ObsHeader flag to indicate such.
-         if (C.ycode)
+         try
          {
-            Rhead.PisY = true;
-            Rheadout.PisY = true;
+            istrm >> Rdata;
          }
-
-         cacheon = false;
-         cache.clear();
-         cachetime.clear();
-
-         string filename(C.InputObsFiles[nfile]);
-
-         // iret is set to 0 ok, or could not: 1 open file, 2 read header, 3 read data
-         iret = 0;
-         for(i=0; i<ndtmax; i++)
-            ndt[i] = -1;
-
-            // open the file ------------------------------------------------
-         istrm.open(filename.c_str(),ios::in);
-         if(!istrm.is_open())
+         catch(Exception& e)
          {
-            LOG(WARNING) << "Warning : could not open file " << filename;
-            iret = 1;
-            continue;
+            SLOG(fc.log,WARNING) << " Warning : Failed to read obs data (Exception "
+                         << e.getText(0) << "); dump follows.";
+            Rdata.dump(fc.log,Rhead);
+            istrm.close();
+            fc.iret = 3;
+            break;
          }
-         istrm.exceptions(ios::failbit);
-
-         // get file size - on windows its different b/c of CRs
-         //char ch;
-         //istrm.seekg(0,ios::end);
-         //streampos filesize(istrm.tellg());
-         //istrm.seekg(0,ios::beg);
-
-            // output file name
-         if(C.quiet)
+         catch(std::exception& e)
          {
-            std::string choppedFN(filename);
-            choppedFN.erase(0,1+filename.find_last_of("/\\"));
-            LOG(INFO) << "+++++++++++++ " << C.PrgmName
-                      << " summary of Rinex obs file " << choppedFN
-                      << " +++++++++++++";
+            Exception ge(string("Std excep: ") + e.what());
+            GNSSTK_THROW(ge);
          }
-         else if(!C.brief)
+         catch(...)
          {
-            LOG(INFO) << "+++++++++++++ " << C.PrgmName
-                      << " summary of Rinex obs file " << filename
-                      << " +++++++++++++";
+            Exception ue("Unknown exception while reading RINEX data.");
+            GNSSTK_THROW(ue);
          }
 
-            // read the header ----------------------------------------------
-         try
+            // normal EOF
+         if(!istrm.good() || istrm.eof())
          {
-            istrm >> Rhead;
-         }
-         catch(Exception& e)
-         {
-            LOG(WARNING) << "Warning : Failed to read header: " << e.what()
-                         << "\n Header dump follows.";
-            Rhead.dump(LOGstrm);
-            istrm.close();
-            iret = 2;
-            continue;
+            fc.iret = 0;
+            break;
          }
-         if(Rhead.lastObs.getTimeSystem() != Rhead.firstObs.getTimeSystem())
-            Rhead.lastObs.setTimeSystem(Rhead.firstObs.getTimeSystem());
 
-            // output file name and header
-         if(C.brief)
+            // stay within time limits
+         if(Rdata.time < C.beginTime)
          {
-            if(nfile > 0)
-               LOG(INFO) << "";
-            LOG(INFO) << "File name: " << filename
-                      << " (RINEX ver. " << Rhead.version << ")";
-            LOG(INFO) << "Marker name: " << Rhead.markerName;
-            LOG(INFO) << "Antenna type: " << Rhead.antType;
-            LOG(INFO) << "Position (XYZ,m) : " << fixed << setprecision(4)
-                      << Rhead.antennaPosition << ".";
-            LOG(INFO) << "Antenna offset (UEN,m) : " << fixed << setprecision(4)
-                      << Rhead.antennaDeltaHEN << ".";
+            SLOG(fc.log,DEBUG) << " RINEX data timetag "
+                       << printTime(C.beginTime,C.longfmt) << " is before begin time.";
+            continue;
          }
-         else if(!C.nohead)
+         if(Rdata.time > C.endTime)
          {
-            LOG(DEBUG) << "RINEX header:";
-            if(outputVersion == 0.0)
-               outputVersion = Rhead.version;
-            else
-               LOG(INFO) << " (Header has version " << Rhead.version
-                        << "; output as version " << outputVersion << ")";
-            Rhead.dump(LOGstrm,outputVersion);
+            SLOG(fc.log,DEBUG) << " RINEX data timetag " << printTime(C.endTime,C.longfmt)
+                       << " is after end time.";
+            fc.hitEnd = true;
+            break;
          }
 
-         if(!Rhead.isValid())
-         {
-            LOG(INFO) << "Abort: header is invalid.";
-            if(C.quiet)
-            {
-               std::string choppedFN(filename);
-               choppedFN.erase(0,1+filename.find_last_of("/\\"));
-               LOG(INFO) << "\n+++++++++++++ End of RinSum summary of "
-                         << choppedFN << " +++++++++++++";
-            }
-            else if(!C.brief)
+            // fix time systems - only for data, not aux headers
+         if(Rdata.epochFlag == 0) {
+            if(fixTS && fc.nepochs == 0 &&
+               Rdata.time.getTimeSystem() != Rhead.lastObs.getTimeSystem())
             {
-               LOG(INFO) << "\n+++++++++++++ End of RinSum summary of "
-                         << filename << " +++++++++++++";
+               Rhead.lastObs.setTimeSystem(Rdata.time.getTimeSystem());
+               Rhead.firstObs.setTimeSystem(Rdata.time.getTimeSystem());
             }
-            continue;
+            fc.lastObsTime = Rdata.time;
+            fc.lastObsTime.setTimeSystem(Rhead.lastObs.getTimeSystem());
+            fc.firstObsTime.setTimeSystem(Rhead.lastObs.getTimeSystem());
+            fc.prevObsTime.setTimeSystem(Rhead.lastObs.getTimeSystem());
+            if(fc.firstObsTime == CommonTime::BEGINNING_OF_TIME)
+               fc.firstObsTime = fc.lastObsTime;
          }
 
-            // initialize counting -------------------------------------------
-         int nepochs(0), nauxheads(0), nmaxobs(0);
-         vector<TableData> table;            // table of counts per sat,obs
-         map<char, vector<int> > totals;     // totals per system,obs
-
-         prevObsTime = CommonTime::BEGINNING_OF_TIME;
-         firstObsTime = CommonTime::BEGINNING_OF_TIME;
+         SLOG(fc.log,DEBUG) << " Read RINEX data: flag " << Rdata.epochFlag
+                    << ", timetag " << printTime(Rdata.time,C.longfmt);
 
-            // initialize for all systems in the header
-         map<std::string,vector<RinexObsID> >::const_iterator sit;   // used below often
-         for(sit=Rhead.mapObsTypes.begin(); sit != Rhead.mapObsTypes.end(); ++sit)
+            // if aux header data, either output or skip
+         if(Rdata.epochFlag > 1)
          {
-               // Initialize the vectors contained in the map
-            totals[(sit->first)[0]] = vector<int>((sit->second).size());
+            //if(C.debug > -1)
+            //   for(j=0; j<Rdata.auxHeader.commentList.size(); j++)
+            //      SLOG(fc.log,DEBUG) << "Comment: " << Rdata.auxHeader.commentList[j];
+            if(C.verbose) {
+               SLOG(fc.log,INFO) << "\nDump auxiliary header information:";
+               Rdata.auxHeader.dump(fc.log);
+            }
+            fc.nauxheads++;
+            continue;
+         }
 
-            LOG(DEBUG) << "GNSS " << (sit->first) << " is present with "
-                       << (sit->second).size() << " observations...";
+            // debug: dump the RINEX data object
+         if(C.debug > -1)
+            Rdata.dump(fc.log,Rhead);
 
-               // find the max size of obs list
-            if(int((sit->second).size()) > nmaxobs)
-               nmaxobs = (sit->second).size();
+            // count this epoch
+         if(fc.nepochs++ == 0)
+         {
+            fc.firstFlag = Rdata.epochFlag;
+            fc.firstTime = fc.lastObsTime;
          }
 
-            // initialize millisecond handler with obstypes and wavelengths
-         vector<string> msots;
-         if(C.doms)
+            // check for data out of time order
+            // use < 1.e-3 not < 0 b/c inline header info (epochFlag > 1) excluded
+         if(fc.prevObsTime != CommonTime::BEGINNING_OF_TIME
+            && Rdata.time-fc.prevObsTime < 1.e-3)
          {
-            vector<double> waves;
-               // get obs types from header
-            for(sit=Rhead.mapObsTypes.begin(); sit != Rhead.mapObsTypes.end(); ++sit)
+               // save it
+            if(!cacheon)
             {
-                  // get the system
-               RinexSatID rsid;
-               rsid.fromString(sit->first);
-               SatID sid(rsid);
-                  // TD support only GPS currently
-               if(rsid.systemChar() != 'G') continue;
-                  // excluded satellites/systems
-               if(find(C.exSats.begin(), C.exSats.end(), rsid) != C.exSats.end())
-                  continue;
-                  // get the obstypes, prepend the system character
-               for(i=0; i<sit->second.size(); i++)
-               {
-                  tag = sit->second[i].asString();       // 3-char obs type
-                  if(tag[0] == 'C' || tag[0] == 'L')
-                  {
-                        // code and phase only
-                     msots.push_back(string(1,rsid.systemChar())+tag);
-                        // get wavelength ... NB TD Glonass frequency channel not supported
-                     if(tag[0] == 'L')
-                     {
-                        ii = asInt(string(1,tag[1]));
-                        waves.push_back(getWavelength(sid.system, ii));
-                     }
-                     else
-                        waves.push_back(0.0);
-                  }
-               }
+                  // new block
+               fc.cachetime.push_back(fc.prevObsTime);
+               cacheon = true;
+               vector<Rinex3ObsData> v;
+               fc.cache.push_back(v);
             }
-
-            C.msh.setObstypes(msots,waves);
-            LOG(DEBUG) << "Initialize millisecond handler with obs type, wavelength:";
-            for(i=0; i<msots.size(); i++) LOG(DEBUG) << " " << msots[i]
-                                                     << fixed << setprecision(6) << " " << waves[i];
+            fc.cache[fc.cache.size()-1].push_back(Rdata);
+            continue;
          }
+         cacheon = false;
 
-         if(pLOGstrm == &cout && !C.brief)
-            LOG(INFO) << "\nReading the observation data...";
-
-            // loop over epochs ---------------------------------------------
-         while(1)
+            // look for gaps in the timetags
+         int ncount;
+         if(C.dt > 0.0)
          {
-            try
-            {
-               istrm >> Rdata;
-            }
-            catch(Exception& e)
-            {
-               LOG(WARNING) << " Warning : Failed to read obs data (Exception "
-                            << e.getText(0) << "); dump follows.";
-               Rdata.dump(LOGstrm,Rhead);
-               istrm.close();
-               iret = 3;
-               break;
-            }
-            catch(std::exception& e)
-            {
-               Exception ge(string("Std excep: ") + e.what());
-               GNSSTK_THROW(ge);
-            }
-            catch(...)
-            {
-               Exception ue("Unknown exception while reading RINEX data.");
-               GNSSTK_THROW(ue);
-            }
-
-               // normal EOF
-            if(!istrm.good() || istrm.eof())
+            ncount = int(0.5+(fc.lastObsTime-fc.firstObsTime)/C.dt);
+               // update gap count
+            if(fc.gapcount.size() == 0)
             {
-               iret = 0;
-               break;
-            }
-
-               // stay within time limits
-            if(Rdata.time < C.beginTime)
-            {
-               LOG(DEBUG) << " RINEX data timetag " << printTime(C.beginTime,C.longfmt)
-                          << " is before begin time.";
-               continue;
+                  // create the list
+               fc.gapcount.push_back(ncount);   // start time
+               fc.gapcount.push_back(ncount-1); // end time
             }
-            if(Rdata.time > C.endTime)
+            i = fc.gapcount.size() - 1;
+            if(ncount == fc.gapcount[i] + 1)    // no gap
+               fc.gapcount[i] = ncount;
+            else
             {
-               LOG(DEBUG) << " RINEX data timetag " << printTime(C.endTime,C.longfmt)
-                          << " is after end time.";
-               break;
+                  // found a gap
+               fc.gapcount.push_back(ncount);   // start time
+               fc.gapcount.push_back(ncount);   // end time
             }
 
-               // fix time systems - only for data, not aux headers
-            if(Rdata.epochFlag == 0) {
-               if(nepochs == 0 &&
-                  Rdata.time.getTimeSystem() != Rhead.lastObs.getTimeSystem())
-               {
-                  Rhead.lastObs.setTimeSystem(Rdata.time.getTimeSystem());
-                  Rhead.firstObs.setTimeSystem(Rdata.time.getTimeSystem());
-               }
-               lastObsTime = Rdata.time;
-               lastObsTime.setTimeSystem(Rhead.lastObs.getTimeSystem());
-               firstObsTime.setTimeSystem(Rhead.lastObs.getTimeSystem());
-               prevObsTime.setTimeSystem(Rhead.lastObs.getTimeSystem());
-               if(firstObsTime == CommonTime::BEGINNING_OF_TIME)
-                  firstObsTime = lastObsTime;
-            }
+               // TD test after 50 epochs - wrong dt is disasterous
+         }
 
-            LOG(DEBUG) << " Read RINEX data: flag " << Rdata.epochFlag
-                       << ", timetag " << printTime(Rdata.time,C.longfmt);
+            // loop over satellites -------------------------------------
+         Rinex3ObsData::DataMap::const_iterator it;
+         for(it=Rdata.obs.begin(); it != Rdata.obs.end(); ++it)
+         {
+            const RinexSatID& sat(it->first);
 
-               // if aux header data, either output or skip
-            if(Rdata.epochFlag > 1)
-            {
-               //if(C.debug > -1)
-               //   for(j=0; j<Rdata.auxHeader.commentList.size(); j++)
-               //      LOG(DEBUG) << "Comment: " << Rdata.auxHeader.commentList[j];
-               if(C.verbose) {
-                  LOG(INFO) << "\nDump auxiliary header information:";
-                  Rdata.auxHeader.dump(LOGstrm);
-               }
-               nauxheads++;
+               // is sat included?
+            if(C.onlySats.size() > 0 &&
+               find(C.onlySats.begin(), C.onlySats.end(), sat) == C.onlySats.end()
+               && find(C.onlySats.begin(), C.onlySats.end(),
+                       RinexSatID(-1,sat.system)) == C.onlySats.end())
                continue;
-            }
 
-               // debug: dump the RINEX data object
-            if(C.debug > -1)
-               Rdata.dump(LOGstrm,Rhead);
+               // is sat excluded?
+            if(find(C.exSats.begin(), C.exSats.end(), sat) != C.exSats.end())
+               continue;
+               // check for all sats of this system
+            else if(find(C.exSats.begin(), C.exSats.end(),
+                         RinexSatID(-1,sat.system)) != C.exSats.end())
+               continue;
 
-               // count this epoch
-            nepochs++;
+            const vector<RinexDatum>& vecData(it->second);
 
-               // check for data out of time order
-               // use < 1.e-3 not < 0 b/c inline header info (epochFlag > 1) excluded
-            if(prevObsTime != CommonTime::BEGINNING_OF_TIME
-               && Rdata.time-prevObsTime < 1.e-3)
+               // find this sat in the table; add it if necessary
+            vector<TableData>::iterator ptab;
+            ptab = find(fc.table.begin(),fc.table.end(),TableData(sat,nmaxobs));
+            if(ptab == fc.table.end())
             {
-                  // save it
-               if(!cacheon)
+                  // add it
+               fc.table.push_back(TableData(sat,nmaxobs));
+               ptab = find(fc.table.begin(),fc.table.end(),TableData(sat,nmaxobs));
+               ptab->begin = fc.lastObsTime;
+               if(C.dt > 0.0)
                {
-                     // new block
-                  cachetime.push_back(prevObsTime);
-                  cacheon = true;
-                  vector<Rinex3ObsData> v;
-                  cache.push_back(v);
+                  ptab->gapcount.push_back(ncount);      // start time
+                  ptab->gapcount.push_back(ncount-1);    // end time
                }
-               cache[cache.size()-1].push_back(Rdata);
-               continue;
             }
-            cacheon = false;
 
-               // look for gaps in the timetags
-            int ncount;
+               // update list of gap times
             if(C.dt > 0.0)
             {
-               ncount = int(0.5+(lastObsTime-firstObsTime)/C.dt);
-                  // update gap count
-               if(C.gapcount.size() == 0)
-               {
-                     // create the list
-                  C.gapcount.push_back(ncount);   // start time
-                  C.gapcount.push_back(ncount-1); // end time
-               }
-               i = C.gapcount.size() - 1;
-               if(ncount == C.gapcount[i] + 1)    // no gap
-                  C.gapcount[i] = ncount;
+               i = ptab->gapcount.size() - 1;         // index of curr end time
+               if(ncount == ptab->gapcount[i] + 1)    // no gap
+                  ptab->gapcount[i] = ncount;
                else
                {
                      // found a gap
-                  C.gapcount.push_back(ncount);   // start time
-                  C.gapcount.push_back(ncount);   // end time
+                  ptab->gapcount.push_back(ncount);   // start time
+                  ptab->gapcount.push_back(ncount);   // end time
                }
-
-                  // TD test after 50 epochs - wrong dt is disasterous
             }
 
-               // loop over satellites -------------------------------------
-            Rinex3ObsData::DataMap::const_iterator it;
-            for(it=Rdata.obs.begin(); it != Rdata.obs.end(); ++it)
+               // set the end time for this satellite to the current epoch
+            ptab->end = fc.lastObsTime;
+            if(C.debug > -1)
             {
-               const RinexSatID& sat(it->first);
-
-                  // is sat included?
-               if(C.onlySats.size() > 0 &&
-                  find(C.onlySats.begin(), C.onlySats.end(), sat) == C.onlySats.end()
-                  && find(C.onlySats.begin(), C.onlySats.end(),
-                          RinexSatID(-1,sat.system)) == C.onlySats.end())
-                  continue;
+               oss.str("");
+               oss << "Sat " << setw(2) << sat;
+            }
 
-                  // is sat excluded?
-               if(find(C.exSats.begin(), C.exSats.end(), sat) != C.exSats.end())
-                  continue;
-                  // check for all sats of this system
-               else if(find(C.exSats.begin(), C.exSats.end(),
-                            RinexSatID(-1,sat.system)) != C.exSats.end())
-                  continue;
+               // first, find the current system...
+            char sysCode = sat.systemChar();
+            string sysStr(string(1,sysCode));
 
-               const vector<RinexDatum>& vecData(it->second);
+               // update Obs data fc.totals
+            for(size_t index=0; index != vecData.size(); index++)
+            {
+               if(C.debug > -1)
+                  oss << " (" << index << ")";
 
-                  // find this sat in the table; add it if necessary
-               vector<TableData>::iterator ptab;
-               ptab = find(table.begin(),table.end(),TableData(sat,nmaxobs));
-               if(ptab == table.end())
+                  // if this observation is not zero, update it's total count
+               if(vecData[index].data != 0)
                {
-                     // add it
-                  table.push_back(TableData(sat,nmaxobs));
-                  ptab = find(table.begin(),table.end(),TableData(sat,nmaxobs));
-                  ptab->begin = lastObsTime;
-                  if(C.dt > 0.0)
-                  {
-                     ptab->gapcount.push_back(ncount);      // start time
-                     ptab->gapcount.push_back(ncount-1);    // end time
-                  }
+                  (ptab->nobs)[index]++;                 // per obs
+                  if(fc.totals[sysCode].size() == 0)
+                     fc.totals[sysCode] = vector<int>(vecData.size());
+                  fc.totals[sysCode][index]++;              // per system
                }
 
-                  // update list of gap times
-               if(C.dt > 0.0)
+                  // if looking for milliseconds, update handler
+               if(C.doms && vecData[index].data != 0)
                {
-                  i = ptab->gapcount.size() - 1;         // index of curr end time
-                  if(ncount == ptab->gapcount[i] + 1)    // no gap
-                     ptab->gapcount[i] = ncount;
-                  else
+                  tag = sysStr + Rhead.mapObsTypes[sysStr][index].asString();
+                  if(vectorindex(msots,tag) != -1)
                   {
-                        // found a gap
-                     ptab->gapcount.push_back(ncount);   // start time
-                     ptab->gapcount.push_back(ncount);   // end time
+                     C.msh.add(fc.lastObsTime, sat, tag, vecData[index].data);
                   }
                }
 
-                  // set the end time for this satellite to the current epoch
-               ptab->end = lastObsTime;
                if(C.debug > -1)
-               {
-                  oss.str("");
-                  oss << "Sat " << setw(2) << sat;
-               }
-
-                  // first, find the current system...
-               char sysCode = sat.systemChar();
-               string sysStr(string(1,sysCode));
-
-                  // update Obs data totals
-               for(size_t index=0; index != vecData.size(); index++)
-               {
-                  if(C.debug > -1)
-                     oss << " (" << index << ")";
-
-                     // if this observation is not zero, update it's total count
-                  if(vecData[index].data != 0)
-                  {
-                     (ptab->nobs)[index]++;                 // per obs
-                     if(totals[sysCode].size() == 0)
-                        totals[sysCode] = vector<int>(vecData.size());
-                     totals[sysCode][index]++;              // per system
-                  }
-
-                     // if looking for milliseconds, update handler
-                  if(C.doms && vecData[index].data != 0)
-                  {
-                     tag = sysStr + Rhead.mapObsTypes[sysStr][index].asString();
-                     if(vectorindex(msots,tag) != -1)
-                     {
-                        C.msh.add(lastObsTime, sat, tag, vecData[index].data);
-                     }
-                  }
+                  oss << fixed << setprecision(3)
+                      << " " << asString(Rhead.mapObsTypes[sysStr][index])
+                      << " " << setw(13) << vecData[index].data
+                      << " " << vecData[index].lli
+                      << " " << vecData[index].ssi;
 
-                  if(C.debug > -1)
-                     oss << fixed << setprecision(3)
-                         << " " << asString(Rhead.mapObsTypes[sysStr][index])
-                         << " " << setw(13) << vecData[index].data
-                         << " " << vecData[index].lli
-                         << " " << vecData[index].ssi;
+            } // end loop over observations
 
-               } // end loop over observations
-
-               if(C.debug > -1)
-                  LOG(DEBUG) << oss.str();
+            if(C.debug > -1)
+               SLOG(fc.log,DEBUG) << oss.str();
 
-            }  // end loop over satellites
+         }  // end loop over satellites
 
-            if(prevObsTime != CommonTime::BEGINNING_OF_TIME)
+         if(fc.prevObsTime != CommonTime::BEGINNING_OF_TIME)
+         {
+            double dt = fc.lastObsTime-fc.prevObsTime;
+            if(dt > 0.0)
             {
-               dt = lastObsTime-prevObsTime;
-               if(dt > 0.0)
-               {
-                  for(i=0; i<ndtmax; i++)
-                  {
-                     if(ndt[i] <= 0)
-                     {
-                        bestdt[i]=dt;
-                        ndt[i]=1;
-                        break;
-                     }
-                     if(fabs(dt-bestdt[i]) < 0.0001)
-                     {
-                        ndt[i]++;
-                        break;
-                     }
-                     if(i == ndtmax-1)
-                     {
-                        k = 0;
-                        int nleast = ndt[k];
-                        for(j=1; j<ndtmax; j++)
-                        {
-                           if(ndt[j] <= nleast)
-                           {
-                              k = j;
-                              nleast = ndt[j];
-                           }
-                        }
-                        ndt[k] = 1;
-                        bestdt[k] = dt;
-                     }
-                  }
-               }
-               else if(dt == 0)
-               {
-                  LOG(WARNING) << "Warning - repeated time tag at "
-                               << printTime(lastObsTime,C.longfmt);
-               }
+                  // save runs of equal steps; cf. AddTimeStep()
+               if(fc.steps.size() > 0 && fc.steps.back().first == dt)
+                  fc.steps.back().second++;
                else
-               {
-                  LOG(WARNING) << "Warning - time tags out of order: "
-                               << printTime(prevObsTime,C.longfmt) << " > "
-                               << printTime(lastObsTime,C.longfmt);
-                     //<< " " << scientific << setprecision(4) << dt;
-               }
+                  fc.steps.push_back(make_pair(dt,1));
+            }
+            else if(dt == 0)
+            {
+               SLOG(fc.log,WARNING) << "Warning - repeated time tag at "
+                            << printTime(fc.lastObsTime,C.longfmt);
             }
-            prevObsTime = lastObsTime;
+            else
+            {
+               SLOG(fc.log,WARNING) << "Warning - time tags out of order: "
+                            << printTime(fc.prevObsTime,C.longfmt) << " > "
+                            << printTime(fc.lastObsTime,C.longfmt);
+                  //<< " " << scientific << setprecision(4) << dt;
+            }
+         }
+         fc.prevObsTime = fc.lastObsTime;
 
-         }  // end while loop over epochs
+      }  // end while loop over epochs
+   }
+   catch(Exception& e)
+   {
+      GNSSTK_RETHROW(e);
+   }
+}  // end ReadEpochs()
 
-         istrm.close();
+//-----------------------------------------------------------------------------
+// Open RINEX obs file filename, read its header (into a dummy) and position the
+// stream at pos; return false if any of that fails.
+bool OpenAt(Rinex3ObsStream& strm, const string& filename, long long pos)
+{
+   Configuration& C(Configuration::Instance());
+   Rinex3ObsHeader Rhead;
+   if(C.ycode)
+      Rhead.PisY = true;
+   try
+   {
+      strm.open(filename.c_str(),ios::in);
+      if(!strm.is_open())
+         return false;
+      strm.exceptions(ios::failbit);
+      strm >> Rhead;
+      strm.seekg(pos);
+   }
+   catch(...)
+   {
+      return false;
+   }
+   return strm.good();
+}
+
+//-----------------------------------------------------------------------------
+// Find the first epoch of data, as ReadEpochs() does, fixing the header time
+// systems to match it. Return false if there is none, or if an epoch with flag 1
+// comes first, since ReadEpochs() counts it before the first time is known.
+bool FirstEpoch(Rinex3ObsStream& strm, Rinex3ObsHeader& Rhead, CommonTime& first)
+{
+   Configuration& C(Configuration::Instance());
+   Rinex3ObsData Rdata;
+   while(1)
+   {
+      try
+      {
+         strm >> Rdata;
+      }
+      catch(Exception& e)
+      {
+         return false;
+      }
+      if(!strm.good() || strm.eof())
+         return false;
 
-            // check that we found some data
-         if(nepochs <= 0)
+      if(Rdata.time < C.beginTime)
+         continue;
+      if(Rdata.time > C.endTime)
+         return false;
+      if(Rdata.epochFlag == 1)
+         return false;
+      if(Rdata.epochFlag == 0)
+      {
+         if(Rdata.time.getTimeSystem() != Rhead.lastObs.getTimeSystem())
          {
-            LOG(INFO) << "File " << filename
-                      << " : no data found. Are time limits wrong?";
-            continue;
+            Rhead.lastObs.setTimeSystem(Rdata.time.getTimeSystem());
+            Rhead.firstObs.setTimeSystem(Rdata.time.getTimeSystem());
          }
+         first = Rdata.time;
+         first.setTimeSystem(Rhead.lastObs.getTimeSystem());
+         return true;
+      }
+   }
+}
 
-            // Compute interval -------------------------------------------------
-         for(i=1,j=0; i < ndtmax; i++)
+//-----------------------------------------------------------------------------
+// Split the data of RINEX 3 file filename, from position begin (the end of the
+// header) to the end of the file, into up to n chunks of at least 256kB, each
+// starting at an epoch line. Return the start of each chunk; fewer than two means
+// the file is too small to split.
+vector<long long> ChunkStarts(const string& filename, long long begin, int n)
+{
+   const long long minsize(1<<18);
+   vector<long long> starts;
+   ifstream ifs(filename.c_str(), ios::in);
+   if(!ifs.is_open())
+      return starts;
+   ifs.seekg(0,ios::end);
+   long long size(ifs.tellg());
+   if((size-begin)/minsize < n)
+      n = int((size-begin)/minsize);
+   if(n < 2)
+      return starts;
+
+   string line;
+   starts.push_back(begin);
+   for(int k=1; k<n; k++)
+   {
+      ifs.clear();
+      ifs.seekg(begin + k*(size-begin)/n);
+      getline(ifs,line);                  // finish the partial line
+      while(1)
+      {
+         long long pos(ifs.tellg());
+         if(!getline(ifs,line))
+            break;
+            // "> yyyy mm dd hh mm ss.sssssss  f nn"
+         if(line.size() >= 35 && line[0] == '>' && line[1] == ' '
+            && isdigit(line[2]) && line[21] == '.' && isdigit(line[31]))
          {
-            if(ndt[i] > ndt[j])
-               j = i;
-            dt = bestdt[j];
+            if(pos > starts.back())
+               starts.push_back(pos);
+            break;
          }
+      }
+   }
 
-            // Summary info -----------------------------------------------------
-         LOG(INFO) << "Computed interval " << fixed << setw(5) << setprecision(2)
-                   << dt << " seconds.";
-         LOG(INFO) << "Computed first epoch: " << printTime(firstObsTime,C.longfmt);
-         LOG(INFO) << "Computed last  epoch: " << printTime(lastObsTime,C.longfmt);
-
-            // compute time span of dataset in days/hours/minutes/seconds
-         oss.str("");
-         oss << "Computed time span: ";
-         double secs = lastObsTime - firstObsTime;
-         int remainder = int(secs);
-         CivilTime delta(firstObsTime);
-         delta.day    = remainder / 86400; remainder %= 86400;
-         delta.hour   = remainder / 3600;  remainder %= 3600;
-         delta.minute = remainder / 60;    remainder %= 60;
-         delta.second = remainder;
-         if(delta.day > 0)
-            oss << delta.day << "d ";
-
-         LOG(INFO) << oss.str() << delta.hour << "h " << delta.minute << "m "
-                   << delta.second << "s = " << secs << " seconds.";
-
-         //LOG(INFO) << "Computed file size: " << filesize << " bytes.";
-
-            // Reusing secs, as it is equivalent to the original expression
-            // i = 1+int(0.5+(lastObsTime-firstObsTime)/dt);
-         i = 1+int(0.5 + secs / dt);
-
-         LOG(INFO) << "There were " << nepochs << " epochs ("
-                   << fixed << setprecision(2) << double(nepochs*100)/i
-                   << "% of " << i << " possible epochs in this timespan) and "
-                   << nauxheads << " inline header blocks.";
-
-            // Sort table
-         if(C.sorttime)
-            sort(table.begin(),table.end(),TableBegLessThan());
-         else
-            sort(table.begin(),table.end(),TableSATLessThan());
+   return starts;
+}
 
-            // output table
-            // header
-         vector<TableData>::iterator tabIt;
-         if(table.size() > 0)
-            table.begin()->sat.setfill('0');
+//-----------------------------------------------------------------------------
+// Append the gap counts b, of a later chunk, to a; cf. TableData::gapcount
+void MergeGaps(vector<int>& a, const vector<int>& b)
+{
+   if(b.empty())
+      return;
+   if(a.empty())
+   {
+      a = b;
+      return;
+   }
+   size_t i(0);
+   if(b[0] == a.back()+1)                 // no gap at the split
+   {
+      a.back() = b[1];
+      i = 2;
+   }
+   a.insert(a.end(), b.begin()+i, b.end());
+}
 
-         if(!C.brief && !C.notab)
-         {
-               // non-brief output ------------
-            LOG(INFO) << "\n      Summary of data available in this file: "
-                      << "(Spans are based on times and interval)";
-            string fmt(C.gpstime ? C.gpsfmt : C.calfmt);
-            j = 0;
-            for(sit=Rhead.mapObsTypes.begin(); sit != Rhead.mapObsTypes.end(); ++sit)
-            {
-               RinexSatID sat(sit->first);
-
-               map<char, vector<int> >::const_iterator totalsIter;
-                  // compute grand total first
-               totalsIter = totals.find((sit->first)[0]);
-               const vector<int>& vec = totalsIter->second;
-               for(i=0,k=0; k<vec.size(); k++) i += vec[k];
-               if(i == 0)
-                  continue;
+//-----------------------------------------------------------------------------
+// Add the counts b of the next chunk to fc. Return false if b cannot be merged
+// to give exactly what ReadEpochs() would give on the two together: if it failed
+// to read, or starts with an epoch ReadEpochs() would treat as out of order.
+bool MergeCounts(FileCounts& fc, FileCounts& b)
+{
+   size_t i,j;
+   if(b.iret != 0)
+      return false;
 
-                  // print the table
-               if(++j > 1)
-                  LOG(INFO) << "";
-               LOG(INFO) << "System " << sit->first <<" = "<< sat.systemString() << ":";
-               oss.str("");
-               oss << " Sat\\OT:";
+      // the time step across the split
+   if(b.nepochs > 0 && fc.prevObsTime != CommonTime::BEGINNING_OF_TIME)
+   {
+      if(b.firstFlag != 0 || b.firstTime-fc.prevObsTime < 1.e-3)
+         return false;
+      fc.steps.push_back(make_pair(b.firstTime-fc.prevObsTime,1));
+   }
+   fc.steps.insert(fc.steps.end(), b.steps.begin(), b.steps.end());
+
+   fc.log << b.log.str();
+   fc.nepochs += b.nepochs;
+   fc.nauxheads += b.nauxheads;
+   if(b.prevObsTime != CommonTime::BEGINNING_OF_TIME)
+      fc.prevObsTime = b.prevObsTime;
+   if(b.lastObsTime != CommonTime::BEGINNING_OF_TIME)
+      fc.lastObsTime = b.lastObsTime;
+   fc.hitEnd = b.hitEnd;
+
+      // sats, in order of appearance
+   for(i=0; i<b.table.size(); i++)
+   {
+      TableData& d(b.table[i]);
+      vector<TableData>::iterator ptab(find(fc.table.begin(),fc.table.end(),d));
+      if(ptab == fc.table.end())
+      {
+         fc.table.push_back(d);
+         continue;
+      }
+      for(j=0; j<d.nobs.size() && j<ptab->nobs.size(); j++)
+         ptab->nobs[j] += d.nobs[j];
+      ptab->end = d.end;
+      MergeGaps(ptab->gapcount, d.gapcount);
+   }
 
-                  // print line of RINEX 3 codes
-               for(k=0; k < (sit->second).size(); k++) {
-                  RinexObsID rot((sit->second)[k]);
-                  oss << setw(k==0?4:7) << rot.asString(outputVersion);
-               }
-               LOG(INFO) << oss.str() << "   Span             Begin time - End time";
+   map<char, vector<int> >::const_iterator it;
+   for(it=b.totals.begin(); it != b.totals.end(); ++it)
+   {
+      vector<int>& tot(fc.totals[it->first]);
+      if(tot.size() < it->second.size())
+         tot.resize(it->second.size());
+      for(j=0; j<it->second.size(); j++)
+         tot[j] += it->second[j];
+   }
 
-                  // print the table
-               for(tabIt = table.begin(); tabIt != table.end(); ++tabIt)
-               {
-                  std::string sysChar;
-                  sysChar += (tabIt->sat).systemChar();
-                  if((sit->first) == sysChar)
-                  {
-                     oss.str("");
-                     oss << " " << tabIt->sat << " ";
-                     size_t obsSize = (Rhead.mapObsTypes.find(sysChar)->second).size();
-                     for(k = 0; k < obsSize; k++)
-                        oss << setw(7) << tabIt->nobs[k];
+   MergeGaps(fc.gapcount, b.gapcount);
+   fc.cachetime.insert(fc.cachetime.end(), b.cachetime.begin(), b.cachetime.end());
+   fc.cache.insert(fc.cache.end(), b.cache.begin(), b.cache.end());
 
-                     oss << setw(7) << 1+int(0.5+(tabIt->end-tabIt->begin)/dt);
+   return true;
+}
 
-                     LOG(INFO) << oss.str() << "  " << printTime(tabIt->begin,fmt)
-                               << " - " << printTime(tabIt->end,fmt);
-                  }
-               }
+//-----------------------------------------------------------------------------
+// Read the data of RINEX 3 file filename in up to nchunks chunks concurrently,
+// and merge them in file order into fc; begin is the end of the header. The
+// result is exactly that of ReadEpochs() on the whole file; when that cannot be
+// assured (cf. FirstEpoch() and MergeCounts()) return false, and the file must
+// be read serially. On success the header time systems are fixed as ReadEpochs()
+// would fix them.
+bool ReadChunks(const string& filename, Rinex3ObsHeader& Rhead, long long begin,
+                int nchunks, int nmaxobs, FileCounts& fc)
+{
+   try
+   {
+      size_t i;
+      vector<long long> starts(ChunkStarts(filename, begin, nchunks));
+      if(starts.size() < 2)
+         return false;
+
+         // find the first epoch; gaps are counted from it
+      Rinex3ObsHeader Rchunk(Rhead);
+      CommonTime first;
+      {
+         Rinex3ObsStream strm;
+         if(!OpenAt(strm, filename, begin) || !FirstEpoch(strm, Rchunk, first))
+            return false;
+      }
 
-               oss.str("");
-               oss << "TOTAL";
-               for(k=0; k<vec.size(); k++) oss << setw(7) << vec[k];
-               LOG(INFO) << oss.str();
+         // read the chunks concurrently
+      vector<FileCounts> counts(starts.size());
+      vector<exception_ptr> errors(starts.size());
+      vector<thread> workers;
+      for(i=0; i<starts.size(); i++)
+      {
+         long long stop(i+1 < starts.size() ? starts[i+1] : -1);
+         workers.push_back(thread([&, i, stop]()
+         {
+            try
+            {
+               Rinex3ObsStream strm;
+               Rinex3ObsHeader Rhd(Rchunk);
+               vector<string> msots;
+               if(!OpenAt(strm, filename, starts[i]))
+               {
+                  counts[i].iret = 1;
+                  return;
+               }
+               counts[i].firstObsTime = first;
+               ReadEpochs(strm, Rhd, stop, false, msots, nmaxobs, counts[i]);
+            }
+            catch(...)
+            {
+               errors[i] = current_exception();
             }
-            LOG(INFO) << "";
+         }));
+      }
+      for(i=0; i<workers.size(); i++)
+         workers[i].join();
+      for(i=0; i<errors.size(); i++)
+         if(errors[i])
+            rethrow_exception(errors[i]);
+
+         // merge in file order, up to the --stop time
+      fc.firstObsTime = first;
+      for(i=0; i<counts.size(); i++)
+      {
+         if(!MergeCounts(fc, counts[i]))
+            return false;
+         if(counts[i].hitEnd)
+            break;
+      }
+
+      Rhead = Rchunk;
+      return true;
+   }
+   catch(Exception& e)
+   {
+      GNSSTK_RETHROW(e);
+   }
+}  // end ReadChunks()
+
+//-----------------------------------------------------------------------------
+// Summarize file C.InputObsFiles[nfile], writing the output to S; outputVersion
+// was set by the header of file nver. The data is read in up to nchunks chunks
+// at once (see ReadChunks()).
+// Return 0 ok, or could not: 1 open file, 2 read header, 3 read data,
+// 4 header invalid or no data
+int SummarizeFile(size_t nfile, double outputVersion, size_t nver, int nchunks,
+                  ostringstream& S)
+{
+   try
+   {
+      Configuration& C(Configuration::Instance());
+      int iret,ii,k;
+      size_t i,j;
+      string tag;
+      ostringstream oss;
+      Rinex3ObsStream istrm;
+      Rinex3ObsHeader Rhead, Rheadout;
+
+         // If command line specified P1/P2 are to be considered
+         // as Y-code, set the Rinex3ObsHeader flag to indicate such.
+      if (C.ycode)
+      {
+         Rhead.PisY = true;
+         Rheadout.PisY = true;
+      }
+
+      string filename(C.InputObsFiles[nfile]);
+
+      // iret is set to 0 ok, or could not: 1 open file, 2 read header, 3 read data
+      iret = 0;
+
+         // open the file ------------------------------------------------
+      istrm.open(filename.c_str(),ios::in);
+      if(!istrm.is_open())
+      {
+         SLOG(S,WARNING) << "Warning : could not open file " << filename;
+         return 1;
+      }
+      istrm.exceptions(ios::failbit);
+
+      // get file size - on windows its different b/c of CRs
+      //char ch;
+      //istrm.seekg(0,ios::end);
+      //streampos filesize(istrm.tellg());
+      //istrm.seekg(0,ios::beg);
+
+         // output file name
+      if(C.quiet)
+      {
+         std::string choppedFN(filename);
+         choppedFN.erase(0,1+filename.find_last_of("/\\"));
+         SLOG(S,INFO) << "+++++++++++++ " << C.PrgmName
+                   << " summary of Rinex obs file " << choppedFN
+                   << " +++++++++++++";
+      }
+      else if(!C.brief)
+      {
+         SLOG(S,INFO) << "+++++++++++++ " << C.PrgmName
+                   << " summary of Rinex obs file " << filename
+                   << " +++++++++++++";
+      }
+
+         // read the header ----------------------------------------------
+      try
+      {
+         istrm >> Rhead;
+      }
+      catch(Exception& e)
+      {
+         SLOG(S,WARNING) << "Warning : Failed to read header: " << e.what()
+                      << "\n Header dump follows.";
+         Rhead.dump(S);
+         istrm.close();
+         return 2;
+      }
+      if(Rhead.lastObs.getTimeSystem() != Rhead.firstObs.getTimeSystem())
+         Rhead.lastObs.setTimeSystem(Rhead.firstObs.getTimeSystem());
+
+         // output file name and header
+      if(C.brief)
+      {
+         if(nfile > 0)
+            SLOG(S,INFO) << "";
+         SLOG(S,INFO) << "File name: " << filename
+                   << " (RINEX ver. " << Rhead.version << ")";
+         SLOG(S,INFO) << "Marker name: " << Rhead.markerName;
+         SLOG(S,INFO) << "Antenna type: " << Rhead.antType;
+         SLOG(S,INFO) << "Position (XYZ,m) : " << fixed << setprecision(4)
+                   << Rhead.antennaPosition << ".";
+         SLOG(S,INFO) << "Antenna offset (UEN,m) : " << fixed << setprecision(4)
+                   << Rhead.antennaDeltaHEN << ".";
+      }
+      else if(!C.nohead)
+      {
+         SLOG(S,DEBUG) << "RINEX header:";
+         if(nfile != nver)       // else this file set outputVersion
+            SLOG(S,INFO) << " (Header has version " << Rhead.version
+                     << "; output as version " << outputVersion << ")";
+         Rhead.dump(S,outputVersion);
+      }
+
+      if(!Rhead.isValid())
+      {
+         SLOG(S,INFO) << "Abort: header is invalid.";
+         if(C.quiet)
+         {
+            std::string choppedFN(filename);
+            choppedFN.erase(0,1+filename.find_last_of("/\\"));
+            SLOG(S,INFO) << "\n+++++++++++++ End of RinSum summary of "
+                      << choppedFN << " +++++++++++++";
          }
-         else
+         else if(!C.brief)
+         {
+            SLOG(S,INFO) << "\n+++++++++++++ End of RinSum summary of "
+                      << filename << " +++++++++++++";
+         }
+         return 4;
+      }
+
+         // initialize counting -------------------------------------------
+      int nmaxobs(0);
+      FileCounts fc;
+      int& nepochs(fc.nepochs);
+      int& nauxheads(fc.nauxheads);
+      vector<TableData>& table(fc.table);       // table of counts per sat,obs
+      map<char, vector<int> >& totals(fc.totals);     // totals per system,obs
+      CommonTime& firstObsTime(fc.firstObsTime);
+      CommonTime& lastObsTime(fc.lastObsTime);
+      vector<int>& gapcount(fc.gapcount);
+      vector<CommonTime>& cachetime(fc.cachetime);
+      vector<vector<Rinex3ObsData> >& cache(fc.cache);
+
+         // initialize for all systems in the header
+      map<std::string,vector<RinexObsID> >::const_iterator sit;   // used below often
+      for(sit=Rhead.mapObsTypes.begin(); sit != Rhead.mapObsTypes.end(); ++sit)
+      {
+            // Initialize the vectors contained in the map
+         totals[(sit->first)[0]] = vector<int>((sit->second).size());
+
+         SLOG(S,DEBUG) << "GNSS " << (sit->first) << " is present with "
+                    << (sit->second).size() << " observations...";
+
+            // find the max size of obs list
+         if(int((sit->second).size()) > nmaxobs)
+            nmaxobs = (sit->second).size();
+      }
+
+         // initialize millisecond handler with obstypes and wavelengths
+      vector<string> msots;
+      if(C.doms)
+      {
+         vector<double> waves;
+            // get obs types from header
+         for(sit=Rhead.mapObsTypes.begin(); sit != Rhead.mapObsTypes.end(); ++sit)
+         {
+               // get the system
+            RinexSatID rsid;
+            rsid.fromString(sit->first);
+            SatID sid(rsid);
+               // TD support only GPS currently
+            if(rsid.systemChar() != 'G') continue;
+               // excluded satellites/systems
+            if(find(C.exSats.begin(), C.exSats.end(), rsid) != C.exSats.end())
+               continue;
+               // get the obstypes, prepend the system character
+            for(i=0; i<sit->second.size(); i++)
+            {
+               tag = sit->second[i].asString();       // 3-char obs type
+               if(tag[0] == 'C' || tag[0] == 'L')
+               {
+                     // code and phase only
+                  msots.push_back(string(1,rsid.systemChar())+tag);
+                     // get wavelength ... NB TD Glonass frequency channel not supported
+                  if(tag[0] == 'L')
+                  {
+                     ii = asInt(string(1,tag[1]));
+                     waves.push_back(getWavelength(sid.system, ii));
+                  }
+                  else
+                     waves.push_back(0.0);
+               }
+            }
+         }
+
+         C.msh.setObstypes(msots,waves);
+         SLOG(S,DEBUG) << "Initialize millisecond handler with obs type, wavelength:";
+         for(i=0; i<msots.size(); i++) SLOG(S,DEBUG) << " " << msots[i]
+                                                  << fixed << setprecision(6) << " " << waves[i];
+      }
+
+      if(pLOGstrm == &cout && !C.brief)
+         SLOG(S,INFO) << "\nReading the observation data...";
+
+         // read the data, in chunks if that is possible, else serially
+      bool done(false);
+      if(nchunks > 1 && !C.doms && C.debug < 0 && Rhead.version >= 3)
+      {
+         done = ReadChunks(filename, Rhead, istrm.tellg(), nchunks, nmaxobs, fc);
+         if(!done)
          {
-               // brief output ---------------
-               // output satellites
-            oss.str(""); oss << "SATs(" << table.size() << "):";
-            i = 0;
+            fc.reset();
+            for(sit=Rhead.mapObsTypes.begin(); sit != Rhead.mapObsTypes.end(); ++sit)
+               totals[(sit->first)[0]] = vector<int>((sit->second).size());
+            SLOG(S,DEBUG) << "Read file " << filename << " serially";
+         }
+      }
+      if(!done)
+         ReadEpochs(istrm, Rhead, -1, true, msots, nmaxobs, fc);
+      istrm.close();
+      iret = fc.iret;
+      S << fc.log.str();
+
+         // check that we found some data
+      if(nepochs <= 0)
+      {
+         SLOG(S,INFO) << "File " << filename
+                   << " : no data found. Are time limits wrong?";
+         return 4;
+      }
+
+         // Compute interval -------------------------------------------------
+      const size_t ndtmax=15;
+      double dt, bestdt[ndtmax];
+      int ndt[ndtmax];
+      for(i=0; i<ndtmax; i++)
+         ndt[i] = -1;
+      for(i=0; i<fc.steps.size(); i++)
+         AddTimeStep(fc.steps[i].first, fc.steps[i].second, bestdt, ndt, ndtmax);
+      for(i=1,j=0; i < ndtmax; i++)
+      {
+         if(ndt[i] > ndt[j])
+            j = i;
+         dt = bestdt[j];
+      }
+
+         // Summary info -----------------------------------------------------
+      SLOG(S,INFO) << "Computed interval " << fixed << setw(5) << setprecision(2)
+                << dt << " seconds.";
+      SLOG(S,INFO) << "Computed first epoch: " << printTime(firstObsTime,C.longfmt);
+      SLOG(S,INFO) << "Computed last  epoch: " << printTime(lastObsTime,C.longfmt);
+
+         // compute time span of dataset in days/hours/minutes/seconds
+      oss.str("");
+      oss << "Computed time span: ";
+      double secs = lastObsTime - firstObsTime;
+      int remainder = int(secs);
+      CivilTime delta(firstObsTime);
+      delta.day    = remainder / 86400; remainder %= 86400;
+      delta.hour   = remainder / 3600;  remainder %= 3600;
+      delta.minute = remainder / 60;    remainder %= 60;
+      delta.second = remainder;
+      if(delta.day > 0)
+         oss << delta.day << "d ";
+
+      SLOG(S,INFO) << oss.str() << delta.hour << "h " << delta.minute << "m "
+                << delta.second << "s = " << secs << " seconds.";
+
+      //SLOG(S,INFO) << "Computed file size: " << filesize << " bytes.";
+
+         // Reusing secs, as it is equivalent to the original expression
+         // i = 1+int(0.5+(lastObsTime-firstObsTime)/dt);
+      i = 1+int(0.5 + secs / dt);
+
+      SLOG(S,INFO) << "There were " << nepochs << " epochs ("
+                << fixed << setprecision(2) << double(nepochs*100)/i
+                << "% of " << i << " possible epochs in this timespan) and "
+                << nauxheads << " inline header blocks.";
+
+         // Sort table
+      if(C.sorttime)
+         sort(table.begin(),table.end(),TableBegLessThan());
+      else
+         sort(table.begin(),table.end(),TableSATLessThan());
+
+         // output table
+         // header
+      vector<TableData>::iterator tabIt;
+      if(table.size() > 0)
+         table.begin()->sat.setfill('0');
+
+      if(!C.brief && !C.notab)
+      {
+            // non-brief output ------------
+         SLOG(S,INFO) << "\n      Summary of data available in this file: "
+                   << "(Spans are based on times and interval)";
+         string fmt(C.gpstime ? C.gpsfmt : C.calfmt);
+         j = 0;
+         for(sit=Rhead.mapObsTypes.begin(); sit != Rhead.mapObsTypes.end(); ++sit)
+         {
+            RinexSatID sat(sit->first);
+
+            map<char, vector<int> >::const_iterator totalsIter;
+               // compute grand total first
+            totalsIter = totals.find((sit->first)[0]);
+            const vector<int>& vec = totalsIter->second;
+            for(i=0,k=0; k<vec.size(); k++) i += vec[k];
+            if(i == 0)
+               continue;
+
+               // print the table
+            if(++j > 1)
+               SLOG(S,INFO) << "";
+            SLOG(S,INFO) << "System " << sit->first <<" = "<< sat.systemString() << ":";
+            oss.str("");
+            oss << " Sat\\OT:";
+
+               // print line of RINEX 3 codes
+            for(k=0; k < (sit->second).size(); k++) {
+               RinexObsID rot((sit->second)[k]);
+               oss << setw(k==0?4:7) << rot.asString(outputVersion);
+            }
+            SLOG(S,INFO) << oss.str() << "   Span             Begin time - End time";
+
+               // print the table
             for(tabIt = table.begin(); tabIt != table.end(); ++tabIt)
             {
-               oss << " " << tabIt->sat;
-               if((++i % 20) == 0)
+               std::string sysChar;
+               sysChar += (tabIt->sat).systemChar();
+               if((sit->first) == sysChar)
                {
-                  LOG(INFO) << oss.str();
-                  oss.str(""); i=0;
-                  oss << "SATs ...:";
+                  oss.str("");
+                  oss << " " << tabIt->sat << " ";
+                  size_t obsSize = (Rhead.mapObsTypes.find(sysChar)->second).size();
+                  for(k = 0; k < obsSize; k++)
+                     oss << setw(7) << tabIt->nobs[k];
+
+                  oss << setw(7) << 1+int(0.5+(tabIt->end-tabIt->begin)/dt);
+
+                  SLOG(S,INFO) << oss.str() << "  " << printTime(tabIt->begin,fmt)
+                            << " - " << printTime(tabIt->end,fmt);
                }
             }
-            LOG(INFO) << oss.str();
 
-               // output obs types
-            sit = Rhead.mapObsTypes.begin();
-            for( ; sit != Rhead.mapObsTypes.end(); ++sit)
+            oss.str("");
+            oss << "TOTAL";
+            for(k=0; k<vec.size(); k++) oss << setw(7) << vec[k];
+            SLOG(S,INFO) << oss.str();
+         }
+         SLOG(S,INFO) << "";
+      }
+      else
+      {
+            // brief output ---------------
+            // output satellites
+         oss.str(""); oss << "SATs(" << table.size() << "):";
+         i = 0;
+         for(tabIt = table.begin(); tabIt != table.end(); ++tabIt)
+         {
+            oss << " " << tabIt->sat;
+            if((++i % 20) == 0)
             {
-               string sysCode = (sit->first);
-               const vector<RinexObsID>& vec(sit->second);
+               SLOG(S,INFO) << oss.str();
+               oss.str(""); i=0;
+               oss << "SATs ...:";
+            }
+         }
+         SLOG(S,INFO) << oss.str();
 
-                  // is this system found in the list of sats?
-               map<char, vector<int> >::const_iterator totalsIter;
-               totalsIter = totals.find(sysCode[0]);
-               const vector<int>& vectot = totalsIter->second;
-               for(i=0,k=0; k<vectot.size(); k++) i += vectot[k];
-               if(i == 0)
-                  continue;    // no, skip it
+            // output obs types
+         sit = Rhead.mapObsTypes.begin();
+         for( ; sit != Rhead.mapObsTypes.end(); ++sit)
+         {
+            string sysCode = (sit->first);
+            const vector<RinexObsID>& vec(sit->second);
 
-               oss.str("");
-               oss << "System " << RinexSatID(sysCode).systemString3()
-                   << " Obs types(" << vec.size() << "): ";
+               // is this system found in the list of sats?
+            map<char, vector<int> >::const_iterator totalsIter;
+            totalsIter = totals.find(sysCode[0]);
+            const vector<int>& vectot = totalsIter->second;
+            for(i=0,k=0; k<vectot.size(); k++) i += vectot[k];
+            if(i == 0)
+               continue;    // no, skip it
 
-               for(i=0; i<vec.size(); i++) {
-                  RinexObsID rot(vec[i]);
-                  oss << " " << rot.asString(outputVersion);
-               }
+            oss.str("");
+            oss << "System " << RinexSatID(sysCode).systemString3()
+                << " Obs types(" << vec.size() << "): ";
 
-                  // if RINEX ver. 2, then add ver 2 obstypes in parentheses
-                  //map<string, map<string, RinexObsID> > Rinex3ObsHeader::mapSysR2toR3ObsID
-                  //Rhead.mapSysR2toR3ObsID[sys][ot2] = OT3;
-               if(Rhead.version < 3)
+            for(i=0; i<vec.size(); i++) {
+               RinexObsID rot(vec[i]);
+               oss << " " << rot.asString(outputVersion);
+            }
+
+               // if RINEX ver. 2, then add ver 2 obstypes in parentheses
+               //map<string, map<string, RinexObsID> > Rinex3ObsHeader::mapSysR2toR3ObsID
+               //Rhead.mapSysR2toR3ObsID[sys][ot2] = OT3;
+            if(Rhead.version < 3)
+            {
+               oss << " [v2:";
+               for(i=0; i<vec.size(); i++)
                {
-                  oss << " [v2:";
-                  for(i=0; i<vec.size(); i++)
+                  map<string,RinexObsID>::iterator it;
+                  for(it = Rhead.mapSysR2toR3ObsID[sysCode].begin();
+                      it != Rhead.mapSysR2toR3ObsID[sysCode].end(); ++it)
                   {
-                     map<string,RinexObsID>::iterator it;
-                     for(it = Rhead.mapSysR2toR3ObsID[sysCode].begin();
-                         it != Rhead.mapSysR2toR3ObsID[sysCode].end(); ++it)
+                     if(it->second == vec[i])
                      {
-                        if(it->second == vec[i])
-                        {
-                           oss << " " << it->first;
-                           break;
-                        }
+                        oss << " " << it->first;
+                        break;
                      }
                   }
-                  oss << "]";
                }
-
-               LOG(INFO) << oss.str();
+               oss << "]";
             }
+
+            SLOG(S,INFO) << oss.str();
          }
+      }
 
-            // gaps
-         if(C.dogaps)
+         // gaps
+      if(C.dogaps)
+      {
+            // summary of gaps using count
+         oss.str("");
+         oss << "Summary of gaps (vs count) in the data in this file, "
+             << "assuming dt = " << C.dt << " sec.\n";
+         if(C.dt != dt)
+            oss << " Warning - computed dt does not match input dt\n";
+         oss << " First epoch = " << printTime(firstObsTime,C.longfmt)
+             << " and last epoch = " << printTime(lastObsTime,C.longfmt) << endl;
+         oss << "    Sat    beg - end (count,size) ... "
+             << "[count = # of dt's from first epoch]\n";
+            // print for timetags = all sats
+         k = gapcount.size()-1;               // size() is at least 2
+         oss << "GAP ALL " << setw(5) << gapcount[0]
+             << " - " << setw(5) << gapcount[k];
+
+            // NB DO NOT make ii size_t
+         for(ii=1; ii<=k-2; ii+=2)
+            oss << " (" << gapcount[ii]+1                          // begin of gap
+                << "," << gapcount[ii+1]-gapcount[ii]-1 << ")";   // size
+         oss << endl;
+
+            // loop over sats
+         for(tabIt = table.begin(); tabIt != table.end(); ++tabIt)
          {
-               // summary of gaps using count
-            oss.str("");
-            oss << "Summary of gaps (vs count) in the data in this file, "
-                << "assuming dt = " << C.dt << " sec.\n";
-            if(C.dt != dt)
-               oss << " Warning - computed dt does not match input dt\n";
-            oss << " First epoch = " << printTime(firstObsTime,C.longfmt)
-                << " and last epoch = " << printTime(lastObsTime,C.longfmt) << endl;
-            oss << "    Sat    beg - end (count,size) ... "
-                << "[count = # of dt's from first epoch]\n";
-               // print for timetags = all sats
-            k = C.gapcount.size()-1;               // size() is at least 2
-            oss << "GAP ALL " << setw(5) << C.gapcount[0]
-                << " - " << setw(5) << C.gapcount[k];
-
+            k = tabIt->gapcount.size() - 1;
+            oss << "GAP " << tabIt->sat << " " << setw(5) << tabIt->gapcount[0]
+                << " - " << setw(5) << tabIt->gapcount[k];
                // NB DO NOT make ii size_t
             for(ii=1; ii<=k-2; ii+=2)
-               oss << " (" << C.gapcount[ii]+1                          // begin of gap
-                   << "," << C.gapcount[ii+1]-C.gapcount[ii]-1 << ")";   // size
+               oss << " (" << tabIt->gapcount[ii]+1 << ","      // begin count of gap
+                   << tabIt->gapcount[ii+1]-tabIt->gapcount[ii]-1 << ")";   // size
             oss << endl;
+         }
 
-               // loop over sats
-            for(tabIt = table.begin(); tabIt != table.end(); ++tabIt)
-            {
-               k = tabIt->gapcount.size() - 1;
-               oss << "GAP " << tabIt->sat << " " << setw(5) << tabIt->gapcount[0]
-                   << " - " << setw(5) << tabIt->gapcount[k];
-                  // NB DO NOT make ii size_t
-               for(ii=1; ii<=k-2; ii+=2)
-                  oss << " (" << tabIt->gapcount[ii]+1 << ","      // begin count of gap
-                      << tabIt->gapcount[ii+1]-tabIt->gapcount[ii]-1 << ")";   // size
-               oss << endl;
-            }
-
-            tag = oss.str(); stripTrailing(tag,"\n");
-            LOG(INFO) << tag;
-
-               // summary of gaps using sow
-            oss.str("");
-            double t(static_cast<GPSWeekSecond>(firstObsTime).sow), d(C.dt);
-            oss << "\nSummary of gaps (vs SOW) in the data in this file, assuming dt = "
-                << C.dt << " sec.\n";
-            if(C.dt != dt)
-               oss << " Warning - computed dt does not match input dt\n";
-            oss << " First epoch = " << printTime(firstObsTime,C.longfmt)
-                << " and last epoch = " << printTime(lastObsTime,C.longfmt) << endl;
-            oss << "    Sat      beg -      end (sow,number of missing points)\n";
+         tag = oss.str(); stripTrailing(tag,"\n");
+         SLOG(S,INFO) << tag;
 
-               // print for timetags = all sats
-            k = C.gapcount.size()-1;               // size() is at least 2
-            oss << "GAP ALL " << fixed << setprecision(1) << setw(8) << t+d*C.gapcount[0]
-                << " - " << setw(8) << t+d*C.gapcount[k];
+            // summary of gaps using sow
+         oss.str("");
+         double t(static_cast<GPSWeekSecond>(firstObsTime).sow), d(C.dt);
+         oss << "\nSummary of gaps (vs SOW) in the data in this file, assuming dt = "
+             << C.dt << " sec.\n";
+         if(C.dt != dt)
+            oss << " Warning - computed dt does not match input dt\n";
+         oss << " First epoch = " << printTime(firstObsTime,C.longfmt)
+             << " and last epoch = " << printTime(lastObsTime,C.longfmt) << endl;
+         oss << "    Sat      beg -      end (sow,number of missing points)\n";
+
+            // print for timetags = all sats
+         k = gapcount.size()-1;               // size() is at least 2
+         oss << "GAP ALL " << fixed << setprecision(1) << setw(8) << t+d*gapcount[0]
+             << " - " << setw(8) << t+d*gapcount[k];
+            // NB DO NOT make ii size_t
+         for(ii=1; ii<=k-2; ii+=2)
+            oss << " (" << t+d*(gapcount[ii]+1)                    // begin of gap
+                << "," << gapcount[ii+1]-gapcount[ii]-1 << ")";   // size
+         oss << endl;
+
+            // loop over sats
+         for(tabIt = table.begin(); tabIt != table.end(); ++tabIt)
+         {
+            k = tabIt->gapcount.size() - 1;
+            oss << "GAP " << tabIt->sat << " " << fixed << setprecision(1)
+                << setw(8) << t+d*tabIt->gapcount[0]
+                << " - " << setw(8) << t+d*tabIt->gapcount[k];
                // NB DO NOT make ii size_t
             for(ii=1; ii<=k-2; ii+=2)
-               oss << " (" << t+d*(C.gapcount[ii]+1)                    // begin of gap
-                   << "," << C.gapcount[ii+1]-C.gapcount[ii]-1 << ")";   // size
+               oss << " (" << t+d*(tabIt->gapcount[ii]+1) << ","  // begin sow of gap
+                   << tabIt->gapcount[ii+1]-tabIt->gapcount[ii]-1 << ")";   // size
             oss << endl;
+         }
 
-               // loop over sats
-            for(tabIt = table.begin(); tabIt != table.end(); ++tabIt)
+         tag = oss.str(); stripTrailing(tag,"\n");
+         SLOG(S,INFO) << tag;
+
+            // visibility
+         if(C.vres > 0)
+         {
+               // print visibility graphically, resolution C.vres = counts/character
+            double dn(static_cast<double>(C.vres));
+            oss.str("");
+            oss << "\nVisibility - resolution is " << dn << " epochs = " << dn*C.dt
+                << " seconds.\n";
+            oss << " First epoch = " << printTime(firstObsTime,C.longfmt)
+                << " and last epoch = " << printTime(lastObsTime,C.longfmt) << endl;
+            oss << "VIS ALL ";
+            bool isOn(false);
+            for(k=0,i=0; i<gapcount.size()-1; i+=2)
             {
-               k = tabIt->gapcount.size() - 1;
-               oss << "GAP " << tabIt->sat << " " << fixed << setprecision(1)
-                   << setw(8) << t+d*tabIt->gapcount[0]
-                   << " - " << setw(8) << t+d*tabIt->gapcount[k];
-                  // NB DO NOT make ii size_t
-               for(ii=1; ii<=k-2; ii+=2)
-                  oss << " (" << t+d*(tabIt->gapcount[ii]+1) << ","  // begin sow of gap
-                      << tabIt->gapcount[ii+1]-tabIt->gapcount[ii]-1 << ")";   // size
-               oss << endl;
+               ii = int(double(gapcount[i]/dn));
+               if(ii-k > 0)
+               {
+                  oss << string(ii-k,' ');
+                  k = ii;
+                  isOn = false;
+               }
+               ii = int(double(gapcount[i+1]/dn));
+               if(ii-k > 0)
+               {
+                  if(isOn)
+                  {
+                     oss << "x";
+                     ii--;
+                  }
+                  oss << string(ii-k,'X');
+                  k = ii;
+                  isOn = true;
+               }
             }
+            SLOG(S,INFO) << oss.str();
 
-            tag = oss.str(); stripTrailing(tag,"\n");
-            LOG(INFO) << tag;
+               // timetable of visibility, resolution dn epochs
+               // to get resolution = 1 epoch, remove isOn, kk and //RES=1
+            multimap<int,string> vtab;
 
-               // visibility
-            if(C.vres > 0)
+               // loop over sats
+               //ostringstream ossvt;
+            for(tabIt = table.begin(); tabIt != table.end(); ++tabIt)
             {
-                  // print visibility graphically, resolution C.vres = counts/character
-               double dn(static_cast<double>(C.vres));
                oss.str("");
-               oss << "\nVisibility - resolution is " << dn << " epochs = " << dn*C.dt
-                   << " seconds.\n";
-               oss << " First epoch = " << printTime(firstObsTime,C.longfmt)
-                   << " and last epoch = " << printTime(lastObsTime,C.longfmt) << endl;
-               oss << "VIS ALL ";
-               bool isOn(false);
-               for(k=0,i=0; i<C.gapcount.size()-1; i+=2)
+               oss << "VIS " << tabIt->sat << " ";
+
+               isOn = false;
+               bool first(true);
+               int jj,kk(static_cast<int>(tabIt->gapcount[0]/dn)); // + 0.5);
+               for(k=0,i=0; i<tabIt->gapcount.size()-1; i+=2)
                {
-                  ii = int(double(C.gapcount[i]/dn));
-                  if(ii-k > 0)
+                     // satellite 'off'
+                  j = int(double(tabIt->gapcount[i]/dn));
+                  if(!first)
+                  {
+                     vtab.insert(multimap<int, string>::value_type(
+                                    kk, string("-")+asString(tabIt->sat)));
+                     kk = j;
+                  }
+                  first = false;
+                  jj = j-k;
+                  if(jj > 0)
                   {
-                     oss << string(ii-k,' ');
-                     k = ii;
                      isOn = false;
+                     oss << string(jj,' ');
+                     k = j;
                   }
-                  ii = int(double(C.gapcount[i+1]/dn));
-                  if(ii-k > 0)
+                     // satellite 'on'
+                  j = int(double(tabIt->gapcount[i+1]/dn));
+                  vtab.insert(multimap<int, string>::value_type(
+                                 kk, string("+")+asString(tabIt->sat)));
+                  kk = j;
+                  jj = j-k;
+                  if(jj > 0)
                   {
-                     if(isOn)
+                     if(!isOn)
+                     {
+                        isOn = true;
+                     }
+                     else
                      {
                         oss << "x";
-                        ii--;
+                        jj--;
                      }
-                     oss << string(ii-k,'X');
-                     k = ii;
-                     isOn = true;
+                     oss << string(jj,'X');
+                     k = j;
                   }
                }
-               LOG(INFO) << oss.str();
-
-                  // timetable of visibility, resolution dn epochs
-                  // to get resolution = 1 epoch, remove isOn, kk and //RES=1
-               multimap<int,string> vtab;
+               vtab.insert(multimap<int, string>::value_type(
+                              kk, string("-")+asString(tabIt->sat)));
+               SLOG(S,INFO) << oss.str();
+            }
 
-                  // loop over sats
-                  //ostringstream ossvt;
-               for(tabIt = table.begin(); tabIt != table.end(); ++tabIt)
+            if(C.vistab)
+            {
+               SLOG(S,INFO) << "\n Visibility Timetable - resolution is "
+                         << dn << " epochs = " << dn*C.dt << " seconds.\n"
+                         << " First epoch = " << printTime(firstObsTime,C.longfmt)
+                         << " and last epoch = " << printTime(lastObsTime,C.longfmt) << "\n"
+                         << "     YYYY/MM/DD HH:MM:SS = week d secs-of-wk Xtot count  nX  "
+                         << "seconds nsats visible satellites";
+               j = k = 0;
+               CommonTime ttag(firstObsTime);
+               vector<string> sats;
+               multimap<int,string>::const_iterator vt;
+               vt = vtab.begin();
+               while(vt != vtab.end())
                {
-                  oss.str("");
-                  oss << "VIS " << tabIt->sat << " ";
-
-                  isOn = false;
-                  bool first(true);
-                  int jj,kk(static_cast<int>(tabIt->gapcount[0]/dn)); // + 0.5);
-                  for(k=0,i=0; i<tabIt->gapcount.size()-1; i+=2)
+                  while(vt != vtab.end() && vt->first == k)
                   {
-                        // satellite 'off'
-                     j = int(double(tabIt->gapcount[i]/dn));
-                     if(!first)
+                     string str(vt->second);
+                     if(str[0] == '+')
                      {
-                        vtab.insert(multimap<int, string>::value_type(
-                                       kk, string("-")+asString(tabIt->sat)));
-                        kk = j;
+                           //SLOG(S,INFO) << "Add " << str.substr(1);
+                        sats.push_back(str.substr(1));
                      }
-                     first = false;
-                     jj = j-k;
-                     if(jj > 0)
-                     {
-                        isOn = false;
-                        oss << string(jj,' ');
-                        k = j;
-                     }
-                        // satellite 'on'
-                     j = int(double(tabIt->gapcount[i+1]/dn));
-                     vtab.insert(multimap<int, string>::value_type(
-                                    kk, string("+")+asString(tabIt->sat)));
-                     kk = j;
-                     jj = j-k;
-                     if(jj > 0)
+                     else
                      {
-                        if(!isOn)
+                        vector<string>::iterator fsat;
+                        fsat = find(sats.begin(),sats.end(),str.substr(1));
+                        if(fsat != sats.end())
                         {
-                           isOn = true;
+                           sats.erase(fsat);
                         }
-                        else
-                        {
-                           oss << "x";
-                           jj--;
-                        }
-                        oss << string(jj,'X');
-                        k = j;
                      }
+                     ++vt;
                   }
-                  vtab.insert(multimap<int, string>::value_type(
-                                 kk, string("-")+asString(tabIt->sat)));
-                  LOG(INFO) << oss.str();
-               }
-
-               if(C.vistab)
-               {
-                  LOG(INFO) << "\n Visibility Timetable - resolution is "
-                            << dn << " epochs = " << dn*C.dt << " seconds.\n"
-                            << " First epoch = " << printTime(firstObsTime,C.longfmt)
-                            << " and last epoch = " << printTime(lastObsTime,C.longfmt) << "\n"
-                            << "     YYYY/MM/DD HH:MM:SS = week d secs-of-wk Xtot count  nX  "
-                            << "seconds nsats visible satellites";
-                  j = k = 0;
-                  CommonTime ttag(firstObsTime);
-                  vector<string> sats;
-                  multimap<int,string>::const_iterator vt;
-                  vt = vtab.begin();
-                  while(vt != vtab.end())
-                  {
-                     while(vt != vtab.end() && vt->first == k)
-                     {
-                        string str(vt->second);
-                        if(str[0] == '+')
-                        {
-                              //LOG(INFO) << "Add " << str.substr(1);
-                           sats.push_back(str.substr(1));
-                        }
-                        else
-                        {
-                           vector<string>::iterator fsat;
-                           fsat = find(sats.begin(),sats.end(),str.substr(1));
-                           if(fsat != sats.end())
-                           {
-                              sats.erase(fsat);
-                           }
-                        }
-                        ++vt;
-                     }
 
-                     ttag += (k-j)*C.dt*dn;
+                  ttag += (k-j)*C.dt*dn;
 
-                     if(vt == vtab.end())
-                        break;
+                  if(vt == vtab.end())
+                     break;
 
-                     sort(sats.begin(),sats.end());
+                  sort(sats.begin(),sats.end());
 
-                     oss.str("");
-                     oss << "VTAB " << setw(4) << printTime(ttag,C.longfmt)
-                         << " " << setw(4) << k
-                         << " " << setw(5) << k*C.vres
-                         << " " << setw(3) << vt->first - k
-                         << fixed << setprecision(1)
-                         << " " << setw(8) << (vt->first-k)*C.dt*dn
-                         << " " << setw(5) << sats.size();
-                     for(i=0; i<sats.size(); i++) oss << " " << sats[i];
-                     LOG(INFO) << oss.str();
-
-                     j = k;
-                     k = vt->first;
-                  }
-                  LOG(INFO) << "VTAB " << setw(4) << printTime(ttag,C.longfmt)
-                            << " " << setw(4) << k
-                            << " " << setw(5) << int(0.5+(ttag-firstObsTime)/C.dt)
-                            << " END";
+                  oss.str("");
+                  oss << "VTAB " << setw(4) << printTime(ttag,C.longfmt)
+                      << " " << setw(4) << k
+                      << " " << setw(5) << k*C.vres
+                      << " " << setw(3) << vt->first - k
+                      << fixed << setprecision(1)
+                      << " " << setw(8) << (vt->first-k)*C.dt*dn
+                      << " " << setw(5) << sats.size();
+                  for(i=0; i<sats.size(); i++) oss << " " << sats[i];
+                  SLOG(S,INFO) << oss.str();
+
+                  j = k;
+                  k = vt->first;
                }
+               SLOG(S,INFO) << "VTAB " << setw(4) << printTime(ttag,C.longfmt)
+                         << " " << setw(4) << k
+                         << " " << setw(5) << int(0.5+(ttag-firstObsTime)/C.dt)
+                         << " END";
+            }
 
-            }  // end if C.vres > 0 (user chose vis output)
-         }
+         }  // end if C.vres > 0 (user chose vis output)
+      }
 
-            // output milliseconds
-         if(C.doms)
-         {
-            C.msh.afterAddbeforeFix();
+         // output milliseconds
+      if(C.doms)
+      {
+         C.msh.afterAddbeforeFix();
 
-               // true b/c no fixing, but false b/c editing commands follow
-            LOG(INFO) << C.msh.getFindMessage(false);
+            // true b/c no fixing, but false b/c editing commands follow
+         SLOG(S,INFO) << C.msh.getFindMessage(false);
 
-            vector<string> cmds = C.msh.getEditCommands();
-            for(i=0; i<cmds.size(); i++)
-               LOG(INFO) << cmds[i] << " # edit cmd for millisecond clock adjust";
-            LOG(INFO) << "";
-         }
+         vector<string> cmds = C.msh.getEditCommands();
+         for(i=0; i<cmds.size(); i++)
+            SLOG(S,INFO) << cmds[i] << " # edit cmd for millisecond clock adjust";
+         SLOG(S,INFO) << "";
+      }
 
-            // Warnings ------------------------------------------------------------
-            // there were records out of time order
-         if(cache.size() > 0)
-         {
-            for(i=0; i<cache.size(); i++)
-               LOG(INFO) << " Warning: " << setw(4) << cache[i].size()
-                         << " data records following epoch "
-                         << printTime(cachetime[i],C.calfmt) << " are out of time order,"
-                         << "\n         with epochs " << printTime(cache[i][0].time,C.calfmt)
-                         << " to " << printTime(cache[i][cache[i].size()-1].time,C.calfmt)
-                         << endl;
-         }
+         // Warnings ------------------------------------------------------------
+         // there were records out of time order
+      if(cache.size() > 0)
+      {
+         for(i=0; i<cache.size(); i++)
+            SLOG(S,INFO) << " Warning: " << setw(4) << cache[i].size()
+                      << " data records following epoch "
+                      << printTime(cachetime[i],C.calfmt) << " are out of time order,"
+                      << "\n         with epochs " << printTime(cache[i][0].time,C.calfmt)
+                      << " to " << printTime(cache[i][cache[i].size()-1].time,C.calfmt)
+                      << endl;
+      }
 
-         if((Rhead.valid & Rinex3ObsHeader::validInterval)
-            && fabs(dt-Rhead.interval) > 1.e-3)
-            LOG(INFO) << " Warning - Computed interval is " << setprecision(2)
-                      << dt << " sec, while input header has " << setprecision(2)
-                      << Rhead.interval << " sec.";
+      if((Rhead.valid & Rinex3ObsHeader::validInterval)
+         && fabs(dt-Rhead.interval) > 1.e-3)
+         SLOG(S,INFO) << " Warning - Computed interval is " << setprecision(2)
+                   << dt << " sec, while input header has " << setprecision(2)
+                   << Rhead.interval << " sec.";
 
-         if(C.beginTime == CommonTime::BEGINNING_OF_TIME
-            && fabs(firstObsTime-Rhead.firstObs) > 1.e-8)
-            LOG(INFO) << " Warning - Computed first time does not agree with header";
+      if(C.beginTime == CommonTime::BEGINNING_OF_TIME
+         && fabs(firstObsTime-Rhead.firstObs) > 1.e-8)
+         SLOG(S,INFO) << " Warning - Computed first time does not agree with header";
 
-         if(C.endTime == CommonTime::END_OF_TIME
-            && (Rhead.valid & Rinex3ObsHeader::validLastTime)
-            && fabs(lastObsTime-Rhead.lastObs) > 1.e-8)
-            LOG(INFO) << " Warning - Computed last time does not agree with header";
+      if(C.endTime == CommonTime::END_OF_TIME
+         && (Rhead.valid & Rinex3ObsHeader::validLastTime)
+         && fabs(lastObsTime-Rhead.lastObs) > 1.e-8)
+         SLOG(S,INFO) << " Warning - Computed last time does not agree with header";
 
-            // look for empty systems
-         for(sit=Rhead.mapObsTypes.begin(); sit != Rhead.mapObsTypes.end(); ++sit)
+         // look for empty systems
+      for(sit=Rhead.mapObsTypes.begin(); sit != Rhead.mapObsTypes.end(); ++sit)
+      {
+         map<char,vector<int> >::const_iterator totIt(totals.find(sit->first[0]));
+         const vector<int>& vec(totIt->second);
+         for(i=0,k=0; k<vec.size(); k++)
+            i += vec[k];
+         if(i == 0)
          {
-            map<char,vector<int> >::const_iterator totIt(totals.find(sit->first[0]));
-            const vector<int>& vec(totIt->second);
-            for(i=0,k=0; k<vec.size(); k++)
-               i += vec[k];
-            if(i == 0)
-            {
-               RinexSatID sat(sit->first);
-               if( (find(C.exSats.begin(), C.exSats.end(),
-                         RinexSatID(-1,sat.system)) == C.exSats.end()) // sys not excluded
-                   &&
-                   (C.onlySats.size() > 0 &&
-                    find(C.onlySats.begin(), C.onlySats.end(), // only system
-                         RinexSatID(-1,sat.system)) != C.onlySats.end()) )
-                  LOG(INFO) << " Warning - System " << sit->first << " = "
-                            << sat.systemString() << " should be removed from the header.";
-            }
+            RinexSatID sat(sit->first);
+            if( (find(C.exSats.begin(), C.exSats.end(),
+                      RinexSatID(-1,sat.system)) == C.exSats.end()) // sys not excluded
+                &&
+                (C.onlySats.size() > 0 &&
+                 find(C.onlySats.begin(), C.onlySats.end(), // only system
+                      RinexSatID(-1,sat.system)) != C.onlySats.end()) )
+               SLOG(S,INFO) << " Warning - System " << sit->first << " = "
+                         << sat.systemString() << " should be removed from the header.";
          }
+      }
 
-            // look for obs types that are completely empty
-            // sit declared above map<std::string,vector<RinexObsID> >::const_iterator sit;
-         for(sit=Rhead.mapObsTypes.begin(); sit != Rhead.mapObsTypes.end(); ++sit)
-         {
-               // loop over obs types in header - systems first
-            RinexSatID sat(sit->first);
-            map<char, vector<int> >::const_iterator totalsIter;
-            totalsIter = totals.find((sit->first)[0]);
+         // look for obs types that are completely empty
+         // sit declared above map<std::string,vector<RinexObsID> >::const_iterator sit;
+      for(sit=Rhead.mapObsTypes.begin(); sit != Rhead.mapObsTypes.end(); ++sit)
+      {
+            // loop over obs types in header - systems first
+         RinexSatID sat(sit->first);
+         map<char, vector<int> >::const_iterator totalsIter;
+         totalsIter = totals.find((sit->first)[0]);
 
-               // this vector is printed after "TOTAL" above
-            const vector<int>& totvec = totalsIter->second;
+            // this vector is printed after "TOTAL" above
+         const vector<int>& totvec = totalsIter->second;
 
-               // compute grand total first - skip if this system has no data at all
-            for(i=0,k=0; k<totvec.size(); k++) i += totvec[k];
-            if(i == 0)
-               continue;
+            // compute grand total first - skip if this system has no data at all
+         for(i=0,k=0; k<totvec.size(); k++) i += totvec[k];
+         if(i == 0)
+            continue;
 
-            for(k=0; k<totvec.size(); k++)
+         for(k=0; k<totvec.size(); k++)
+         {
+            if(totvec[k] == 0)
             {
-               if(totvec[k] == 0)
+               tag = string();
+               if(Rhead.version < 3)
                {
-                  tag = string();
-                  if(Rhead.version < 3)
+                  map<string,RinexObsID>::iterator it;
+                  for(it = Rhead.mapSysR2toR3ObsID[sit->first].begin();
+                      it != Rhead.mapSysR2toR3ObsID[sit->first].end(); ++it)
                   {
-                     map<string,RinexObsID>::iterator it;
-                     for(it = Rhead.mapSysR2toR3ObsID[sit->first].begin();
-                         it != Rhead.mapSysR2toR3ObsID[sit->first].end(); ++it)
+                     if(it->second == sit->second[k])
                      {
-                        if(it->second == sit->second[k])
-                        {
-                           tag = string(", ") + it->first + string(" in ver.2");
-                           break;
-                        }
+                        tag = string(", ") + it->first + string(" in ver.2");
+                        break;
                      }
                   }
-                  LOG(INFO) << " Warning - Obs type "
-                            << sit->first << asString((sit->second)[k])
-                            << " (" << sat.systemString()
-                            << " " << asString((sit->second)[k]) << tag
-                            << ") should be removed from header";
                }
+               SLOG(S,INFO) << " Warning - Obs type "
+                         << sit->first << asString((sit->second)[k])
+                         << " (" << sat.systemString()
+                         << " " << asString((sit->second)[k]) << tag
+                         << ") should be removed from header";
             }
          }
+      }
+
+
+      return iret;
+   }
+   catch(Exception& e)
+   {
+      GNSSTK_RETHROW(e);
+   }
+}  // end SummarizeFile()
 
-            // failure due to critical error
-         if(iret < 0)
+//-----------------------------------------------------------------------------
+// Return 0 ok, >0 number of files successfully read, <0 fatal error
+int ProcessFiles()
+{
+   try
+   {
+      Configuration& C(Configuration::Instance());
+      size_t nfile, nfiles(0), nf(C.InputObsFiles.size());
+
+      // output in header.version, unless user requests otherwise; if not, the first
+      // header that is read sets it for all files
+      double outputVersion(C.Rversion);
+      if(C.doCurrRversion) outputVersion = Rinex3ObsBase::currentVersion;
+      size_t nver(nf);
+      if(outputVersion == 0.0 && !C.brief && !C.nohead)
+      {
+         for(nfile=0; nfile<nf; nfile++)
+         {
+            Rinex3ObsStream istrm;
+            Rinex3ObsHeader Rhead;
+            if(C.ycode)
+               Rhead.PisY = true;
+            istrm.open(C.InputObsFiles[nfile].c_str(),ios::in);
+            if(!istrm.is_open())
+               continue;
+            istrm.exceptions(ios::failbit);
+            try
+            {
+               istrm >> Rhead;
+            }
+            catch(Exception& e)
+            {
+               continue;
+            }
+            outputVersion = Rhead.version;
+            nver = nfile;
             break;
+         }
+      }
 
-         if(iret == 0)
-            nfiles++;
+         // summarize the files, several at once with --threads, or a single file
+         // in chunks; each summary is printed in the order of the files
+      int nthreads(C.nthreads);
+      if(C.doms || C.debug > -1)
+         nthreads = 1;
+
+      if(nthreads <= 1 || nf == 1)
+      {
+         for(nfile=0; nfile<nf; nfile++)
+         {
+            ostringstream sum;
+            int iret(SummarizeFile(nfile, outputVersion, nver, nthreads, sum));
+            LOGstrm << sum.str() << flush;
+            if(iret == 0)
+               nfiles++;
+         }
+         return nfiles;
+      }
 
-      }  // end loop over files
+      vector<ostringstream> sums(nf);
+      vector<int> irets(nf,0);
+      vector<bool> done(nf,false);
+      vector<exception_ptr> errors(nf);
+      mutex mtx;
+      condition_variable cv;
+      atomic<size_t> next(0);
+      vector<thread> workers;
+      for(int t=0; t<nthreads && size_t(t)<nf; t++)
+      {
+         workers.push_back(thread([&]()
+         {
+            size_t n;
+            while((n = next++) < nf)
+            {
+               try
+               {
+                  irets[n] = SummarizeFile(n, outputVersion, nver, 1, sums[n]);
+               }
+               catch(...)
+               {
+                  errors[n] = current_exception();
+               }
+               {
+                  lock_guard<mutex> lock(mtx);
+                  done[n] = true;
+               }
+               cv.notify_all();
+            }
+         }));
+      }
 
-      if(iret < 0)
-         return iret;
+         // print each summary as soon as it, and all before it, are done
+      exception_ptr error;
+      for(nfile=0; nfile<nf; nfile++)
+      {
+         {
+            unique_lock<mutex> lock(mtx);
+            cv.wait(lock, [&]() { return bool(done[nfile]); });
+         }
+         if(errors[nfile])
+         {
+            error = errors[nfile];
+            break;
+         }
+         LOGstrm << sums[nfile].str() << flush;
+         sums[nfile].str("");
+         if(irets[nfile] == 0)
+            nfiles++;
+      }
+      for(size_t t=0; t<workers.size(); t++)
+         workers[t].join();
+      if(error)
+         rethrow_exception(error);
 
       return nfiles;
    }
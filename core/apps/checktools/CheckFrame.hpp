@@ -40,6 +40,15 @@
 #define CHECKFRAME_HPP
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <chrono>
 
 #include <gnsstk/CommandOptionWithTimeArg.hpp>
 #include <gnsstk/FileFilterFrame.hpp>
@@ -77,13 +86,17 @@ public:
                     " \"beginning of time\")"),
          eTimeOption('e', "end-time", "End of time range to compare (default"
                      " = \"end of time\")"),
+         threadsOption(0, "threads", "Check files, or chunks of one large"
+                       " file, on this many threads (default = 1)."),
          inputFileOption("Each input file is checked for errors.", true),
          quitOnFirstError(false),
+         threads(1),
          startTime(gnsstk::CommonTime::BEGINNING_OF_TIME),
          endTime(gnsstk::CommonTime::END_OF_TIME)
    {
       timeOption.setMaxCount(1);
       eTimeOption.setMaxCount(1);
+      threadsOption.setMaxCount(1);
       timeOptions.addOption(&timeOption);
       timeOptions.addOption(&eTimeOption);
    }
@@ -104,60 +117,97 @@ public:
          std::cerr << "End time can't precede start time." << std::endl;
          return false;
       }
+      if (threadsOption.getCount())
+      {
+         int n = gnsstk::StringUtils::asInt(threadsOption.getValue()[0]);
+         if (n < 1)
+         {
+            std::cerr << "Number of threads must be positive." << std::endl;
+            return false;
+         }
+         threads = n;
+      }
       return true;
    }
 #pragma clang diagnostic pop
 protected:
+      /// The output and outcome of checking one file.
+   struct FileCheck
+   {
+      FileCheck() : done(false) {}
+      std::ostringstream out;       ///< what is printed for the file
+      std::exception_ptr error;     ///< the error found, if any
+      bool done;
+   };
+
+      /** Check the input files.  With more than one thread, several
+       * files are checked at once, or a single file is checked in
+       * chunks; the output is the same as when checking serially. */
    virtual void process()
    {
       unsigned errors = 0;
       std::vector<std::string> inputFiles = inputFileOption.getValue();
-      std::vector<std::string>::iterator itr = inputFiles.begin();
-      FilterTimeOperator timeFilt(startTime, endTime);
+      size_t nfiles = inputFiles.size();
+      std::vector<FileCheck> checks(nfiles);
 
-      while (itr != inputFiles.end())
+         // check the files on a pool of threads, unless there is only
+         // one file (or thread), which is checked here
+      std::mutex mtx;
+      std::condition_variable cv;
+      std::atomic<size_t> next(0);
+      std::atomic<bool> stop(false);
+      std::vector<std::thread> pool;
+      size_t nworkers = (nfiles > 1 && threads > 1
+                         ? std::min<size_t>(threads, nfiles) : 0);
+      auto work = [&]()
       {
-
-         std::cout << "Checking " << *itr << std::endl;
-         unsigned long recCount = 0;
-         try
+         size_t i;
+         while (!stop && (i = next++) < nfiles)
          {
-
-	    FileStream f((*itr).c_str());
-            f.exceptions(std::ios::failbit);
-            FileData temp;
-            while (f >> temp)
-            {
-               if (!timeFilt(temp))
-                  recCount++;
-            }
-            std::cout << "Read " << recCount << " records."
-                      << std::endl << std::endl;
+            checkFile(inputFiles[i], checks[i], 1);
+            std::lock_guard<std::mutex> lock(mtx);
+            checks[i].done = true;
+            cv.notify_all();
          }
-         catch (gnsstk::Exception& e)
+      };
+      for (size_t t = 0; t < nworkers; t++)
+         pool.push_back(std::thread(work));
+
+         // print the results in input order as they become available
+      for (size_t i = 0; i < nfiles; i++)
+      {
+         if (nworkers == 0)
          {
-            std::cout << e << std::endl << std::endl;
-            ++errors;
-            if (quitOnFirstError)
-               GNSSTK_RETHROW(e);
+            checkFile(inputFiles[i], checks[i], threads);
          }
-         catch (std::exception& e)
+         else
          {
-            std::cout << e.what() << std::endl;
-            ++errors;
-            if (quitOnFirstError)
-               throw e;
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [&]{ return checks[i].done; });
          }
-         catch (...)
+         std::cout << checks[i].out.str() << std::flush;
+
+         if (checks[i].error)
          {
-            std::cout << "unknown exception caught" << std::endl;
             ++errors;
             if (quitOnFirstError)
-               throw;
+            {
+               stop = true;
+               for (size_t t = 0; t < pool.size(); t++)
+                  pool[t].join();
+               try
+               {
+                  std::rethrow_exception(checks[i].error);
+               }
+               catch (gnsstk::Exception& e)
+               {
+                  GNSSTK_RETHROW(e);
+               }
+            }
          }
-
-         itr++;
       }
+      for (size_t t = 0; t < pool.size(); t++)
+         pool[t].join();
 
       if (errors > 0)
       {
@@ -169,6 +219,197 @@ protected:
       }
    }
 
+      /** Check one file, writing what is to be printed for it to
+       * check.out and keeping the error, if any, in check.error.
+       * @param[in] fname the file to check.
+       * @param[in,out] check the output and outcome.
+       * @param[in] nthreads the number of threads on which to check
+       *   chunks of the file, if it can be split. */
+   void checkFile(const std::string& fname, FileCheck& check,
+                  unsigned nthreads)
+   {
+      check.out << "Checking " << fname << std::endl;
+      try
+      {
+         auto startClock = std::chrono::steady_clock::now();
+         unsigned long recCount = 0;
+         if (nthreads < 2 || !countChunks(fname, nthreads, recCount))
+            recCount = countRecords(fname, 0, -1);
+         check.out << "Read " << recCount << " records." << std::endl;
+
+         if (verboseLevel)
+         {
+            std::chrono::duration<double> dt =
+               std::chrono::steady_clock::now() - startClock;
+            std::ifstream in(fname.c_str(), std::ios::binary|std::ios::ate);
+            double bytes = static_cast<double>(in.tellg());
+            double secs = std::max(dt.count(), 1.e-9);
+            check.out << "Checked " << bytes/1.e6 << " MB in " << secs
+                      << " s: " << recCount/secs << " records/s, "
+                      << bytes/1.e6/secs << " MB/s." << std::endl;
+         }
+         check.out << std::endl;
+      }
+      catch (gnsstk::Exception& e)
+      {
+         check.out << e << std::endl << std::endl;
+         check.error = std::current_exception();
+      }
+      catch (std::exception& e)
+      {
+         check.out << e.what() << std::endl;
+         check.error = std::current_exception();
+      }
+      catch (...)
+      {
+         check.out << "unknown exception caught" << std::endl;
+         check.error = std::current_exception();
+      }
+   }
+
+      /** Read the records of fname that start in [begin,end) and count
+       * those within the time limits.  If begin is 0 the whole file is
+       * read from the start, otherwise the header is read and reading
+       * starts at begin.  If end < 0 reading stops at the end of file.
+       * @throw gnsstk::Exception or std::exception on a read error. */
+   unsigned long countRecords(const std::string& fname, std::streamoff begin,
+                              std::streamoff end)
+   {
+      FilterTimeOperator timeFilt(startTime, endTime);
+      unsigned long recCount = 0;
+      FileStream f(fname.c_str());
+      f.exceptions(std::ios::failbit);
+      if (begin > 0)
+      {
+         f >> f.header;
+         f.seekg(begin);
+      }
+      FileData temp;
+      while ((end < 0 || static_cast<std::streamoff>(f.tellg()) < end) &&
+             (f >> temp))
+      {
+         if (!timeFilt(temp))
+            recCount++;
+      }
+      return recCount;
+   }
+
+      /** Count the records of fname by checking chunks of it
+       * concurrently on nthreads threads.
+       * @param[out] recCount the number of records within the time
+       *   limits, as counted by countRecords() for the whole file.
+       * @return false if the file cannot be split or any chunk has an
+       *   error; the file must then be read serially, which also
+       *   reports the error and where it is. */
+   bool countChunks(const std::string& fname, unsigned nthreads,
+                    unsigned long& recCount)
+   {
+      std::vector<std::streamoff> bounds;
+      if (!findChunks(fname, nthreads, bounds))
+         return false;
+
+      size_t nchunks = bounds.size()-1;
+      std::vector<unsigned long> counts(nchunks, 0);
+      std::vector<char> failed(nchunks, 0);
+      std::atomic<size_t> next(0);
+      auto work = [&]()
+      {
+         size_t k;
+         while ((k = next++) < nchunks)
+         {
+            try
+            {
+               counts[k] = countRecords(fname, bounds[k], bounds[k+1]);
+            }
+            catch (...)
+            {
+               failed[k] = 1;
+            }
+         }
+      };
+      std::vector<std::thread> pool;
+      for (size_t t = 0; t < std::min<size_t>(nthreads, nchunks); t++)
+         pool.push_back(std::thread(work));
+      for (size_t t = 0; t < pool.size(); t++)
+         pool[t].join();
+
+      recCount = 0;
+      for (size_t k = 0; k < nchunks; k++)
+      {
+         if (failed[k])
+            return false;
+         recCount += counts[k];
+      }
+      return true;
+   }
+
+      /** Split fname after its header into chunks of about equal size
+       * that start on lines beginning with recordMarker().
+       * @param[out] bounds the offsets at which the chunks start,
+       *   followed by the file size.
+       * @return false if the file should not be split. */
+   bool findChunks(const std::string& fname, unsigned nthreads,
+                   std::vector<std::streamoff>& bounds)
+   {
+      const std::streamoff minChunkSize = 65536;
+      FileStream f(fname.c_str());
+      char marker = 0;
+      std::streamoff first = 0, size = 0;
+      try
+      {
+         f.exceptions(std::ios::failbit);
+         f >> f.header;
+         marker = recordMarker(f);
+         first = f.tellg();
+         f.seekg(0, std::ios::end);
+         size = f.tellg();
+      }
+      catch (...)
+      {
+            // let the serial read report it
+         return false;
+      }
+      if (marker == 0)
+         return false;
+      std::streamoff nchunks = std::min<std::streamoff>(
+         4*nthreads, (size-first)/minChunkSize);
+      if (nchunks < 2)
+         return false;
+
+         // look for the first record after each equal division of the file
+      std::ifstream scan(fname.c_str(), std::ios::binary);
+      std::string line;
+      bounds.push_back(first);
+      for (std::streamoff k = 1; k < nchunks; k++)
+      {
+         scan.clear();
+         scan.seekg(first + (size-first)*k/nchunks);
+         std::getline(scan, line);
+         while (true)
+         {
+            std::streamoff at = scan.tellg();
+            if (!std::getline(scan, line))
+               break;
+            if (!line.empty() && line[0] == marker)
+            {
+               if (at > bounds.back())
+                  bounds.push_back(at);
+               break;
+            }
+         }
+      }
+      bounds.push_back(size);
+      return (bounds.size() > 2);
+   }
+
+      /** Return the character that starts every record line of a file
+       * whose header has been read into f, so that the file can be
+       * split between records, or 0 if it cannot be split. */
+   virtual char recordMarker(const FileStream& f) const
+   {
+      return 0;
+   }
+
       /// Quit on first error.
    gnsstk::CommandOptionNoArg firstErrorOption;
       /// start time for record counting
@@ -177,9 +418,12 @@ protected:
    gnsstk::CommandOptionWithSimpleTimeArg eTimeOption;
       /// if either of the time options are set
    gnsstk::CommandOptionGroupOr timeOptions;
+      /// number of threads
+   gnsstk::CommandOptionWithNumberArg threadsOption;
    gnsstk::CommandOptionRest inputFileOption;
 
    bool quitOnFirstError;
+   unsigned threads;
    gnsstk::CommonTime startTime, endTime;
 
 };
@@ -64,6 +64,8 @@
  * \dicdef{Start of time range to compare (default = "beginning of time")}
  * \dicterm{-e, \--end-time=\argarg{TIME}}
  * \dicdef{End of time range to compare (default = "end of time")}
+ * \dicterm{\--threads=\argarg{NUM}}
+ * \dicdef{Check files on this many threads (default = 1).}
  * \enddictionary
  *
  * Time may be specified in one of three formats:
@@ -64,6 +64,12 @@
  * \dicdef{Start of time range to compare (default = "beginning of time")}
  * \dicterm{-e, \--end-time=\argarg{TIME}}
  * \dicdef{End of time range to compare (default = "end of time")}
+ * \dicterm{\--threads=\argarg{NUM}}
+ * \dicdef{Check files, or chunks of one large file, on this many threads
+ *   (default = 1).  A single RINEX 3 file is split at epoch lines and the
+ *   chunks checked concurrently; if a chunk has an error the file is
+ *   read again serially to report it.  With -v the throughput is also
+ *   reported.}
  * \enddictionary
  *
  * Time may be specified in one of three formats:
@@ -99,13 +105,28 @@
 using namespace std;
 using namespace gnsstk;
 
+/// CheckFrame for RINEX obs files, which can be split at RINEX 3 epoch lines.
+class RowCheckFrame : public CheckFrame<Rinex3ObsStream, Rinex3ObsData>
+{
+public:
+   RowCheckFrame(char* arg0)
+         : CheckFrame<Rinex3ObsStream, Rinex3ObsData>(arg0,
+                                                      std::string("Rinex Obs"))
+   {}
+
+protected:
+   char recordMarker(const Rinex3ObsStream& f) const override
+   {
+      return (f.header.version >= 3 ? '>' : 0);
+   }
+};
+
 int main(int argc, char* argv[])
 {
 #include "NewNavInit.h"
    try
    {
-      CheckFrame<Rinex3ObsStream, Rinex3ObsData> cf(argv[0],
-                                                  std::string("Rinex Obs"));
+      RowCheckFrame cf(argv[0]);
 
       if (!cf.initialize(argc, argv))
          return cf.exitCode;
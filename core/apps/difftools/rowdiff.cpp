@@ -63,6 +63,8 @@
  * \dicdef{End of time range to compare (default = "end of time")}
  * \dicterm{-p, \--precision=\argarg{ARG}}
  * \dicdef{Limit data comparison to \argarg{ARL} decimal places. Default = 5}
+ * \dicterm{-w, \--window=\argarg{N}}
+ * \dicdef{Look ahead N epochs in each file for epochs out of time order. Default = 64}
  * \enddictionary
  *
  * Time may be specified in one of three formats:
@@ -94,9 +96,24 @@
  * \ref rnwdiff, \ref rmwdiff
  */
 
-/// This utility assumes that epochs are in ascending time order
+/// This utility compares the files one epoch at a time, each file
+/// being read on a thread of its own, so only a window of epochs is in
+/// memory at once.  Epochs out of time order by no more than the
+/// look-ahead window (-w) are put back in order; if an epoch is further
+/// out of order than that, it falls back to reading both files into
+/// memory and comparing them whole.  The differences are held until
+/// the files have been read, so the fallback can discard them.
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 #include "NewNavInc.h"
+#include <gnsstk/FileFilter.hpp>
 #include <gnsstk/FileFilterFrameWithHeader.hpp>
 #include <gnsstk/Rinex3ObsStream.hpp>
 #include <gnsstk/Rinex3ObsFilterOperators.hpp>
@@ -109,6 +126,142 @@
 using namespace std;
 using namespace gnsstk;
 
+/// Read the epochs of a RINEX obs stream on a thread of its own, and
+/// pass them on in time order, sorting those that are out of order by
+/// no more than the look-ahead window.
+class EpochReader
+{
+public:
+      /** Start reading.
+       * @param[in,out] strm the stream, positioned after the header.
+       * @param[in] window the number of epochs to look ahead. */
+   EpochReader(Rinex3ObsStream& strm, size_t window);
+      /// Stop reading, if not at the end of the file.
+   ~EpochReader();
+
+      /** Get the next epoch in time order.
+       * @param[out] data the epoch.
+       * @return false at the end of the file, or if an epoch is out
+       *   of time order by more than the window; then outOfOrder is
+       *   set.
+       * @throw Exception if the reader thread failed. */
+   bool next(Rinex3ObsData& data);
+
+      /// true if an epoch was out of order by more than the window
+   bool outOfOrder;
+
+private:
+      /// the reader thread: read epochs into queue until the end
+   void read();
+      /// take the next epoch read, in file order; false at the end
+   bool pop(Rinex3ObsData& data);
+
+   Rinex3ObsStream& strm;
+   size_t window;
+      /// epochs read, not yet taken; at most maxQueue
+   std::deque<Rinex3ObsData> queue;
+   static const size_t maxQueue = 32;
+   bool done, quit;
+   std::exception_ptr error;
+   std::mutex mtx;
+   std::condition_variable cvRead, cvTake;
+   std::thread reader;
+      /// the look-ahead, sorted by time, and the time of the last
+      /// epoch passed on
+   std::deque<Rinex3ObsData> ahead;
+   CommonTime last;
+};
+
+EpochReader::EpochReader(Rinex3ObsStream& s, size_t w)
+      : outOfOrder(false), strm(s), window(w), done(false), quit(false),
+        last(CommonTime::BEGINNING_OF_TIME)
+{
+   reader = std::thread(&EpochReader::read, this);
+}
+
+EpochReader::~EpochReader()
+{
+   {
+      std::lock_guard<std::mutex> lock(mtx);
+      quit = true;
+   }
+   cvTake.notify_all();
+   reader.join();
+}
+
+void EpochReader::read()
+{
+   try
+   {
+      Rinex3ObsData data;
+      while (strm >> data)
+      {
+         std::unique_lock<std::mutex> lock(mtx);
+         cvTake.wait(lock, [this]{ return quit || queue.size() < maxQueue; });
+         if (quit)
+         {
+            break;
+         }
+         queue.push_back(data);
+         cvRead.notify_one();
+      }
+   }
+   catch (...)
+   {
+      std::lock_guard<std::mutex> lock(mtx);
+      error = std::current_exception();
+   }
+   std::lock_guard<std::mutex> lock(mtx);
+   done = true;
+   cvRead.notify_one();
+}
+
+bool EpochReader::pop(Rinex3ObsData& data)
+{
+   std::unique_lock<std::mutex> lock(mtx);
+   cvRead.wait(lock, [this]{ return done || !queue.empty(); });
+   if (queue.empty())
+   {
+      if (error)
+      {
+         std::rethrow_exception(error);
+      }
+      return false;
+   }
+   data = std::move(queue.front());
+   queue.pop_front();
+   cvTake.notify_one();
+   return true;
+}
+
+bool EpochReader::next(Rinex3ObsData& data)
+{
+      // fill the look-ahead, keeping it in time order and epochs of
+      // the same time in file order
+   Rinex3ObsData rec;
+   while (ahead.size() <= window && pop(rec))
+   {
+      if (rec.time < last)
+      {
+         outOfOrder = true;
+         return false;
+      }
+      auto it = std::upper_bound(ahead.begin(), ahead.end(), rec,
+                                 [](const Rinex3ObsData& a,
+                                    const Rinex3ObsData& b)
+                                 { return a.time < b.time; });
+      ahead.insert(it, std::move(rec));
+   }
+   if (ahead.empty())
+   {
+      return false;
+   }
+   data = std::move(ahead.front());
+   ahead.pop_front();
+   last = data.time;
+   return true;
+}
+
 class ROWDiff : public DiffFrame
 {
 public:
@@ -119,17 +272,44 @@ public:
    ROWDiff(char* arg0)
          : DiffFrame(arg0, std::string("RINEX Obs")),
            precisionOption('p',"precision","Limit data comparison to n decimal"
-                           " places. Default = 5")
+                           " places. Default = 5"),
+           windowOption('w',"window","Look ahead n epochs in each file for"
+                        " epochs out of time order. Default = 64")
    {}
    virtual bool initialize(int argc, char* argv[]) noexcept;
 
 protected:
    virtual void process();
    gnsstk::CommandOptionWithAnyArg precisionOption;
+   gnsstk::CommandOptionWithNumberArg windowOption;
 
 private:
+      /** Difference the two files one epoch at a time, reading both
+       * streams concurrently in time order (see EpochReader), and
+       * writing the differences of each epoch before going on.
+       * @param[in,out] ros1 stream for file 1, positioned after the header.
+       * @param[in,out] ros2 stream for file 2, positioned after the header.
+       * @param[out] os the differences are written here.
+       * @param[out] diffs set true if any differences were found.
+       * @return false if either file is out of time order by more
+       *   than the window; the differences are then incomplete. */
+   bool streamDiff(Rinex3ObsStream& ros1, Rinex3ObsStream& ros2,
+                   std::ostream& os, bool& diffs);
+
+      /** Write the half-diffs first (file 1 not in file 2) and second
+       * (file 2 not in file 1), both sorted by time, to os. */
+   void outputDiffs(std::ostream& os,
+                    const std::list<Rinex3ObsData>& first,
+                    const std::list<Rinex3ObsData>& second);
+
    int precision;
    static const int DEFAULT_PRECISION = 5;
+   size_t window;
+   static const size_t DEFAULT_WINDOW = 64;
+      /// headers, with obs types mapped to match each other
+   Rinex3ObsHeader header1, header2;
+      /// obs types that are in both files
+   Rinex3ObsHeader::RinexObsMap intersectRom;
 };
 
 bool ROWDiff::initialize(int argc, char* argv[]) noexcept
@@ -146,27 +326,49 @@ bool ROWDiff::initialize(int argc, char* argv[]) noexcept
    {
       precision = DEFAULT_PRECISION;
    }
+   if (windowOption.getCount())
+   {
+      window = atoi(windowOption.getValue()[0].c_str());
+   }
+   else
+   {
+      window = DEFAULT_WINDOW;
+   }
    return true;
 }
 
 void ROWDiff::process()
 {
-   gnsstk::FileFilterFrameWithHeader<Rinex3ObsStream, Rinex3ObsData, Rinex3ObsHeader>
-      ff1(inputFileOption.getValue()[0]), ff2(inputFileOption.getValue()[1]);
+   string fname1(inputFileOption.getValue()[0]),
+      fname2(inputFileOption.getValue()[1]);
+   Rinex3ObsStream ros1(fname1.c_str()), ros2(fname2.c_str());
 
-      // no data?  FIX make this program faster.. if one file
-      // doesn't exist, there's little point in reading any.
-   if (ff1.emptyHeader())
+      // read the headers; leave the streams positioned at the first epoch
+   auto readHeader = [](Rinex3ObsStream& strm, Rinex3ObsHeader& hdr)
    {
-      cerr << "No header information for " << inputFileOption.getValue()[0]
-           << endl;
+      try
+      {
+         return static_cast<bool>(strm && (strm >> hdr));
+      }
+      catch (...)
+      {
+         return false;
+      }
+   };
+   bool emptyHeader1 = !readHeader(ros1, header1);
+   bool emptyHeader2 = !readHeader(ros2, header2);
+
+      // no data?  if one file doesn't exist, there's little point in
+      // reading any.
+   if (emptyHeader1)
+   {
+      cerr << "No header information for " << fname1 << endl;
    }
-   if (ff2.emptyHeader())
+   if (emptyHeader2)
    {
-      cerr << "No header information for " << inputFileOption.getValue()[1]
-           << endl;
+      cerr << "No header information for " << fname2 << endl;
    }
-   if (ff1.emptyHeader() || ff2.emptyHeader())
+   if (emptyHeader1 || emptyHeader2)
    {
       cerr << "Check that files exist." << endl;
       cerr << "diff failed." << endl;
@@ -176,13 +378,6 @@ void ROWDiff::process()
 
       // determine whether the two input files have the same observation types
 
-   Rinex3ObsHeader header1, header2;
-   Rinex3ObsStream ros1(inputFileOption.getValue()[0]),
-      ros2(inputFileOption.getValue()[1]);
-
-   ros1 >> header1;
-   ros2 >> header2;
-
       // find the obs data intersection
 
    if (header1.version != header2.version)
@@ -201,7 +396,6 @@ void ROWDiff::process()
             r3ov.push_back(header2.mapSysR2toR3ObsID["G"][r2it]);
          }
          header1.mapObsTypes["G"] = r3ov;
-         ff1.frontHeader().mapObsTypes["G"] = r3ov;
       }
       else if (header2.version < 3 && header1.version >= 3)
       {
@@ -212,7 +406,6 @@ void ROWDiff::process()
             r3ov.push_back(header1.mapSysR2toR3ObsID["G"][r2it]);
          }
          header2.mapObsTypes["G"] = r3ov;
-         ff2.frontHeader().mapObsTypes["G"] = r3ov;
       }
    }
 
@@ -220,7 +413,6 @@ void ROWDiff::process()
       // add those to intersectionRom/ diffRom respectively.
    cout << "Comparing the following fields:" << endl;
    Rinex3ObsHeader::RinexObsMap diffRom;
-   Rinex3ObsHeader::RinexObsMap intersectRom;
    for (const auto& mit : header1.mapObsTypes)
    {
       string sysChar = mit.first;
@@ -275,17 +467,33 @@ void ROWDiff::process()
       }
    }
 
-   std::list<Rinex3ObsData> a =
-      ff1.halfDiff(ff2,Rinex3ObsDataOperatorLessThanFull(intersectRom),
-                   precision);
-   std::list<Rinex3ObsData> b =
-      ff2.halfDiff(ff1, Rinex3ObsDataOperatorLessThanFull(intersectRom),
-                   precision);
-
-   pair< list<Rinex3ObsData>, list<Rinex3ObsData> > difflist =
-      pair< list<Rinex3ObsData>, list<Rinex3ObsData> >( a, b);
+      // Difference the files one epoch at a time, holding the output
+      // until both have been read in time order (to within the
+      // window); otherwise compare the whole files.
+   bool diffs = false;
+   ostringstream oss;
+   if (streamDiff(ros1, ros2, oss, diffs))
+   {
+      cout << oss.str();
+   }
+   else
+   {
+      cerr << "Input is not in time order, to within the look-ahead"
+           << " window; comparing the whole files." << endl;
+      gnsstk::FileFilterFrameWithHeader<Rinex3ObsStream, Rinex3ObsData,
+                                        Rinex3ObsHeader>
+         ff1(fname1), ff2(fname2);
+      std::list<Rinex3ObsData> a =
+         ff1.halfDiff(ff2,Rinex3ObsDataOperatorLessThanFull(intersectRom),
+                      precision);
+      std::list<Rinex3ObsData> b =
+         ff2.halfDiff(ff1, Rinex3ObsDataOperatorLessThanFull(intersectRom),
+                      precision);
+      diffs = !(a.empty() && b.empty());
+      outputDiffs(cout, a, b);
+   }
 
-   if (difflist.first.empty() && difflist.second.empty())
+   if (!diffs)
    {
          //Indicate to the user, before exiting, that rowdiff
          //performed properly and no differences were found.
@@ -297,53 +505,106 @@ void ROWDiff::process()
 
       // differences found
    exitCode = DIFFS_CODE;
+}
 
-   auto firstDiffItr = difflist.first.begin();
-   auto secondDiffItr = difflist.second.begin();
-   while ((firstDiffItr != difflist.first.end()) ||
-          (secondDiffItr != difflist.second.end()))
+bool ROWDiff::streamDiff(Rinex3ObsStream& ros1, Rinex3ObsStream& ros2,
+                         std::ostream& os, bool& diffs)
+{
+   EpochReader rd1(ros1, window), rd2(ros2, window);
+   Rinex3ObsData data1, data2;
+   bool have1 = rd1.next(data1);
+   bool have2 = rd2.next(data2);
+   diffs = false;
+
+   while (have1 || have2)
+   {
+         // the next epoch in either file, and all of its records
+      CommonTime epoch = ((have1 && (!have2 || data1.time < data2.time))
+                          ? data1.time : data2.time);
+      FileFilter<Rinex3ObsData> ep1, ep2;
+      while (have1 && data1.time == epoch)
+      {
+         ep1.addData(data1);
+         have1 = rd1.next(data1);
+      }
+      while (have2 && data2.time == epoch)
+      {
+         ep2.addData(data2);
+         have2 = rd2.next(data2);
+      }
+      if (rd1.outOfOrder || rd2.outOfOrder)
+      {
+         return false;
+      }
+
+         // the same half-diffs as for the whole files, restricted to
+         // this epoch; Rinex3ObsDataOperatorLessThanFull orders by time
+         // first, so they are the same records in the same order.
+      std::list<Rinex3ObsData> a =
+         ep1.halfDiff(ep2,Rinex3ObsDataOperatorLessThanFull(intersectRom),
+                      precision);
+      std::list<Rinex3ObsData> b =
+         ep2.halfDiff(ep1, Rinex3ObsDataOperatorLessThanFull(intersectRom),
+                      precision);
+      if (!a.empty() || !b.empty())
+      {
+         diffs = true;
+         outputDiffs(os, a, b);
+      }
+   }
+   return true;
+}
+
+void ROWDiff::outputDiffs(std::ostream& os,
+                          const std::list<Rinex3ObsData>& first,
+                          const std::list<Rinex3ObsData>& second)
+{
+   auto firstDiffItr = first.begin();
+   auto secondDiffItr = second.begin();
+   while ((firstDiffItr != first.end()) ||
+          (secondDiffItr != second.end()))
    {
          //Epoch in both files
          //Epoch only in first file
-      if ((firstDiffItr != difflist.first.end()) &&
-          ((secondDiffItr == difflist.second.end()) ||
+      if ((firstDiffItr != first.end()) &&
+          ((secondDiffItr == second.end()) ||
            (firstDiffItr->time < secondDiffItr->time)))
       {
          for (const auto& firstObsItr : firstDiffItr->obs)
          {
-            cout << "<" << setw(3) << (static_cast<YDSTime>(firstDiffItr->time))
-                 << ' ' << setw(2) << firstObsItr.first << ' ';
+            os << "<" << setw(3) << (static_cast<YDSTime>(firstDiffItr->time))
+               << ' ' << setw(2) << firstObsItr.first << ' ';
             string sysString = string(1,firstObsItr.first.systemChar());
             for (const auto& romIt : intersectRom[sysString])
             {
                size_t idx = header1.getObsIndex(sysString, romIt);
-               cout << setw(15) << setprecision(3) << fixed
-                    << firstObsItr.second[idx].data << ' ' << romIt.asString()
-                    << ' ';
+               os << setw(15) << setprecision(3) << fixed
+                  << firstObsItr.second[idx].data << ' ' << romIt.asString()
+                  << ' ';
             }
-            cout << endl;
+            os << endl;
          }
          firstDiffItr++;
       }
          //Epoch only in second file
-      else if ((secondDiffItr != difflist.second.end()) &&
-               ((firstDiffItr == difflist.first.end()) ||
+      else if ((secondDiffItr != second.end()) &&
+               ((firstDiffItr == first.end()) ||
                 (secondDiffItr->time < firstDiffItr->time)))
       {
          for (const auto& secondObsItr : secondDiffItr->obs)
          {
-            cout << ">" << setw(3)
-                 << (static_cast<YDSTime>(secondDiffItr->time))
-                 << ' ' << setw(2) << secondObsItr.first << ' ';
+            os << ">" << setw(3)
+               << (static_cast<YDSTime>(secondDiffItr->time))
+               << ' ' << setw(2) << secondObsItr.first << ' ';
             string sysString = string(1,secondObsItr.first.systemChar());
             for (const auto& romIt : intersectRom[sysString])
             {
                size_t idx = header2.getObsIndex(sysString, romIt);
-               cout << setw(15) << setprecision(3) << fixed
-                    << secondObsItr.second[idx].data << ' '
-                    << romIt.asString() << ' ';
+               os << setw(15) << setprecision(3) << fixed
+                  << secondObsItr.second[idx].data << ' '
+                  << romIt.asString() << ' ';
             }
-            cout << endl;
+            os << endl;
          }
          secondDiffItr++;
       }
@@ -359,17 +620,17 @@ void ROWDiff::process()
             if (firstObsItr->first == secondObsItr->first)
             {
                string sysString = string(1,firstObsItr->first.systemChar());
-               cout << "-" << setw(3)
-                    << (static_cast<YDSTime>(firstDiffItr->time))
-                    << ' ' << setw(2) << firstObsItr->first << ' ';
+               os << "-" << setw(3)
+                  << (static_cast<YDSTime>(firstDiffItr->time))
+                  << ' ' << setw(2) << firstObsItr->first << ' ';
                for (const auto& romIt : intersectRom[sysString])
                {
                   size_t idx1 = header1.getObsIndex(sysString, romIt);
                   size_t idx2 = header2.getObsIndex(sysString, romIt);
-                  cout << setw(15) << setprecision(3) << fixed
-                       << (firstObsItr->second[idx1].data -
-                           secondObsItr->second[idx2].data)
-                       << ' ' << romIt.asString() << ' ';
+                  os << setw(15) << setprecision(3) << fixed
+                     << (firstObsItr->second[idx1].data -
+                         secondObsItr->second[idx2].data)
+                     << ' ' << romIt.asString() << ' ';
                }
                firstObsItr++;
                secondObsItr++;
@@ -380,15 +641,15 @@ void ROWDiff::process()
                       (firstObsItr->first.id < secondObsItr->first.id)))
             {
                string sysString = string(1,firstObsItr->first.systemChar());
-               cout << "<" << setw(3)
-                    << (static_cast<YDSTime>(firstDiffItr->time))
-                    << ' ' << setw(2) << firstObsItr->first << ' ';
+               os << "<" << setw(3)
+                  << (static_cast<YDSTime>(firstDiffItr->time))
+                  << ' ' << setw(2) << firstObsItr->first << ' ';
                for (const auto& romIt : intersectRom[sysString])
                {
                   size_t idx = header1.getObsIndex(sysString, romIt);
-                  cout << setw(15) << setprecision(3) << fixed
-                       << firstObsItr->second[idx].data << ' '
-                       << romIt.asString() << ' ';
+                  os << setw(15) << setprecision(3) << fixed
+                     << firstObsItr->second[idx].data << ' '
+                     << romIt.asString() << ' ';
                }
                firstObsItr++;
             }
@@ -396,19 +657,19 @@ void ROWDiff::process()
             else if (secondObsItr != secondDiffItr->obs.end())
             {
                string sysString = string(1,secondObsItr->first.systemChar());
-               cout << ">" << setw(3)
-                    << (static_cast<YDSTime>(secondDiffItr->time))
-                    << ' ' << setw(2) << secondObsItr->first << ' ';
+               os << ">" << setw(3)
+                  << (static_cast<YDSTime>(secondDiffItr->time))
+                  << ' ' << setw(2) << secondObsItr->first << ' ';
                for (const auto& romIt : intersectRom[sysString])
                {
                   size_t idx = header2.getObsIndex(sysString, romIt);
-                  cout << setw(15) << setprecision(3) << fixed
-                       << secondObsItr->second[idx].data << ' '
-                       << romIt.asString() << ' ';
+                  os << setw(15) << setprecision(3) << fixed
+                     << secondObsItr->second[idx].data << ' '
+                     << romIt.asString() << ' ';
                }
                secondObsItr++;
             }
-            cout << endl;
+            os << endl;
          }
 
          firstDiffItr++;
@@ -0,0 +1,537 @@
+//==============================================================================
+//
+//  This file is part of GNSSTk, the ARL:UT GNSS Toolkit.
+//
+//  The GNSSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GNSSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GNSSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin.
+//  Copyright 2004-2022, The Board of Regents of The University of Texas System
+//
+//==============================================================================
+
+//==============================================================================
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin, under contract to an agency or agencies
+//  within the U.S. Department of Defense. The U.S. Government retains all
+//  rights to use, duplicate, distribute, disclose, or release this software.
+//
+//  Pursuant to DoD Directive 523024
+//
+//  DISTRIBUTION STATEMENT A: This software has been approved for public
+//                            release, distribution is unlimited.
+//
+//==============================================================================
+
+/**
+ * @file NavCache.cpp
+ * Binary, memory-mapped cache of broadcast ephemerides; see NavCache.hpp
+ */
+
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <memory>
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <gnsstk/StringUtils.hpp>
+#include <gnsstk/RinexNavDataFactory.hpp>
+
+#include "NavCache.hpp"
+
+using namespace std;
+using namespace gnsstk;
+
+const uint32_t NavCache::version = 1;
+const long NavCache::loadMarginDays = 2;
+
+static const char navCacheMagic[8] = { 'G','N','S','S','N','A','V','C' };
+
+// order records by satellite, then time
+static bool recordLess(const NavCache::Record& a, const NavCache::Record& b)
+{
+   if(a.sys != b.sys) return a.sys < b.sys;
+   if(a.prn != b.prn) return a.prn < b.prn;
+   if(a.day != b.day) return a.day < b.day;
+   if(a.sod != b.sod) return a.sod < b.sod;
+   if(a.fsod != b.fsod) return a.fsod < b.fsod;
+   return a.xmitTime < b.xmitTime;
+}
+
+// order records by time only, for the records of one satellite
+static bool recordTimeLess(const NavCache::Record& a, const NavCache::Record& b)
+{
+   if(a.day != b.day) return a.day < b.day;
+   if(a.sod != b.sod) return a.sod < b.sod;
+   return a.fsod < b.fsod;
+}
+
+// a record key with the time of t, shifted by days
+static NavCache::Record timeKey(const CommonTime& t, long days)
+{
+   NavCache::Record key;
+   memset(&key, 0, sizeof(key));
+   long day, sod;
+   double fsod;
+   TimeSystem ts;
+   t.get(day, sod, fsod, ts);
+   key.day = day + days;
+   key.sod = sod;
+   key.fsod = fsod;
+   return key;
+}
+
+// records are duplicates if they have the same satellite, time, transmit time
+// and issue of data
+static bool recordSame(const NavCache::Record& a, const NavCache::Record& b)
+{
+   return (a.sys == b.sys && a.prn == b.prn && a.day == b.day
+           && a.sod == b.sod && a.fsod == b.fsod && a.xmitTime == b.xmitTime
+           && a.IODE == b.IODE && a.IODnav == b.IODnav);
+}
+
+NavCache ::
+NavCache()
+      : pData(nullptr), nBytes(0), mapped(false),
+        pHead(nullptr), pIndex(nullptr), pRecords(nullptr)
+{
+}
+
+NavCache ::
+~NavCache()
+{
+   close();
+}
+
+bool NavCache ::
+open(const string& filename, string& error)
+{
+   close();
+
+#ifndef _WIN32
+   int fd = ::open(filename.c_str(), O_RDONLY);
+   if(fd < 0) {
+      error = "could not open " + filename;
+      return false;
+   }
+   struct stat st;
+   if(::fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(Header)) {
+      ::close(fd);
+      error = filename + " is not a nav cache (too short)";
+      return false;
+   }
+   nBytes = st.st_size;
+   void *p = ::mmap(nullptr, nBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+   ::close(fd);
+   if(p == MAP_FAILED) {
+      nBytes = 0;
+      error = "could not map " + filename;
+      return false;
+   }
+   pData = static_cast<const char*>(p);
+   mapped = true;
+#else
+      // no mmap; read the whole file, which is still cheap compared
+      // to parsing the RINEX
+   ifstream ifs(filename.c_str(), ios::in | ios::binary);
+   if(!ifs) {
+      error = "could not open " + filename;
+      return false;
+   }
+   ifs.seekg(0, ios::end);
+   nBytes = ifs.tellg();
+   ifs.seekg(0, ios::beg);
+   if(nBytes < sizeof(Header)) {
+      nBytes = 0;
+      error = filename + " is not a nav cache (too short)";
+      return false;
+   }
+      // allocate as doubles so the records are aligned
+   double *buf = new double[(nBytes+sizeof(double)-1)/sizeof(double)];
+   ifs.read(reinterpret_cast<char*>(buf), nBytes);
+   pData = reinterpret_cast<const char*>(buf);
+   mapped = false;
+   if(!ifs) {
+      close();
+      error = "could not read " + filename;
+      return false;
+   }
+#endif
+
+   pHead = reinterpret_cast<const Header*>(pData);
+   if(memcmp(pHead->magic, navCacheMagic, sizeof(navCacheMagic)) != 0) {
+      close();
+      error = filename + " is not a nav cache";
+      return false;
+   }
+   if(pHead->version != version || pHead->recordSize != sizeof(Record)) {
+      close();
+      error = filename + " is a nav cache of another version or byte order;"
+         " rebuild it with navcache";
+      return false;
+   }
+   if(pHead->indexOffset + pHead->numSats*sizeof(IndexEntry) > nBytes ||
+      pHead->recordOffset + pHead->numRecords*sizeof(Record) > nBytes)
+   {
+      close();
+      error = filename + " is truncated";
+      return false;
+   }
+   pIndex = reinterpret_cast<const IndexEntry*>(pData + pHead->indexOffset);
+   pRecords = reinterpret_cast<const Record*>(pData + pHead->recordOffset);
+
+   return true;
+}
+
+void NavCache ::
+close()
+{
+   if(pData) {
+#ifndef _WIN32
+      if(mapped)
+         ::munmap(const_cast<char*>(pData), nBytes);
+      else
+#endif
+         delete[] reinterpret_cast<const double*>(pData);
+   }
+   pData = nullptr;
+   nBytes = 0;
+   mapped = false;
+   pHead = nullptr;
+   pIndex = nullptr;
+   pRecords = nullptr;
+}
+
+string NavCache ::
+systems() const
+{
+   string sys;
+   for(size_t i=0; i<numSats(); i++) {
+      char c(static_cast<char>(pIndex[i].sys));
+      if(sys.find(c) == string::npos) sys += c;
+   }
+   return sys;
+}
+
+const NavCache::Record* NavCache ::
+records(const RinexSatID& sat, size_t& n) const
+{
+   n = 0;
+   if(!pHead) return nullptr;
+
+   IndexEntry key;
+   key.sys = sat.systemChar();
+   key.prn = sat.id;
+   const IndexEntry *end = pIndex + pHead->numSats;
+   const IndexEntry *it = lower_bound(pIndex, end, key,
+      [](const IndexEntry& a, const IndexEntry& b)
+      { return (a.sys != b.sys ? a.sys < b.sys : a.prn < b.prn); });
+   if(it == end || it->sys != key.sys || it->prn != key.prn)
+      return nullptr;
+
+   n = it->count;
+   return pRecords + it->first;
+}
+
+const NavCache::Record* NavCache ::
+find(const RinexSatID& sat, const CommonTime& t) const
+{
+   size_t n;
+   const Record *first = records(sat, n);
+   if(!first) return nullptr;
+
+      // first record after t, ignoring transmit time
+   const Record *it = upper_bound(first, first+n, timeKey(t,0), recordTimeLess);
+   if(it == first) return nullptr;
+   return it-1;
+}
+
+size_t NavCache ::
+load(NavLibrary& navLib, const NavMessageTypeSet& types,
+     const CommonTime& fromTime, const CommonTime& toTime,
+     std::shared_ptr<RinexNavDataFactory> *factory) const
+{
+   if(factory) factory->reset();
+   if(!pHead) return 0;
+
+   bool doEph(types.count(NavMessageType::Ephemeris) > 0);
+   bool doHea(types.count(NavMessageType::Health) > 0);
+   if(!doEph && !doHea) return 0;
+
+      // the conversions are those used when RinexNavDataFactory reads
+      // a RINEX file, so the nav data is the same as loading the files
+   std::shared_ptr<RinexNavDataFactory> fact =
+      std::make_shared<RinexNavDataFactory>();
+   size_t nloaded(0);
+   Rinex3NavData rnd;
+   const Record lo(timeKey(fromTime,-loadMarginDays));
+   const Record hi(timeKey(toTime,loadMarginDays));
+   for(size_t s=0; s<pHead->numSats; s++) {
+      // each satellite's records are in time order
+      const Record *first = pRecords + pIndex[s].first;
+      const Record *last = first + pIndex[s].count;
+      const Record *beg = lower_bound(first, last, lo, recordTimeLess);
+      const Record *end = upper_bound(beg, last, hi, recordTimeLess);
+      for(const Record *rec=beg; rec<end; rec++) {
+         fromRecord(*rec, rnd);
+         if(doEph) {
+            NavDataPtr eph;
+            if(RinexNavDataFactory::convertToOrbit(rnd, eph) && eph) {
+               fact->addNavData(eph);
+               nloaded++;
+            }
+         }
+         if(doHea) {
+            NavDataPtrList health;
+            if(RinexNavDataFactory::convertToHealth(rnd, health)) {
+               for(NavDataPtrList::iterator it=health.begin(); it!=health.end();
+                   ++it)
+               {
+                  fact->addNavData(*it);
+                  nloaded++;
+               }
+            }
+         }
+      }
+   }
+   navLib.addFactory(fact);
+   if(factory) *factory = fact;
+
+   return nloaded;
+}
+
+size_t NavCache ::
+loadFile(const string& filename, NavLibrary& navLib,
+         const NavMessageTypeSet& types, const CommonTime& fromTime,
+         const CommonTime& toTime, std::shared_ptr<RinexNavDataFactory> *factory)
+{
+   NavCache cache;
+   string error;
+   if(!cache.open(filename, error)) {
+      Exception e("Nav cache: " + error);
+      GNSSTK_THROW(e);
+   }
+   return cache.load(navLib, types, fromTime, toTime, factory);
+}
+
+string NavCache ::
+headerWarning(const vector<string>& filenames, size_t nNavFiles)
+{
+   if(nNavFiles > 0) return string();
+
+   string sys, error;
+   for(size_t i=0; i<filenames.size(); i++) {
+      NavCache cache;
+      if(!cache.open(filenames[i], error)) continue;
+      string s(cache.systems());
+      for(size_t j=0; j<s.size(); j++)
+         if(sys.find(s[j]) == string::npos) sys += s[j];
+   }
+   if(sys.size() < 2) return string();
+
+   return "Warning - nav cache(s) hold systems " + sys + " but no RINEX nav"
+      " file is loaded; the caches do not keep the RINEX header time system"
+      " corrections or iono, so the offsets between systems are not"
+      " available. Load the RINEX nav files as well.";
+}
+
+size_t NavCache ::
+write(const string& filename, const vector<Rinex3NavData>& data)
+{
+   size_t i;
+   vector<Record> recs(data.size());
+   for(i=0; i<data.size(); i++)
+      toRecord(data[i], recs[i]);
+   sort(recs.begin(), recs.end(), recordLess);
+   recs.erase(unique(recs.begin(), recs.end(), recordSame), recs.end());
+
+   vector<IndexEntry> index;
+   for(i=0; i<recs.size(); i++) {
+      if(index.empty() || index.back().sys != recs[i].sys
+                       || index.back().prn != recs[i].prn)
+      {
+         IndexEntry ie;
+         ie.sys = recs[i].sys;
+         ie.prn = recs[i].prn;
+         ie.first = i;
+         ie.count = 0;
+         index.push_back(ie);
+      }
+      index.back().count++;
+   }
+
+   Header head;
+   memset(&head, 0, sizeof(head));
+   memcpy(head.magic, navCacheMagic, sizeof(navCacheMagic));
+   head.version = version;
+   head.recordSize = sizeof(Record);
+   head.numSats = index.size();
+   head.numRecords = recs.size();
+   head.indexOffset = sizeof(Header);
+   head.recordOffset = head.indexOffset + index.size()*sizeof(IndexEntry);
+
+   ofstream ofs(filename.c_str(), ios::out | ios::binary | ios::trunc);
+   if(!ofs) {
+      Exception e("Nav cache: could not open " + filename + " for output");
+      GNSSTK_THROW(e);
+   }
+   ofs.write(reinterpret_cast<const char*>(&head), sizeof(head));
+   if(!index.empty())
+      ofs.write(reinterpret_cast<const char*>(&index[0]),
+                index.size()*sizeof(IndexEntry));
+   if(!recs.empty())
+      ofs.write(reinterpret_cast<const char*>(&recs[0]),
+                recs.size()*sizeof(Record));
+   ofs.close();
+   if(!ofs) {
+      Exception e("Nav cache: failed to write " + filename);
+      GNSSTK_THROW(e);
+   }
+
+   return recs.size();
+}
+
+void NavCache ::
+toRecord(const Rinex3NavData& rnd, Record& rec)
+{
+   memset(&rec, 0, sizeof(rec));
+   rec.sys = rnd.sat.systemChar();
+   rec.prn = rnd.sat.id;
+   long day, sod;
+   double fsod;
+   TimeSystem ts;
+   rnd.time.get(day, sod, fsod, ts);
+   rec.day = day;
+   rec.sod = sod;
+   rec.fsod = fsod;
+   rec.timeSystem = static_cast<int64_t>(ts);
+
+   rec.xmitTime = rnd.xmitTime;
+   rec.weeknum = rnd.weeknum;
+   rec.health = rnd.health;
+   rec.codeflgs = rnd.codeflgs;
+   rec.L2Pdata = rnd.L2Pdata;
+   rec.MFtime = rnd.MFtime;
+   rec.freqNum = rnd.freqNum;
+   rec.datasources = rnd.datasources;
+
+   rec.accuracy = rnd.accuracy;
+   rec.IODC = rnd.IODC;
+   rec.IODE = rnd.IODE;
+   rec.TauN = rnd.TauN;
+   rec.GammaN = rnd.GammaN;
+   rec.MFTraw = rnd.MFTraw;
+   rec.ageOfInfo = rnd.ageOfInfo;
+   rec.IODnav = rnd.IODnav;
+   rec.accCode = rnd.accCode;
+   rec.IODN = rnd.IODN;
+
+   rec.Toc = rnd.Toc;
+   rec.af0 = rnd.af0;
+   rec.af1 = rnd.af1;
+   rec.af2 = rnd.af2;
+   rec.Tgd = rnd.Tgd;
+   rec.Tgd2 = rnd.Tgd2;
+
+   rec.Cuc = rnd.Cuc;
+   rec.Cus = rnd.Cus;
+   rec.Crc = rnd.Crc;
+   rec.Crs = rnd.Crs;
+   rec.Cic = rnd.Cic;
+   rec.Cis = rnd.Cis;
+
+   rec.Toe = rnd.Toe;
+   rec.M0 = rnd.M0;
+   rec.dn = rnd.dn;
+   rec.ecc = rnd.ecc;
+   rec.Ahalf = rnd.Ahalf;
+   rec.OMEGA0 = rnd.OMEGA0;
+   rec.i0 = rnd.i0;
+   rec.w = rnd.w;
+   rec.OMEGAdot = rnd.OMEGAdot;
+   rec.idot = rnd.idot;
+   rec.fitint = rnd.fitint;
+
+   rec.px = rnd.px; rec.py = rnd.py; rec.pz = rnd.pz;
+   rec.vx = rnd.vx; rec.vy = rnd.vy; rec.vz = rnd.vz;
+   rec.ax = rnd.ax; rec.ay = rnd.ay; rec.az = rnd.az;
+}
+
+void NavCache ::
+fromRecord(const Record& rec, Rinex3NavData& rnd)
+{
+   rnd.satSys = string(1, static_cast<char>(rec.sys));
+   rnd.PRNID = rec.prn;
+   rnd.sat = RinexSatID(rnd.satSys + StringUtils::asString(rec.prn));
+   rnd.time.set(rec.day, rec.sod, rec.fsod,
+                static_cast<TimeSystem>(rec.timeSystem));
+
+   rnd.xmitTime = rec.xmitTime;
+   rnd.weeknum = rec.weeknum;
+   rnd.health = rec.health;
+   rnd.codeflgs = rec.codeflgs;
+   rnd.L2Pdata = rec.L2Pdata;
+   rnd.MFtime = rec.MFtime;
+   rnd.freqNum = rec.freqNum;
+   rnd.datasources = rec.datasources;
+
+   rnd.accuracy = rec.accuracy;
+   rnd.IODC = rec.IODC;
+   rnd.IODE = rec.IODE;
+   rnd.TauN = rec.TauN;
+   rnd.GammaN = rec.GammaN;
+   rnd.MFTraw = rec.MFTraw;
+   rnd.ageOfInfo = rec.ageOfInfo;
+   rnd.IODnav = rec.IODnav;
+   rnd.accCode = rec.accCode;
+   rnd.IODN = rec.IODN;
+
+   rnd.Toc = rec.Toc;
+   rnd.af0 = rec.af0;
+   rnd.af1 = rec.af1;
+   rnd.af2 = rec.af2;
+   rnd.Tgd = rec.Tgd;
+   rnd.Tgd2 = rec.Tgd2;
+
+   rnd.Cuc = rec.Cuc;
+   rnd.Cus = rec.Cus;
+   rnd.Crc = rec.Crc;
+   rnd.Crs = rec.Crs;
+   rnd.Cic = rec.Cic;
+   rnd.Cis = rec.Cis;
+
+   rnd.Toe = rec.Toe;
+   rnd.M0 = rec.M0;
+   rnd.dn = rec.dn;
+   rnd.ecc = rec.ecc;
+   rnd.Ahalf = rec.Ahalf;
+   rnd.OMEGA0 = rec.OMEGA0;
+   rnd.i0 = rec.i0;
+   rnd.w = rec.w;
+   rnd.OMEGAdot = rec.OMEGAdot;
+   rnd.idot = rec.idot;
+   rnd.fitint = rec.fitint;
+
+   rnd.px = rec.px; rnd.py = rec.py; rnd.pz = rec.pz;
+   rnd.vx = rec.vx; rnd.vy = rec.vy; rnd.vz = rec.vz;
+   rnd.ax = rec.ax; rnd.ay = rec.ay; rnd.az = rec.az;
+}
@@ -0,0 +1,233 @@
+//==============================================================================
+//
+//  This file is part of GNSSTk, the ARL:UT GNSS Toolkit.
+//
+//  The GNSSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GNSSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GNSSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin.
+//  Copyright 2004-2022, The Board of Regents of The University of Texas System
+//
+//==============================================================================
+
+//==============================================================================
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin, under contract to an agency or agencies
+//  within the U.S. Department of Defense. The U.S. Government retains all
+//  rights to use, duplicate, distribute, disclose, or release this software.
+//
+//  Pursuant to DoD Directive 523024
+//
+//  DISTRIBUTION STATEMENT A: This software has been approved for public
+//                            release, distribution is unlimited.
+//
+//==============================================================================
+
+#ifndef NAVCACHE_HPP
+#define NAVCACHE_HPP
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <gnsstk/Exception.hpp>
+#include <gnsstk/CommonTime.hpp>
+#include <gnsstk/RinexSatID.hpp>
+#include <gnsstk/Rinex3NavData.hpp>
+#include <gnsstk/NavLibrary.hpp>
+#include <gnsstk/RinexNavDataFactory.hpp>
+
+/** Binary, memory-mapped cache of broadcast ephemerides.
+ *
+ * A cache file is built once from any number of RINEX navigation
+ * files (see the navcache application) and holds every ephemeris as
+ * a fixed-size binary record, sorted by satellite and time, with an
+ * index giving the first record and number of records for each
+ * satellite.  Loading a cache maps the file into memory and converts
+ * the records directly into NavLibrary data, so the applications that
+ * accept a cache (--navcache) skip parsing the RINEX text and probing
+ * each file's format.  Given the time span of interest, only the
+ * records near that span are converted; they are found per satellite
+ * through the index by binary search.
+ *
+ * The file is written in the native byte order; a cache written on a
+ * machine of different byte order, or by an incompatible version, is
+ * rejected by open().  Only the ephemeris records of RINEX nav files
+ * are cached (not SP3); the RINEX headers, with the iono and time system
+ * corrections, are not, so the offsets between systems are missing
+ * unless the RINEX nav files are loaded as well; see headerWarning(). */
+class NavCache
+{
+public:
+      /// File header, at the start of the cache file.
+   struct Header
+   {
+      char magic[8];          ///< "GNSSNAVC"
+      uint32_t version;       ///< format version, NavCache::version
+      uint32_t recordSize;    ///< sizeof(Record), also detects byte order
+      uint64_t numSats;       ///< number of entries in the index
+      uint64_t numRecords;    ///< total number of records
+      uint64_t indexOffset;   ///< file offset of the index
+      uint64_t recordOffset;  ///< file offset of the records
+   };
+
+      /// Index entry, one per satellite, sorted by system and PRN.
+   struct IndexEntry
+   {
+      int32_t sys;            ///< RINEX system character, e.g. 'G'
+      int32_t prn;            ///< satellite PRN or slot
+      uint64_t first;         ///< index of the first record of this satellite
+      uint64_t count;         ///< number of records of this satellite
+   };
+
+      /** One ephemeris; the members of Rinex3NavData, with the time
+       * (Toc) as CommonTime day, second of day and fraction. All
+       * members are 8 bytes so the records pack without padding. */
+   struct Record
+   {
+      int64_t sys, prn;
+      int64_t day, sod;
+      double fsod;
+      int64_t timeSystem;
+      int64_t xmitTime, weeknum, health, codeflgs, L2Pdata;
+      int64_t MFtime, freqNum, datasources;
+      double accuracy, IODC, IODE, TauN, GammaN, MFTraw, ageOfInfo;
+      double IODnav, accCode, IODN;
+      double Toc, af0, af1, af2, Tgd, Tgd2;
+      double Cuc, Cus, Crc, Crs, Cic, Cis;
+      double Toe, M0, dn, ecc, Ahalf, OMEGA0, i0, w, OMEGAdot, idot, fitint;
+      double px, py, pz, vx, vy, vz, ax, ay, az;
+   };
+
+      /// Version of the file format written by write().
+   static const uint32_t version;
+
+      /** Records up to this many days outside the span given to
+       * load() are also loaded, so that every ephemeris valid in the
+       * span (GPS fit intervals are at most a few days) is kept. */
+   static const long loadMarginDays;
+
+   NavCache();
+   ~NavCache();
+
+      /** Map a cache file into memory and check its header.
+       * @param[in] filename the cache file.
+       * @param[out] error reason for failure.
+       * @return true if the file is a valid cache. */
+   bool open(const std::string& filename, std::string& error);
+
+      /// Release the mapped file.
+   void close();
+
+      /// Number of ephemerides in the cache.
+   size_t size() const
+   { return (pHead ? pHead->numRecords : 0); }
+
+      /// Number of satellites in the index.
+   size_t numSats() const
+   { return (pHead ? pHead->numSats : 0); }
+
+      /// Index entry i, 0 <= i < numSats().
+   const IndexEntry& entry(size_t i) const
+   { return pIndex[i]; }
+
+      /** The systems of the satellites in the cache, as RINEX system
+       * characters in index order, e.g. "GR". */
+   std::string systems() const;
+
+      /** Get the records of a satellite.
+       * @param[in] sat the satellite.
+       * @param[out] n the number of records.
+       * @return pointer to the first of n records, sorted by time,
+       *   or null if sat is not in the cache. */
+   const Record* records(const gnsstk::RinexSatID& sat, size_t& n) const;
+
+      /** Find the latest record of a satellite with time (Toc) at or
+       * before t; return null if there is none. */
+   const Record* find(const gnsstk::RinexSatID& sat,
+                      const gnsstk::CommonTime& t) const;
+
+      /** Convert the records with time from fromTime to toTime,
+       * within loadMarginDays, to nav data, and add it to navLib in a
+       * new nav data factory.  Time systems are ignored in selecting
+       * the records.
+       * @param[in,out] navLib the nav library to load.
+       * @param[in] types the nav message types to load; Ephemeris and
+       *   Health are the only types in the cache.
+       * @param[in] fromTime,toTime the span of interest; by default
+       *   every record is loaded.
+       * @param[out] factory if not null, set to the new factory, e.g.
+       *   to count() what was loaded.
+       * @return the number of nav data objects loaded. */
+   size_t load(gnsstk::NavLibrary& navLib,
+               const gnsstk::NavMessageTypeSet& types =
+               gnsstk::allNavMessageTypes,
+               const gnsstk::CommonTime& fromTime =
+               gnsstk::CommonTime::BEGINNING_OF_TIME,
+               const gnsstk::CommonTime& toTime =
+               gnsstk::CommonTime::END_OF_TIME,
+               std::shared_ptr<gnsstk::RinexNavDataFactory> *factory =
+               nullptr) const;
+
+      /** Open the cache file and load it into navLib (see load()).
+       * @throw gnsstk::Exception if the file is not a valid cache. */
+   static size_t loadFile(const std::string& filename,
+                          gnsstk::NavLibrary& navLib,
+                          const gnsstk::NavMessageTypeSet& types =
+                          gnsstk::allNavMessageTypes,
+                          const gnsstk::CommonTime& fromTime =
+                          gnsstk::CommonTime::BEGINNING_OF_TIME,
+                          const gnsstk::CommonTime& toTime =
+                          gnsstk::CommonTime::END_OF_TIME,
+                          std::shared_ptr<gnsstk::RinexNavDataFactory>
+                          *factory = nullptr);
+
+      /** Check whether loading caches in place of RINEX nav files loses
+       * data: with no RINEX nav file, the time system corrections between
+       * systems, and the iono, in the RINEX headers are not available.
+       * @param[in] filenames the cache files.
+       * @param[in] nNavFiles the number of other nav files loaded.
+       * @return a warning message if the caches hold more than one system
+       *   and nNavFiles is zero, else an empty string. */
+   static std::string headerWarning(const std::vector<std::string>& filenames,
+                                    size_t nNavFiles);
+
+      /** Sort the ephemerides by satellite and time, remove duplicates
+       * and write them to a cache file.
+       * @param[in] filename the cache file, which is overwritten.
+       * @param[in] data the ephemerides, in any order.
+       * @return the number of records written.
+       * @throw gnsstk::Exception if the file cannot be written. */
+   static size_t write(const std::string& filename,
+                       const std::vector<gnsstk::Rinex3NavData>& data);
+
+      /// Convert between Record and Rinex3NavData.
+   static void toRecord(const gnsstk::Rinex3NavData& rnd, Record& rec);
+   static void fromRecord(const Record& rec, gnsstk::Rinex3NavData& rnd);
+
+private:
+   NavCache(const NavCache&);             // not copyable
+   NavCache& operator=(const NavCache&);
+
+   const char *pData;               ///< start of the mapped file
+   size_t nBytes;                   ///< size of the mapped file
+   bool mapped;                     ///< pData is mapped, else allocated
+   const Header *pHead;             ///< file header, in pData
+   const IndexEntry *pIndex;        ///< index, in pData
+   const Record *pRecords;          ///< records, in pData
+};
+
+#endif
@@ -0,0 +1,88 @@
+//==============================================================================
+//
+//  This file is part of GNSSTk, the ARL:UT GNSS Toolkit.
+//
+//  The GNSSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GNSSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GNSSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin.
+//  Copyright 2004-2022, The Board of Regents of The University of Texas System
+//
+//==============================================================================
+
+//==============================================================================
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin, under contract to an agency or agencies
+//  within the U.S. Department of Defense. The U.S. Government retains all
+//  rights to use, duplicate, distribute, disclose, or release this software.
+//
+//  Pursuant to DoD Directive 523024
+//
+//  DISTRIBUTION STATEMENT A: This software has been approved for public
+//                            release, distribution is unlimited.
+//
+//==============================================================================
+
+/**
+ * @file SatSystems.cpp
+ * Parser of the --sys option; see SatSystems.hpp
+ */
+
+#include <gnsstk/StringUtils.hpp>
+
+#include "SatSystems.hpp"
+
+using namespace std;
+using namespace gnsstk;
+
+bool parseSatSystems(const vector<string>& values,
+                     set<SatelliteSystem>& systems, bool& all, string& bad)
+{
+   for (size_t i=0; i<values.size(); i++)
+   {
+      vector<string> fields(StringUtils::split(values[i], ","));
+      for (size_t n=0; n<fields.size(); n++)
+      {
+         string field(StringUtils::lowerCase(fields[n]));
+         if (field == "all")
+         {
+            all = true;
+            continue;
+         }
+         SatelliteSystem sys(SatelliteSystem::Unknown);
+         if (field.size() == 1)
+         {
+            switch (field[0])
+            {
+               case 'g': sys = SatelliteSystem::GPS;     break;
+               case 'r': sys = SatelliteSystem::Glonass; break;
+               case 'e': sys = SatelliteSystem::Galileo; break;
+               case 'c': sys = SatelliteSystem::BeiDou;  break;
+               case 'j': sys = SatelliteSystem::QZSS;    break;
+               case 'i': sys = SatelliteSystem::IRNSS;   break;
+               case 's': sys = SatelliteSystem::Geosync; break;
+            }
+         }
+         if (sys == SatelliteSystem::Unknown)
+         {
+            bad = fields[n];
+            return false;
+         }
+         systems.insert(sys);
+      }
+   }
+   return true;
+}
@@ -0,0 +1,59 @@
+//==============================================================================
+//
+//  This file is part of GNSSTk, the ARL:UT GNSS Toolkit.
+//
+//  The GNSSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GNSSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GNSSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin.
+//  Copyright 2004-2022, The Board of Regents of The University of Texas System
+//
+//==============================================================================
+
+//==============================================================================
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin, under contract to an agency or agencies
+//  within the U.S. Department of Defense. The U.S. Government retains all
+//  rights to use, duplicate, distribute, disclose, or release this software.
+//
+//  Pursuant to DoD Directive 523024
+//
+//  DISTRIBUTION STATEMENT A: This software has been approved for public
+//                            release, distribution is unlimited.
+//
+//==============================================================================
+
+#ifndef SATSYSTEMS_HPP
+#define SATSYSTEMS_HPP
+
+#include <set>
+#include <string>
+#include <vector>
+#include <gnsstk/SatelliteSystem.hpp>
+
+/** Parse the values of a --sys option, as used by bc2sp3 and
+ * findMoreThan12: each is a comma-separated list of the system
+ * characters G,R,E,C,J,I,S, in either case, or "all".
+ * @param[in] values the option values.
+ * @param[in,out] systems the systems named are added.
+ * @param[out] all set true if "all" is given, otherwise unchanged.
+ * @param[out] bad the field that is not a system, if any.
+ * @return false if a field is not a system. */
+bool parseSatSystems(const std::vector<std::string>& values,
+                     std::set<gnsstk::SatelliteSystem>& systems,
+                     bool& all, std::string& bad);
+
+#endif
@@ -46,11 +46,14 @@
  *
  * \section bc2sp3_synopsis SYNOPSIS
  * <b>bc2sp3</b>  <b>-h</b> <br/>
- * <b>bc2sp3</b> <b>[-d</b><b>]</b> <b>[-v</b><b>]</b> <b>[\--in</b>&nbsp;\argarg{ARG}<b>]</b> <b>[\--out</b>&nbsp;\argarg{ARG}<b>]</b> <b>[\--tb</b>&nbsp;\argarg{TIME}<b>]</b> <b>[\--te</b>&nbsp;\argarg{TIME}<b>]</b> <b>[\--cs</b>&nbsp;\argarg{NUM}<b>]</b> <b>[\--outputC</b><b>]</b> <b>[\--msg</b>&nbsp;\argarg{ARG}<b>]</b> <b>[</b>\argarg{ARG}<b>]</b> <b>[</b>...<b>]</b>
+ * <b>bc2sp3</b> <b>[-d</b><b>]</b> <b>[-v</b><b>]</b> <b>[\--in</b>&nbsp;\argarg{ARG}<b>]</b> <b>[\--navcache</b>&nbsp;\argarg{ARG}<b>]</b> <b>[\--out</b>&nbsp;\argarg{ARG}<b>]</b> <b>[\--tb</b>&nbsp;\argarg{TIME}<b>]</b> <b>[\--te</b>&nbsp;\argarg{TIME}<b>]</b> <b>[\--cs</b>&nbsp;\argarg{NUM}<b>]</b> <b>[\--outputC</b><b>]</b> <b>[\--msg</b>&nbsp;\argarg{ARG}<b>]</b> <b>[\--sys</b>&nbsp;\argarg{ARG}<b>]</b> <b>[\--threads</b>&nbsp;\argarg{NUM}<b>]</b> <b>[</b>\argarg{ARG}<b>]</b> <b>[</b>...<b>]</b>
  *
  * \section bc2sp3_description DESCRIPTION
  * This application reads RINEX navigation file(s) and writes to SP3
- * (a or c) file(s).
+ * (a or c) file(s).  By default only GPS LNAV ephemerides are used;
+ * \--sys adds other systems, which are written as SP3c.  Epochs are in
+ * GPS time; the ephemerides of other systems are evaluated at the same
+ * instants in their own time systems.
  *
  * \dictionary
  * \dicterm{-d, \--debug}
@@ -61,6 +64,8 @@
  * \dicdef{Print help usage}
  * \dicterm{\--in=\argarg{ARG}}
  * \dicdef{Read the input file(s)}
+ * \dicterm{\--navcache=\argarg{ARG}}
+ * \dicdef{Read ephemeris cache file(s) built by navcache}
  * \dicterm{\--out=\argarg{ARG}}
  * \dicdef{Name the output file (default=sp3.out)}
  * \dicterm{\--tb=\argarg{TIME}}
@@ -73,6 +78,10 @@
  * \dicdef{Output SP3 version c (no correlation, default=a)}
  * \dicterm{\--msg=\argarg{ARG}}
  * \dicdef{Add a comment to the output header}
+ * \dicterm{\--sys=\argarg{ARG}}
+ * \dicdef{Include satellite system(s) G,R,E,C,J,I,S, or 'all' for every system in the input (default=G)}
+ * \dicterm{\--threads=\argarg{NUM}}
+ * \dicdef{Compute positions on this many threads (default=1)}
  * \enddictionary
  *
  * \subsection bc2sp3_example_merge Merge and Convert
@@ -103,6 +112,13 @@
 #include <iomanip>
 #include <string>
 #include <vector>
+#include <set>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <functional>
 
 #include <gnsstk/RinexNavStream.hpp>
 #include <gnsstk/RinexNavHeader.hpp>
@@ -110,6 +126,8 @@
 #include <gnsstk/NavLibrary.hpp>
 #include <gnsstk/MultiFormatNavDataFactory.hpp>
 #include <gnsstk/GPSLNavEph.hpp>
+#include <gnsstk/OrbitDataKepler.hpp>
+#include <gnsstk/NavFit.hpp>
 #include <gnsstk/SP3Stream.hpp>
 #include <gnsstk/SP3Header.hpp>
 #include <gnsstk/SP3Data.hpp>
@@ -118,29 +136,107 @@
 #include <gnsstk/StringUtils.hpp>
 #include <gnsstk/TimeString.hpp>
 #include <gnsstk/GPSWeekSecond.hpp>
+#include <gnsstk/BasicTimeSystemConverter.hpp>
 #include <gnsstk/BasicFramework.hpp>
 #include <gnsstk/CommandOptionWithCommonTimeArg.hpp>
+#include "NavCache.hpp"
+#include "SatSystems.hpp"
 
 using namespace std;
 using namespace gnsstk;
 
+   /// A run of consecutive epochs at which a satellite uses one ephemeris.
+struct EphRun
+{
+   size_t first, last;              ///< epoch indexes, inclusive
+   NavDataPtr nav;                  ///< as returned by NavLibrary::find()
+   shared_ptr<OrbitData> orb;       ///< nav, for computing positions
+   double issue;                    ///< see IssueOf()
+};
+
+   /// The position of one satellite at one epoch.
+struct SatXvt
+{
+   size_t isat;                     ///< index of the satellite
+   Xvt xvt;
+   double issue;                    ///< see IssueOf()
+};
+
+   /** Return the issue of an ephemeris, a change in which is flagged as
+    * a maneuver: the IODE for GPS LNAV, otherwise the time of
+    * ephemeris, or the transmit time if there is none. */
+double IssueOf(const NavDataPtr& nav)
+{
+   GPSLNavEph *eph = dynamic_cast<GPSLNavEph*>(nav.get());
+   if (eph != nullptr)
+      return eph->iode;
+   OrbitDataKepler *kep = dynamic_cast<OrbitDataKepler*>(nav.get());
+   if (kep != nullptr)
+      return kep->Toe.getDays() * 86400.0;
+   return nav->timeStamp.getDays() * 86400.0;
+}
+
+   /** Return the time system of the ephemerides of a satellite system,
+    * in which they are looked up and evaluated. */
+TimeSystem NavTimeSystem(SatelliteSystem sys)
+{
+   switch (sys)
+   {
+      case SatelliteSystem::Glonass: return TimeSystem::GLO;
+      case SatelliteSystem::Galileo: return TimeSystem::GAL;
+      case SatelliteSystem::BeiDou:  return TimeSystem::BDT;
+      case SatelliteSystem::QZSS:    return TimeSystem::QZS;
+      case SatelliteSystem::IRNSS:   return TimeSystem::IRN;
+      default:                       return TimeSystem::GPS;
+   }
+}
+
+   /// Call work(i) for i = 0 .. n-1 on up to nthreads threads.
+void RunParallel(unsigned nthreads, size_t n,
+                 const function<void(size_t)>& work)
+{
+   if (nthreads < 2 || n < 2)
+   {
+      for (size_t i = 0; i < n; i++)
+         work(i);
+      return;
+   }
+   atomic<size_t> next(0);
+   vector<thread> pool;
+   for (unsigned t = 0; t < nthreads && t < n; t++)
+   {
+      pool.push_back(thread([&]()
+      {
+         size_t i;
+         while ((i = next++) < n)
+            work(i);
+      }));
+   }
+   for (size_t t = 0; t < pool.size(); t++)
+      pool[t].join();
+}
+
 class BC2SP3 : public BasicFramework
 {
 public:
    BC2SP3(const string& applName);
    void process() override;
    CommandOptionWithAnyArg inFileOpt;
+   CommandOptionWithAnyArg navCacheOpt;
    CommandOptionWithAnyArg outFileOpt;
    CommandOptionWithCommonTimeArg beginOpt;
    CommandOptionWithCommonTimeArg endOpt;
    CommandOptionWithNumberArg cadenceOpt;
    CommandOptionNoArg sp3cOpt;
    CommandOptionWithAnyArg msgOpt;
+   CommandOptionWithAnyArg sysOpt;
+   CommandOptionWithNumberArg threadsOpt;
       /** The original implementation allowed either --in or trailing
        * arguments to indicate an input file name, so we do the
        * same... */
    CommandOptionRest inFile2Opt;
-      /// Make sure at least one of inFileOpt and/or inFile2Opt is used
+      /** Make sure at least one of inFileOpt, navCacheOpt and/or
+       * inFile2Opt is used */
    CommandOptionOneOf inFileOneOf;
       /// High level nav store interface.
    NavLibrary navLib;
@@ -151,9 +247,11 @@ public:
 
 BC2SP3 ::
 BC2SP3(const string& applName)
-      : BasicFramework(applName, "Read GPS LNAV file(s) and write to SP3(a or"
-                       " c) file."),
+      : BasicFramework(applName, "Read GNSS ephemeris file(s) and write to"
+                       " SP3(a or c) file."),
         inFileOpt(0, "in", "Read the input file(s)"),
+        navCacheOpt(0, "navcache", "Read ephemeris cache file(s) built by"
+                    " navcache"),
         inFile2Opt("[nav file] ..."),
         outFileOpt(0, "out", "Name the output file (default=sp3.out)"),
         beginOpt(0, "tb", "%F,%g", "Output beginning epoch (week,sec-of-week)"),
@@ -161,7 +259,11 @@ BC2SP3(const string& applName)
         cadenceOpt(0, "cs", "Cadence of epochs in seconds (default=300s)"),
         sp3cOpt(0, "outputC", "Output SP3 version c (no correlation,"
                 " default=a)"),
-        msgOpt(0, "msg", "Add a comment to the output header")
+        msgOpt(0, "msg", "Add a comment to the output header"),
+        sysOpt(0, "sys", "Include satellite system(s) G,R,E,C,J,I,S, or"
+               " 'all' for every system in the input (default=G)"),
+        threadsOpt(0, "threads", "Compute positions on this many threads"
+                   " (default=1)")
 {
       // Initialize these two items in here rather than in the
       // initializer list to guarantee execution order and avoid seg
@@ -173,7 +275,9 @@ BC2SP3(const string& applName)
    beginOpt.setMaxCount(1);
    endOpt.setMaxCount(1);
    cadenceOpt.setMaxCount(1);
+   threadsOpt.setMaxCount(1);
    inFileOneOf.addOption(&inFileOpt);
+   inFileOneOf.addOption(&navCacheOpt);
    inFileOneOf.addOption(&inFile2Opt);
 }
 
@@ -190,13 +294,16 @@ process()
       string fileout("sp3.out");
       vector<string> inputFiles;
       vector<string> comments;
-      map<SatID,long> IODEmap;
+      map<SatID,double> IODEmap;
       CommonTime begTime=CommonTime::BEGINNING_OF_TIME;
       CommonTime endTime=CommonTime::END_OF_TIME;
       CommonTime tt;
       SP3Header sp3header;
       SP3Data sp3data;
       double cadence = 300.0;       // Cadence of epochs.  Default to 5 minutes.
+      set<SatelliteSystem> systems;
+      bool allSystems = false;
+      unsigned nthreads = 1;
 
       navLib.addFactory(ndfp);
          // without clock, SP3 doesn't work.
@@ -234,6 +341,32 @@ process()
             exitCode = BasicFramework::EXIST_ERROR;            
          }
       }
+      values = navCacheOpt.getValue();
+      for (size_t i=0; i<values.size(); i++)
+      {
+         if (verboseLevel)
+         {
+            cout << " Input cache name " << values[i] << endl;
+         }
+         try
+         {
+            NavCache::loadFile(values[i], navLib,
+                               {NavMessageType::Ephemeris,
+                                NavMessageType::Clock});
+         }
+         catch (Exception& e)
+         {
+            cerr << "Unable to load \"" << values[i] << "\": "
+                 << e.getText() << endl;
+            exitCode = BasicFramework::EXIST_ERROR;
+         }
+      }
+      string warn(NavCache::headerWarning(values, inFileOpt.getCount()
+                                          + inFile2Opt.getCount()));
+      if (!warn.empty())
+      {
+         cerr << warn << endl;
+      }
       if (outFileOpt.getCount())
       {
          fileout = outFileOpt.getValue()[0];
@@ -280,6 +413,35 @@ process()
          }
       }
 
+      if (sysOpt.getCount())
+      {
+         string bad;
+         if (!parseSatSystems(sysOpt.getValue(), systems, allSystems, bad))
+         {
+            cerr << "Unknown satellite system \"" << bad << "\"" << endl;
+            exitCode = BasicFramework::OPTION_ERROR;
+            return;
+         }
+      }
+      else
+      {
+         systems.insert(SatelliteSystem::GPS);
+      }
+      if (allSystems)
+         systems.insert(SatelliteSystem::GPS);
+      if (threadsOpt.getCount())
+      {
+         int n = StringUtils::asInt(threadsOpt.getValue()[0]);
+         if (n < 1)
+         {
+            cerr << "Warning - --threads must be positive; using 1" << endl;
+            n = 1;
+         }
+         nthreads = n;
+         if (verboseLevel)
+            cout << " Threads    " << nthreads << endl;
+      }
+
          // open the output SP3 file
       SP3Stream outstrm(fileout.c_str(),ios::out);
       outstrm.exceptions(ifstream::failbit);
@@ -303,6 +465,81 @@ process()
       if (endTime == CommonTime::END_OF_TIME)
          endTime = navLib.getFinalTime();
 
+         // the output is in GPS time; the limits from the input may be
+         // in the time system of any satellite system
+      CommonTime::tsConv = make_shared<BasicTimeSystemConverter>();
+      auto toGPS = [](CommonTime& t)
+      {
+         if (t.getTimeSystem() == TimeSystem::Any)
+            t.setTimeSystem(TimeSystem::GPS);
+         else
+            t.changeTimeSystem(TimeSystem::GPS);
+      };
+      toGPS(begTime);
+      toGPS(endTime);
+
+         // the epochs, and the same epochs with any time system for the
+         // output records
+      vector<CommonTime> epochs, epochsAny;
+      for (tt = begTime; tt <= endTime; tt += cadence)
+      {
+         epochs.push_back(tt);
+         epochsAny.push_back(tt);
+         epochsAny.back().setTimeSystem(TimeSystem::Any);
+      }
+
+         // the satellites to look for: GPS PRNs 1-32 from LNAV, then the
+         // satellites of any other systems in the input
+      vector<SatID> sats;
+      vector<NavMessageID> nmids;
+      if (systems.count(SatelliteSystem::GPS))
+      {
+         for (i=1; i<33; i++)
+         {
+               // IODE is used to flag maneuvers so we require LNAV
+            sats.push_back(SatID(i,SatelliteSystem::GPS));
+            nmids.push_back(
+               NavMessageID(NavSatelliteID(i,i,SatelliteSystem::GPS,
+                                           CarrierBand::Any,
+                                           TrackingCode::Any,
+                                           NavType::GPSLNAV),
+                            NavMessageType::Ephemeris));
+         }
+      }
+      set<SatelliteSystem> present;
+      if (!sats.empty())
+         present.insert(SatelliteSystem::GPS);
+      if (allSystems || systems.size() > present.size())
+      {
+         CommonTime fromTime(begTime), toTime(endTime);
+         fromTime.setTimeSystem(TimeSystem::Any);
+         toTime.setTimeSystem(TimeSystem::Any);
+         SatIDSet avail(navLib.getAvailableSats(fromTime, toTime));
+         for (const auto& sat : avail)
+         {
+            if (sat.system == SatelliteSystem::GPS ||
+                (!allSystems && !systems.count(sat.system)))
+            {
+               continue;
+            }
+            sats.push_back(sat);
+            present.insert(sat.system);
+            nmids.push_back(
+               NavMessageID(NavSatelliteID(sat.id,sat.id,sat.system,
+                                           CarrierBand::Any,
+                                           TrackingCode::Any,
+                                           NavType::Any),
+                            NavMessageType::Ephemeris));
+         }
+      }
+         // SP3a is GPS only
+      if (present.size() > present.count(SatelliteSystem::GPS) &&
+          versionOut != SP3Header::SP3c)
+      {
+         cout << "Warning - SP3a is GPS only; output version c\n";
+         versionOut = SP3Header::SP3c;
+      }
+
          // define the data version and the header info
       if (versionOut == SP3Header::SP3c)
       {
@@ -311,6 +548,10 @@ process()
          sp3header.version = SP3Header::SP3c;
 
          sp3header.system = SP3SatID();
+         if (present.size() > 1)
+            sp3header.system = SP3SatID(-1, SatelliteSystem::Mixed);
+         else if (present.size() == 1 && !present.count(SatelliteSystem::GPS))
+            sp3header.system = SP3SatID(-1, *present.begin());
          sp3header.timeSystem = TimeSystem::GPS;
          sp3header.basePV = 0.0;
          sp3header.baseClk = 0.0;
@@ -331,43 +572,127 @@ process()
       sp3header.orbitType = "   ";
       sp3header.agency = "ARL";
 
-         // determine which SVs, with accuracy, start time, epoch interval,
-         // number of epochs, for header
-         // this is a pain....
-      sp3header.numberOfEpochs = 0;
-      tt = begTime;
-      while (tt <= endTime)
+         // the epochs in the time system of each satellite, in which its
+         // ephemerides are looked up and evaluated, e.g. GLONASS is
+         // offset from GPS by the leap seconds and BeiDou by 14s
+      size_t nsats(sats.size()), nepochs(epochs.size());
+      map<TimeSystem, vector<CommonTime> > sysEpochs;
+      vector<const vector<CommonTime>*> satEpochs(nsats, nullptr);
+      for (size_t s=0; s<nsats; s++)
       {
-         bool foundSome = false;
-         for (i=1; i<33; i++)              // for each PRN ...
+         TimeSystem ts(NavTimeSystem(sats[s].system));
+         if (!sysEpochs.count(ts))
+         {
+            vector<CommonTime>& tsEpochs(sysEpochs[ts]);
+            for (k=0; k<nepochs; k++)
+            {
+               tsEpochs.push_back(epochs[k]);
+               if (!tsEpochs.back().changeTimeSystem(ts))
+               {
+                  cerr << "Warning - unable to convert GPS time to "
+                       << StringUtils::asString(ts)
+                       << "; those satellites are skipped" << endl;
+                  tsEpochs.clear();
+                  break;
+               }
+            }
+         }
+         if (!sysEpochs[ts].empty())
+            satEpochs[s] = &sysEpochs[ts];
+      }
+
+         // find the ephemeris each satellite uses at each epoch, as runs
+         // of epochs using the same one.  An ephemeris serves the epochs
+         // to the end of its fit interval, or until a newer one is
+         // transmitted, which then replaces it, so rather than looking up
+         // every epoch, the end of each run is found by bisection within
+         // the fit interval.  The NavLibrary is shared by the threads, so
+         // its lookups are serialized.
+      vector<vector<EphRun> > runs(nsats);
+      mutex navMutex;
+      RunParallel(nthreads, nsats, [&](size_t s)
+      {
+         if (satEpochs[s] == nullptr)
+            return;
+         const vector<CommonTime>& satEpoch(*satEpochs[s]);
+         auto findEph = [&](size_t k, NavDataPtr& navOut) -> bool
+         {
+            lock_guard<mutex> lock(navMutex);
+            return navLib.find(nmids[s], satEpoch[k], navOut,
+                               SVHealth::Healthy,
+                               NavValidityType::ValidOnly,
+                               NavSearchOrder::User);
+         };
+         size_t k(0);
+         while (k < nepochs)
          {
-            SatID sat(i,SatelliteSystem::GPS);
-            NavMessageID nmid(NavSatelliteID(i,i,SatelliteSystem::GPS,
-                                             CarrierBand::Any,
-                                             TrackingCode::Any,
-                                             NavType::GPSLNAV),
-                              NavMessageType::Ephemeris);
             NavDataPtr navOut;
-            if (!navLib.find(nmid, tt, navOut, SVHealth::Healthy,
-                             NavValidityType::ValidOnly, NavSearchOrder::User))
+            if (!findEph(k, navOut))
             {
+               k++;
                continue;
             }
-            if (sp3header.satList.find(sat) == sp3header.satList.end())
+               // epochs k..lo use navOut; hi is past the fit interval, or
+               // the first epoch known to use another ephemeris
+            size_t lo(k), hi(k+1);
+            NavFit *fit = dynamic_cast<NavFit*>(navOut.get());
+            if (fit != nullptr)
             {
-               sp3header.satList[sat] = 0;        // sat accuracy = ?
-               IODEmap[sat] = -1;
+                  // compare in the epochs' time system
+               CommonTime endFit(fit->getEndFitTime());
+               endFit.setTimeSystem(TimeSystem::Any);
+               hi = upper_bound(satEpoch.begin()+k+1, satEpoch.end(),
+                                endFit) - satEpoch.begin();
             }
-
-            if (!foundSome)
+            while (hi - lo > 1)
+            {
+               size_t mid(lo + (hi-lo)/2);
+               NavDataPtr midNav;
+               if (findEph(mid, midNav) && midNav == navOut)
+                  lo = mid;
+               else
+                  hi = mid;
+            }
+            vector<EphRun>& satRuns(runs[s]);
+            if (!satRuns.empty() && satRuns.back().last+1 == k &&
+                satRuns.back().nav == navOut)
+            {
+               satRuns.back().last = lo;
+            }
+            else
             {
-               sp3header.numberOfEpochs++;
-               foundSome = true;
-               if (tt < sp3header.time)
-                  sp3header.time = tt;
+               EphRun run;
+               run.first = k;
+               run.last = lo;
+               run.nav = navOut;
+               run.orb = dynamic_pointer_cast<OrbitData>(navOut);
+               run.issue = IssueOf(navOut);
+               satRuns.push_back(run);
             }
+            k = lo+1;
          }
-         tt += sp3header.epochInterval;
+      });
+
+         // determine which SVs, with accuracy, start time, epoch interval,
+         // number of epochs, for header
+      vector<bool> foundSome(nepochs, false);
+      for (size_t s=0; s<nsats; s++)
+      {
+         if (runs[s].empty())
+            continue;
+         sp3header.satList[sats[s]] = 0;        // sat accuracy = ?
+         IODEmap[sats[s]] = -1;
+         for (const auto& run : runs[s])
+         {
+            for (k=run.first; k<=run.last; k++)
+               foundSome[k] = true;
+         }
+      }
+      sp3header.numberOfEpochs = 0;
+      for (k=0; k<nepochs; k++)
+      {
+         if (foundSome[k] && sp3header.numberOfEpochs++ == 0)
+            sp3header.time = epochs[k];
       }
 
          // add comments
@@ -396,84 +721,101 @@ process()
       for (j=0; j<4; j++)
          sp3data.sig[j]=0;   // sigma = ?
 
-      tt = begTime;
-      tt.setTimeSystem(TimeSystem::Any);
-      while (tt <= endTime)
+         // compute the positions of a block of epochs at a time on the
+         // threads, then write them in order
+      const size_t blockSize = 64;
+      size_t nblocks((nepochs+blockSize-1)/blockSize);
+      vector<vector<vector<SatXvt> > > blocks;
+      for (size_t b0=0; b0<nblocks; b0 += 4*nthreads)
       {
-         bool epochOut=false;
-
-         for (i=1; i<33; i++)
+         size_t nb(min<size_t>(4*nthreads, nblocks-b0));
+         blocks.assign(nb, vector<vector<SatXvt> >());
+         RunParallel(nthreads, nb, [&](size_t b)
          {
-            long iode;
-            SatID sat(i,SatelliteSystem::GPS);
-            Xvt xvt;
-               // code below depends on IODE so we require LNAV
-            NavMessageID nmid(NavSatelliteID(i,i,SatelliteSystem::GPS,
-                                             CarrierBand::Any,
-                                             TrackingCode::Any,
-                                             NavType::GPSLNAV),
-                              NavMessageType::Ephemeris);
-            NavDataPtr navOut;
-            if (!navLib.find(nmid, tt, navOut, SVHealth::Healthy,
-                             NavValidityType::ValidOnly, NavSearchOrder::User))
+            size_t k0((b0+b)*blockSize), k1(min(k0+blockSize, nepochs));
+            vector<vector<SatXvt> >& block(blocks[b]);
+            block.resize(k1-k0);
+            for (size_t s=0; s<nsats; s++)
             {
-               continue;
-            }
-            sp3data.sat = sat;
-            GPSLNavEph *eph = dynamic_cast<GPSLNavEph*>(navOut.get());
-            if (!eph->getXvt(tt, xvt))
-            {
-               continue;
+                  // the first run that may contain epoch k0
+               auto run = lower_bound(runs[s].begin(), runs[s].end(), k0,
+                                      [](const EphRun& r, size_t k)
+                                      { return r.last < k; });
+               for (; run != runs[s].end() && run->first < k1; ++run)
+               {
+                  if (!run->orb)
+                     continue;
+                  for (size_t k=max(k0,run->first); k<=run->last && k<k1; k++)
+                  {
+                     SatXvt sx;
+                     sx.isat = s;
+                     sx.issue = run->issue;
+                     if (run->orb->getXvt((*satEpochs[s])[k], sx.xvt))
+                        block[k-k0].push_back(sx);
+                  }
+               }
             }
+         });
 
-               // epoch
-            if (!epochOut)
-            {
-               sp3data.time = tt;
-               sp3data.RecType = '*';
-               outstrm << sp3data;
-               if (verboseLevel)
-                  sp3data.dump(cout);
-               epochOut = true;
-            }
-
-               // Position
-            sp3data.RecType = 'P';
-            for (j=0; j<3; j++)
-               sp3data.x[j] = xvt.x[j]/1000.0;       // km
-            sp3data.clk = xvt.clkbias * 1.0e6;    // microseconds
-
-               //if (versionOut == 'c') for (j=0; j<4; j++) sp3data.sig[j]=...
-            iode = eph->iode;
-            if (IODEmap[sat] == -1)
-               IODEmap[sat] = iode;
-            if (IODEmap[sat] != iode)
-            {
-               sp3data.orbitManeuverFlag = true;
-               IODEmap[sat] = iode;
-            }
-            else
+         for (size_t b=0; b<nb; b++)
+         {
+            size_t k0((b0+b)*blockSize);
+            for (k=0; k<blocks[b].size(); k++)
             {
-               sp3data.orbitManeuverFlag = false;
+               bool epochOut=false;
+               for (const auto& sx : blocks[b][k])
+               {
+                  const SatID& sat(sats[sx.isat]);
+                  const Xvt& xvt(sx.xvt);
+                  sp3data.sat = sat;
+
+                     // epoch
+                  if (!epochOut)
+                  {
+                     sp3data.time = epochsAny[k0+k];
+                     sp3data.RecType = '*';
+                     outstrm << sp3data;
+                     if (verboseLevel)
+                        sp3data.dump(cout);
+                     epochOut = true;
+                  }
+
+                     // Position
+                  sp3data.RecType = 'P';
+                  for (j=0; j<3; j++)
+                     sp3data.x[j] = xvt.x[j]/1000.0;       // km
+                  sp3data.clk = xvt.clkbias * 1.0e6;    // microseconds
+
+                     //if (versionOut == 'c') for (j=0; j<4; j++) sp3data.sig[j]=...
+                  if (IODEmap[sat] == -1)
+                     IODEmap[sat] = sx.issue;
+                  if (IODEmap[sat] != sx.issue)
+                  {
+                     sp3data.orbitManeuverFlag = true;
+                     IODEmap[sat] = sx.issue;
+                  }
+                  else
+                  {
+                     sp3data.orbitManeuverFlag = false;
+                  }
+
+                  outstrm << sp3data;
+                  if (verboseLevel)
+                     sp3data.dump(cout);
+
+                     // Velocity
+                  sp3data.RecType = 'V';
+                  for (j=0; j<3; j++)
+                     sp3data.x[j] = xvt.v[j] * 10.0;         // dm/s
+                  sp3data.clk = xvt.clkdrift * 1.0e10;                  // 10**-4 us/s
+                     //if (versionOut == 'c') for (j=0; j<4; j++) sp3data.sig[j]=...
+
+                  outstrm << sp3data;
+                  if (verboseLevel)
+                     sp3data.dump(cout);
+               }
             }
-
-            outstrm << sp3data;
-            if (verboseLevel)
-               sp3data.dump(cout);
-
-               // Velocity
-            sp3data.RecType = 'V';
-            for (j=0; j<3; j++)
-               sp3data.x[j] = xvt.v[j] * 10.0;         // dm/s
-            sp3data.clk = xvt.clkdrift * 1.0e10;                  // 10**-4 us/s
-               //if (versionOut == 'c') for (j=0; j<4; j++) sp3data.sig[j]=...
-
-            outstrm << sp3data;
-            if (verboseLevel)
-               sp3data.dump(cout);
          }
-
-         tt += sp3header.epochInterval;
       }
          // don't forget this
          //outstrm << "EOF" << endl;
@@ -0,0 +1,229 @@
+//==============================================================================
+//
+//  This file is part of GNSSTk, the ARL:UT GNSS Toolkit.
+//
+//  The GNSSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GNSSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GNSSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin.
+//  Copyright 2004-2022, The Board of Regents of The University of Texas System
+//
+//==============================================================================
+
+//==============================================================================
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin, under contract to an agency or agencies
+//  within the U.S. Department of Defense. The U.S. Government retains all
+//  rights to use, duplicate, distribute, disclose, or release this software.
+//
+//  Pursuant to DoD Directive 523024
+//
+//  DISTRIBUTION STATEMENT A: This software has been approved for public
+//                            release, distribution is unlimited.
+//
+//==============================================================================
+
+/** \page apps
+ * - \subpage navcache - Compile RINEX navigation files into a binary cache
+ * \page navcache
+ * \tableofcontents
+ *
+ * \section navcache_name NAME
+ * navcache - Compile RINEX navigation files into a binary ephemeris cache
+ *
+ * \section navcache_synopsis SYNOPSIS
+ * <b>navcache</b>  <b>-h</b> <br/>
+ * <b>navcache</b> <b>[-d</b><b>]</b> <b>[-v</b><b>]</b> <b>-o</b>&nbsp;\argarg{ARG} \argarg{ARG} <b>[</b>...<b>]</b>
+ *
+ * \section navcache_description DESCRIPTION
+ * Read any number of RINEX navigation files once, and write all the
+ * ephemerides to a binary cache file, sorted and indexed by satellite
+ * and time.  PRSolve, WhereSat, findMoreThan12, bc2sp3, navdump and
+ * dfix load the cache (option \--navcache) by mapping it into memory,
+ * which is much faster than parsing the RINEX text again.
+ *
+ * The cache holds the ephemerides only; the RINEX headers (iono and
+ * time system corrections) are not cached, so for more than one system
+ * load the RINEX nav files as well, for the offsets between systems;
+ * the applications warn when a cache of several systems is loaded
+ * without them.  SP3 files cannot be cached.  The cache is written in
+ * the byte order of the machine that builds it.
+ *
+ * \dictionary
+ * \dicterm{-d, \--debug}
+ * \dicdef{Increase debug level}
+ * \dicterm{-v, \--verbose}
+ * \dicdef{Increase verbosity}
+ * \dicterm{-h, \--help}
+ * \dicdef{Print help usage}
+ * \dicterm{-o, \--output=\argarg{ARG}}
+ * \dicdef{Name of the output cache file, which is overwritten}
+ * \enddictionary
+ *
+ * \section navcache_examples EXAMPLES
+ *
+ * \cmdex{navcache -o brdc.navc data/arlm200a.15n data/arlm200b.15n}
+ *
+ * Compile the two nav files into brdc.navc, then use it with
+ *
+ * \cmdex{PRSolve \--navcache brdc.navc \--obs data/arlm200a.15o \--sol GPS:12:WPC}
+ *
+ * \section navcache_exit_status EXIT STATUS
+ * The following exit values are returned:
+ * \dictable
+ * \dictentry{0,No errors ocurred}
+ * \dictentry{1,A C++ exception occurred}
+ * \dictentry{2,An input file could not be read}
+ * \enddictable
+ */
+
+#include "NewNavInc.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gnsstk/BasicFramework.hpp>
+#include <gnsstk/Rinex3NavStream.hpp>
+#include <gnsstk/Rinex3NavHeader.hpp>
+#include <gnsstk/Rinex3NavData.hpp>
+#include <gnsstk/RinexSatID.hpp>
+#include <gnsstk/StringUtils.hpp>
+
+#include "NavCache.hpp"
+
+using namespace std;
+using namespace gnsstk;
+
+/// Read RINEX nav files and write them to a NavCache file.
+class NavCacheBuilder : public BasicFramework
+{
+public:
+      /** Initialize command-line options.
+       * @param[in] applName Application file name.
+       */
+   NavCacheBuilder(const string& applName);
+
+      /// Read the input files and write the cache.
+   void process() override;
+
+      /// Name of the output cache file.
+   CommandOptionWithAnyArg outputOpt;
+      /// All remaining command-line arguments are RINEX nav files.
+   CommandOptionRest filesOpt;
+};
+
+
+NavCacheBuilder ::
+NavCacheBuilder(const string& applName)
+      : BasicFramework(applName, "Compile RINEX navigation files into a binary"
+                       " ephemeris cache, indexed by satellite and time, for"
+                       " fast loading with --navcache"),
+        outputOpt('o', "output", "Name of the output cache file, which is"
+                  " overwritten", true),
+        filesOpt("NAV-FILE [...] (RINEX navigation, version 2 or 3)", true)
+{
+   outputOpt.setMaxCount(1);
+}
+
+
+void NavCacheBuilder ::
+process()
+{
+   vector<Rinex3NavData> data;
+   vector<string> names(filesOpt.getValue());
+   for (size_t i = 0; i < names.size(); i++)
+   {
+      Rinex3NavStream strm(names[i].c_str(), ios::in);
+      if (!strm.is_open())
+      {
+         cerr << "Unable to open \"" << names[i] << "\"" << endl;
+         exitCode = BasicFramework::EXIST_ERROR;
+         return;
+      }
+      Rinex3NavHeader head;
+      Rinex3NavData rnd;
+      size_t n = data.size();
+      strm >> head;
+      while (strm >> rnd)
+      {
+         data.push_back(rnd);
+      }
+         // normal end of file sets eof; a bad header or record does not
+      if (!strm.eof())
+      {
+         cerr << "Unable to read \"" << names[i] << "\"" << endl;
+         exitCode = BasicFramework::EXIST_ERROR;
+         return;
+      }
+      if (verboseLevel)
+      {
+         cout << "Read " << data.size()-n << " ephemerides from "
+              << names[i] << endl;
+      }
+   }
+
+   string fileout(outputOpt.getValue()[0]);
+   size_t nrec = NavCache::write(fileout, data);
+   if (verboseLevel)
+   {
+      NavCache cache;
+      string error;
+      if (!cache.open(fileout, error))
+      {
+         cerr << "Unable to reopen \"" << fileout << "\": " << error << endl;
+         exitCode = BasicFramework::EXIST_ERROR;
+         return;
+      }
+      cout << "Wrote " << nrec << " ephemerides (" << data.size()-nrec
+           << " duplicates removed) for " << cache.numSats()
+           << " satellites to " << fileout << endl;
+      for (size_t i = 0; i < cache.numSats(); i++)
+      {
+         const NavCache::IndexEntry& ie(cache.entry(i));
+         cout << "  " << RinexSatID(string(1,char(ie.sys))
+                                    + StringUtils::asString(ie.prn))
+              << " " << ie.count << endl;
+      }
+   }
+}
+
+
+int main(int argc, char* argv[])
+{
+#include "NewNavInit.h"
+   try
+   {
+      NavCacheBuilder app(argv[0]);
+      if (!app.initialize(argc, argv))
+         return app.exitCode;
+      app.run();
+      return app.exitCode;
+   }
+   catch(Exception& e)
+   {
+      cout << e << endl;
+   }
+   catch(std::exception& e)
+   {
+      cout << e.what() << endl;
+   }
+   catch(...)
+   {
+      cout << "unknown error" << endl;
+   }
+      // only reach this point if an exception was caught
+   return BasicFramework::EXCEPTION_ERROR;
+}
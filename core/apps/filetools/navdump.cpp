@@ -61,6 +61,7 @@
 #include <gnsstk/GLOCNavEph.hpp> // debug code
 #endif
 #include <gnsstk/DebugTrace.hpp>
+#include "NavCache.hpp"
 
 using namespace std;
 using namespace gnsstk;
@@ -197,7 +198,7 @@ public:
  * \section navdump_synopsis SYNOPSIS
  * <b>navdump</b>  <b>-h</b> <br/>
  * <b>navdump</b>  <b>-E</b>&nbsp;\argarg{ARG} <br/>
- * <b>navdump</b> <b>[-d</b><b>]</b> <b>[-v</b><b>]</b> <b>[-t</b>&nbsp;\argarg{ARG}<b>]</b> <b>[-l</b>&nbsp;\argarg{ARG}<b>]</b> <b>[-F</b>&nbsp;\argarg{ARG}<b>]</b> <b>[-X</b>&nbsp;\argarg{ARG}<b>]</b> <b>[\--xvt-file</b>&nbsp;\argarg{ARG}<b>]</b> <b>[-g</b>&nbsp;\argarg{ARG}<b>]</b> <b>[\--to-file</b>&nbsp;\argarg{ARG}<b>]</b> \argarg{ARG} <b>[</b>...<b>]</b>
+ * <b>navdump</b> <b>[-d</b><b>]</b> <b>[-v</b><b>]</b> <b>[-t</b>&nbsp;\argarg{ARG}<b>]</b> <b>[-l</b>&nbsp;\argarg{ARG}<b>]</b> <b>[-F</b>&nbsp;\argarg{ARG}<b>]</b> <b>[-X</b>&nbsp;\argarg{ARG}<b>]</b> <b>[\--xvt-file</b>&nbsp;\argarg{ARG}<b>]</b> <b>[-g</b>&nbsp;\argarg{ARG}<b>]</b> <b>[\--to-file</b>&nbsp;\argarg{ARG}<b>]</b> <b>[\--navcache</b>&nbsp;\argarg{ARG}<b>]</b> <b>[</b>\argarg{ARG}<b>]</b> <b>[</b>...<b>]</b>
  *
  * \section navdump_description DESCRIPTION
  * Print (to standard output) the parsed contents of any number of
@@ -230,6 +231,8 @@ public:
  * \dicdef{Print position in geodetic coordinates in addition to an XVT in ECEF, using the specified ellipsoid model (WGS84, GPS, PZ90, Galileo, CGCS2000)}
  * \dicterm{\--to-file=\argarg{ARG}}
  * \dicdef{File containing nav data to be loaded for the sole purpose of providing time offsets when doing time system conversions during look-ups for everything else.  Only makes sense to use with -F -X or --xvt-file when a time system is specified.}
+ * \dicterm{\--navcache=\argarg{ARG}}
+ * \dicdef{Ephemeris cache file(s) built by navcache, loaded with or in place of NAV-FILE}
  * \enddictionary
  *
  * \section navdump_examples EXAMPLES
@@ -276,6 +279,10 @@ public:
    CommandOptionWithAnyArg detailOpt;
       /// All remaining command-line arguments are treated as input files.
    CommandOptionRest filesOpt;
+      /// Pre-indexed ephemeris cache files built by navcache.
+   CommandOptionWithAnyArg navCacheOpt;
+      /// Make sure at least one of filesOpt and/or navCacheOpt is used.
+   CommandOptionOneOf inputOneOf;
       /// Get a specific object
    CommandOptionNavLibraryFind inqOpt;
       /// Get satellite XVT
@@ -559,7 +566,9 @@ NavDump(const string& applName)
         enumHelpOpt('E', "enum"),
         detail(DumpDetail::Full),
         ell(nullptr),
-        filesOpt("", true)
+        filesOpt(""),
+        navCacheOpt(0, "navcache", "Ephemeris cache file(s) built by"
+                    " navcache, loaded with or in place of NAV-FILE")
 {
       // Initialize these two items in here rather than in the
       // initializer list to guarantee execution order and avoid seg
@@ -569,6 +578,8 @@ NavDump(const string& applName)
                            ndfp->getFactoryFormats() + ")");
    detailOpt.setMaxCount(1);
    geodOpt.setMaxCount(1);
+   inputOneOf.addOption(&filesOpt);
+   inputOneOf.addOption(&navCacheOpt);
 }
 
 
@@ -691,6 +702,26 @@ process()
          exitCode = BasicFramework::EXIST_ERROR;
          return;
       }
+   }
+   names = navCacheOpt.getValue();
+   for (size_t i=0; i<names.size(); i++)
+   {
+      try
+      {
+         NavCache::loadFile(names[i], *navLib, nmts);
+      }
+      catch (Exception& e)
+      {
+         cerr << "Unable to load \"" << names[i] << "\": " << e.getText()
+              << endl;
+         exitCode = BasicFramework::EXIST_ERROR;
+         return;
+      }
+   }
+   string warn(NavCache::headerWarning(names, filesOpt.getCount()));
+   if (!warn.empty())
+   {
+      cerr << warn << endl;
    }
       // load time offset data
    ndfp->setTypeFilter({gnsstk::NavMessageType::TimeOffset});
@@ -64,7 +64,12 @@ public:
                             "Name for the merged output " + type + " file."
                             " Any existing file with that name will be"
                             " overwritten.",
-                            true)
+                            true),
+           streamOption(0,
+                        "stream",
+                        "Merge the input files record by record as they are"
+                        " read, instead of loading them all into memory."
+                        " Each input file must be in time order.")
    {
       outputFileOption.setMaxCount(1);
    }
@@ -80,6 +85,7 @@ protected:
 
    gnsstk::CommandOptionRest inputFileOption;
    gnsstk::CommandOptionWithAnyArg outputFileOption;
+   gnsstk::CommandOptionNoArg streamOption;
 };
 
 
@@ -0,0 +1,205 @@
+//==============================================================================
+//
+//  This file is part of GNSSTk, the ARL:UT GNSS Toolkit.
+//
+//  The GNSSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GNSSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GNSSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin.
+//  Copyright 2004-2022, The Board of Regents of The University of Texas System
+//
+//==============================================================================
+
+//==============================================================================
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin, under contract to an agency or agencies
+//  within the U.S. Department of Defense. The U.S. Government retains all
+//  rights to use, duplicate, distribute, disclose, or release this software.
+//
+//  Pursuant to DoD Directive 523024
+//
+//  DISTRIBUTION STATEMENT A: This software has been approved for public
+//                            release, distribution is unlimited.
+//
+//==============================================================================
+
+#ifndef STREAMMERGE_HPP
+#define STREAMMERGE_HPP
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gnsstk/CommonTime.hpp>
+#include <gnsstk/Exception.hpp>
+
+/** Merge files whose records are each in time order, or nearly so,
+ * without loading them: all of the files are opened and the next
+ * records of each are merged as they are written.  Only the records of
+ * each file within a look-ahead window of its earliest unwritten record
+ * are held in memory.
+ *
+ * The output is the same as that of FileFilterFrameWithHeader with
+ * sort(lessThan) and unique(equals), provided lessThan orders records
+ * by the time given by timeOf first. */
+template <class FileStream, class FileData, class FileHeader>
+class StreamMerge
+{
+public:
+      /** Open each of files and read its header.
+       * @throw gnsstk::Exception or std::exception if a file can't
+       *   be opened or its header read. */
+   StreamMerge(const std::vector<std::string>& files)
+         : names(files)
+   {
+      for (size_t i = 0; i < files.size(); i++)
+      {
+         std::shared_ptr<FileStream> s(new FileStream(files[i].c_str()));
+         s->exceptions(std::ios::failbit);
+         FileHeader header;
+         *s >> header;
+         streams.push_back(s);
+         headers.push_back(header);
+      }
+   }
+
+      /// Apply the functor to each header, e.g. to merge them.
+   template <class Operation>
+   Operation& touchHeader(Operation& op)
+   {
+      for (size_t i = 0; i < headers.size(); i++)
+         op(headers[i]);
+      return op;
+   }
+
+      /** Write header and then the merged records to outputFile.
+       * Records are written in order of lessThan; a record that equals
+       * the one written last is dropped.
+       * @param[in] timeOf functor returning the time of a record.
+       * @param[in] window look-ahead in seconds: each file must be in
+       *   order of timeOf to within window, i.e. no record may come
+       *   after one that is more than window seconds later.  Records
+       *   of equal time (CommonTime ==) may always be in any order
+       *   within a file.
+       * @throw gnsstk::Exception if a file is not in time order. */
+   template <class TimeOf, class LessThan, class Equals>
+   void writeFile(const std::string& outputFile, const FileHeader& header,
+                  TimeOf timeOf, LessThan lessThan, Equals equals,
+                  double window = 0.0)
+   {
+      FileStream out(outputFile.c_str(), std::ios::out);
+      out.exceptions(std::ios::failbit);
+      out << header;
+
+      std::vector<Cursor> cursors(streams.size());
+
+         // read file i until the next record is more than window after
+         // the earliest one held, keeping the held records sorted
+      auto fill = [&](size_t i) -> bool
+      {
+         Cursor& c(cursors[i]);
+         while (c.havePending)
+         {
+            gnsstk::CommonTime t(timeOf(c.pending));
+            if (!c.held.empty())
+            {
+               gnsstk::CommonTime t0(timeOf(c.held.front()));
+               if (t != t0 && t - t0 > window)
+                  break;
+            }
+            if (c.started && t < c.time)
+            {
+               gnsstk::Exception e(names[i] + " is not in time order,"
+                                  " to within the look-ahead; merge it"
+                                  " without --stream.");
+               GNSSTK_THROW(e);
+            }
+            c.held.insert(std::upper_bound(c.held.begin(), c.held.end(),
+                                           c.pending, lessThan),
+                          c.pending);
+            c.havePending = static_cast<bool>(*streams[i] >> c.pending);
+         }
+         return !c.held.empty();
+      };
+
+         // heap of the files by their next record, earliest on top;
+         // files with equivalent records are taken in input order
+      auto later = [&](size_t a, size_t b) -> bool
+      {
+         const FileData& da(cursors[a].held.front());
+         const FileData& db(cursors[b].held.front());
+         if (lessThan(db, da))
+            return true;
+         return (!lessThan(da, db) && b < a);
+      };
+      std::vector<size_t> heap;
+      for (size_t i = 0; i < cursors.size(); i++)
+      {
+         cursors[i].havePending =
+            static_cast<bool>(*streams[i] >> cursors[i].pending);
+         if (fill(i))
+            heap.push_back(i);
+      }
+      std::make_heap(heap.begin(), heap.end(), later);
+
+      FileData last;
+      bool haveLast = false;
+      while (!heap.empty())
+      {
+         std::pop_heap(heap.begin(), heap.end(), later);
+         size_t i = heap.back();
+         heap.pop_back();
+         Cursor& c(cursors[i]);
+         const FileData& d(c.held.front());
+         if (!haveLast || !equals(last, d))
+         {
+            out << d;
+            last = d;
+            haveLast = true;
+         }
+            // every record still to be read from file i must be at or
+            // after this one
+         c.time = timeOf(d);
+         c.started = true;
+         c.held.pop_front();
+         if (fill(i))
+         {
+            heap.push_back(i);
+            std::push_heap(heap.begin(), heap.end(), later);
+         }
+      }
+   }
+
+private:
+      /// Where the merge is in one file.
+   struct Cursor
+   {
+      Cursor() : havePending(false), started(false) {}
+      std::deque<FileData> held;    ///< records read but not merged, sorted
+      FileData pending;             ///< first record after held
+      bool havePending;             ///< pending was read
+      bool started;                 ///< time has been set
+      gnsstk::CommonTime time;      ///< time of the last record merged
+   };
+
+   std::vector<std::string> names;
+   std::vector<std::shared_ptr<FileStream> > streams;
+   std::vector<FileHeader> headers;
+};
+
+#endif
@@ -61,10 +61,14 @@
  * \dicdef{Increase verbosity}
  * \dicterm{-h, \--help}
  * \dicdef{Print help usage}
+ * \dicterm{\--stream}
+ * \dicdef{Merge the input files record by record as they are read, instead of loading them all into memory. Each input file must be in time order.}
  * \enddictionary
  *
- * \note mergeRinMet will load the entire contents of all input files into
- * memory before writing.
+ * \note Unless \--stream is given, mergeRinMet will load the entire
+ * contents of all input files into memory before writing.  With
+ * \--stream, only the records of the current epoch of each file are held,
+ * and the output is the same; a file found out of time order is an error.
  *
  * \section mergeRinMet_examples EXAMPLES
  *
@@ -97,6 +101,7 @@
 #include <gnsstk/SystemTime.hpp>
 
 #include "MergeFrame.hpp"
+#include "StreamMerge.hpp"
 
 using namespace std;
 using namespace gnsstk;
@@ -112,11 +117,34 @@ public:
 
 protected:
    virtual void process();
+
+private:
+      /// Set the pgm/runby/date fields of the merged header.
+   void setProgram(RinexMetHeader& header);
 };
 
 void MergeRinMet::process()
 {
    std::vector<std::string> files = inputFileOption.getValue();
+   std::string outputFile = outputFileOption.getValue().front();
+
+   if (streamOption.getCount())
+   {
+         // merge the data as it is read, using the same time check
+      StreamMerge<RinexMetStream, RinexMetData, RinexMetHeader> sm(files);
+
+         // get the header data
+      RinexMetHeaderTouchHeaderMerge merged;
+      sm.touchHeader(merged);
+      setProgram(merged.theHeader);
+
+         // write the header and the sorted, filtered data
+      sm.writeFile(outputFile, merged.theHeader,
+                   [](const RinexMetData& d) { return d.time; },
+                   RinexMetDataOperatorLessThanFull(merged.obsSet),
+                   RinexMetDataOperatorEqualsSimple());
+      return;
+   }
 
       // FFF will sort and merge the data using
       // a simple time check
@@ -131,16 +159,19 @@ void MergeRinMet::process()
    fff.sort(RinexMetDataOperatorLessThanFull(merged.obsSet));
    fff.unique(RinexMetDataOperatorEqualsSimple());
 
-      // set the pgm/runby/date field
-   merged.theHeader.fileProgram = std::string("mergeRinMet");
-   merged.theHeader.fileAgency = std::string("gnsstk");
-   merged.theHeader.date = CivilTime(SystemTime()).asString();
+   setProgram(merged.theHeader);
 
       // write the header
-   std::string outputFile = outputFileOption.getValue().front();
    fff.writeFile(outputFile, merged.theHeader);
 }
 
+void MergeRinMet::setProgram(RinexMetHeader& header)
+{
+   header.fileProgram = std::string("mergeRinMet");
+   header.fileAgency = std::string("gnsstk");
+   header.date = CivilTime(SystemTime()).asString();
+}
+
 int main(int argc, char* argv[])
 {
 #include "NewNavInit.h"
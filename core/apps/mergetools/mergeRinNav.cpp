@@ -61,10 +61,20 @@
  * \dicdef{Increase verbosity}
  * \dicterm{-h, \--help}
  * \dicdef{Print help usage}
+ * \dicterm{\--stream}
+ * \dicdef{Merge the input files record by record as they are read, instead of loading them all into memory. Each input file must be in order of transmit time, to within the look-ahead.}
+ * \dicterm{\--look-ahead=\argarg{SEC}}
+ * \dicdef{With \--stream, how far, in seconds, the records of an input file may be out of transmit time order (default 86400).}
  * \enddictionary
  *
- * \note mergeRinNav will load the entire contents of all input files into
- * memory before writing.
+ * \note Unless \--stream is given, mergeRinNav will load the entire
+ * contents of all input files into memory before writing.  With
+ * \--stream, each file is read only as far as \--look-ahead seconds of
+ * transmit time past its earliest unwritten record, and the output is
+ * the same.  Nav files are usually ordered by Toc, or by PRN and then
+ * Toc, rather than by transmit time; the default of one day covers
+ * either order in daily files.  A file out of order by more than the
+ * look-ahead is an error.
  *
  * \section mergeRinNav_examples EXAMPLES
  *
@@ -93,8 +103,11 @@
 #include <gnsstk/FileFilterFrameWithHeader.hpp>
 #include <gnsstk/SystemTime.hpp>
 #include <gnsstk/CivilTime.hpp>
+#include <gnsstk/GPSWeekSecond.hpp>
+#include <gnsstk/StringUtils.hpp>
 
 #include "MergeFrame.hpp"
+#include "StreamMerge.hpp"
 
 using namespace std;
 using namespace gnsstk;
@@ -105,16 +118,57 @@ public:
    MergeRinNav(char* arg0)
       : MergeFrame(arg0,
                    std::string("RINEX Nav"),
-                   std::string("Only unique nav subframes will be output and they will be sorted by time."))
-   {}
+                   std::string("Only unique nav subframes will be output and they will be sorted by time.")),
+        lookAheadOption(0, "look-ahead", "With --stream, how far, in seconds,"
+                        " the records of an input file may be out of"
+                        " transmit time order (default 86400).")
+   {
+      lookAheadOption.setMaxCount(1);
+   }
 
 protected:
    virtual void process();
+
+   gnsstk::CommandOptionWithNumberArg lookAheadOption;
+
+private:
+      /// Set the type, version and pgm/runby/date fields of the merged header.
+   void setProgram(Rinex3NavHeader& header);
 };
 
 void MergeRinNav::process()
 {
    std::vector<std::string> files = inputFileOption.getValue();
+   std::string outputFile = outputFileOption.getValue().front();
+
+   if (streamOption.getCount())
+   {
+         // merge the data as it is read; Rinex3NavDataOperatorLessThanFull
+         // orders by transmit time first, but files are ordered by Toc or
+         // PRN, so read ahead
+      double lookAhead = 86400.;
+      if (lookAheadOption.getCount())
+      {
+         lookAhead = StringUtils::asDouble(lookAheadOption.getValue()[0]);
+      }
+      StreamMerge<Rinex3NavStream, Rinex3NavData, Rinex3NavHeader> sm(files);
+
+         // get the header data
+      Rinex3NavHeaderTouchHeaderMerge merged;
+      sm.touchHeader(merged);
+      setProgram(merged.theHeader);
+
+         // write the header and the sorted, filtered data
+      sm.writeFile(outputFile, merged.theHeader,
+                   [](const Rinex3NavData& d)
+                   {
+                      return CommonTime(GPSWeekSecond(d.getXmitWeek(),
+                                                      d.getXmitSOW()));
+                   },
+                   Rinex3NavDataOperatorLessThanFull(),
+                   Rinex3NavDataOperatorEqualsFull(), lookAhead);
+      return;
+   }
 
       // FFF will sort and merge the obs data using
       // a simple time check
@@ -129,22 +183,25 @@ void MergeRinNav::process()
    fff.sort(Rinex3NavDataOperatorLessThanFull());
    fff.unique(Rinex3NavDataOperatorEqualsFull());
 
-      // set the pgm/runby/date field
-   merged.theHeader.fileType = string("NAVIGATION");
-   merged.theHeader.fileProgram = std::string("mergeRinNav");
-   merged.theHeader.fileAgency = std::string("gnsstk");
-   merged.theHeader.date = CivilTime(SystemTime()).asString();
-   merged.theHeader.version = 2.1;
-   merged.theHeader.valid |= gnsstk::Rinex3NavHeader::validVersion;
-   merged.theHeader.valid |= gnsstk::Rinex3NavHeader::validRunBy;
-   merged.theHeader.valid |= gnsstk::Rinex3NavHeader::validComment;
-   merged.theHeader.valid |= gnsstk::Rinex3NavHeader::validEoH;
+   setProgram(merged.theHeader);
 
       // write the header
-   std::string outputFile = outputFileOption.getValue().front();
    fff.writeFile(outputFile, merged.theHeader);
 }
 
+void MergeRinNav::setProgram(Rinex3NavHeader& header)
+{
+   header.fileType = string("NAVIGATION");
+   header.fileProgram = std::string("mergeRinNav");
+   header.fileAgency = std::string("gnsstk");
+   header.date = CivilTime(SystemTime()).asString();
+   header.version = 2.1;
+   header.valid |= gnsstk::Rinex3NavHeader::validVersion;
+   header.valid |= gnsstk::Rinex3NavHeader::validRunBy;
+   header.valid |= gnsstk::Rinex3NavHeader::validComment;
+   header.valid |= gnsstk::Rinex3NavHeader::validEoH;
+}
+
 int main(int argc, char* argv[])
 {
 #include "NewNavInit.h"
@@ -0,0 +1,251 @@
+//==============================================================================
+//
+//  This file is part of GNSSTk, the ARL:UT GNSS Toolkit.
+//
+//  The GNSSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GNSSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GNSSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin.
+//  Copyright 2004-2022, The Board of Regents of The University of Texas System
+//
+//==============================================================================
+
+//==============================================================================
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin, under contract to an agency or agencies
+//  within the U.S. Department of Defense. The U.S. Government retains all
+//  rights to use, duplicate, distribute, disclose, or release this software.
+//
+//  Pursuant to DoD Directive 523024
+//
+//  DISTRIBUTION STATEMENT A: This software has been approved for public
+//                            release, distribution is unlimited.
+//
+//==============================================================================
+
+/**
+ * @file PRSBinary.cpp
+ * Binary output of PRSolve; see PRSBinary.hpp
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+
+#include "PRSBinary.hpp"
+
+using namespace std;
+using namespace gnsstk;
+
+const uint32_t PRSBinary::version = 1;
+
+static const char prsBinaryMagic[8] = { 'G','N','S','S','P','R','S','B' };
+static const uint32_t prsByteOrder = 0x01020304;
+
+// schema line for a column: name, type (c8 char[8], i8 int64, f8 double) and
+// byte offset in the record
+#define PRSB_COLUMN(oss,Rec,name,type) \
+   oss << "COLUMN " << #name << " " << type << " " << offsetof(Rec,name) << "\n"
+
+// the same for the i'th element of an array column
+#define PRSB_ARRAY(oss,Rec,name,i,type) \
+   oss << "COLUMN " << #name << i << " " << type << " " \
+       << offsetof(Rec,name) + i*sizeof(((Rec*)0)->name[0]) << "\n"
+
+// columns of the time tag, common to several records
+#define PRSB_TIME(oss,Rec) \
+   PRSB_COLUMN(oss,Rec,day,"i8"); \
+   PRSB_COLUMN(oss,Rec,sod,"f8"); \
+   PRSB_COLUMN(oss,Rec,timeSystem,"i8")
+
+string PRSBinary ::
+schema(const vector<string>& descs)
+{
+   int i;
+   ostringstream oss;
+
+   oss << "PRSBINARY " << version << "\n";
+   for(size_t j=0; j<descs.size(); j++)
+      oss << "DESCRIPTOR " << j << " " << descs[j] << "\n";
+
+   oss << "RECORD " << SolutionType << " Solution " << sizeof(Solution) << "\n";
+   PRSB_COLUMN(oss,Solution,tag,"c8");
+   PRSB_COLUMN(oss,Solution,desc,"i8");
+   PRSB_COLUMN(oss,Solution,iret,"i8");
+   PRSB_TIME(oss,Solution);
+   PRSB_COLUMN(oss,Solution,nsvs,"i8");
+   PRSB_COLUMN(oss,Solution,niter,"i8");
+   PRSB_COLUMN(oss,Solution,flags,"i8");
+   PRSB_COLUMN(oss,Solution,nclk,"i8");
+   PRSB_COLUMN(oss,Solution,x,"f8");
+   PRSB_COLUMN(oss,Solution,y,"f8");
+   PRSB_COLUMN(oss,Solution,z,"f8");
+   PRSB_COLUMN(oss,Solution,cxx,"f8");
+   PRSB_COLUMN(oss,Solution,cxy,"f8");
+   PRSB_COLUMN(oss,Solution,cxz,"f8");
+   PRSB_COLUMN(oss,Solution,cyy,"f8");
+   PRSB_COLUMN(oss,Solution,cyz,"f8");
+   PRSB_COLUMN(oss,Solution,czz,"f8");
+   PRSB_COLUMN(oss,Solution,rms,"f8");
+   PRSB_COLUMN(oss,Solution,tdop,"f8");
+   PRSB_COLUMN(oss,Solution,pdop,"f8");
+   PRSB_COLUMN(oss,Solution,gdop,"f8");
+   PRSB_COLUMN(oss,Solution,slope,"f8");
+   PRSB_COLUMN(oss,Solution,conv,"f8");
+   for(i=0; i<MaxClocks; i++) PRSB_ARRAY(oss,Solution,clksys,i,"i8");
+   for(i=0; i<MaxClocks; i++) PRSB_ARRAY(oss,Solution,clk,i,"f8");
+
+   oss << "RECORD " << ResidualType << " Residual " << sizeof(Residual) << "\n";
+   PRSB_COLUMN(oss,Residual,tag,"c8");
+   PRSB_COLUMN(oss,Residual,desc,"i8");
+   PRSB_COLUMN(oss,Residual,iret,"i8");
+   PRSB_TIME(oss,Residual);
+   PRSB_COLUMN(oss,Residual,nsvs,"i8");
+   PRSB_COLUMN(oss,Residual,flags,"i8");
+   for(i=0; i<3; i++) PRSB_ARRAY(oss,Residual,v,i,"f8");
+
+   oss << "RECORD " << SatelliteType << " Satellite " << sizeof(Satellite) << "\n";
+   PRSB_COLUMN(oss,Satellite,sys,"i8");
+   PRSB_COLUMN(oss,Satellite,prn,"i8");
+
+   oss << "RECORD " << ORDType << " ORD " << sizeof(ORD) << "\n";
+   PRSB_COLUMN(oss,ORD,desc,"i8");
+   PRSB_COLUMN(oss,ORD,iret,"i8");
+   PRSB_TIME(oss,ORD);
+   PRSB_COLUMN(oss,ORD,sys,"i8");
+   PRSB_COLUMN(oss,ORD,prn,"i8");
+   PRSB_COLUMN(oss,ORD,elev,"f8");
+   PRSB_COLUMN(oss,ORD,iono,"f8");
+   PRSB_COLUMN(oss,ORD,ORD1,"f8");
+   PRSB_COLUMN(oss,ORD,ORD2,"f8");
+   PRSB_COLUMN(oss,ORD,ord,"f8");
+   PRSB_COLUMN(oss,ORD,clk,"f8");
+
+   oss << "END\n";
+   return oss.str();
+}
+
+void PRSBinary ::
+writeHeader(ostream& os, const vector<string>& descs)
+{
+   string text(schema(descs));
+   text.append((8 - text.size() % 8) % 8, ' ');    // keep the records aligned
+
+   Header head;
+   memcpy(head.magic, prsBinaryMagic, sizeof(prsBinaryMagic));
+   head.version = version;
+   head.byteOrder = prsByteOrder;
+   head.schemaSize = text.size();
+
+   os.write(reinterpret_cast<const char*>(&head), sizeof(head));
+   os.write(text.data(), text.size());
+   if(!os) {
+      Exception e("PRSolve binary output: failed to write the header");
+      GNSSTK_THROW(e);
+   }
+}
+
+bool PRSBinary ::
+readHeader(istream& is, vector<string>& descs, string& error)
+{
+   Header head;
+   is.read(reinterpret_cast<char*>(&head), sizeof(head));
+   if(!is || memcmp(head.magic, prsBinaryMagic, sizeof(prsBinaryMagic)) != 0) {
+      error = "not a PRSolve binary file";
+      return false;
+   }
+   if(head.byteOrder != prsByteOrder) {
+      error = "PRSolve binary file of another byte order";
+      return false;
+   }
+   if(head.version != version) {
+      error = "PRSolve binary file of another version";
+      return false;
+   }
+
+   string text(head.schemaSize, ' ');
+   is.read(&text[0], head.schemaSize);
+   if(!is) {
+      error = "PRSolve binary file is truncated";
+      return false;
+   }
+
+      // the descriptors, and the record sizes, which must be those of this
+      // version
+   descs.clear();
+   istringstream iss(text);
+   string line, key;
+   while(getline(iss, line)) {
+      istringstream ils(line);
+      ils >> key;
+      if(key == "DESCRIPTOR") {
+         size_t n;
+         string desc;
+         ils >> n >> desc;
+         if(n != descs.size()) {
+            error = "PRSolve binary file has an invalid schema";
+            return false;
+         }
+         descs.push_back(desc);
+      }
+      else if(key == "RECORD") {
+         uint32_t type;
+         size_t size;
+         string name;
+         ils >> type >> name >> size;
+         if((type == SolutionType && size != sizeof(Solution)) ||
+            (type == ResidualType && size != sizeof(Residual)) ||
+            (type == SatelliteType && size != sizeof(Satellite)) ||
+            (type == ORDType && size != sizeof(ORD)))
+         {
+            error = "PRSolve binary file has records of another size";
+            return false;
+         }
+      }
+   }
+
+   return true;
+}
+
+uint32_t PRSBinary ::
+readRecord(istream& is, vector<char>& buf)
+{
+   RecordHead head;
+   is.read(reinterpret_cast<char*>(&head), sizeof(head));
+   if(is.gcount() == 0 && is.eof())
+      return 0;
+   if(!is || head.size < sizeof(head)) {
+      Exception e("PRSolve binary file is truncated");
+      GNSSTK_THROW(e);
+   }
+
+   buf.resize(head.size);
+   memcpy(&buf[0], &head, sizeof(head));
+   is.read(&buf[sizeof(head)], head.size - sizeof(head));
+   if(!is) {
+      Exception e("PRSolve binary file is truncated");
+      GNSSTK_THROW(e);
+   }
+   return head.type;
+}
+
+void PRSBinary ::
+setTag(char tag[8], const string& str)
+{
+   memset(tag, 0, 8);
+   memcpy(tag, str.data(), min(str.size(), size_t(7)));
+}
@@ -0,0 +1,232 @@
+//==============================================================================
+//
+//  This file is part of GNSSTk, the ARL:UT GNSS Toolkit.
+//
+//  The GNSSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GNSSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GNSSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin.
+//  Copyright 2004-2022, The Board of Regents of The University of Texas System
+//
+//==============================================================================
+
+//==============================================================================
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin, under contract to an agency or agencies
+//  within the U.S. Department of Defense. The U.S. Government retains all
+//  rights to use, duplicate, distribute, disclose, or release this software.
+//
+//  Pursuant to DoD Directive 523024
+//
+//  DISTRIBUTION STATEMENT A: This software has been approved for public
+//                            release, distribution is unlimited.
+//
+//==============================================================================
+
+#ifndef PRSBINARY_HPP
+#define PRSBINARY_HPP
+
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <gnsstk/Exception.hpp>
+#include <gnsstk/CommonTime.hpp>
+
+/** Binary output of PRSolve (--binout), and its reader (prsbindump).
+ *
+ * The file starts with a Header, followed by a text schema that
+ * describes the file: the solution descriptors, then for each record
+ * type its name and size, and the name, type and byte offset of each
+ * column.  The records follow the schema.  Every record is of fixed
+ * size, and starts with its type and size, so a reader may skip
+ * record types it does not know.
+ *
+ * Solution records (SPS and RPF) hold the solution, its covariance
+ * and the RAIM statistics, and are each followed by a Satellite
+ * record for each satellite in the solution.  Residual records (SPR,
+ * SNE, RPR, RNE) hold the solution minus the known position, and ORD
+ * records hold the observed range deviations.  All columns are 8
+ * bytes so the records pack without padding.  Times are CommonTime
+ * day, second of day and time system.
+ *
+ * The file is written in the native byte order; a file of different
+ * byte order, or of an incompatible version, is rejected by
+ * readHeader(). */
+class PRSBinary
+{
+public:
+      /// Record types.
+   enum RecordType
+   {
+      SolutionType = 1,
+      ResidualType,
+      SatelliteType,
+      ORDType
+   };
+
+      /// Bits of the flags column.
+   enum Flags
+   {
+      ValidFlag = 1,          ///< PRSolution::isValid()
+      RMSFlag = 2,            ///< large RMS residual
+      SlopeFlag = 4,          ///< large RAIM slope
+      TropFlag = 8            ///< missed trop. correction
+   };
+
+      /// Maximum number of clock solutions (systems) in a Solution record.
+   static const int MaxClocks = 4;
+
+      /// File header, at the start of the file.
+   struct Header
+   {
+      char magic[8];          ///< "GNSSPRSB"
+      uint32_t version;       ///< format version, PRSBinary::version
+      uint32_t byteOrder;     ///< 0x01020304 in the native byte order
+      uint64_t schemaSize;    ///< bytes of schema text that follow, padded to 8
+   };
+
+      /// Common start of every record.
+   struct RecordHead
+   {
+      uint32_t type;          ///< RecordType
+      uint32_t size;          ///< size of the record in bytes
+   };
+
+      /// SPS or RPF solution.
+   struct Solution
+   {
+      RecordHead head;
+      char tag[8];            ///< "SPS" or "RPF"
+      int64_t desc;           ///< index of the solution descriptor
+      int64_t iret;           ///< return value of the solution
+      int64_t day;            ///< time tag: day,
+      double sod;             ///< second of day
+      int64_t timeSystem;     ///< and time system
+      int64_t nsvs;           ///< number of satellites used
+      int64_t niter;          ///< number of iterations
+      int64_t flags;          ///< Flags
+      int64_t nclk;           ///< number of clock solutions
+      double x, y, z;         ///< ECEF XYZ solution (m)
+      double cxx, cxy, cxz, cyy, cyz, czz;   ///< its covariance (m^2)
+      double rms, tdop, pdop, gdop, slope, conv;
+      int64_t clksys[MaxClocks];             ///< RINEX system character
+      double clk[MaxClocks];                 ///< clock solution (m)
+   };
+
+      /// SPR, SNE, RPR or RNE residual of the solution from the known position.
+   struct Residual
+   {
+      RecordHead head;
+      char tag[8];            ///< "SPR", "SNE", "RPR" or "RNE"
+      int64_t desc;           ///< index of the solution descriptor
+      int64_t iret;           ///< return value of the solution
+      int64_t day;            ///< time tag: day,
+      double sod;             ///< second of day
+      int64_t timeSystem;     ///< and time system
+      int64_t nsvs;           ///< number of satellites used
+      int64_t flags;          ///< Flags
+      double v[3];            ///< residual XYZ or NEU (m)
+   };
+
+      /// A satellite of the preceding Solution record.
+   struct Satellite
+   {
+      RecordHead head;
+      int64_t sys;            ///< RINEX system character
+      int64_t prn;            ///< satellite PRN, negative if rejected by RAIM
+   };
+
+      /// Observed range deviation of one satellite.
+   struct ORD
+   {
+      RecordHead head;
+      int64_t desc;           ///< index of the solution descriptor
+      int64_t iret;           ///< return value of the solution
+      int64_t day;            ///< time tag: day,
+      double sod;             ///< second of day
+      int64_t timeSystem;     ///< and time system
+      int64_t sys;            ///< RINEX system character
+      int64_t prn;            ///< satellite PRN
+      double elev, iono, ORD1, ORD2, ord, clk;
+   };
+
+      /// Version of the file format.
+   static const uint32_t version;
+
+      /** Write the header and schema of a file.
+       * @param[in] os the output stream, opened in binary mode.
+       * @param[in] descs the solution descriptors, indexed by the desc
+       *   column of the records.
+       * @throw gnsstk::Exception if the stream fails. */
+   static void writeHeader(std::ostream& os,
+                           const std::vector<std::string>& descs);
+
+      /** Read and check the header and schema of a file.
+       * @param[in] is the input stream, opened in binary mode.
+       * @param[out] descs the solution descriptors.
+       * @param[out] error reason for failure.
+       * @return true if the file is valid. */
+   static bool readHeader(std::istream& is, std::vector<std::string>& descs,
+                          std::string& error);
+
+      /** Read the next record, of any type.
+       * @param[in] is the input stream, after readHeader().
+       * @param[out] buf the record, starting with a RecordHead; buf is
+       *   resized as needed.
+       * @return the RecordType, or 0 at the end of the file.
+       * @throw gnsstk::Exception if the file is truncated. */
+   static uint32_t readRecord(std::istream& is, std::vector<char>& buf);
+
+      /// The schema text that writeHeader() writes.
+   static std::string schema(const std::vector<std::string>& descs);
+
+      /// Append a record to a buffer, setting its head.
+   template <class Rec>
+   static void append(std::string& buf, Rec& rec, RecordType type)
+   {
+      rec.head.type = type;
+      rec.head.size = sizeof(Rec);
+      buf.append(reinterpret_cast<const char*>(&rec), sizeof(Rec));
+   }
+
+      /// Set the time columns of a record.
+   template <class Rec>
+   static void setTime(Rec& rec, const gnsstk::CommonTime& t)
+   {
+      long day, sod;
+      double fsod;
+      t.get(day, sod, fsod);
+      rec.day = day;
+      rec.sod = sod + fsod;
+      rec.timeSystem = static_cast<int64_t>(t.getTimeSystem());
+   }
+
+      /// Get the time of a record.
+   template <class Rec>
+   static gnsstk::CommonTime getTime(const Rec& rec)
+   {
+      gnsstk::CommonTime t;
+      t.set(long(rec.day), double(rec.sod),
+            static_cast<gnsstk::TimeSystem>(rec.timeSystem));
+      return t;
+   }
+
+      /// Set a tag column, e.g. "RPF".
+   static void setTag(char tag[8], const std::string& str);
+};
+
+#endif
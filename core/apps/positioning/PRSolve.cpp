@@ -66,6 +66,8 @@
  * \dicdef{Ephemeris+clock (SP3 format) file name(s) [repeatable] ()}
  * \dicterm{\--nav \argarg{FN}}
  * \dicdef{RINEX nav file name(s) (also cf. \--BCEpast) [repeatable] ()}
+ * \dicterm{\--navcache \argarg{FN}}
+ * \dicdef{Nav cache file name(s), built by navcache, with or in place of \--nav [repeatable] ()}
  * \dicterm{\--clk \argarg{FN}}
  * \dicdef{Clock (RINEX format) file name(s) [repeatable] ()}
  * \dicterm{\--met \argarg{FN}}
@@ -112,8 +114,14 @@
  * \dicdef{Maximum iteration count in linearized LS (10)}
  * \dicterm{\--conv \argarg{LIM}}
  * \dicdef{Maximum convergence criterion in estimation in meters (3.00e-07)}
+ * \dicterm{\--warm}
+ * \dicdef{Start each epoch from the previous solution [w/o \--ref] and previous RAIM rejections (don't)}
  * \dicterm{\--Trop \argarg{M,T,P,H}}
  * \dicdef{Trop model \argarg{M}, one of Zero,Black,Saas,NewB,Neill,GG,GGHt,Global with optional weather T(C),P(mb),RH(%)] (NewB,20.0,1013.0,50.0)}
+ * \dicterm{\--threads \argarg{N}}
+ * \dicdef{Compute solutions at each epoch concurrently on N threads, each with its own copy of the nav data [1: serial] (1)}
+ * \dicterm{\--pipeline \argarg{N}}
+ * \dicdef{Read, solve and write on 3 threads, queueing N epochs [0: serial] (0)}
  * \dicterm{\--log \argarg{FN}}
  * \dicdef{Output log file name (prs.log)}
  * \dicterm{\--out \argarg{FN}}
@@ -126,6 +134,10 @@
  * \dicdef{Output autonomous pseudorange solution [tag SPS, no RAIM] (don't)}
  * \dicterm{\--ORDs \argarg{FN}}
  * \dicdef{Write ORDs (Observed Range Deviations) to file \argarg{FN} [\--ref req'd] ()}
+ * \dicterm{\--binout \argarg{FN}}
+ * \dicdef{Write solutions, covariances, residuals and ORDs [\--ref] to binary file \argarg{FN}, instead of their NAV, RMS and POS lines in the log; see prsbindump ()}
+ * \dicterm{\--batch \argarg{DIR}}
+ * \dicdef{Process each obs file as a separate station, concurrently on \--threads threads; output for obs file \argarg{F} goes to \argarg{DIR}/\argarg{F}.log [.ord,.out] ()}
  * \dicterm{\--timefmt \argarg{F}}
  * \dicdef{Format for time tags in output (%4F %10.3g)}
  * \dicterm{\--SOLhelp}
@@ -208,6 +220,17 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <new>
+#include <cstdlib>
+#include <cstring>
 
 // GNSSTK
 #include <gnsstk/Exception.hpp>
@@ -268,6 +291,9 @@
 
 #include <gnsstk/BasicFramework.hpp>   // for EXCEPTION_ERROR
 
+#include "NavCache.hpp"
+#include "PRSBinary.hpp"
+
 //------------------------------------------------------------------------------------
 using namespace std;
 using namespace gnsstk;
@@ -278,6 +304,70 @@ string Version(string("5.3 1/27/20"));
 
 // forward declarations
 class SolutionObject;
+class ORDSet;
+class Station;
+
+//------------------------------------------------------------------------------------
+// The nav stores used by concurrent solutions (--threads) and stations (--batch).
+// NavLibrary and its factories do not promise that lookups are safe from several
+// threads at once (e.g. SP3 data and time offsets are built at lookup time), so
+// rather than take turns with one store, each job leases a store of its own (see
+// NavLease) for its lookups and its solution. The first store is C.navLib; others
+// are loaded from the same files, on demand, so there are no more stores than jobs
+// that have run at the same time.
+class NavStores {
+public:
+   NavStores() noexcept : load(0), nstores(0) { }
+
+   // set the first store, and the function that loads the others like it
+   void init(NavLibrary *lib, void (*loader)(NavLibrary&)) noexcept
+   {
+      lock_guard<mutex> lock(mtx);
+      load = loader;
+      nstores = 1;
+      idle.assign(1, lib);
+   }
+
+      /** make sure there are at least n stores, so the first n leases at the same
+       * time do not wait for a store to load
+       * @throw Exception, from the loader */
+   void reserve(size_t n);
+
+      /** take a store no other thread is using, loading a new one if all are busy
+       * @throw Exception, from the loader */
+   NavLibrary& lease(void);
+
+   // return a store taken by lease()
+   void release(NavLibrary& lib) noexcept
+   {
+      lock_guard<mutex> lock(mtx);
+      idle.push_back(&lib);
+   }
+
+   // number of stores loaded, including the first
+   size_t size(void) noexcept { lock_guard<mutex> lock(mtx); return nstores; }
+
+private:
+      /** load a new store; mtx is not held, so others may lease meanwhile
+       * @throw Exception */
+   NavLibrary *create(void);
+
+   void (*load)(NavLibrary&);          // loads a store like the first
+   vector<unique_ptr<NavLibrary> > stores;   // all but the first, owned here
+   vector<NavLibrary*> idle;           // stores not leased
+   size_t nstores;                     // stores loaded or being loaded
+   mutex mtx;
+}; // end class NavStores
+
+// A store leased from NavStores for the lifetime of the NavLease
+class NavLease {
+public:
+   NavLease(NavStores& s) : lib(s.lease()), stores(s) { }
+   ~NavLease() { stores.release(lib); }
+   NavLibrary& lib;              // the store
+private:
+   NavStores& stores;
+}; // end class NavLease
 
 //------------------------------------------------------------------------------------
 // Object for command line input and global data
@@ -287,10 +377,7 @@ public:
 
    // Default and only constructor
    Configuration() noexcept { SetDefaults(); }
-   virtual ~Configuration()
-   {
-      delete pTrop;
-   }
+   virtual ~Configuration() { }
 
    // Create, parse and process command line options and user input
    int ProcessUserInput(int argc, char **argv) noexcept;
@@ -307,9 +394,9 @@ public:
    //TD on clau, this leads to the SPS algorithm failing to converge on some problems.
    int ExtraProcessing(string& errors, string& extras) noexcept;
 
-      /** update weather in the trop model using the Met store
-       * @throw Exception */
-   void setWeather(const CommonTime& ttag);
+   // Create a copy of the trop model ptm, of type TropType, including its current
+   // state; caller owns the returned object.
+   TropModel *CloneTropModel(const TropModel *ptm) const;
 
 private:
 
@@ -332,6 +419,7 @@ public:
    vector<string> InputSP3Files; // SP3 ephemeris+clock file names
    vector<string> InputClkFiles; // RINEX clock file names
    vector<string> InputNavFiles; // RINEX nav file names
+   vector<string> InputNavCaches;// nav cache (navcache) file names
    vector<string> InputMetFiles; // RINEX met file names
    vector<string> InputDCBFiles; // differential code bias C1-P1 file names
 
@@ -350,11 +438,13 @@ public:
    vector<RinexSatID> exclSat;// exclude satellites
 
    bool PisY;                 // Interpret RINEX 2 P code as if the receiver was keyed
-   bool SPSout,ORDout;        // output autonomous solutions? ORDs?
+   bool SPSout;               // output autonomous solutions?
    bool outver2;              // output RINEX version 2 (OutputObsFile)
    string LogFile;            // output log file (required)
    string OutputORDFile;      // output ORD file
+   string OutputBinFile;      // output binary file
    string OutputObsFile;      // output RINEX obs file
+   string BatchDir;           // batch mode: output directory, one station per file
    string userfmt;            // user's time format for output
    string refPosStr;          // temp used to parse --ref input
 
@@ -368,13 +458,17 @@ public:
    int maxReject;             // Max number of sats to reject [-1 for no limit]
    int nIter;                 // Maximum iteration count in linearized LS
    double convLimit;          // Minimum convergence criterion in estimation (meters)
+   bool warmStart;            // start each epoch from previous solution, rejections
 
    string TropStr;            // temp used to parse --trop
 
+   int nThreads;              // number of threads used to compute solutions
+   int pipeline;              // max epochs queued between read/solve/write, 0: serial
+
    // end of command line input
 
    // output file streams
-   ofstream logstrm, ordstrm; // for LogFile, OutputORDFile
+   ofstream logstrm;          // for LogFile
 
    // time formats
    static const string calfmt, gpsfmt, longfmt;
@@ -382,6 +476,9 @@ public:
    // stores
       /// High level nav store interface.
    NavLibrary navLib;
+      /** navLib, and copies of it for concurrent jobs; once the stores are
+       * loaded, navLib is used only through a NavLease */
+   NavStores navStores;
       /// nav data file reader
    std::shared_ptr<NavDataFactory> ndfp;
    list<RinexMetData> MetStore;
@@ -391,13 +488,13 @@ public:
    int PZ90ITRF, PZ90WGS84;         // Helmert transforms after 20 Sept 07
 
    // trop models
-   TropModel *pTrop;          // to pass to PRS
+   shared_ptr<TropModel> pTrop;  // to pass to PRS, via each Station
    string TropType;           // key ~ Black, NewB, etc; use to identify model
    bool TropPos,TropTime;     // true when trop model has been init with Pos,time
                               // default weather
    double defaultTemp,defaultPress,defaultHumid;
 
-   // solutions to build
+   // solutions to build; each Station processes a copy
    vector<SolutionObject> SolObjs;     // solution objects to process
 
    // reference position and rotation matrix
@@ -421,6 +518,153 @@ const string Configuration::calfmt = string("%04Y/%02m/%02d %02H:%02M:%02S");
 const string Configuration::gpsfmt = string("%4F %10.3g");
 const string Configuration::longfmt = calfmt + " = %4F %w %10.3g %P";
 
+//------------------------------------------------------------------------------------
+// Equivalent of LOG(level), but the message is appended to the string buf, or
+// written to the stream buf, rather than to the log stream. Used by SolutionObject,
+// which may compute its solution on a worker thread (--threads); the buffer is then
+// written to the log, in descriptor order, so the log is the same as a serial run.
+// Also used by Station, which in batch mode (--batch) has its own log file.
+#define LOGTO(buf,level) \
+   if(level > LOGlevel) ; else BufferedLog(buf).get()
+
+class BufferedLog {
+public:
+   BufferedLog(string& buf) : buffer(&buf), stream(0) { }
+   BufferedLog(ostream& os) : buffer(0), stream(&os) { }
+   // like LOG, terminate each message with a newline, and flush a stream
+   ~BufferedLog()
+   {
+      oss << endl;
+      if(buffer) *buffer += oss.str();
+      else { *stream << oss.str(); stream->flush(); }
+   }
+   ostringstream& get(void) { return oss; }
+private:
+   string *buffer;
+   ostream *stream;
+   ostringstream oss;
+};
+
+//------------------------------------------------------------------------------------
+// Pool of worker threads used to compute solutions concurrently (--threads).
+// run(n,job) calls job(i) for i=0..n-1, spread over the workers and the calling
+// thread, and returns when all calls have finished; an exception thrown by any job
+// is rethrown by run() in the calling thread.
+class WorkerPool {
+public:
+   // nthreads includes the calling thread, so nthreads-1 workers are created
+   WorkerPool(int nthreads);
+   ~WorkerPool();
+
+   // number of threads, including the caller
+   int size(void) const { return workers.size()+1; }
+
+      /** Call job(i) for i=0..n-1, concurrently, and wait for all to finish
+       * @throw whatever job throws */
+   void run(size_t n, const function<void(size_t)>& job);
+
+private:
+   void work(void);        // worker thread loop
+   void doJobs(void);      // take and do jobs until there are none left
+
+   vector<thread> workers;
+   mutex mtx;
+   condition_variable cvStart, cvDone;
+   const function<void(size_t)> *pJob;       // current job, valid during run()
+   size_t nJobs, nextJob, nDone;
+   unsigned long generation;                 // counts calls to run()
+   exception_ptr error;                      // first exception thrown by a job
+   bool quit;
+}; // end class WorkerPool
+
+//------------------------------------------------------------------------------------
+// Queue of at most maxsize items between two stages of the pipeline (--pipeline).
+// push() waits while the queue is full, and pop() while it is empty. After close(),
+// push() fails, and pop() fails once the queue is empty.
+template <class T> class BoundedQueue {
+public:
+   BoundedQueue(size_t n) : maxsize(n > 0 ? n : 1), closed(false) { }
+
+   // add item to the queue; return false, dropping item, if the queue is closed
+   bool push(T&& item)
+   {
+      unique_lock<mutex> lock(mtx);
+      cvPush.wait(lock, [this]{ return closed || items.size() < maxsize; });
+      if(closed) return false;
+      items.push_back(std::move(item));
+      cvPop.notify_one();
+      return true;
+   }
+
+   // take the oldest item; return false if the queue is closed and empty
+   bool pop(T& item)
+   {
+      unique_lock<mutex> lock(mtx);
+      cvPop.wait(lock, [this]{ return closed || !items.empty(); });
+      if(items.empty()) return false;
+      item = std::move(items.front());
+      items.pop_front();
+      cvPush.notify_one();
+      return true;
+   }
+
+   void close(void)
+   {
+      lock_guard<mutex> lock(mtx);
+      closed = true;
+      cvPush.notify_all();
+      cvPop.notify_all();
+   }
+
+private:
+   size_t maxsize;
+   deque<T> items;
+   mutex mtx;
+   condition_variable cvPush, cvPop;
+   bool closed;
+}; // end class BoundedQueue
+
+// seconds elapsed since beg
+static double SecondsSince(const chrono::steady_clock::time_point& beg)
+{
+   return chrono::duration<double>(chrono::steady_clock::now()-beg).count();
+}
+
+//------------------------------------------------------------------------------------
+// Heap allocation counting is a development diagnostic, compiled in only with
+// -DPRSOLVE_COUNT_ALLOCS: operator new is then replaced to count the allocations
+// made by each thread, so that those made per epoch by each solution can be
+// reported (with --verbose, and in the --batch summary). The cheaper count of
+// per-epoch buffer regrowths (SolutionObject::regrows()) is made in any build,
+// and reported on the timing line of the log and in the --batch summary.
+#ifdef PRSOLVE_COUNT_ALLOCS
+static thread_local unsigned long nHeapAllocs(0);
+
+void *operator new(size_t n)
+{
+   ++nHeapAllocs;
+   if(void *p = malloc(n > 0 ? n : 1)) return p;
+   throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+#endif
+
+// Add the heap allocations made by this thread during the lifetime of the
+// AllocCounter to count; does nothing without PRSOLVE_COUNT_ALLOCS
+class AllocCounter {
+public:
+#ifdef PRSOLVE_COUNT_ALLOCS
+   AllocCounter(unsigned long& n) noexcept : count(n), start(nHeapAllocs) { }
+   ~AllocCounter() { count += nHeapAllocs - start; }
+private:
+   unsigned long& count;
+   unsigned long start;
+#else
+   AllocCounter(unsigned long&) noexcept { }
+#endif
+};
+
 //------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------
 // Encapsulate one observation datum that will be input to PRSolution, including a
@@ -646,6 +890,19 @@ public:
       ParseDescriptor();
 
       nepochs = 0;
+      descIndex = 0;
+      allocsNow = allocsFirst = allocsMax = allocsTotal = 0;
+      nallocs = 0;
+      regrowsNow = nRegrows = 0;
+      for(int i=0; i<NBufs; i++) bufCaps[i] = 0;
+      haveWarm = false;
+      nReuseTried = nReused = 0;
+
+      // per-epoch buffers of fixed size
+      Vres.resize(3);
+      Cres.resize(3,3);
+      Vneu.resize(3);
+      Cneu.resize(3,3);
 
       // for initialization of constants and PRSolution
       Configuration& C(Configuration::Instance());
@@ -656,6 +913,7 @@ public:
       prs.NSatsReject = C.maxReject;
       prs.MaxNIterations = C.nIter;
       prs.ConvergenceLimit = C.convLimit;
+      iterHist.assign(C.nIter+1, 0);
 
       // initialize apriori solution
       if(C.knownPos.getCoordinateSystem() != Position::Unknown)
@@ -678,7 +936,7 @@ public:
    // return string containing dump
    string dump(int level, string msg="SOLN", string msg2="") noexcept;
 
-   // reset the object before each epoch
+   // reset the object before each epoch; buffers keep their capacity
    void EpochReset(void) noexcept;
 
    // Given a RINEX data object, pull out the data to be used, and set the flag
@@ -691,18 +949,60 @@ public:
        * CollectData() same return value as RAIMCompute()
        * @throw Exception
        */
-   int ComputeSolution(const CommonTime& t);
+   int ComputeSolution(const CommonTime& t, Station& S);
 
-      /** Write out ORDs - call after ComputeSolution pass it iret
-       * from ComputeSolution
+      /** Compute the ORDs, to be written by ORDSet::write() - call after
+       * ComputeSolution pass it iret from ComputeSolution
        * @throw Exception
        */
-   int WriteORDs(const CommonTime& t, const int iret);
+   void GetORDs(const int iret, ORDSet& ords) const;
 
-      /** Output final results
+   // write the DAT record (and on the first epoch, record headers) to LogBuffer;
+   // call before ComputeSolution(), since RAIM marks rejected Satellites
+   void LogDataRecord(const string& tag, bool firstepoch) noexcept;
+
+   // append the contents of LogBuffer to the log output buf, and clear it
+   void FlushLog(string& buf) noexcept;
+
+   // add a Solution record, with the Satellite records, or a Residual record of
+   // V, to BinBuffer, for the binary output (--binout)
+   void AddSolutionRecord(const string& tag, const CommonTime& ttag, int iret)
+      noexcept;
+   void AddResidualRecord(const string& tag, const CommonTime& ttag, int iret,
+                          const Vector<double>& V) noexcept;
+
+   // append the contents of BinBuffer to buf, and clear it
+   void FlushBinary(string& buf) noexcept;
+
+   // trop model to be used by this solution
+   TropModel *getTrop(void) noexcept;
+
+   // compute the residuals of the solution from C.knownPos, and their covariance,
+   // in XYZ (Vres,Cres) and rotated to NEU (Vneu,Cneu), without reallocating
+   void ComputeResiduals(void) noexcept;
+
+   // call at the end of each epoch, to add the epoch's allocations and buffer
+   // regrowths to the stats
+   void EndAllocCount(void) noexcept;
+
+   // heap allocations per epoch, as a string for the final summary
+   string allocString(void) const;
+
+   // mean heap allocations per epoch after the first, or 0 if none
+   double allocsPerEpoch(void) const noexcept
+   { return (nallocs > 1 ? double(allocsTotal)/(nallocs-1) : 0.0); }
+
+   // per-epoch buffer regrowths after the first epoch, and the epochs counted
+   unsigned long regrows(void) const noexcept { return nRegrows; }
+   long regrowEpochs(void) const noexcept { return (nallocs > 1 ? nallocs-1 : 0); }
+
+   // histogram of RAIM iteration counts (and --warm reuse), for the final summary
+   string iterString(void) const;
+
+      /** Output final results to the log os
        * @throw Exception
        */
-   void FinalOutput(void);
+   void FinalOutput(ostream& os);
 
 // member data
 
@@ -728,11 +1028,61 @@ public:
    vector<double> ERanges;                   // corr eph range, parallel to Satellites
    vector<double> RIono;                     // range iono, parallel to Satellites
    vector<double> R1,R2;                     // raw ranges, parallel to Satellites
-   multimap<RinexSatID,string> UsedObsIDs;   // valid or not; may be comma-sep. list
+   // valid or not; may be comma-sep. list; in order of satellite, as CollectData()
+   // is called in that order
+   vector<pair<RinexSatID,string> > UsedObsIDs;
+
+   // Per-epoch buffers of ComputeSolution, kept so their memory is reused.
+   // The weights (inverse measurement variance) are diagonal, so kept as a vector;
+   // PRSolution takes a dense matrix, so this is copied to the diagonal of one of
+   // invMCovs, one per number of satellites, each allocated only once.
+   vector<double> invMeasVar;                // weights, parallel to Satellites
+   vector<Matrix<double> > invMCovs;         // index is number of satellites
+   Matrix<double> noWeights;                 // empty, used when not weighting
+   Matrix<double> SVP;                       // for SimplePRSolution
+   Vector<double> Resid,Slopes;              // for SimplePRSolution
+   Vector<double> Vres,Vneu;                 // residuals in XYZ and NEU (3)
+   Matrix<double> Cres,Cneu;                 // and their covariance (3x3)
+
+   // heap allocations by EpochReset, CollectData and ComputeSolution: in this
+   // epoch, in the first epoch, and the max and total over the later epochs
+   unsigned long allocsNow, allocsFirst, allocsMax, allocsTotal;
+   long nallocs;                             // number of epochs counted
+
+   // Regrowths of the per-epoch buffers after the first epoch, counted in any
+   // build as a cheap stand-in for the allocations: the buffers whose capacity
+   // (for Matrix and Vector, which reallocate on resize, the size) changed at the
+   // end of an epoch, plus the invMCovs matrices allocated during it (regrowsNow).
+   static const int NBufs = 15;
+   size_t bufCaps[NBufs];                    // capacities at the last epoch
+   unsigned long regrowsNow, nRegrows;
+
+   // warm start (--warm): the last good RAIM solution, the satellites at that
+   // epoch and those RAIM rejected; when the satellites are the same, the rejected
+   // ones are tried first without a search, in place in prs
+   bool haveWarm;
+   double warmXYZ[3];
+   vector<SatID> warmSats, warmRejected;
+   long nReuseTried, nReused;                // tries, and tries accepted
+
+   // histogram of the number of LS iterations in the RAIM solution
+   vector<long> iterHist;
 
    // the PRS itself
    PRSolution prs;
 
+   // trop model used by this solution; this is the Station's model, unless
+   // solutions are computed concurrently (--threads), when each has a copy.
+   shared_ptr<TropModel> pTrop;
+
+   // log output of this solution, written to the log by FlushLog()
+   string LogBuffer;
+
+   // binary output of this solution (--binout), written by FlushBinary(), and the
+   // index of this solution in Station::SolObjs, which identifies it in the file
+   string BinBuffer;
+   int descIndex;
+
    // statistics on the solution residuals
    int nepochs;
    WtdAveStats statsXYZresid;                // RPF (XYZ) minus reference position
@@ -742,6 +1092,173 @@ public:
 
 }; // end class SolutionObject
 
+//------------------------------------------------------------------------------------
+// ORDs of one solution at one epoch, computed by SolutionObject::GetORDs() in the
+// solve stage of ProcessFiles, and written in the write stage.
+class ORDSet {
+public:
+      /** Write the ORD records for time to os
+       * @throw Exception */
+   void write(const CommonTime& time, ostream& os) const;
+
+      /** Write the ORD records for time to the binary output os (--binout)
+       * @throw Exception */
+   void writeBinary(const CommonTime& time, ostream& os) const;
+
+   string Descriptor;            // solution descriptor
+   int descIndex;                // index of the solution in Station::SolObjs
+   int iret;                     // return value of ComputeSolution
+   vector<RinexSatID> sats;      // satellites
+   vector<double> elev, iono;    // elevation and iono delay, parallel to sats
+   vector<double> ORD1, ORD2;    // ORD of the raw ranges, parallel to sats
+   vector<double> ORD, clk;      // ORD and clock, parallel to sats
+
+}; // end class ORDSet
+
+//------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------
+// Object to encapsulate the processing of one station: its RINEX obs files, and the
+// solutions, trop model, weather and output that go with them. Normally all the
+// input obs files form one station, with output to the log file. In batch mode
+// (--batch) each obs file is an independent station, processed concurrently with
+// the others, with its own output files in C.BatchDir.
+class Station {
+public:
+      /** Constructor; copy the SolutionObjects from C.SolObjs. If name is empty,
+       * output goes to the log file and the trop model is C.pTrop; otherwise
+       * output goes to files <name>.* in C.BatchDir and the trop model is a copy.
+       * @throw Exception */
+   Station(const vector<string>& obsfiles, const string& name);
+
+   // open the log file in batch mode; return false, and set error, on failure
+   bool OpenLog(void) noexcept;
+
+   // stream for log output: the log file, or in batch mode the station's log
+   ostream& log(void) noexcept { return *plog; }
+
+      /** update weather in the trop model(s) using the Met store; log to buf
+       * @throw Exception */
+   void setWeather(const CommonTime& ttag, string& buf);
+
+      /** Output final results for each solution
+       * @throw Exception */
+   void FinalOutput(void);
+
+   // buffer regrowths after the first epoch, summed over the valid solutions
+   unsigned long regrows(void) const noexcept;
+
+// member data
+   string Name;                  // station name (batch mode) ~ obs file name
+   vector<string> ObsFiles;      // RINEX obs file names
+   string LogFile;               // output log file (batch mode)
+   string OutputORDFile;         // output ORD file
+   string OutputBinFile;         // output binary file
+   string OutputObsFile;         // output RINEX obs file
+
+   ofstream logstrm;             // for LogFile
+   ostream *plog;                // log output, logstrm or the log file
+   ofstream ordstrm;             // for OutputORDFile
+   bool ORDout;                  // output ORDs?
+   ofstream binstrm;             // for OutputBinFile
+   bool BINout;                  // output binary?
+   bool ORDcalc;                 // compute ORDs, for ORDout, or BINout with --ref
+
+   vector<SolutionObject> SolObjs;     // solution objects to process
+
+   // trop model, shared by SolObjs unless they are computed concurrently
+   shared_ptr<TropModel> pTrop;
+   bool TropPos,TropTime;        // true when trop model has been init with Pos,time
+
+   // current weather, and the current entry in the Met store
+   double Temp,Press,Humid;
+   list<RinexMetData>::const_iterator metit;
+   CommonTime metTime;
+
+   long nepochs;                 // number of epochs processed
+   double seconds;               // wallclock time of processing
+   string error;                 // reason processing failed (batch mode)
+
+}; // end class Station
+
+//------------------------------------------------------------------------------------
+// One item passed through the stages of ProcessFiles: the header of an obs file, an
+// epoch of data, or the end of processing. Each stage appends its log output to
+// LogText, and the write stage writes it, so the log is in order in any mode.
+class EpochItem {
+public:
+   enum ItemType { Header, Data, End };
+
+   EpochItem() noexcept
+      : type(End), nfile(0), timesystem(TimeSystem::Unknown), DCBcorr(false) { }
+
+   ItemType type;
+   size_t nfile;                 // index of the obs file in Station::ObsFiles
+
+   // Header: the header, its time system, and the indexes for DCB correction
+   Rinex3ObsHeader Rhead;
+   TimeSystem timesystem;
+   bool DCBcorr;
+   map<string,int> mapDCBindex;
+
+   // Data: the epoch, and the output of the solve stage
+   Rinex3ObsData Rdata;
+   vector<ORDSet> ORDs;          // ORDs of each valid solution, if Station::ORDcalc
+   string BinData;               // binary output records, if Station::BINout
+   vector<string> Comments;      // comments for output RINEX, if any
+
+   string LogText;               // log output
+
+}; // end class EpochItem
+
+//------------------------------------------------------------------------------------
+// The processing of the obs files of a Station, in three stages through which
+// EpochItems pass in order: Read (read the obs files, select epochs), Solve (collect
+// data, compute solutions) and Write (log, ORD and RINEX output). ProcessFiles
+// passes each item through the stages in turn, or runs them concurrently.
+class FileProcessor {
+public:
+   // if useThreads, compute the solutions with a WorkerPool (--threads)
+   FileProcessor(Station& s, bool useThreads);
+
+      /** the stages; Read() fills item, the others process it
+       * @throw Exception */
+   void Read(EpochItem& item);
+   void Solve(EpochItem& item);
+   void Write(EpochItem& item);
+
+      /** run the stages on 3 threads, with queues of depth items (--pipeline)
+       * @throw Exception */
+   void Pipeline(size_t depth);
+
+   Station& S;
+   int nfiles;                   // number of files read successfully
+   double readSeconds, solveSeconds, writeSeconds;    // busy time of each stage
+
+private:
+      /** open the output files, called by Read() on the first header
+       * @throw Exception */
+   void OpenOutput(string& log);
+
+   Position PrevPos;             // a priori position, for elevation and ORDs
+   unique_ptr<WorkerPool> pool;  // computes solutions (--threads)
+   Rinex3ObsStream ostrm;        // output RINEX, opened by Read, used by Write
+
+   // read stage
+   size_t nfile;                 // current obs file
+   unique_ptr<Rinex3ObsStream> istrm;      // the open obs file
+   Rinex3ObsHeader Rhead;        // its header
+   int iret;                     // 0 ok, or could not: 1 open, 2 read header, 3 data
+   bool readFirst;               // true until the first epoch is read
+
+   // solve stage
+   Rinex3ObsHeader SolveRhead;   // header of the current file
+   bool DCBcorr;                 // correct the current file for DCB
+   map<string,int> mapDCBindex;  // index of C1C in each system
+   bool firstepoch;              // true until the first epoch is solved
+   vector<int> iretSol;          // return values of ComputeSolution
+
+}; // end class FileProcessor
+
 //------------------------------------------------------------------------------------
 // prototypes
 /**
@@ -749,7 +1266,15 @@ public:
 int Initialize(string& errors);
 /**
  * @throw Exception */
-int ProcessFiles(void);
+int ProcessFiles(Station& S, bool useThreads);
+/**
+ * @throw Exception */
+int ProcessBatch(void);
+// configure the SP3 store, once loaded, for C.navLib and its copies
+void ConfigureSP3Store(SP3NavDataFactory& sp3fact);
+/**
+ * @throw Exception */
+void LoadNavStore(NavLibrary& lib);
 
 //------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------
@@ -762,6 +1287,7 @@ int main(int argc, char **argv)
 try {
    int iret;
    clock_t totaltime(clock());
+   string regrowMsg;          // buffer regrowths, for the timing line
    Epoch wallclkbeg;
    wallclkbeg.setLocalTime();
 
@@ -783,16 +1309,40 @@ try {
          break;
       }
 
+      // batch mode: process each obs file as a station, with its own output
+      if(!C.BatchDir.empty()) {
+         int nsta = ProcessBatch();
+         LOG(VERBOSE) << "Successfully processed " << nsta
+            << " station" << (nsta != 1 ? "s.":".");
+         break;
+      }
+
       // open files, read, compute solutions and output
-      int nfiles = ProcessFiles();
+      Station S(C.InputObsFiles, string());
+      int nfiles = ProcessFiles(S, true);
       if(nfiles < 0) break;
       LOG(VERBOSE) << "Successfully read " << nfiles
          << " RINEX observation file" << (nfiles > 1 ? "s.":".");
 
       // output final results
-      for(size_t i=0; i<C.SolObjs.size(); ++i) {
-         LOG(INFO) << "\n ----- Final output " << C.SolObjs[i].Descriptor << " -----";
-         C.SolObjs[i].FinalOutput();
+      S.FinalOutput();
+      regrowMsg = " Per-epoch buffer regrowths after the first epoch: "
+                  + asString(S.regrows()) + ".";
+
+      // wallclock time of the processing, to the screen only so the log is
+      // unchanged; e.g. to compare --threads
+      cout << C.PrgmName << " solve timing: " << S.nepochs << " epochs in "
+         << fixed << setprecision(3) << S.seconds << " sec wallclock using "
+         << C.nThreads << " thread" << (C.nThreads > 1 ? "s." : ".") << endl;
+
+      // heap allocations and iterations per epoch, to the screen only so the
+      // log is unchanged
+      if(C.verbose) for(size_t i=0; i<S.SolObjs.size(); i++) {
+         if(!S.SolObjs[i].isValid) continue;
+#ifdef PRSOLVE_COUNT_ALLOCS
+         cout << S.SolObjs[i].allocString() << endl;
+#endif
+         cout << S.SolObjs[i].iterString() << endl;
       }
 
       break;      // mandatory
@@ -806,7 +1356,8 @@ try {
       ostringstream oss;
       oss << C.PrgmName << " timing: processing " << fixed << setprecision(3)
          << double(totaltime)/double(CLOCKS_PER_SEC) << " sec, wallclock: "
-         << setprecision(0) << (wallclkend-wallclkbeg) << " sec.\n";
+         << setprecision(0) << (wallclkend-wallclkbeg) << " sec." << regrowMsg
+         << "\n";
       LOGstrm << oss.str();
       cout << oss.str();
    }
@@ -839,6 +1390,15 @@ try {
    C.navLib.addFactory(C.ndfp);
       // without clock, SP3 doesn't work.
    C.navLib.setTypeFilter({NavMessageType::Ephemeris, NavMessageType::Clock});
+   // nav caches (--navcache) are loaded into factories of their own
+   vector<shared_ptr<RinexNavDataFactory> > cacheFacts;
+   // count the ephemerides of a system in all the factories
+   auto countEph = [&](SatelliteSystem sys) -> size_t {
+      size_t n(mfndfp->count(sys, NavMessageType::Ephemeris));
+      for(size_t k=0; k<cacheFacts.size(); k++)
+         n += cacheFacts[k]->count(sys, NavMessageType::Ephemeris);
+      return n;
+   };
 
    errors = string("");
 
@@ -847,6 +1407,7 @@ try {
    include_path(C.SP3path, C.InputSP3Files);
    include_path(C.Clkpath, C.InputClkFiles);
    include_path(C.Navpath, C.InputNavFiles);
+   include_path(C.Navpath, C.InputNavCaches);
    include_path(C.Metpath, C.InputMetFiles);
    include_path(C.DCBpath, C.InputDCBFiles);
 
@@ -854,6 +1415,7 @@ try {
    expand_filename(C.InputSP3Files);
    expand_filename(C.InputClkFiles);
    expand_filename(C.InputNavFiles);
+   expand_filename(C.InputNavCaches);
    expand_filename(C.InputMetFiles);
    expand_filename(C.InputDCBFiles);
 
@@ -993,8 +1555,7 @@ try {
       LOG(VERBOSE) << "SP3 Ephemeris store contains "
          << sp3fact->size() << " data";
 
-      // set to linear interpolation, as this is best estimate for clocks - TD input?
-      sp3fact->setClockLinearInterp();     // changes 'interp order' to 2: linear
+      ConfigureSP3Store(*sp3fact);
 
       set<SatID> sats(sp3fact->getIndexSet(CommonTime::BEGINNING_OF_TIME,
                                            CommonTime::END_OF_TIME));
@@ -1011,16 +1572,6 @@ try {
       //C.SP3EphStore.setClockGapInterval(C.SP3EphStore.getClockTimeStep()+1.);
       //C.SP3EphStore.setClockMaxInterval(2*C.SP3EphStore.getClockTimeStep()+1.);
 
-      // ignore predictions for now // TD make user input?
-      sp3fact->rejectPredPositions(true);
-      sp3fact->rejectPredClocks(true);
-
-      // set gap checking  NB be sure InterpolationOrder is set first
-      sp3fact->setPositionInterpOrder(10);
-      sp3fact->setPosGapInterval(dtp+1.);
-      sp3fact->setPosMaxInterval(
-         (sp3fact->getPositionInterpOrder()-1) * dtp + 1.);
-
       // dump the SP3 ephemeris store; while looping, check the GLO freq channel
       LOG(VERBOSE) << "\nDump clock and position stores, including file stores";
       // NB clock dumps are huge!
@@ -1064,9 +1615,25 @@ try {
 
    // -------- Nav files --------------------------
    // NB Nav files may set GLOfreqChannel
-   if(C.InputNavFiles.size() > 0) {
+   if(C.InputNavFiles.size() > 0 || C.InputNavCaches.size() > 0) {
       try {
-         for(nread=0,nfile=0; nfile < C.InputNavFiles.size(); nfile++) {
+         // nav caches are already indexed, and load without parsing only the
+         // ephemerides near the time limits
+         for(nread=0,nfile=0; nfile < C.InputNavCaches.size(); nfile++) {
+            shared_ptr<RinexNavDataFactory> fact;
+            size_t n = NavCache::loadFile(C.InputNavCaches[nfile], C.navLib,
+                           {NavMessageType::Ephemeris, NavMessageType::Clock},
+                           C.beginTime, C.endTime, &fact);
+            if(fact) cacheFacts.push_back(fact);
+            nread += 1;
+            LOG(VERBOSE) << "Read " << n << " ephemerides from nav cache "
+                         << C.InputNavCaches[nfile] << ".";
+         }
+         string warn(NavCache::headerWarning(C.InputNavCaches,
+                                             C.InputNavFiles.size()));
+         if(!warn.empty()) LOG(WARNING) << warn;
+
+         for(nfile=0; nfile < C.InputNavFiles.size(); nfile++) {
             string filename(C.InputNavFiles[nfile]);
             if (!C.ndfp->addDataSource(filename))
             {
@@ -1105,23 +1672,20 @@ try {
       }
 
       if(isValid) {
+         size_t nmsg(mfndfp->size());
+         for(i=0; i<cacheFacts.size(); i++) nmsg += cacheFacts[i]->size();
          LOG(VERBOSE) << "Read " << nread << " RINEX navigation files, containing "
-            << mfndfp->size() << " messages, into store.";
+            << nmsg << " messages, into store.";
          LOG(VERBOSE) << "GPS ephemeris store contains "
-            << mfndfp->count(SatelliteSystem::GPS, NavMessageType::Ephemeris)
-            << " ephemerides.";
+            << countEph(SatelliteSystem::GPS) << " ephemerides.";
          LOG(VERBOSE) << "GAL ephemeris store contains "
-            << mfndfp->count(SatelliteSystem::Galileo,NavMessageType::Ephemeris)
-            << " ephemerides.";
+            << countEph(SatelliteSystem::Galileo) << " ephemerides.";
          LOG(VERBOSE) << "BDS ephemeris store contains "
-            << mfndfp->count(SatelliteSystem::BeiDou, NavMessageType::Ephemeris)
-            << " ephemerides.";
+            << countEph(SatelliteSystem::BeiDou) << " ephemerides.";
          LOG(VERBOSE) << "QZS ephemeris store contains "
-            << mfndfp->count(SatelliteSystem::QZSS, NavMessageType::Ephemeris)
-            << " ephemerides.";
+            << countEph(SatelliteSystem::QZSS) << " ephemerides.";
          LOG(VERBOSE) << "GLO ephemeris store contains "
-            << mfndfp->count(SatelliteSystem::Glonass,NavMessageType::Ephemeris)
-            << " satellites.";
+            << countEph(SatelliteSystem::Glonass) << " satellites.";
          // dump the entire store
          C.navLib.dump(LOGstrm,(C.debug > -1 ? DumpDetail::Full
                                 : DumpDetail::OneLine));
@@ -1353,7 +1917,7 @@ try {
       for(size_t k=0; k<SObj.sysChars.size(); k++) {
          RinexSatID sat;
          sat.fromString(SObj.sysChars[k]);
-         int n = mfndfp->count(sat.system, NavMessageType::Ephemeris);
+         int n = countEph(sat.system);
          if(n == 0) {
             LOG(WARNING) << "Warning - no ephemeris found for system "
                << RinexObsID::map1to3sys[SObj.sysChars[k]]
@@ -1399,392 +1963,821 @@ try {
    errors = ossE.str();
 
    if(!isValid) return -5;
+
+   // concurrent jobs use copies of the nav store
+   C.navStores.init(&C.navLib, LoadNavStore);
+
    return 0;
 }
 catch(Exception& e) { GNSSTK_RETHROW(e); }
 }  // end Initialize()
 
 //------------------------------------------------------------------------------------
+void ConfigureSP3Store(SP3NavDataFactory& sp3fact)
+{
+   // set to linear interpolation, as this is best estimate for clocks - TD input?
+   sp3fact.setClockLinearInterp();     // changes 'interp order' to 2: linear
+
+   // ignore predictions for now // TD make user input?
+   sp3fact.rejectPredPositions(true);
+   sp3fact.rejectPredClocks(true);
+
+   // set gap checking  NB be sure InterpolationOrder is set first
+   set<SatID> sats(sp3fact.getIndexSet(CommonTime::BEGINNING_OF_TIME,
+                                       CommonTime::END_OF_TIME));
+   double dtp = sp3fact.getPositionTimeStep(*sats.rbegin());
+   sp3fact.setPositionInterpOrder(10);
+   sp3fact.setPosGapInterval(dtp+1.);
+   sp3fact.setPosMaxInterval((sp3fact.getPositionInterpOrder()-1) * dtp + 1.);
+}
+
+//------------------------------------------------------------------------------------
+// Load lib with the files that Initialize() loaded into C.navLib, in the same order
+// and with the same configuration, for use by one job at a time (see NavStores).
+// The files have been read once already, so they are not checked again here.
+void LoadNavStore(NavLibrary& lib)
+{
+try {
+   Configuration& C(Configuration::Instance());
+   size_t nfile;
+
+   shared_ptr<MultiFormatNavDataFactory> ndfp(
+                                 make_shared<MultiFormatNavDataFactory>());
+   lib.addFactory(ndfp);
+   lib.setTypeFilter({NavMessageType::Ephemeris, NavMessageType::Clock});
+
+   // SP3 files, sorted on start time by Initialize(), then RINEX clock files
+   shared_ptr<SP3NavDataFactory> sp3fact(ndfp->getFactory<SP3NavDataFactory>());
+   if(C.InputSP3Files.size() > 0 && C.InputClkFiles.size() > 0) {
+      sp3fact->rejectBadClocks(false);
+      sp3fact->useRinexClockData();
+   }
+   for(nfile=0; nfile<C.InputSP3Files.size(); nfile++)
+      ndfp->addDataSource(C.InputSP3Files[nfile]);
+   for(nfile=0; nfile<C.InputClkFiles.size(); nfile++)
+      ndfp->addDataSource(C.InputClkFiles[nfile]);
+   if(sp3fact->size() > 0) ConfigureSP3Store(*sp3fact);
+
+   // nav caches and nav files
+   for(nfile=0; nfile<C.InputNavCaches.size(); nfile++)
+      NavCache::loadFile(C.InputNavCaches[nfile], lib,
+                         {NavMessageType::Ephemeris, NavMessageType::Clock},
+                         C.beginTime, C.endTime);
+   for(nfile=0; nfile<C.InputNavFiles.size(); nfile++)
+      ndfp->addDataSource(C.InputNavFiles[nfile]);
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}  // end LoadNavStore()
+
+//------------------------------------------------------------------------------------
+// Process the obs files of station S; if useThreads, compute the solutions at each
+// epoch concurrently (--threads), and run the read, solve and write stages
+// concurrently (--pipeline).
 // Return 0 ok, >0 number of files successfully read, <0 fatal error
-int ProcessFiles(void)
+int ProcessFiles(Station& S, bool useThreads)
 {
 try {
    Configuration& C(Configuration::Instance());
-   bool firstepoch(true);
-   int k,iret,nfiles;
-   size_t i,j,nfile;
-   Position PrevPos(C.knownPos);
-   Rinex3ObsStream ostrm;
+   FileProcessor FP(S, useThreads);
+   chrono::steady_clock::time_point beg(chrono::steady_clock::now());
+
+   // the pipeline is not used with --debug, because debug output from the solution
+   // algorithm goes straight to the log, while the write stage is writing to it
+   if(!useThreads || C.pipeline < 1 || C.debug > -1) {
+      // serial: each item passes through all the stages before the next is read
+      unique_ptr<EpochItem> item;
+      do {
+         item.reset(new EpochItem());
+         FP.Read(*item);
+         FP.Solve(*item);
+         FP.Write(*item);
+      } while(item->type != EpochItem::End);
+   }
+   else {
+      FP.Pipeline(C.pipeline);
+      double wall(SecondsSince(beg));
+
+      // busy time of each stage; the slowest limits the throughput
+      const char *slowest("read");
+      if(FP.solveSeconds > FP.readSeconds) slowest = "solve";
+      if(FP.writeSeconds > max(FP.readSeconds,FP.solveSeconds)) slowest = "write";
+      LOGTO(S.log(),INFO) << C.PrgmName << " pipeline timing: read " << fixed
+         << setprecision(3) << FP.readSeconds << " sec, solve " << FP.solveSeconds
+         << " sec, write " << FP.writeSeconds << " sec, wallclock " << wall
+         << " sec, " << S.nepochs << " epochs, queue " << C.pipeline
+         << " (slowest stage: " << slowest << ")";
+   }
+   S.seconds = SecondsSince(beg);
 
-   for(nfiles=0,nfile=0; nfile<C.InputObsFiles.size(); nfile++) {
-      Rinex3ObsStream istrm;
-      Rinex3ObsHeader Rhead, Rheadout;
-      Rinex3ObsData Rdata;
-      string filename(C.InputObsFiles[nfile]);
+   return FP.nfiles;
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}  // end ProcessFiles()
 
-      if (C.PisY)
-      {
-         LOG(DEBUG) << "Converting P/W code data to Y code";
-         Rhead.PisY = C.PisY;
-      }
+//------------------------------------------------------------------------------------
+FileProcessor::FileProcessor(Station& s, bool useThreads)
+   : S(s), nfiles(0), readSeconds(0.0), solveSeconds(0.0), writeSeconds(0.0),
+     PrevPos(Configuration::Instance().knownPos), nfile(0), iret(0),
+     readFirst(true), DCBcorr(false), firstepoch(true)
+{
+   Configuration& C(Configuration::Instance());
 
-      // iret is set to 0 ok, or could not: 1 open file, 2 read header, 3 read data
-      iret = 0;
+   // worker pool for computing the solutions concurrently; not used with --debug
+   // because debug output from the solution algorithm cannot be kept in order.
+   if(useThreads && C.nThreads > 1 && S.SolObjs.size() > 1 && C.debug < 0) {
+      pool.reset(new WorkerPool(min(size_t(C.nThreads),S.SolObjs.size())));
+      C.navStores.reserve(pool->size());     // one nav store per thread
+      LOGTO(S.log(),VERBOSE) << "Compute solutions using " << pool->size()
+         << " threads";
+   }
+}
 
-      // open the file ------------------------------------------------
-      istrm.open(filename.c_str(),ios::in);
-      if(!istrm.is_open()) {
-         LOG(WARNING) << "Warning : could not open file " << filename;
-         iret = 1;
-         continue;
-      }
-      else
-         LOG(VERBOSE) << "Opened input file " << filename;
-      istrm.exceptions(ios::failbit);
+//------------------------------------------------------------------------------------
+// Read stage: open the obs files in turn; for each, produce a Header item, then a
+// Data item for each epoch to be processed; finally produce the End item.
+// Also open the output files, after reading the first header, as always.
+void FileProcessor::Read(EpochItem& item)
+{
+try {
+   Configuration& C(Configuration::Instance());
+   size_t i;
+   string& log(item.LogText);
+
+   while(1) {
+      // open the next file and read the header -----------------------
+      if(!istrm) {
+         if(nfile >= S.ObsFiles.size()) {
+            item.type = EpochItem::End;
+            return;
+         }
 
-      // read the header ----------------------------------------------
-      try { istrm >> Rhead; }
-      catch(Exception& e) {
-         LOG(WARNING) << "Warning : Failed to read header; dump follows.";
-         Rhead.dump(LOGstrm);
-         istrm.close();
-         iret = 2;
-         continue;
-      }
-      if(C.verbose) {
-         LOG(VERBOSE) << "Input header for RINEX file " << filename;
-         Rhead.dump(LOGstrm);
-         LOG(VERBOSE) << "Time system for RINEX file " << filename
-                      << " is " << gnsstk::StringUtils::asString(istrm.timesystem);
-      }
+         string filename(S.ObsFiles[nfile]);
+         istrm.reset(new Rinex3ObsStream());
+         Rhead = Rinex3ObsHeader();
 
-      // does header include C1C (for DCB correction)?
-      bool DCBcorr(false);
-      map<string,int> mapDCBindex;
-      for(;;) {
-         map<string,vector<RinexObsID> >::const_iterator sit;
-         sit = Rhead.mapObsTypes.begin();
-         for( ; sit != Rhead.mapObsTypes.end(); ++sit) {
-            for(i=0; i<sit->second.size(); i++) {
-               if(asString(sit->second[i]) == string("C1C")) {
-                  DCBcorr = true;
-                  mapDCBindex.insert(map<string,int>::value_type(sit->first,i));
-                  LOG(DEBUG) << "Correct for DCB: found " << asString(sit->second[i])
-                     << " for system " << sit->first << " at index " << i;
-                  break;
-               }
-            }
+         if (C.PisY)
+         {
+            LOGTO(log,DEBUG) << "Converting P/W code data to Y code";
+            Rhead.PisY = C.PisY;
          }
-         break;
-      }
-
-      // do on first epoch only
-      if(firstepoch) {
-         // if writing to output RINEX, open and write header ---------
-         if(!C.OutputObsFile.empty()) {
-            ostrm.open(C.OutputObsFile.c_str(),ios::out);
-            if(!ostrm.is_open()) {
-               LOG(WARNING) << "Warning : could not open output file "
-                  << C.OutputObsFile;
-               C.OutputObsFile = string();
-            }
-            else {
-               LOG(VERBOSE) << "Opened output RINEX file " << C.OutputObsFile;
-               ostrm.exceptions(ios::failbit);
 
-               // copy header and modify it?
-               Rheadout = Rhead;
-               Rheadout.fileProgram = C.PrgmName;
+         // iret is set to 0 ok, or could not: 1 open file, 2 read header, 3 read data
+         iret = 0;
 
-               // output version 2
-               if(C.outver2)
-                  Rheadout.prepareVer2Write();
+         // open the file
+         istrm->open(filename.c_str(),ios::in);
+         if(!istrm->is_open()) {
+            LOGTO(log,WARNING) << "Warning : could not open file " << filename;
+            istrm.reset();
+            nfile++;
+            continue;
+         }
+         else
+            LOGTO(log,VERBOSE) << "Opened input file " << filename;
+         istrm->exceptions(ios::failbit);
 
-               ostrm << Rheadout;
-            }
+         // read the header
+         try { *istrm >> Rhead; }
+         catch(Exception& e) {
+            LOGTO(log,WARNING) << "Warning : Failed to read header; dump follows.";
+            ostringstream oss;
+            Rhead.dump(oss);
+            log += oss.str();
+            istrm->close();
+            istrm.reset();
+            nfile++;
+            continue;
+         }
+         if(C.verbose) {
+            LOGTO(log,VERBOSE) << "Input header for RINEX file " << filename;
+            ostringstream oss;
+            Rhead.dump(oss);
+            log += oss.str();
+            LOGTO(log,VERBOSE) << "Time system for RINEX file " << filename
+               << " is " << gnsstk::StringUtils::asString(istrm->timesystem);
          }
 
-         // if writing out ORDs, open the file
-         if(!C.OutputORDFile.empty()) {
-            C.ordstrm.open(C.OutputORDFile.c_str(),ios::out);
-            if(!C.ordstrm.is_open()) {
-               LOG(WARNING) << "Warning : failed to open output ORDs file "
-                  << C.OutputORDFile << " - abort ORD output.";
-               C.ORDout = false;
-            }
-            else {
-               C.ORDout = true;
-               // write header
-               C.ordstrm << "ORD sat week  sec-of-wk   elev   iono     ORD1"
-                  << "     ORD2      ORD    Clock  Solution_descriptor\n";
+         // does header include C1C (for DCB correction)?
+         item.DCBcorr = false;
+         map<string,vector<RinexObsID> >::const_iterator sit;
+         for(sit = Rhead.mapObsTypes.begin(); sit != Rhead.mapObsTypes.end(); ++sit) {
+            for(i=0; i<sit->second.size(); i++) {
+               if(asString(sit->second[i]) == string("C1C")) {
+                  item.DCBcorr = true;
+                  item.mapDCBindex.insert(map<string,int>::value_type(sit->first,i));
+                  LOGTO(log,DEBUG) << "Correct for DCB: found "
+                     << asString(sit->second[i]) << " for system " << sit->first
+                     << " at index " << i;
+                  break;
+               }
             }
          }
 
-         //see below in loop firstepoch = false;
-      }
-
-      // Dump the solution descriptors and needed conversions ---------
-      LOG(VERBOSE) << "\nSolutions to be computed for this file:";
-      for(i=0; i<C.SolObjs.size(); ++i) {
-         bool ok(C.SolObjs[i].ChooseObsIDs(Rhead.mapObsTypes));
+         // do before the first epoch only
+         if(readFirst) OpenOutput(log);
 
-         LOG(VERBOSE) << (ok ? " OK ":" NO ") << i+1 << " " << C.SolObjs[i].dump(0);
-         LOG(VERBOSE) << C.SolObjs[i].dump(0);
-         if(C.verbose) for(j=0; j<C.SolObjs[i].sysChars.size(); j++) {
-            TimeSystem ts;
-            // TD nice if this mapping were in the library somwhere...
-            if(C.SolObjs[i].sysChars[j] == "G") ts = TimeSystem::GPS;
-            if(C.SolObjs[i].sysChars[j] == "R") ts = TimeSystem::GLO;
-            if(C.SolObjs[i].sysChars[j] == "E") ts = TimeSystem::GAL;
-            if(C.SolObjs[i].sysChars[j] == "C") ts = TimeSystem::BDT;
-            if(C.SolObjs[i].sysChars[j] == "S") ts = TimeSystem::GPS;
-            if(C.SolObjs[i].sysChars[j] == "J") ts = TimeSystem::QZS;
-            NavDataPtr ndp;
-            if (C.navLib.getOffset(istrm.timesystem, ts, C.beginTime, ndp,
-                                   SVHealth::Healthy))
-            {
-               ostringstream s;
-               ndp->dump(s, DumpDetail::Full);
-               LOG(INFO) << s.str();
-            }
-         }
+         item.type = EpochItem::Header;
+         item.nfile = nfile;
+         item.Rhead = Rhead;
+         item.timesystem = istrm->timesystem;
+         return;
       }
 
-      // loop over epochs ---------------------------------------------
-      while(1) {
-         try { istrm >> Rdata; }
-         catch(Exception& e) {
-            LOG(WARNING) << " Warning : Failed to read obs data (Exception "
-               << e.getText(0) << "); dump follows.";
-            Rdata.dump(LOGstrm,Rhead);
-            istrm.close();
-            iret = 3;
-            break;
-         }
-         catch(std::exception& e) {
-            Exception ge(string("Std excep: ") + e.what());
-            GNSSTK_THROW(ge);
-         }
-         catch(...) {
-            Exception ue("Unknown exception while reading RINEX data.");
-            GNSSTK_THROW(ue);
-         }
+      // read the next epoch ------------------------------------------
+      bool endfile(false);
+      Rinex3ObsData& Rdata(item.Rdata);
+      try { *istrm >> Rdata; }
+      catch(Exception& e) {
+         LOGTO(log,WARNING) << " Warning : Failed to read obs data (Exception "
+            << e.getText(0) << "); dump follows.";
+         ostringstream oss;
+         Rdata.dump(oss,Rhead);
+         log += oss.str();
+         iret = 3;
+         endfile = true;
+      }
+      catch(std::exception& e) {
+         Exception ge(string("Std excep: ") + e.what());
+         GNSSTK_THROW(ge);
+      }
+      catch(...) {
+         Exception ue("Unknown exception while reading RINEX data.");
+         GNSSTK_THROW(ue);
+      }
 
-         // normal EOF
-         if(!istrm.good() || istrm.eof()) { iret = 0; break; }
+      // normal EOF
+      if(!endfile && (!istrm->good() || istrm->eof())) { iret = 0; endfile = true; }
 
+      if(!endfile) {
          // if aux header data, or no data, skip it
          if(Rdata.epochFlag > 1 || Rdata.obs.empty()) {
-            LOG(DEBUG) << " RINEX Data is aux header or empty.";
+            LOGTO(log,DEBUG) << " RINEX Data is aux header or empty.";
             continue;
          }
 
-         LOG(DEBUG) << "\n Read RINEX data: flag " << Rdata.epochFlag
+         LOGTO(log,DEBUG) << "\n Read RINEX data: flag " << Rdata.epochFlag
             << ", timetag " << printTime(Rdata.time,C.longfmt);
 
          // stay within time limits
          if(Rdata.time < C.beginTime) {
-            LOG(DEBUG) << " RINEX data timetag " << printTime(C.beginTime,C.longfmt)
-               << " is before begin time.";
+            LOGTO(log,DEBUG) << " RINEX data timetag "
+               << printTime(C.beginTime,C.longfmt) << " is before begin time.";
             continue;
          }
          if(Rdata.time > C.endTime) {
-            LOG(DEBUG) << " RINEX data timetag " << printTime(C.endTime,C.longfmt)
-               << " is after end time.";
-            break;
+            LOGTO(log,DEBUG) << " RINEX data timetag "
+               << printTime(C.endTime,C.longfmt) << " is after end time.";
+            endfile = true;
          }
+      }
 
-         // decimate
-         if(C.decimate > 0.0) {
-            double dt(::fabs(Rdata.time - C.decTime));
-            dt -= C.decimate * long(0.5 + dt/C.decimate);
-            if(::fabs(dt) > 0.25) {
-               LOG(DEBUG) << " Decimation rejects RINEX data timetag "
-                  << printTime(Rdata.time,C.longfmt);
-               continue;
-            }
+      // end of this file; go on to the next
+      if(endfile) {
+         istrm->close();
+         istrm.reset();
+         if(iret == 0) nfiles++;
+         nfile++;
+         continue;
+      }
+
+      // decimate
+      if(C.decimate > 0.0) {
+         double dt(::fabs(Rdata.time - C.decTime));
+         dt -= C.decimate * long(0.5 + dt/C.decimate);
+         if(::fabs(dt) > 0.25) {
+            LOGTO(log,DEBUG) << " Decimation rejects RINEX data timetag "
+               << printTime(Rdata.time,C.longfmt);
+            continue;
          }
+      }
 
-         // reset solution objects for this epoch
-         for(i=0; i<C.SolObjs.size(); ++i)
-            C.SolObjs[i].EpochReset();
+      item.type = EpochItem::Data;
+      item.nfile = nfile;
+      readFirst = false;
+      return;
+   }
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}  // end FileProcessor::Read()
 
-         // loop over satellites -----------------------------
-         RinexSatID sat;
-         Rinex3ObsData::DataMap::iterator it;
-         for(it=Rdata.obs.begin(); it!=Rdata.obs.end(); ++it) {
-            sat = it->first;
-            vector<RinexDatum>& vrdata(it->second);
-            string sys(asString(sat.systemChar()));
-
-            // is this system excluded?
-            if(find(C.allSystemChars.begin(),C.allSystemChars.end(),sys)
-                  == C.allSystemChars.end())
-            {
-               LOG(DEBUG) << " Sat " << sat << " : system " << sys
-                  << " is not needed.";
-               continue;
-            }
+//------------------------------------------------------------------------------------
+// open the output RINEX and ORD files, if any, and write their headers; called by
+// the read stage after the first header, before any other stage uses the files.
+void FileProcessor::OpenOutput(string& log)
+{
+try {
+   Configuration& C(Configuration::Instance());
 
-            // has user excluded this satellite?
-            if(find(C.exclSat.begin(),C.exclSat.end(),sat) != C.exclSat.end()) {
-               LOG(DEBUG) << " Sat " << sat << " is excluded.";
-               continue;
-            }
+   // if writing to output RINEX, open and write header
+   if(!S.OutputObsFile.empty()) {
+      ostrm.open(S.OutputObsFile.c_str(),ios::out);
+      if(!ostrm.is_open()) {
+         LOGTO(log,WARNING) << "Warning : could not open output file "
+            << S.OutputObsFile;
+         S.OutputObsFile = string();
+      }
+      else {
+         LOGTO(log,VERBOSE) << "Opened output RINEX file " << S.OutputObsFile;
+         ostrm.exceptions(ios::failbit);
 
-            // correct for DCB
-            if(DCBcorr && mapDCBindex.find(sys) != mapDCBindex.end()) {
-               i = mapDCBindex[sys];
-               if(C.P1C1bias.find(sat) != C.P1C1bias.end()) {
-                  LOG(DEBUG) << "Correct data " << asString(Rhead.mapObsTypes[sys][i])
-                     << " = " << fixed << setprecision(2) << vrdata[i].data
-                     << " for DCB with " << C.P1C1bias[sat];
-                  vrdata[i].data += C.P1C1bias[sat];
-               }
+         // copy header and modify it?
+         Rinex3ObsHeader Rheadout(Rhead);
+         Rheadout.fileProgram = C.PrgmName;
+
+         // output version 2
+         if(C.outver2)
+            Rheadout.prepareVer2Write();
+
+         ostrm << Rheadout;
+      }
+   }
+
+   // if writing out ORDs, open the file
+   if(!S.OutputORDFile.empty()) {
+      S.ordstrm.open(S.OutputORDFile.c_str(),ios::out);
+      if(!S.ordstrm.is_open()) {
+         LOGTO(log,WARNING) << "Warning : failed to open output ORDs file "
+            << S.OutputORDFile << " - abort ORD output.";
+         S.ORDout = false;
+      }
+      else {
+         S.ORDout = true;
+         // write header
+         S.ordstrm << "ORD sat week  sec-of-wk   elev   iono     ORD1"
+            << "     ORD2      ORD    Clock  Solution_descriptor\n";
+      }
+   }
+
+   // if writing binary output, open the file and write the header
+   if(!S.OutputBinFile.empty()) {
+      S.binstrm.open(S.OutputBinFile.c_str(),ios::out | ios::binary);
+      if(!S.binstrm.is_open()) {
+         LOGTO(log,WARNING) << "Warning : failed to open output binary file "
+            << S.OutputBinFile << " - abort binary output.";
+         S.BINout = false;
+      }
+      else {
+         S.BINout = true;
+         vector<string> descs;
+         for(size_t i=0; i<S.SolObjs.size(); i++)
+            descs.push_back(S.SolObjs[i].Descriptor);
+         PRSBinary::writeHeader(S.binstrm, descs);
+      }
+   }
+
+   // ORDs need the known position for the elevation and range
+   S.ORDcalc = S.ORDout || (S.BINout
+                  && C.knownPos.getCoordinateSystem() != Position::Unknown);
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
+
+//------------------------------------------------------------------------------------
+// Solve stage: for a Header item, choose the ObsIDs for each solution; for a Data
+// item, collect the data and compute the solutions, leaving the ORDs and the
+// comments for the output RINEX in the item, for the write stage.
+void FileProcessor::Solve(EpochItem& item)
+{
+try {
+   Configuration& C(Configuration::Instance());
+   size_t i,j;
+   string& log(item.LogText);
+
+   if(item.type == EpochItem::End) return;
+
+   if(item.type == EpochItem::Header) {
+      SolveRhead = item.Rhead;
+      DCBcorr = item.DCBcorr;
+      mapDCBindex = item.mapDCBindex;
+
+      // Dump the solution descriptors and needed conversions ---------
+      LOGTO(log,VERBOSE) << "\nSolutions to be computed for this file:";
+      for(i=0; i<S.SolObjs.size(); ++i) {
+         bool ok(S.SolObjs[i].ChooseObsIDs(SolveRhead.mapObsTypes));
+         S.SolObjs[i].FlushLog(log);
+
+         LOGTO(log,VERBOSE) << (ok ? " OK ":" NO ") << i+1 << " "
+            << S.SolObjs[i].dump(0);
+         LOGTO(log,VERBOSE) << S.SolObjs[i].dump(0);
+         if(C.verbose) for(j=0; j<S.SolObjs[i].sysChars.size(); j++) {
+            TimeSystem ts;
+            // TD nice if this mapping were in the library somwhere...
+            if(S.SolObjs[i].sysChars[j] == "G") ts = TimeSystem::GPS;
+            if(S.SolObjs[i].sysChars[j] == "R") ts = TimeSystem::GLO;
+            if(S.SolObjs[i].sysChars[j] == "E") ts = TimeSystem::GAL;
+            if(S.SolObjs[i].sysChars[j] == "C") ts = TimeSystem::BDT;
+            if(S.SolObjs[i].sysChars[j] == "S") ts = TimeSystem::GPS;
+            if(S.SolObjs[i].sysChars[j] == "J") ts = TimeSystem::QZS;
+            NavDataPtr ndp;
+            NavLease nav(C.navStores);
+            if (nav.lib.getOffset(item.timesystem, ts, C.beginTime, ndp,
+                                  SVHealth::Healthy))
+            {
+               ostringstream s;
+               ndp->dump(s, DumpDetail::Full);
+               LOGTO(log,INFO) << s.str();
             }
+         }
+      }
+      return;
+   }
 
-            // elevation mask, azimuth and ephemeris range corrected with trop
-            // - pass elev to CollectData for m-cov matrix and ORDs
-            double elev(0), ER(0), tcorr;
-            if((C.elevLimit > 0 || C.weight || C.ORDout)
-                              && PrevPos.getCoordinateSystem() != Position::Unknown) {
-               CorrectedEphemerisRange CER;
-               try {
-                  CER.ComputeAtReceiveTime(Rdata.time, PrevPos, sat, C.navLib,
-                                           C.searchOrder);
-                  elev = CER.elevation;
-                  // const double azim = CER.azimuth;
-                  if(C.ORDout) {
-                     tcorr = C.pTrop->correction(PrevPos,CER.svPosVel.x,Rdata.time);
-                     ER = CER.rawrange - CER.svclkbias - CER.relativity + tcorr;
-                  }
-                  if(elev < C.elevLimit) {         // TD add elev mask [azim]
-                     LOG(VERBOSE) << " Reject sat " << sat << " for elevation "
-                        << fixed << setprecision(2) << elev << " at time "
-                        << printTime(Rdata.time,C.longfmt);
-                     continue;
-                  }
-               }
-               catch(Exception& e) {
-                  LOG(WARNING) << "WARNING : Failed to get elevation for sat "
-                     << sat << " at time " << printTime(Rdata.time,C.longfmt);
-                  continue;
-               }
+   Rinex3ObsData& Rdata(item.Rdata);
+
+   // reset solution objects for this epoch
+   for(i=0; i<S.SolObjs.size(); ++i)
+      S.SolObjs[i].EpochReset();
+
+   // loop over satellites -----------------------------
+   RinexSatID sat;
+   Rinex3ObsData::DataMap::iterator it;
+   for(it=Rdata.obs.begin(); it!=Rdata.obs.end(); ++it) {
+      sat = it->first;
+      vector<RinexDatum>& vrdata(it->second);
+      string sys(asString(sat.systemChar()));
+
+      // is this system excluded?
+      if(find(C.allSystemChars.begin(),C.allSystemChars.end(),sys)
+            == C.allSystemChars.end())
+      {
+         LOGTO(log,DEBUG) << " Sat " << sat << " : system " << sys
+            << " is not needed.";
+         continue;
+      }
+
+      // has user excluded this satellite?
+      if(find(C.exclSat.begin(),C.exclSat.end(),sat) != C.exclSat.end()) {
+         LOGTO(log,DEBUG) << " Sat " << sat << " is excluded.";
+         continue;
+      }
+
+      // correct for DCB
+      if(DCBcorr && mapDCBindex.find(sys) != mapDCBindex.end()) {
+         i = mapDCBindex[sys];
+         // C is shared by stations in batch mode, so use find(), not []
+         map<RinexSatID,double>::const_iterator bt(C.P1C1bias.find(sat));
+         if(bt != C.P1C1bias.end()) {
+            LOGTO(log,DEBUG) << "Correct data "
+               << asString(SolveRhead.mapObsTypes[sys][i])
+               << " = " << fixed << setprecision(2) << vrdata[i].data
+               << " for DCB with " << bt->second;
+            vrdata[i].data += bt->second;
+         }
+      }
+
+      // elevation mask, azimuth and ephemeris range corrected with trop
+      // - pass elev to CollectData for m-cov matrix and ORDs
+      double elev(0), ER(0), tcorr;
+      if((C.elevLimit > 0 || C.weight || S.ORDcalc)
+                        && PrevPos.getCoordinateSystem() != Position::Unknown) {
+         CorrectedEphemerisRange CER;
+         try {
+            NavLease nav(C.navStores);
+            CER.ComputeAtReceiveTime(Rdata.time, PrevPos, sat, nav.lib,
+                                     C.searchOrder);
+            elev = CER.elevation;
+            // const double azim = CER.azimuth;
+            if(S.ORDcalc) {
+               tcorr = S.pTrop->correction(PrevPos,CER.svPosVel.x,Rdata.time);
+               ER = CER.rawrange - CER.svclkbias - CER.relativity + tcorr;
+            }
+            if(elev < C.elevLimit) {         // TD add elev mask [azim]
+               LOGTO(log,VERBOSE) << " Reject sat " << sat
+                  << " for elevation " << fixed << setprecision(2) << elev
+                  << " at time " << printTime(Rdata.time,C.longfmt);
+               continue;
             }
+         }
+         catch(Exception& e) {
+            LOGTO(log,WARNING) << "WARNING : Failed to get elevation for"
+               << " sat " << sat << " at time "
+               << printTime(Rdata.time,C.longfmt);
+            continue;
+         }
+      }
 
-            // pick out data for each solution object
-            for(i=0; i<C.SolObjs.size(); ++i)
-               C.SolObjs[i].CollectData(sat,elev,ER,vrdata);
+      // pick out data for each solution object
+      for(i=0; i<S.SolObjs.size(); ++i)
+         S.SolObjs[i].CollectData(sat,elev,ER,vrdata);
 
-         }  // end loop over satellites
+   }  // end loop over satellites
 
-         // debug: dump the RINEX data object
-         if(C.debug > -1) Rdata.dump(LOGstrm,Rhead);
+   // debug: dump the RINEX data object
+   if(C.debug > -1) {
+      ostringstream oss;
+      Rdata.dump(oss,SolveRhead);
+      log += oss.str();
+   }
 
-         // update the trop model's weather ------------------
-         if(C.MetStore.size() > 0) C.setWeather(Rdata.time);
+   // update the trop model's weather ------------------
+   if(C.MetStore.size() > 0) S.setWeather(Rdata.time, log);
+
+   // put a blank line here for readability
+   LOGTO(log,INFO) << "";
+
+   // compute the solution(s) --------------------------
+   // tag for DAT - required for PRSplot
+   string dattag(printTime(Rdata.time,"DAT "+C.gpsfmt));
+   iretSol.resize(S.SolObjs.size());
+
+   // compute and print the solution(s) ----------------
+   // Solutions are independent once the trop model has been initialized
+   // (see ComputeSolution), so then they may be computed concurrently; each
+   // solution gets its own copy of the trop model.
+   if(pool && S.TropPos && S.TropTime) {
+      for(i=0; i<S.SolObjs.size(); ++i) {
+         if(!S.SolObjs[i].isValid) continue;
+         if(S.SolObjs[i].pTrop == S.pTrop)
+            S.SolObjs[i].pTrop.reset(C.CloneTropModel(S.pTrop.get()));
+         S.SolObjs[i].LogDataRecord(dattag, firstepoch);
+      }
 
-         // put a blank line here for readability
-         LOG(INFO) << "";
+      pool->run(S.SolObjs.size(), [&](size_t n) {
+         if(S.SolObjs[n].isValid)
+            iretSol[n] = S.SolObjs[n].ComputeSolution(Rdata.time, S);
+      });
 
-         // compute the solution(s) --------------------------
-         // tag for DAT - required for PRSplot
-         C.msg = printTime(Rdata.time,"DAT "+C.gpsfmt);
+      // collect the log in order
+      for(i=0; i<S.SolObjs.size(); ++i)
+         if(S.SolObjs[i].isValid) S.SolObjs[i].FlushLog(log);
+   }
+   else for(i=0; i<S.SolObjs.size(); ++i) {
+      // skip invalid descriptors
+      if(!S.SolObjs[i].isValid) continue;
 
-         // compute and print the solution(s) ----------------
-         for(i=0; i<C.SolObjs.size(); ++i) {
-            // skip invalid descriptors
-            if(!C.SolObjs[i].isValid) continue;
+      // dump the "DAT" record
+      S.SolObjs[i].LogDataRecord(dattag, firstepoch);
+      S.SolObjs[i].FlushLog(log);
 
-            // dump the "DAT" record
-            if(firstepoch)
-               LOG(VERBOSE) << C.SolObjs[i].dump(-1, "RPF", "DAT");
-            LOG(INFO) << C.SolObjs[i].dump((C.debug > -1 ? 2:1), "RPF", C.msg);
+      // compute the solution
+      iretSol[i] = S.SolObjs[i].ComputeSolution(Rdata.time, S);
+      S.SolObjs[i].FlushLog(log);
+   }
 
-            // compute the solution
-            if(firstepoch) LOG(VERBOSE) << C.SolObjs[i].prs.outputString(
-                        string("RPF ")+C.SolObjs[i].Descriptor,-999);
-            if(firstepoch) LOG(VERBOSE) << C.SolObjs[i].prs.outputPOSString(
-                        string("RPR ")+C.SolObjs[i].Descriptor,-999);
-            if(firstepoch) LOG(VERBOSE) << C.SolObjs[i].prs.outputPOSString(
-                        string("RNE ")+C.SolObjs[i].Descriptor,-999);
-            j = C.SolObjs[i].ComputeSolution(Rdata.time);
+   for(i=0; i<S.SolObjs.size(); ++i)
+      if(S.SolObjs[i].isValid) S.SolObjs[i].EndAllocCount();
 
-            // write ORDs, even if solution is not good
-            if(C.ORDout) C.SolObjs[i].WriteORDs(Rdata.time,j);
+   // binary records of the solutions, in order
+   if(S.BINout) for(i=0; i<S.SolObjs.size(); ++i)
+      if(S.SolObjs[i].isValid) S.SolObjs[i].FlushBinary(item.BinData);
+
+   // ORDs, even if solution is not good
+   if(S.ORDcalc) {
+      for(i=0; i<S.SolObjs.size(); ++i) {
+         if(!S.SolObjs[i].isValid) continue;
+         item.ORDs.push_back(ORDSet());
+         S.SolObjs[i].GetORDs(iretSol[i], item.ORDs.back());
+      }
+   }
+
+   // comments for output RINEX ------------------------
+   if(!S.OutputObsFile.empty()) {
+      ostringstream oss;
+      // loop over valid descriptors
+      for(i=0; i<S.SolObjs.size(); ++i) if(S.SolObjs[i].isValid) {
+         SolutionObject& SO(S.SolObjs[i]);
+         if(!SO.prs.isValid())
+         {
+            LOGTO(log,ERROR) << "Invalid soution!";
+            break;
+         }
+         oss.str("");
+         oss << "XYZ" << fixed << setprecision(3)
+            << " " << setw(12) << SO.prs.Solution(0)
+            << " " << setw(12) << SO.prs.Solution(1)
+            << " " << setw(12) << SO.prs.Solution(2);
+         oss << " " << SO.Descriptor;     // may get truncated
+         item.Comments.push_back(oss.str());
+         oss.str("");
+         oss << "CLK" << fixed << setprecision(3);
+
+         for(j=0; j<SO.prs.dataGNSS.size(); j++) {
+            RinexSatID sat(1,SO.prs.dataGNSS[j]);
+            oss << " " << sat.systemString3()
+               << " " << setw(11) << SO.prs.Solution(3+j);
          }
+         oss << " " << SO.Descriptor;     // may get truncated
+         item.Comments.push_back(oss.str());
+         oss.str("");
+         oss << "DIA" << setw(2) << SO.prs.Nsvs
+            << fixed << setprecision(2)
+            << " " << setw(4) << SO.prs.PDOP
+            << " " << setw(4) << SO.prs.GDOP
+            << " " << setw(8) << SO.prs.RMSResidual
+            << " " << SO.Descriptor;     // may get truncated
+         item.Comments.push_back(oss.str());
+      }
+   }
 
-         // write to output RINEX ----------------------------
-         if(!C.OutputObsFile.empty()) {
-            Rinex3ObsData auxData;
-            auxData.time = Rdata.time;
-            auxData.clockOffset = Rdata.clockOffset;
-            auxData.epochFlag = 4;
-            ostringstream oss;
-            // loop over valid descriptors
-            for(k=0,i=0; i<C.SolObjs.size(); ++i) if(C.SolObjs[i].isValid) {
-               if(!C.SolObjs[i].prs.isValid())
-               {
-                  LOG(ERROR) << "Invalid soution!";
-                  break;
-               }
-               oss.str("");
-               oss << "XYZ" << fixed << setprecision(3)
-                  << " " << setw(12) << C.SolObjs[i].prs.Solution(0)
-                  << " " << setw(12) << C.SolObjs[i].prs.Solution(1)
-                  << " " << setw(12) << C.SolObjs[i].prs.Solution(2);
-               oss << " " << C.SolObjs[i].Descriptor;     // may get truncated
-               auxData.auxHeader.commentList.push_back(oss.str());
-               k++;
-               oss.str("");
-               oss << "CLK" << fixed << setprecision(3);
-
-               for(j=0; j<C.SolObjs[i].prs.dataGNSS.size(); j++) {
-                  RinexSatID sat(1,C.SolObjs[i].prs.dataGNSS[j]);
-                  oss << " " << sat.systemString3()
-                     << " " << setw(11) << C.SolObjs[i].prs.Solution(3+j);
-               }
-               oss << " " << C.SolObjs[i].Descriptor;     // may get truncated
-               auxData.auxHeader.commentList.push_back(oss.str());
-               k++;
-               oss.str("");
-               oss << "DIA" << setw(2) << C.SolObjs[i].prs.Nsvs
-                  << fixed << setprecision(2)
-                  << " " << setw(4) << C.SolObjs[i].prs.PDOP
-                  << " " << setw(4) << C.SolObjs[i].prs.GDOP
-                  << " " << setw(8) << C.SolObjs[i].prs.RMSResidual
-                  << " " << C.SolObjs[i].Descriptor;     // may get truncated
-               auxData.auxHeader.commentList.push_back(oss.str());
-               k++;
-            }
-            auxData.numSVs = k;            // number of lines to write
-            auxData.auxHeader.valid |= Rinex3ObsHeader::validComment;
-            ostrm << auxData;
+   firstepoch = false;
+   S.nepochs++;
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}  // end FileProcessor::Solve()
+
+//------------------------------------------------------------------------------------
+// Write stage: write the item's log output, then its ORDs and output RINEX.
+void FileProcessor::Write(EpochItem& item)
+{
+try {
+   if(!item.LogText.empty()) {
+      S.log() << item.LogText;
+      S.log().flush();
+   }
+
+   if(item.type == EpochItem::Data) {
+      if(S.BINout && !item.BinData.empty())
+         S.binstrm.write(item.BinData.data(), item.BinData.size());
 
-            ostrm << Rdata;
+      for(size_t i=0; i<item.ORDs.size(); i++) {
+         if(S.ORDout) item.ORDs[i].write(item.Rdata.time, S.ordstrm);
+         if(S.BINout) item.ORDs[i].writeBinary(item.Rdata.time, S.binstrm);
+      }
+
+      // write to output RINEX
+      if(!S.OutputObsFile.empty()) {
+         Rinex3ObsData auxData;
+         auxData.time = item.Rdata.time;
+         auxData.clockOffset = item.Rdata.clockOffset;
+         auxData.epochFlag = 4;
+         auxData.auxHeader.commentList.assign(item.Comments.begin(),
+                                              item.Comments.end());
+         auxData.numSVs = item.Comments.size();     // number of lines to write
+         auxData.auxHeader.valid |= Rinex3ObsHeader::validComment;
+         ostrm << auxData;
+
+         ostrm << item.Rdata;
+      }
+   }
+   else if(item.type == EpochItem::End) {
+      if(!S.OutputObsFile.empty()) ostrm.close();
+      if(S.BINout) {
+         S.binstrm.close();
+         if(S.binstrm.fail()) {
+            Exception e("failed to write binary output " + S.OutputBinFile);
+            GNSSTK_THROW(e);
          }
+      }
+   }
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}  // end FileProcessor::Write()
 
-         firstepoch = false;
+//------------------------------------------------------------------------------------
+// Run the stages concurrently (--pipeline): read and write each on its own thread,
+// and solve on this thread (which runs the WorkerPool of --threads), connected by
+// queues of at most depth items. An exception in any stage stops all the stages and
+// is rethrown here.
+void FileProcessor::Pipeline(size_t depth)
+{
+   BoundedQueue<unique_ptr<EpochItem> > toSolve(depth), toWrite(depth);
+   exception_ptr readError, solveError, writeError;
 
-      }  // end while loop over epochs
+   thread reader([&]() {
+      try {
+         bool more(true);
+         while(more) {
+            unique_ptr<EpochItem> item(new EpochItem());
+            chrono::steady_clock::time_point beg(chrono::steady_clock::now());
+            Read(*item);
+            readSeconds += SecondsSince(beg);
+            more = (item->type != EpochItem::End);
+            if(!toSolve.push(std::move(item))) break;
+         }
+      }
+      catch(...) { readError = current_exception(); }
+      toSolve.close();
+   });
 
-      istrm.close();
+   thread writer([&]() {
+      try {
+         unique_ptr<EpochItem> item;
+         while(toWrite.pop(item)) {
+            chrono::steady_clock::time_point beg(chrono::steady_clock::now());
+            Write(*item);
+            writeSeconds += SecondsSince(beg);
+         }
+      }
+      catch(...) { writeError = current_exception(); }
+      toWrite.close();        // stop the solve stage, if it is still running
+   });
 
-      // failure due to critical error
-      if(iret < 0) break;
+   try {
+      unique_ptr<EpochItem> item;
+      while(toSolve.pop(item)) {
+         chrono::steady_clock::time_point beg(chrono::steady_clock::now());
+         Solve(*item);
+         solveSeconds += SecondsSince(beg);
+         if(!toWrite.push(std::move(item))) break;
+      }
+   }
+   catch(...) { solveError = current_exception(); }
+   toSolve.close();           // stop the read stage, if it is still running
+   toWrite.close();           // the write stage finishes what it has
 
-      if(iret == 0) nfiles++;
+   reader.join();
+   writer.join();
 
-   }  // end loop over files
+   if(readError) rethrow_exception(readError);
+   if(solveError) rethrow_exception(solveError);
+   if(writeError) rethrow_exception(writeError);
+}
 
-   if(!C.OutputObsFile.empty()) ostrm.close();
+//------------------------------------------------------------------------------------
+// Batch mode (--batch): each obs file is an independent Station, processed on one
+// of --threads threads, with output to its own files in C.BatchDir; the Met and
+// DCB stores are shared and read-only, and each thread leases a copy of the nav
+// store (see NavStores). Summarize throughput in the log.
+// Return the number of stations successfully processed.
+int ProcessBatch(void)
+{
+try {
+   Configuration& C(Configuration::Instance());
+   size_t i;
 
-   if(iret < 0) return iret;
+   // one station per obs file, named for the file
+   vector<unique_ptr<Station> > Stations;
+   for(i=0; i<C.InputObsFiles.size(); i++) {
+      string name(C.InputObsFiles[i]);
+      string::size_type pos(name.find_last_of("/\\"));
+      if(pos != string::npos) name = name.substr(pos+1);
+      Stations.push_back(unique_ptr<Station>(
+         new Station(vector<string>(1,C.InputObsFiles[i]), name)));
+   }
 
-   return nfiles;
+   // debug output from the solution algorithm goes to the log file, and cannot be
+   // kept in order, so with --debug process the stations one at a time
+   int nthreads(C.debug > -1 ? 1 : C.nThreads);
+   WorkerPool pool(min(size_t(nthreads), Stations.size()));
+   LOG(INFO) << "Batch: process " << Stations.size() << " stations using "
+      << pool.size() << " thread" << (pool.size() > 1 ? "s":"")
+      << ", output to directory " << C.BatchDir;
+
+   C.navStores.reserve(pool.size());        // one nav store per thread
+
+   chrono::steady_clock::time_point wallbeg(chrono::steady_clock::now());
+   pool.run(Stations.size(), [&](size_t n) {
+      Station& S(*Stations[n]);
+      chrono::steady_clock::time_point beg(chrono::steady_clock::now());
+      // a failed station does not stop the others
+      try {
+         if(S.OpenLog()) {
+            if(ProcessFiles(S, false) > 0)
+               S.FinalOutput();
+            else
+               S.error = "failed to read RINEX obs file " + S.ObsFiles[0];
+         }
+      }
+      catch(Exception& e) { S.error = e.getText(0); }
+      catch(std::exception& e) { S.error = string("Std excep: ") + e.what(); }
+      S.seconds = chrono::duration<double>(chrono::steady_clock::now()-beg).count();
+      if(S.logstrm.is_open()) S.logstrm.close();
+      if(S.ordstrm.is_open()) S.ordstrm.close();
+      if(S.binstrm.is_open()) S.binstrm.close();
+   });
+   double wall(chrono::duration<double>(chrono::steady_clock::now()-wallbeg).count());
+
+   // summary
+   int ngood(0);
+   long nepochs(0);
+   LOG(INFO) << "\n ----- Batch summary -----";
+#ifdef PRSOLVE_COUNT_ALLOCS
+   const string allocHead("  Allocs/ep");
+#else
+   const string allocHead;
+#endif
+   LOG(INFO) << " Station               Epochs   Seconds   Epochs/s  Regrows"
+      << allocHead << "  Output";
+   for(i=0; i<Stations.size(); i++) {
+      const Station& S(*Stations[i]);
+      nepochs += S.nepochs;
+      if(S.error.empty()) ngood++;
+      // heap allocations per epoch, summed over the solutions
+      ostringstream allocs;
+#ifdef PRSOLVE_COUNT_ALLOCS
+      double nalloc(0.0);
+      for(size_t j=0; j<S.SolObjs.size(); j++)
+         if(S.SolObjs[j].isValid) nalloc += S.SolObjs[j].allocsPerEpoch();
+      allocs << " " << fixed << setprecision(1) << setw(10) << nalloc;
+#endif
+      LOG(INFO) << " " << leftJustify(S.Name,20) << fixed
+         << " " << setw(7) << S.nepochs
+         << " " << setw(9) << setprecision(3) << S.seconds
+         << " " << setw(10) << setprecision(1)
+         << (S.seconds > 0.0 ? S.nepochs/S.seconds : 0.0)
+         << " " << setw(8) << S.regrows()
+         << allocs.str()
+         << "  " << (S.error.empty() ? S.LogFile : "FAILED: " + S.error);
+   }
+   LOG(INFO) << " Total: " << Stations.size() << " stations (" << ngood << " ok), "
+      << nepochs << " epochs in " << fixed << setprecision(3) << wall
+      << " sec wallclock = " << setprecision(1) << (wall > 0.0 ? nepochs/wall : 0.0)
+      << " epochs/s on " << pool.size() << " thread" << (pool.size() > 1 ? "s":"");
+
+   return ngood;
 }
 catch(Exception& e) { GNSSTK_RETHROW(e); }
-}  // end ProcessFiles()
+}  // end ProcessBatch()
 
 //------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------
@@ -1802,7 +2795,7 @@ catch(Exception& e) { GNSSTK_RETHROW(e); }
 //------------------------------------------------------------------------------------
 void Configuration::SetDefaults(void) noexcept
 {
-   SPSout = ORDout = false;
+   SPSout = false;
    LogFile = string("prs.log");
 
    decimate = elevLimit = 0.0;
@@ -1834,6 +2827,10 @@ void Configuration::SetDefaults(void) noexcept
       nIter = dummy.MaxNIterations;
       convLimit = dummy.ConvergenceLimit;
    }
+   warmStart = false;
+
+   nThreads = 1;
+   pipeline = 0;
 
    userfmt = gpsfmt;
    help = verbose = false;
@@ -2052,6 +3049,8 @@ string Configuration::BuildCommandLine(void) noexcept
             "Ephemeris+clock (SP3 format) file name(s)");
    opts.Add(0, "nav", "fn", true, false, &InputNavFiles, "",
             "RINEX nav file name(s) (also cf. --BCEpast)");
+   opts.Add(0, "navcache", "fn", true, false, &InputNavCaches, "",
+            "Nav cache file name(s), built by navcache, with or in place of --nav");
 
    // optional
    opts.Add(0, "clk", "fn", true, false, &InputClkFiles,
@@ -2109,9 +3108,17 @@ string Configuration::BuildCommandLine(void) noexcept
             "Maximum iteration count in linearized LS");
    opts.Add(0, "conv", "lim", false, false, &convLimit, "",
             "Maximum convergence criterion in estimation in meters");
+   opts.Add(0, "warm", "", false, false, &warmStart, "",
+            "Start each epoch from the previous solution [w/o --ref]\n"
+            "                      and previous RAIM rejections");
    opts.Add(0, "Trop", "m,T,P,H", false, false, &TropStr, "",
             "Trop model <m> [one of Zero,Black,Saas,NewB,Neill,GG,GGHt,Global\n"
             "                      with optional weather T(C),P(mb),RH(%)]");
+   opts.Add(0, "threads", "n", false, false, &nThreads, "",
+            "Compute solutions at each epoch concurrently on n threads, each\n"
+            "                      with its own copy of the nav data [1: serial]");
+   opts.Add(0, "pipeline", "n", false, false, &pipeline, "",
+            "Read, solve and write on 3 threads, queueing n epochs [0: serial]");
 
    opts.Add(0, "log", "fn", false, false, &LogFile, "# Output [for formats see "
             "GNSSTK::Position (--ref) and GNSSTK::Epoch (--timefmt)] :",
@@ -2126,6 +3133,15 @@ string Configuration::BuildCommandLine(void) noexcept
             "Output autonomous pseudorange solution [tag SPS, no RAIM]");
    opts.Add(0, "ORDs", "fn", false, false, &OutputORDFile, "",
             "Write ORDs (Observed Range Deviations) to file <fn> [--ref req'd]");
+   opts.Add(0, "binout", "fn", false, false, &OutputBinFile, "",
+            "Write solutions, covariances, residuals and ORDs [--ref] to\n"
+            "                      binary file <fn>, instead of their NAV, RMS and POS\n"
+            "                      lines in the log; see prsbindump");
+   opts.Add(0, "batch", "dir", false, false, &BatchDir, "",
+            "Process each obs file as a separate station, concurrently on\n"
+            "                      --threads threads; output for obs file <f> goes to\n"
+            "                      <dir>/<f>.log [and .ord with --ORDs, .out with --out,\n"
+            "                      .prsb with --binout]");
    //opts.Add(0, "memory", "", false, false, &doMemory, "",
    //         "Keep information between epochs, output APV etc.");
    opts.Add(0, "timefmt", "f", false, false, &userfmt, "",
@@ -2238,14 +3254,14 @@ int Configuration::ExtraProcessing(string& errors, string& extras) noexcept
       else {
          msg = fld[0];
          upperCase(msg);
-         if     (msg=="ZERO")  { pTrop = new ZeroTropModel(); TropType = "Zero"; }
-         else if(msg=="BLACK") { pTrop = new SimpleTropModel(); TropType = "Black"; }
-         else if(msg=="SAAS")  { pTrop = new SaasTropModel(); TropType = "Saas"; }
-         else if(msg=="NEWB")  { pTrop = new NBTropModel(); TropType = "NewB"; }
-         else if(msg=="GG")    { pTrop = new GGTropModel(); TropType = "GG"; }
-         else if(msg=="GGHT")  { pTrop = new GGHeightTropModel(); TropType = "GGht"; }
-         else if(msg=="NEILL") { pTrop = new NeillTropModel(); TropType = "Neill"; }
-         else if(msg=="GLOBAL") { pTrop = new GlobalTropModel(); TropType = "Global";}
+         if     (msg=="ZERO")  { pTrop.reset(new ZeroTropModel()); TropType = "Zero"; }
+         else if(msg=="BLACK") { pTrop.reset(new SimpleTropModel()); TropType = "Black"; }
+         else if(msg=="SAAS")  { pTrop.reset(new SaasTropModel()); TropType = "Saas"; }
+         else if(msg=="NEWB")  { pTrop.reset(new NBTropModel()); TropType = "NewB"; }
+         else if(msg=="GG")    { pTrop.reset(new GGTropModel()); TropType = "GG"; }
+         else if(msg=="GGHT")  { pTrop.reset(new GGHeightTropModel()); TropType = "GGht"; }
+         else if(msg=="NEILL") { pTrop.reset(new NeillTropModel()); TropType = "Neill"; }
+         else if(msg=="GLOBAL") { pTrop.reset(new GlobalTropModel()); TropType = "Global";}
          else {
             msg = string();
             oss << "Error : invalid trop model (" << fld[0] << "); choose one of "
@@ -2293,8 +3309,22 @@ int Configuration::ExtraProcessing(string& errors, string& extras) noexcept
    if(!OutputORDFile.empty() && knownPos.getCoordinateSystem() == Position::Unknown)
       oss << "Error : --ORDs requires --ref\n";
 
-   if(InputNavFiles.size() > 0 && InputSP3Files.size() > 0)
-      oss << "Error : Both --nav and --eph appear: provide only one.\n";
+   if((InputNavFiles.size() > 0 || InputNavCaches.size() > 0)
+                                 && InputSP3Files.size() > 0)
+      oss << "Error : Both --nav (or --navcache) and --eph appear: "
+         << "provide only one.\n";
+
+   if(nThreads < 1)
+      oss << "Error : --threads must be at least 1\n";
+   else if(nThreads > 1 && debug > -1)
+      ossx << "   Warning : --threads is ignored with --debug; solutions are serial.\n";
+
+   if(pipeline < 0)
+      oss << "Error : --pipeline must not be negative\n";
+   else if(pipeline > 0 && debug > -1)
+      ossx << "   Warning : --pipeline is ignored with --debug; it is serial.\n";
+   else if(pipeline > 0 && !BatchDir.empty())
+      ossx << "   Warning : --pipeline is ignored with --batch.\n";
 
    //
    if(LOGlevel != 2)
@@ -2313,55 +3343,141 @@ int Configuration::ExtraProcessing(string& errors, string& extras) noexcept
 } // end Configuration::ExtraProcessing() noexcept
 
 //------------------------------------------------------------------------------------
-// update weather in the trop model using the Met store
-void Configuration::setWeather(const CommonTime& ttag)
+// copy the trop model ptm, of type TropType, including weather, position and time
+TropModel *Configuration::CloneTropModel(const TropModel *ptm) const
 {
-   try {
-      Configuration& C(Configuration::Instance());
-      static list<RinexMetData>::iterator it(MetStore.begin());
-      list<RinexMetData>::iterator nextit;
-      static CommonTime currentTime(C.gpsBeginTime);
-      double dt;
+   if(TropType == "Zero")
+      return new ZeroTropModel(*static_cast<const ZeroTropModel*>(ptm));
+   if(TropType == "Black")
+      return new SimpleTropModel(*static_cast<const SimpleTropModel*>(ptm));
+   if(TropType == "Saas")
+      return new SaasTropModel(*static_cast<const SaasTropModel*>(ptm));
+   if(TropType == "NewB")
+      return new NBTropModel(*static_cast<const NBTropModel*>(ptm));
+   if(TropType == "GG")
+      return new GGTropModel(*static_cast<const GGTropModel*>(ptm));
+   if(TropType == "GGht")
+      return new GGHeightTropModel(*static_cast<const GGHeightTropModel*>(ptm));
+   if(TropType == "Neill")
+      return new NeillTropModel(*static_cast<const NeillTropModel*>(ptm));
+   if(TropType == "Global")
+      return new GlobalTropModel(*static_cast<const GlobalTropModel*>(ptm));
+
+   Exception e("Unknown trop model type " + TropType);
+   GNSSTK_THROW(e);
+}
 
-      while(it != MetStore.end()) {
-         (nextit = it)++;  // point to next entry after it
+//------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------
+WorkerPool::WorkerPool(int nthreads)
+   : pJob(0), nJobs(0), nextJob(0), nDone(0), generation(0), quit(false)
+{
+   for(int i=1; i<nthreads; i++)
+      workers.push_back(thread(&WorkerPool::work, this));
+}
 
-         //                // if ttag is before next but after current,
-         if( (nextit != MetStore.end() && ttag < nextit->time && ttag >= it->time)
-            ||             // OR there is no next, but ttag is w/in 15 min of current
-             (nextit == MetStore.end() && (dt=ttag-it->time) >= 0.0 && dt < 900.0))
-         {
-            // skip if its already done
-            if(it->time == currentTime) break;
-            currentTime = it->time;
+WorkerPool::~WorkerPool()
+{
+   {
+      lock_guard<mutex> lock(mtx);
+      quit = true;
+   }
+   cvStart.notify_all();
+   for(size_t i=0; i<workers.size(); i++)
+      workers[i].join();
+}
 
-            if(it->data.count(RinexMetHeader::TD) > 0)
-               defaultTemp = it->data[RinexMetHeader::TD];
-            if(it->data.count(RinexMetHeader::PR) > 0)
-               defaultPress = it->data[RinexMetHeader::PR];
-            if(it->data.count(RinexMetHeader::HR) > 0)
-               defaultHumid = it->data[RinexMetHeader::HR];
+void WorkerPool::run(size_t n, const function<void(size_t)>& job)
+{
+   if(n == 0) return;
+   {
+      lock_guard<mutex> lock(mtx);
+      pJob = &job;
+      nJobs = n;
+      nextJob = nDone = 0;
+      error = exception_ptr();
+      generation++;
+   }
+   cvStart.notify_all();
 
-            LOG(DEBUG) << "Reset weather at "
-               << printTime(ttag,longfmt) << " to " << printTime(currentTime,longfmt)
-               << " " << defaultTemp
-               << " " << defaultPress
-               << " " << defaultHumid;
+   // the caller works too
+   doJobs();
 
-            pTrop->setWeather(defaultTemp,defaultPress,defaultHumid);
+   unique_lock<mutex> lock(mtx);
+   cvDone.wait(lock, [this]{ return nDone == nJobs; });
+   pJob = 0;
+   if(error) rethrow_exception(error);
+}
 
-            break;
-         }
+void WorkerPool::doJobs(void)
+{
+   unique_lock<mutex> lock(mtx);
+   while(nextJob < nJobs) {
+      size_t i(nextJob++);
+      const function<void(size_t)> *job(pJob);
+      lock.unlock();
+
+      exception_ptr ep;
+      try { (*job)(i); }
+      catch(...) { ep = current_exception(); }
+
+      lock.lock();
+      if(ep && !error) error = ep;
+      if(++nDone == nJobs) cvDone.notify_all();
+   }
+}
 
-         // time is beyond next epoch
-         else if(nextit != MetStore.end() && ttag >= nextit->time)
-            ++it;
+void WorkerPool::work(void)
+{
+   unsigned long done(0);
+   unique_lock<mutex> lock(mtx);
+   while(1) {
+      cvStart.wait(lock, [&]{ return quit || generation != done; });
+      if(quit) return;
+      done = generation;
+      lock.unlock();
+      doJobs();
+      lock.lock();
+   }
+}
 
-         // do nothing, because ttag is before the next epoch
-         else break;
+//------------------------------------------------------------------------------------
+void NavStores::reserve(size_t n)
+{
+   vector<NavLibrary*> made;
+   while(size() < n) made.push_back(create());
+   for(size_t i=0; i<made.size(); i++) release(*made[i]);
+}
+
+NavLibrary& NavStores::lease(void)
+{
+   {
+      lock_guard<mutex> lock(mtx);
+      if(!idle.empty()) {
+         NavLibrary *lib(idle.back());
+         idle.pop_back();
+         return *lib;
       }
    }
-   catch(Exception& e) { GNSSTK_RETHROW(e); }
+   return *create();
+}
+
+NavLibrary *NavStores::create(void)
+{
+   {
+      lock_guard<mutex> lock(mtx);
+      nstores++;
+   }
+   unique_ptr<NavLibrary> lib(new NavLibrary());
+   try { load(*lib); }
+   catch(...) {
+      lock_guard<mutex> lock(mtx);
+      nstores--;
+      throw;
+   }
+   lock_guard<mutex> lock(mtx);
+   stores.push_back(std::move(lib));
+   return stores.back().get();
 }
 
 //------------------------------------------------------------------------------------
@@ -2501,7 +3617,7 @@ bool SolutionObject::ChooseObsIDs(map<string,vector<RinexObsID> >& mapObsTypes)
          isValid = false;
          return false;
       }
-      LOG(DEBUG) << " Chooser: " << vecSolData[i].asString();
+      LOGTO(LogBuffer,DEBUG) << " Chooser: " << vecSolData[i].asString();
    }
 
    return isValid;
@@ -2534,7 +3650,7 @@ string SolutionObject::dump(int level, string msg1, string msg2) noexcept
           << " " << setw(2) << UsedObsIDs.size();
 
       // loop over all potential data: sats+code(s); j counts good values
-      multimap<RinexSatID,string>::const_iterator it(UsedObsIDs.begin());
+      vector<pair<RinexSatID,string> >::const_iterator it(UsedObsIDs.begin());
       for(j=0; it != UsedObsIDs.end(); ++it) {
          // is the sat (it->first) found in Satellites (i.e. does it have data)?
          vector<SatID>::const_iterator jt;
@@ -2561,6 +3677,7 @@ string SolutionObject::dump(int level, string msg1, string msg2) noexcept
 //------------------------------------------------------------------------------------
 void SolutionObject::EpochReset(void) noexcept
 {
+   AllocCounter ac(allocsNow);
    Satellites.clear();
    PRanges.clear();
    Elevations.clear();
@@ -2578,6 +3695,7 @@ void SolutionObject::CollectData(const RinexSatID& sat,
    noexcept
 {
    if(!isValid) return;
+   AllocCounter ac(allocsNow);
 
    for(size_t i=0; i<vecSolData.size(); i++) {
       if(vecSolData[i].ComputeData(sat,vrd)) {
@@ -2590,59 +3708,276 @@ void SolutionObject::CollectData(const RinexSatID& sat,
          R1.push_back(vecSolData[i].RawPR[0]);
          if(vecSolData[i].RawPR.size() > 1) R2.push_back(vecSolData[i].RawPR[1]);
          else R2.push_back(0.0);
-         UsedObsIDs.insert(
-            multimap<RinexSatID,string>::value_type(sat,vecSolData[i].usedString()));
+         UsedObsIDs.push_back(
+            pair<RinexSatID,string>(sat,vecSolData[i].usedString()));
       }
    }
 }
 
+//------------------------------------------------------------------------------------
+void SolutionObject::LogDataRecord(const string& tag, bool firstepoch) noexcept
+{
+   Configuration& C(Configuration::Instance());
+
+   if(firstepoch) LOGTO(LogBuffer,VERBOSE) << dump(-1, "RPF", "DAT");
+   LOGTO(LogBuffer,INFO) << dump((C.debug > -1 ? 2:1), "RPF", tag);
+
+   if(firstepoch) {
+      LOGTO(LogBuffer,VERBOSE) << prs.outputString(string("RPF ")+Descriptor,-999);
+      LOGTO(LogBuffer,VERBOSE) << prs.outputPOSString(string("RPR ")+Descriptor,-999);
+      LOGTO(LogBuffer,VERBOSE) << prs.outputPOSString(string("RNE ")+Descriptor,-999);
+   }
+}
+
+//------------------------------------------------------------------------------------
+void SolutionObject::FlushLog(string& buf) noexcept
+{
+   if(LogBuffer.empty()) return;
+   buf += LogBuffer;
+   LogBuffer.clear();
+}
+
+//------------------------------------------------------------------------------------
+// flags of the records in the binary output
+static int64_t BinaryFlags(PRSolution& prs) noexcept
+{
+   return (prs.isValid() ? PRSBinary::ValidFlag : 0)
+        | (prs.RMSFlag ? PRSBinary::RMSFlag : 0)
+        | (prs.SlopeFlag ? PRSBinary::SlopeFlag : 0)
+        | (prs.TropFlag ? PRSBinary::TropFlag : 0);
+}
+
+//------------------------------------------------------------------------------------
+void SolutionObject::AddSolutionRecord(const string& tag, const CommonTime& ttag,
+                                       int iret) noexcept
+{
+   size_t i;
+   PRSBinary::Solution rec;
+   memset(&rec, 0, sizeof(rec));
+
+   PRSBinary::setTag(rec.tag, tag);
+   rec.desc = descIndex;
+   rec.iret = iret;
+   PRSBinary::setTime(rec, ttag);
+   rec.nsvs = prs.Nsvs;
+   rec.niter = prs.NIterations;
+   rec.flags = BinaryFlags(prs);
+   rec.x = prs.Solution(0);
+   rec.y = prs.Solution(1);
+   rec.z = prs.Solution(2);
+   rec.cxx = prs.Covariance(0,0);
+   rec.cxy = prs.Covariance(0,1);
+   rec.cxz = prs.Covariance(0,2);
+   rec.cyy = prs.Covariance(1,1);
+   rec.cyz = prs.Covariance(1,2);
+   rec.czz = prs.Covariance(2,2);
+   rec.rms = prs.RMSResidual;
+   rec.tdop = prs.TDOP;
+   rec.pdop = prs.PDOP;
+   rec.gdop = prs.GDOP;
+   rec.slope = prs.MaxSlope;
+   rec.conv = prs.Convergence;
+   for(i=0; i<prs.dataGNSS.size() && i<size_t(PRSBinary::MaxClocks); i++) {
+      rec.clksys[i] = RinexSatID(1,prs.dataGNSS[i]).systemChar();
+      rec.clk[i] = prs.Solution(3+i);
+   }
+   rec.nclk = i;
+   PRSBinary::append(BinBuffer, rec, PRSBinary::SolutionType);
+
+   // the satellites, rejected ones (marked by RAIM) with negative PRN
+   for(i=0; i<Satellites.size(); i++) {
+      PRSBinary::Satellite srec;
+      srec.sys = RinexSatID(1,Satellites[i].system).systemChar();
+      srec.prn = Satellites[i].id;
+      PRSBinary::append(BinBuffer, srec, PRSBinary::SatelliteType);
+   }
+}
+
+//------------------------------------------------------------------------------------
+void SolutionObject::AddResidualRecord(const string& tag, const CommonTime& ttag,
+                                       int iret, const Vector<double>& V) noexcept
+{
+   PRSBinary::Residual rec;
+   memset(&rec, 0, sizeof(rec));
+
+   PRSBinary::setTag(rec.tag, tag);
+   rec.desc = descIndex;
+   rec.iret = iret;
+   PRSBinary::setTime(rec, ttag);
+   rec.nsvs = prs.Nsvs;
+   rec.flags = BinaryFlags(prs);
+   for(size_t i=0; i<3; i++) rec.v[i] = V(i);
+   PRSBinary::append(BinBuffer, rec, PRSBinary::ResidualType);
+}
+
+//------------------------------------------------------------------------------------
+void SolutionObject::FlushBinary(string& buf) noexcept
+{
+   if(BinBuffer.empty()) return;
+   buf += BinBuffer;
+   BinBuffer.clear();
+}
+
+//------------------------------------------------------------------------------------
+TropModel *SolutionObject::getTrop(void) noexcept
+{
+   if(pTrop) return pTrop.get();
+   return Configuration::Instance().pTrop.get();
+}
+
+//------------------------------------------------------------------------------------
+// Same as V = Sol-knownPos, Cov = Covariance(0:2,0:2), then Rot*V and Rot*Cov*RotT,
+// but written element by element into the existing buffers.
+void SolutionObject::ComputeResiduals(void) noexcept
+{
+   Configuration& C(Configuration::Instance());
+   size_t i,j,k;
+
+   Vres(0) = prs.Solution(0) - C.knownPos.X();
+   Vres(1) = prs.Solution(1) - C.knownPos.Y();
+   Vres(2) = prs.Solution(2) - C.knownPos.Z();
+   for(i=0; i<3; i++) for(j=0; j<3; j++)
+      Cres(i,j) = prs.Covariance(i,j);
+
+   double RC[3][3];                          // Rot * Cres
+   for(i=0; i<3; i++) {
+      Vneu(i) = 0.0;
+      for(k=0; k<3; k++) Vneu(i) += C.Rot(i,k) * Vres(k);
+      for(j=0; j<3; j++) {
+         RC[i][j] = 0.0;
+         for(k=0; k<3; k++) RC[i][j] += C.Rot(i,k) * Cres(k,j);
+      }
+   }
+   for(i=0; i<3; i++) for(j=0; j<3; j++) {
+      Cneu(i,j) = 0.0;
+      for(k=0; k<3; k++) Cneu(i,j) += RC[i][k] * C.Rot(j,k);
+   }
+}
+
+//------------------------------------------------------------------------------------
+void SolutionObject::EndAllocCount(void) noexcept
+{
+   if(nallocs++ == 0)
+      allocsFirst = allocsNow;
+   else {
+      allocsTotal += allocsNow;
+      if(allocsNow > allocsMax) allocsMax = allocsNow;
+   }
+   allocsNow = 0;
+
+   const size_t caps[NBufs] = { Satellites.capacity(), PRanges.capacity(),
+      Elevations.capacity(), ERanges.capacity(), RIono.capacity(), R1.capacity(),
+      R2.capacity(), UsedObsIDs.capacity(), invMeasVar.capacity(),
+      invMCovs.capacity(), SVP.size(), Resid.size(), Slopes.size(),
+      LogBuffer.capacity(), BinBuffer.capacity() };
+   for(int i=0; i<NBufs; i++) {
+      if(caps[i] != bufCaps[i] && nallocs > 1) regrowsNow++;
+      bufCaps[i] = caps[i];
+   }
+   if(nallocs > 1) nRegrows += regrowsNow;
+   regrowsNow = 0;
+}
+
+//------------------------------------------------------------------------------------
+string SolutionObject::allocString(void) const
+{
+   ostringstream oss;
+   oss << Descriptor << " heap allocations per epoch: first " << allocsFirst
+      << ", then mean " << fixed << setprecision(1) << allocsPerEpoch()
+      << " max " << allocsMax << " over " << (nallocs > 0 ? nallocs-1 : 0)
+      << " epochs";
+   return oss.str();
+}
+
+//------------------------------------------------------------------------------------
+string SolutionObject::iterString(void) const
+{
+   long n(0), sum(0);
+   ostringstream oss;
+   oss << Descriptor << " RAIM iterations (count:epochs):";
+   for(size_t i=0; i<iterHist.size(); i++) {
+      if(iterHist[i] == 0) continue;
+      oss << " " << i << ":" << iterHist[i];
+      n += iterHist[i];
+      sum += i*iterHist[i];
+   }
+   oss << ", mean " << fixed << setprecision(2) << (n > 0 ? double(sum)/n : 0.0)
+      << " over " << n << " epochs";
+   if(Configuration::Instance().warmStart)
+      oss << "; previous rejections reused " << nReused << " of "
+         << nReuseTried << " tries";
+   return oss.str();
+}
+
 //------------------------------------------------------------------------------------
 // return 0 good, negative failure - same as RAIMCompute
-int SolutionObject::ComputeSolution(const CommonTime& ttag)
+// Output goes to LogBuffer, since this may be called on a worker thread.
+int SolutionObject::ComputeSolution(const CommonTime& ttag, Station& S)
 {
    try {
       int i,n,iret;
       Configuration& C(Configuration::Instance());
+      AllocCounter ac(allocsNow);
+      // a nav store of this solution's own, so no lock is needed (see NavStores)
+      NavLease nav(C.navStores);
 
       // is there data?
       if(Satellites.size() < 4) {
-         LOG(VERBOSE) << "Solution algorithm failed, not enough data"
+         LOGTO(LogBuffer,VERBOSE) << "Solution algorithm failed, not enough data"
             << " for " << Descriptor
             << " at time " << printTime(ttag,C.longfmt);
          return -3;
       }
 
-      // compute the inverse measurement covariance
-      Matrix<double> invMCov;       // default is empty - no weighting
+      // compute the inverse measurement covariance; invMCov is empty if
+      // not weighting
+      const Matrix<double> *pInvMCov(&noWeights);
       if(C.weight) {
          n = Elevations.size();
-         invMCov = Matrix<double>(n,n);
-         ident(invMCov);            // start with identity
+         invMeasVar.resize(n);
          static const double elev0(30.0);
          static const double sin0(::sin(elev0 * DEG_TO_RAD));
-         for(i=0; i<n; i++) if(Elevations[i] < elev0) {       // mod only el<30
-            double invsig(::sin(Elevations[i] * DEG_TO_RAD) / sin0);
-            invMCov(i,i) = invsig*invsig;
+         for(i=0; i<n; i++) {
+            invMeasVar[i] = 1.0;
+            if(Elevations[i] < elev0) {                        // mod only el<30
+               double invsig(::sin(Elevations[i] * DEG_TO_RAD) / sin0);
+               invMeasVar[i] = invsig*invsig;
+            }
          }
-         LOG(DEBUG) << "invMeasCov for " << Descriptor
+
+         // the off-diagonal elements are always zero
+         if(invMCovs.size() <= size_t(n)) invMCovs.resize(n+1);
+         Matrix<double>& W(invMCovs[n]);
+         if(W.rows() != size_t(n)) {
+            W = Matrix<double>(n,n,0.0);
+            regrowsNow++;
+         }
+         for(i=0; i<n; i++) W(i,i) = invMeasVar[i];
+         pInvMCov = &W;
+
+         LOGTO(LogBuffer,DEBUG) << "invMeasCov for " << Descriptor
             << " at time " << printTime(ttag,C.longfmt) << "\n"
-            << fixed << setprecision(4) << invMCov;
+            << fixed << setprecision(4) << W;
       }
+      const Matrix<double>& invMCov(*pInvMCov);
+
+      // warm start: iterate from the last solution, unless --ref is the a priori
+      if(C.warmStart && haveWarm
+                     && C.knownPos.getCoordinateSystem() == Position::Unknown)
+         prs.fixAPSolution(warmXYZ[0],warmXYZ[1],warmXYZ[2]);
 
       // get the straight solution --------------------------------------
       if(C.SPSout) {
-         Matrix<double> SVP;
-         iret=prs.PreparePRSolution(ttag, Satellites, PRanges, C.navLib, SVP,
+         iret=prs.PreparePRSolution(ttag, Satellites, PRanges, nav.lib, SVP,
                                     C.searchOrder);
 
          if(iret > -3) {
-            Vector<double> Resid,Slopes;
-            iret = prs.SimplePRSolution(ttag, Satellites, SVP, invMCov, C.pTrop,
+            iret = prs.SimplePRSolution(ttag, Satellites, SVP, invMCov, getTrop(),
                                         prs.MaxNIterations, prs.ConvergenceLimit,
                                         Resid, Slopes);
          }
 
-         if(iret < 0) { LOG(VERBOSE) << "SimplePRS failed "
+         if(iret < 0) { LOGTO(LogBuffer,VERBOSE) << "SimplePRS failed "
             << (iret==-4 ? "to find ANY ephemeris" :
                (iret==-3 ? "to find enough satellites with data" :
                (iret==-2 ? "because the problem is singular" :
@@ -2654,10 +3989,12 @@ int SolutionObject::ComputeSolution(const CommonTime& ttag)
             // at this point we have a good solution
 
             // output XYZ solution
-            LOG(INFO) << prs.outputString(string("SPS ")+Descriptor,iret);
+            if(S.BINout) AddSolutionRecord("SPS", ttag, iret);
+            else LOGTO(LogBuffer,INFO)
+               << prs.outputString(string("SPS ")+Descriptor,iret);
 
             if(prs.RMSFlag || prs.SlopeFlag || prs.TropFlag)
-               LOG(WARNING) << "Warning for " << Descriptor
+               LOGTO(LogBuffer,WARNING) << "Warning for " << Descriptor
                   << " - possible degraded SPS solution at "
                   << printTime(ttag,C.longfmt) << " due to"
                   << (prs.RMSFlag ? " large RMS":"")           // NB strings are used
@@ -2666,37 +4003,58 @@ int SolutionObject::ComputeSolution(const CommonTime& ttag)
 
             // compute residuals using known position, output XYZ resids, NEU resids
             if(C.knownPos.getCoordinateSystem() != Position::Unknown && iret >= 0) {
-               Matrix<double> Cov;
-               Vector<double> V(3);
-
-               // compute residuals in XYZ
-               Position pos(prs.Solution(0), prs.Solution(1), prs.Solution(2));
-               Position res=pos-C.knownPos;
-               // their covariance
-               Cov = Matrix<double>(prs.Covariance,0,0,3,3);
+               // compute residuals in XYZ, and their covariance, and in NEU
+               ComputeResiduals();
                // output these as SPR record
-               V(0) = res.X(); V(1) = res.Y(); V(2) = res.Z();
-               LOG(INFO) << prs.outputPOSString(string("SPR ")+Descriptor,iret,V);
+               if(S.BINout) AddResidualRecord("SPR", ttag, iret, Vres);
+               else LOGTO(LogBuffer,INFO)
+                  << prs.outputPOSString(string("SPR ")+Descriptor,iret,Vres);
                // and accumulate statistics on XYZ residuals
-               //statsSPSXYZresid.add(V,Cov);
+               //statsSPSXYZresid.add(Vres,Cres);
 
-               // convert to NEU
-               V = C.Rot * V;
-               Cov = C.Rot * Cov * transpose(C.Rot);
                // output them as RNE record
-               LOG(INFO) << prs.outputPOSString(string("SNE ")+Descriptor,iret,V);
+               if(S.BINout) AddResidualRecord("SNE", ttag, iret, Vneu);
+               else LOGTO(LogBuffer,INFO)
+                  << prs.outputPOSString(string("SNE ")+Descriptor,iret,Vneu);
                // and accumulate statistics on NEU residuals
-               //statsSPSNEUresid.add(V,Cov);
+               //statsSPSNEUresid.add(Vneu,Cneu);
             }
          }
       }  // end if SPSout
 
       // get the RAIM solution ------------------------------------------
-      iret = prs.RAIMCompute(ttag, Satellites, PRanges, invMCov, C.navLib,
-                             C.pTrop, C.searchOrder);
+      // With --warm, if the satellites are those of the last solution, and RAIM
+      // rejected some of them, first try the same subset with no search; keep it
+      // only if it passes RAIM, else unmark them and do the full search. The try
+      // is made in prs itself: the full search overwrites the whole result, so
+      // only the marks and NSatsReject need to be undone.
+      bool reuse(C.warmStart && haveWarm && !warmRejected.empty()
+                             && Satellites == warmSats);
+      if(reuse) {
+         nReuseTried++;
+         for(i=0; i<int(Satellites.size()); i++)     // mark as rejected
+            if(find(warmRejected.begin(),warmRejected.end(),Satellites[i])
+                                                      != warmRejected.end())
+               Satellites[i].id = -Satellites[i].id;
+         const int maxReject(prs.NSatsReject);
+         prs.NSatsReject = 0;
+         iret = prs.RAIMCompute(ttag, Satellites, PRanges, invMCov, nav.lib,
+                                getTrop(), C.searchOrder);
+         prs.NSatsReject = maxReject;
+         if(iret == 0 && !prs.RMSFlag && !prs.SlopeFlag)
+            nReused++;
+         else {
+            for(i=0; i<int(Satellites.size()); i++)
+               if(Satellites[i].id < 0) Satellites[i].id = -Satellites[i].id;
+            reuse = false;
+         }
+      }
+      if(!reuse)
+         iret = prs.RAIMCompute(ttag, Satellites, PRanges, invMCov, nav.lib,
+                                getTrop(), C.searchOrder);
 
       if(iret < 0) {
-         LOG(VERBOSE) << "RAIMCompute failed "
+         LOGTO(LogBuffer,VERBOSE) << "RAIMCompute failed "
             << (iret==-4 ? "to find ANY ephemeris" :
                (iret==-3 ? "to find enough satellites with data" :
                (iret==-2 ? "because the problem is singular" :
@@ -2708,11 +4066,29 @@ int SolutionObject::ComputeSolution(const CommonTime& ttag)
 
       // at this point we have a good RAIM solution
 
-      // output XYZ solution
-      LOG(INFO) << prs.outputString(string("RPF ")+Descriptor,iret);
+      size_t nit(prs.NIterations > 0 ? prs.NIterations : 0);
+      iterHist[min(nit, iterHist.size()-1)]++;
+
+      // save the solution and the rejections, for the next epoch
+      if(C.warmStart) {
+         for(i=0; i<3; i++) warmXYZ[i] = prs.Solution(i);
+         warmSats.clear();
+         warmRejected.clear();
+         for(i=0; i<int(Satellites.size()); i++) {
+            SatID sat(Satellites[i]);
+            if(sat.id < 0) { sat.id = -sat.id; warmRejected.push_back(sat); }
+            warmSats.push_back(sat);
+         }
+         haveWarm = true;
+      }
+
+      // output XYZ solution; with --binout, as a binary record only
+      if(S.BINout) AddSolutionRecord("RPF", ttag, iret);
+      else LOGTO(LogBuffer,INFO)
+         << prs.outputString(string("RPF ")+Descriptor,iret);
 
       if(prs.RMSFlag || prs.SlopeFlag || prs.TropFlag)
-         LOG(WARNING) << "Warning for " << Descriptor
+         LOGTO(LogBuffer,WARNING) << "Warning for " << Descriptor
             << " - possible degraded RPF solution at "
             << printTime(ttag,C.longfmt) << " due to"
             << (prs.RMSFlag ? " large RMS":"")           // NB these strings are used
@@ -2721,7 +4097,7 @@ int SolutionObject::ComputeSolution(const CommonTime& ttag)
 
       // dump pre-fit residuals
       if(prs.hasMemory && ++nepochs > 1)
-         LOG(VERBOSE) << "RPF " << Descriptor << " PFR"
+         LOGTO(LogBuffer,VERBOSE) << "RPF " << Descriptor << " PFR"
             << " " << printTime(ttag,C.gpsfmt)              // time
             << fixed << setprecision(3)
             << " " << ::sqrt(prs.getAPV())                  // sig(APV)
@@ -2730,42 +4106,36 @@ int SolutionObject::ComputeSolution(const CommonTime& ttag)
 
       // compute residuals using known position, and output XYZ resids, NEU resids
       if(C.knownPos.getCoordinateSystem() != Position::Unknown && iret >= 0) {
-         Matrix<double> Cov;
-         Vector<double> V(3);
-
-         // compute residuals in XYZ
-         Position pos(prs.Solution(0), prs.Solution(1), prs.Solution(2));
-         Position res=pos-C.knownPos;
-         // their covariance
-         Cov = Matrix<double>(prs.Covariance,0,0,3,3);
+         // compute residuals in XYZ, and their covariance, and in NEU
+         ComputeResiduals();
          // output these as RPR record
-         V(0) = res.X(); V(1) = res.Y(); V(2) = res.Z();
-         LOG(INFO) << prs.outputPOSString(string("RPR ")+Descriptor,iret,V);
+         if(S.BINout) AddResidualRecord("RPR", ttag, iret, Vres);
+         else LOGTO(LogBuffer,INFO)
+            << prs.outputPOSString(string("RPR ")+Descriptor,iret,Vres);
          // and accumulate statistics on XYZ residuals
-         statsXYZresid.add(V,Cov);
+         statsXYZresid.add(Vres,Cres);
 
-         // convert to NEU
-         V = C.Rot * V;
-         Cov = C.Rot * Cov * transpose(C.Rot);
          // output them as RNE record
-         LOG(INFO) << prs.outputPOSString(string("RNE ")+Descriptor,iret,V);
+         if(S.BINout) AddResidualRecord("RNE", ttag, iret, Vneu);
+         else LOGTO(LogBuffer,INFO)
+            << prs.outputPOSString(string("RNE ")+Descriptor,iret,Vneu);
          // and accumulate statistics on NEU residuals
          //if(iret == 0)        //   TD ? but not if RMS/Slope/TropFlag?
-         statsNEUresid.add(V,Cov);
+         statsNEUresid.add(Vneu,Cneu);
       }
 
       // prepare for next epoch
 
       // if trop model has not been initialized, do so
-      if(!C.TropPos) {
+      if(!S.TropPos) {
          Position pos(prs.Solution(0), prs.Solution(1), prs.Solution(2));
-         C.pTrop->setReceiverLatitude(pos.getGeodeticLatitude());
-         C.pTrop->setReceiverHeight(pos.getHeight());
-         C.TropPos = true;
+         S.pTrop->setReceiverLatitude(pos.getGeodeticLatitude());
+         S.pTrop->setReceiverHeight(pos.getHeight());
+         S.TropPos = true;
       }
-      if(!C.TropTime) {
-         C.pTrop->setDayOfYear(static_cast<YDSTime>(ttag).doy);
-         C.TropTime = true;
+      if(!S.TropTime) {
+         S.pTrop->setDayOfYear(static_cast<YDSTime>(ttag).doy);
+         S.TropTime = true;
       }
 
       return iret;
@@ -2774,14 +4144,16 @@ int SolutionObject::ComputeSolution(const CommonTime& ttag)
 }
 
 //------------------------------------------------------------------------------------
-int SolutionObject::WriteORDs(const CommonTime& time, const int iret)
+void SolutionObject::GetORDs(const int iret, ORDSet& ords) const
 {
    try {
-      Configuration& C(Configuration::Instance());
-
       int j;
       size_t i;
       double clk;
+
+      ords.Descriptor = Descriptor;
+      ords.descIndex = descIndex;
+      ords.iret = iret;
       for(i=0; i<Satellites.size(); i++) {
          if(Satellites[i].id < 0) continue;
 
@@ -2792,49 +4164,90 @@ int SolutionObject::WriteORDs(const CommonTime& time, const int iret)
          j = jt - prs.dataGNSS.begin();              // index
          clk = prs.Solution(3+j);
 
-         C.ordstrm << "ORD " << RinexSatID(Satellites[i]).toString()
+         ords.sats.push_back(RinexSatID(Satellites[i]));
+         ords.elev.push_back(Elevations[i]);
+         ords.iono.push_back(RIono[i]);
+         ords.ORD1.push_back(R1[i] - ERanges[i] - clk);
+         ords.ORD2.push_back(R2[i] - ERanges[i] - clk);
+         ords.ORD.push_back(PRanges[i] - ERanges[i] - clk);
+         ords.clk.push_back(clk);
+      }
+   }
+   catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
+
+//------------------------------------------------------------------------------------
+void ORDSet::write(const CommonTime& time, ostream& os) const
+{
+   try {
+      Configuration& C(Configuration::Instance());
+
+      for(size_t i=0; i<sats.size(); i++) {
+         os << "ORD " << sats[i].toString()
             << " " << printTime(time,C.userfmt) << fixed << setprecision(3)
-            << " " << setw(6) << Elevations[i]
-            << " " << setw(6) << RIono[i]
-            << " " << setw(8) << R1[i] - ERanges[i] - clk
-            << " " << setw(8) << R2[i] - ERanges[i] - clk
-            << " " << setw(8) << PRanges[i] - ERanges[i] - clk
-            << " " << setw(13) << clk
-            //<< " " << setw(12) << PRanges[i]
-            //<< " " << setw(12) << ERanges[i]
+            << " " << setw(6) << elev[i]
+            << " " << setw(6) << iono[i]
+            << " " << setw(8) << ORD1[i]
+            << " " << setw(8) << ORD2[i]
+            << " " << setw(8) << ORD[i]
+            << " " << setw(13) << clk[i]
             << " " << Descriptor
             << " " << iret
             << endl;
       }
+   }
+   catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
 
-      return 0;
+//------------------------------------------------------------------------------------
+void ORDSet::writeBinary(const CommonTime& time, ostream& os) const
+{
+   try {
+      PRSBinary::ORD rec;
+      string buf;
+      rec.desc = descIndex;
+      rec.iret = iret;
+      PRSBinary::setTime(rec, time);
+      for(size_t i=0; i<sats.size(); i++) {
+         rec.sys = sats[i].systemChar();
+         rec.prn = sats[i].id;
+         rec.elev = elev[i];
+         rec.iono = iono[i];
+         rec.ORD1 = ORD1[i];
+         rec.ORD2 = ORD2[i];
+         rec.ord = ORD[i];
+         rec.clk = clk[i];
+         PRSBinary::append(buf, rec, PRSBinary::ORDType);
+      }
+      os.write(buf.data(), buf.size());
    }
    catch(Exception& e) { GNSSTK_RETHROW(e); }
 }
 
 //------------------------------------------------------------------------------------
-void SolutionObject::FinalOutput(void)
+void SolutionObject::FinalOutput(ostream& os)
 {
    try {
       Configuration& C(Configuration::Instance());
 
       if(prs.was.getN() <= 0) {
-         LOG(INFO) << " No data!";
+         LOGTO(os,INFO) << " No data!";
          return;
       }
 
-      prs.dumpSolution(LOGstrm,Descriptor+" RAIM solution");
-      LOG(INFO) << " ";
+      prs.dumpSolution(os,Descriptor+" RAIM solution");
+      LOGTO(os,INFO) << " ";
+      if(C.warmStart) LOGTO(os,INFO) << iterString();
 
       if(C.knownPos.getCoordinateSystem() != Position::Unknown) {
          // output stats on XYZ residuals
          statsXYZresid.setMessage(Descriptor + " RAIM XYZ position residuals (m)");
-         LOG(INFO) << statsXYZresid << endl;
+         LOGTO(os,INFO) << statsXYZresid << endl;
 
          // output stats on NEU residuals
          statsNEUresid.setMessage(Descriptor + " RAIM NEU position residuals (m)");
          statsNEUresid.setLabels("North","East ","Up   ");
-         LOG(INFO) << statsNEUresid;
+         LOGTO(os,INFO) << statsNEUresid;
 
          // output the covariance for NEU
          double apv(::sqrt(prs.getAPV()));               // APV from XYZ stats
@@ -2850,7 +4263,8 @@ void SolutionObject::FinalOutput(void)
             NL += "North"; NL += "East "; NL += "Up   ";
             LabeledMatrix LM(NL,Cov);
             LM.scientific().setprecision(3).setw(14);
-            LOG(INFO) << "Covariance of " << statsNEUresid.getMessage() << endl << LM;
+            LOGTO(os,INFO) << "Covariance of " << statsNEUresid.getMessage()
+               << endl << LM;
          }
       }
 
@@ -2860,3 +4274,143 @@ void SolutionObject::FinalOutput(void)
 
 //------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------
+Station::Station(const vector<string>& obsfiles, const string& name)
+   : Name(name), ObsFiles(obsfiles), plog(pLOGstrm), ORDout(false),
+     BINout(false), ORDcalc(false), nepochs(0), seconds(0.0)
+{
+   try {
+      Configuration& C(Configuration::Instance());
+
+      SolObjs = C.SolObjs;
+      TropPos = C.TropPos;
+      TropTime = C.TropTime;
+      Temp = C.defaultTemp;
+      Press = C.defaultPress;
+      Humid = C.defaultHumid;
+      metit = C.MetStore.begin();
+      metTime = C.gpsBeginTime;
+
+      if(Name.empty()) {
+         pTrop = C.pTrop;
+         OutputORDFile = C.OutputORDFile;
+         OutputBinFile = C.OutputBinFile;
+         OutputObsFile = C.OutputObsFile;
+      }
+      else {
+         // stations are processed concurrently, so each needs its own trop model
+         pTrop.reset(C.CloneTropModel(C.pTrop.get()));
+         string prefix(C.BatchDir + "/" + Name);
+         LogFile = prefix + ".log";
+         if(!C.OutputORDFile.empty()) OutputORDFile = prefix + ".ord";
+         if(!C.OutputBinFile.empty()) OutputBinFile = prefix + ".prsb";
+         if(!C.OutputObsFile.empty()) OutputObsFile = prefix + ".out";
+      }
+
+      for(size_t i=0; i<SolObjs.size(); i++) {
+         SolObjs[i].pTrop = pTrop;
+         SolObjs[i].descIndex = i;
+      }
+   }
+   catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
+
+//------------------------------------------------------------------------------------
+bool Station::OpenLog(void) noexcept
+{
+   if(LogFile.empty()) return true;
+
+   logstrm.open(LogFile.c_str(), ios::out);
+   if(!logstrm.is_open()) {
+      error = "failed to open log file " + LogFile;
+      return false;
+   }
+   plog = &logstrm;
+
+   LOGTO(log(),INFO) << Configuration::Instance().Title;
+   LOGTO(log(),INFO) << "Station " << Name << " : RINEX obs file " << ObsFiles[0];
+
+   return true;
+}
+
+//------------------------------------------------------------------------------------
+// update weather in the trop model using the Met store
+void Station::setWeather(const CommonTime& ttag, string& buf)
+{
+   try {
+      Configuration& C(Configuration::Instance());
+      list<RinexMetData>::const_iterator nextit;
+      RinexMetData::RinexMetMap::const_iterator jt;
+      double dt;
+
+      while(metit != C.MetStore.end()) {
+         (nextit = metit)++;  // point to next entry after metit
+
+         //                // if ttag is before next but after current,
+         if( (nextit != C.MetStore.end() && ttag < nextit->time
+                                           && ttag >= metit->time)
+            ||             // OR there is no next, but ttag is w/in 15 min of current
+             (nextit == C.MetStore.end() && (dt=ttag-metit->time) >= 0.0
+                                         && dt < 900.0))
+         {
+            // skip if its already done
+            if(metit->time == metTime) break;
+            metTime = metit->time;
+
+            // the Met store is shared by all stations, so do not use operator[]
+            if((jt = metit->data.find(RinexMetHeader::TD)) != metit->data.end())
+               Temp = jt->second;
+            if((jt = metit->data.find(RinexMetHeader::PR)) != metit->data.end())
+               Press = jt->second;
+            if((jt = metit->data.find(RinexMetHeader::HR)) != metit->data.end())
+               Humid = jt->second;
+
+            LOGTO(buf,DEBUG) << "Reset weather at "
+               << printTime(ttag,C.longfmt) << " to " << printTime(metTime,C.longfmt)
+               << " " << Temp
+               << " " << Press
+               << " " << Humid;
+
+            pTrop->setWeather(Temp,Press,Humid);
+            // and the copies used by concurrent solutions
+            for(size_t i=0; i<SolObjs.size(); i++)
+               if(SolObjs[i].pTrop && SolObjs[i].pTrop != pTrop)
+                  SolObjs[i].pTrop->setWeather(Temp,Press,Humid);
+
+            break;
+         }
+
+         // time is beyond next epoch
+         else if(nextit != C.MetStore.end() && ttag >= nextit->time)
+            ++metit;
+
+         // do nothing, because ttag is before the next epoch
+         else break;
+      }
+   }
+   catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
+
+//------------------------------------------------------------------------------------
+void Station::FinalOutput(void)
+{
+   try {
+      for(size_t i=0; i<SolObjs.size(); ++i) {
+         LOGTO(log(),INFO) << "\n ----- Final output " << SolObjs[i].Descriptor
+            << " -----";
+         SolObjs[i].FinalOutput(log());
+      }
+   }
+   catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
+
+//------------------------------------------------------------------------------------
+unsigned long Station::regrows(void) const noexcept
+{
+   unsigned long n(0);
+   for(size_t i=0; i<SolObjs.size(); ++i)
+      if(SolObjs[i].isValid) n += SolObjs[i].regrows();
+   return n;
+}
+
+//------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------
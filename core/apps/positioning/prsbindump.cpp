@@ -0,0 +1,396 @@
+//==============================================================================
+//
+//  This file is part of GNSSTk, the ARL:UT GNSS Toolkit.
+//
+//  The GNSSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GNSSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GNSSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin.
+//  Copyright 2004-2022, The Board of Regents of The University of Texas System
+//
+//==============================================================================
+
+//==============================================================================
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin, under contract to an agency or agencies
+//  within the U.S. Department of Defense. The U.S. Government retains all
+//  rights to use, duplicate, distribute, disclose, or release this software.
+//
+//  Pursuant to DoD Directive 523024
+//
+//  DISTRIBUTION STATEMENT A: This software has been approved for public
+//                            release, distribution is unlimited.
+//
+//==============================================================================
+
+/** \page apps
+ * - \subpage prsbindump - Convert PRSolve binary output to text
+ * \page prsbindump
+ * \tableofcontents
+ *
+ * \section prsbindump_name NAME
+ * prsbindump - Convert the binary output of PRSolve to text
+ *
+ * \section prsbindump_synopsis SYNOPSIS
+ * <b>prsbindump</b>  <b>-h</b> <br/>
+ * <b>prsbindump</b> <b>[-d</b><b>]</b> <b>[-v</b><b>]</b> <b>[-t</b>&nbsp;\argarg{ARG}<b>]</b> <b>[-c</b><b>]</b> <b>[-o</b><b>]</b> <b>[-s</b><b>]</b> \argarg{ARG} <b>[</b>...<b>]</b>
+ *
+ * \section prsbindump_description DESCRIPTION
+ * Read the binary files written by PRSolve (option \--binout) and
+ * write their records to the screen as text, in the layout of the
+ * PRSolve log records: the NAV and RMS lines of the SPS and RPF
+ * solutions, the POS lines of the SPR, SNE, RPR and RNE residuals, and
+ * the ORD lines of the \--ORDs file.
+ *
+ * \dictionary
+ * \dicterm{-d, \--debug}
+ * \dicdef{Increase debug level}
+ * \dicterm{-v, \--verbose}
+ * \dicdef{Increase verbosity}
+ * \dicterm{-h, \--help}
+ * \dicdef{Print help usage}
+ * \dicterm{-t, \--timefmt=\argarg{ARG}}
+ * \dicdef{Format of the time tags (%4F %10.3g)}
+ * \dicterm{-c, \--cov}
+ * \dicdef{Also write the covariance of each solution, as a COV line}
+ * \dicterm{-o, \--ords}
+ * \dicdef{Write only the ORDs, as in the PRSolve \--ORDs file}
+ * \dicterm{-s, \--schema}
+ * \dicdef{Write the schema of each file, and no records}
+ * \enddictionary
+ *
+ * \section prsbindump_examples EXAMPLES
+ *
+ * \cmdex{PRSolve \--obs data/arlm200b.15o \--eph data/test_input_sp3_nav_2015_200.sp3 \--sol GPS:12:WC \--binout prs.prsb}
+ * \cmdex{prsbindump prs.prsb}
+ *
+ * \section prsbindump_exit_status EXIT STATUS
+ * The following exit values are returned:
+ * \dictable
+ * \dictentry{0,No errors ocurred}
+ * \dictentry{1,A C++ exception occurred}
+ * \dictentry{2,An input file could not be read}
+ * \enddictable
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gnsstk/BasicFramework.hpp>
+#include <gnsstk/RinexSatID.hpp>
+#include <gnsstk/StringUtils.hpp>
+#include <gnsstk/TimeString.hpp>
+
+#include "PRSBinary.hpp"
+
+using namespace std;
+using namespace gnsstk;
+
+/// Write the records of PRSolve binary files as text.
+class PRSBinDump : public BasicFramework
+{
+public:
+      /** Initialize command-line options.
+       * @param[in] applName Application file name.
+       */
+   PRSBinDump(const string& applName);
+
+      /// Dump each of the input files.
+   void process() override;
+
+      /// Format of the time tags.
+   CommandOptionWithAnyArg timeFmtOpt;
+      /// Write COV lines.
+   CommandOptionNoArg covOpt;
+      /// Write only the ORDs.
+   CommandOptionNoArg ordsOpt;
+      /// Write the schema only.
+   CommandOptionNoArg schemaOpt;
+      /// All remaining command-line arguments are binary files.
+   CommandOptionRest filesOpt;
+
+private:
+      /// Dump one file; return false if it cannot be read.
+   bool dumpFile(const string& filename);
+
+      /// Write the RMS line of the last Solution record, with its satellites.
+   void flushRMS();
+
+      /// The validity of a solution: " (iret meaning) V|NV".
+   static string validString(int64_t iret, int64_t flags);
+
+      /// A satellite as text, with a '-' if negative (rejected).
+   static string satString(int64_t sys, int64_t prn);
+
+      /// The satellite of system character sys and PRN |prn|.
+   static RinexSatID toSat(int64_t sys, int64_t prn);
+
+   string timeFmt;
+   vector<string> descs;         ///< descriptors of the current file
+   string pendingRMS;            ///< RMS line waiting for its satellites
+   string pendingValid;          ///< and its validity
+   bool ordHeader;               ///< true when the ORD header has been written
+};
+
+
+PRSBinDump ::
+PRSBinDump(const string& applName)
+      : BasicFramework(applName, "Convert the binary output of PRSolve"
+                       " (--binout) to text, in the layout of the PRSolve log"
+                       " records"),
+        timeFmtOpt('t', "timefmt", "Format of the time tags (%4F %10.3g)"),
+        covOpt('c', "cov", "Also write the covariance of each solution, as a"
+               " COV line"),
+        ordsOpt('o', "ords", "Write only the ORDs, as in the PRSolve --ORDs"
+                " file"),
+        schemaOpt('s', "schema", "Write the schema of each file, and no"
+                  " records"),
+        filesOpt("FILE [...] (PRSolve binary output)", true),
+        timeFmt("%4F %10.3g"),
+        ordHeader(false)
+{
+   timeFmtOpt.setMaxCount(1);
+}
+
+
+void PRSBinDump ::
+process()
+{
+   if (timeFmtOpt.getCount())
+      timeFmt = timeFmtOpt.getValue()[0];
+
+   vector<string> names(filesOpt.getValue());
+   for (size_t i = 0; i < names.size(); i++)
+   {
+      if (!dumpFile(names[i]))
+      {
+         exitCode = BasicFramework::EXIST_ERROR;
+         return;
+      }
+   }
+}
+
+
+bool PRSBinDump ::
+dumpFile(const string& filename)
+{
+   ifstream ifs(filename.c_str(), ios::in | ios::binary);
+   if (!ifs)
+   {
+      cerr << "Unable to open \"" << filename << "\"" << endl;
+      return false;
+   }
+   string error;
+   if (!PRSBinary::readHeader(ifs, descs, error))
+   {
+      cerr << "Unable to read \"" << filename << "\": " << error << endl;
+      return false;
+   }
+   if (verboseLevel)
+   {
+      cout << "# " << filename << endl;
+   }
+   if (schemaOpt.getCount())
+   {
+      cout << PRSBinary::schema(descs);
+      return true;
+   }
+      // same as the header PRSolve writes to the --ORDs file
+   if (ordsOpt.getCount() && !ordHeader)
+   {
+      cout << "ORD sat week  sec-of-wk   elev   iono     ORD1"
+           << "     ORD2      ORD    Clock  Solution_descriptor\n";
+      ordHeader = true;
+   }
+
+   vector<char> buf;
+   uint32_t type;
+   unsigned long nrec(0);
+   while ((type = PRSBinary::readRecord(ifs, buf)) != 0)
+   {
+      nrec++;
+      if (type != PRSBinary::SatelliteType)
+         flushRMS();
+
+         // the text is formatted as in PRSolution::outputString() and
+         // outputPOSString(), and ORDSet::write() in PRSolve
+      if (type == PRSBinary::SolutionType && !ordsOpt.getCount())
+      {
+         PRSBinary::Solution rec;
+         memcpy(&rec, &buf[0], sizeof(rec));
+         string tag(string(rec.tag) + " " + descs.at(rec.desc));
+         string time(printTime(PRSBinary::getTime(rec), timeFmt));
+         ostringstream oss;
+         oss << tag << " NAV " << time << fixed << setprecision(6)
+             << " " << setw(16) << rec.x
+             << " " << setw(16) << rec.y
+             << " " << setw(16) << rec.z;
+         for (int64_t i = 0; i < rec.nclk; i++)
+         {
+            oss << " " << toSat(rec.clksys[i], 1).systemString3()
+                << setprecision(3) << " " << setw(11) << rec.clk[i];
+         }
+         pendingValid = validString(rec.iret, rec.flags);
+         cout << oss.str() << pendingValid << endl;
+
+         if (covOpt.getCount())
+         {
+            cout << tag << " COV " << time << scientific << setprecision(6)
+                 << " " << setw(14) << rec.cxx
+                 << " " << setw(14) << rec.cxy
+                 << " " << setw(14) << rec.cxz
+                 << " " << setw(14) << rec.cyy
+                 << " " << setw(14) << rec.cyz
+                 << " " << setw(14) << rec.czz << endl;
+         }
+
+         oss.str("");
+         oss << tag << " RMS " << time
+             << " " << setw(2) << rec.nsvs
+             << fixed << setprecision(3) << " " << setw(8) << rec.rms
+             << setprecision(2)
+             << " " << setw(7) << rec.tdop
+             << " " << setw(7) << rec.pdop
+             << " " << setw(7) << rec.gdop
+             << setprecision(1) << " " << setw(5) << rec.slope
+             << " " << setw(2) << rec.niter
+             << scientific << setprecision(2) << " " << setw(8) << rec.conv;
+         pendingRMS = oss.str();
+      }
+      else if (type == PRSBinary::SatelliteType && !pendingRMS.empty())
+      {
+         PRSBinary::Satellite rec;
+         memcpy(&rec, &buf[0], sizeof(rec));
+         pendingRMS += " " + satString(rec.sys, rec.prn);
+      }
+      else if (type == PRSBinary::ResidualType && !ordsOpt.getCount())
+      {
+         PRSBinary::Residual rec;
+         memcpy(&rec, &buf[0], sizeof(rec));
+         cout << rec.tag << " " << descs.at(rec.desc) << " POS "
+              << printTime(PRSBinary::getTime(rec), timeFmt)
+              << fixed << setprecision(6)
+              << " " << setw(16) << rec.v[0]
+              << " " << setw(16) << rec.v[1]
+              << " " << setw(16) << rec.v[2]
+              << validString(rec.iret, rec.flags) << endl;
+      }
+      else if (type == PRSBinary::ORDType)
+      {
+         PRSBinary::ORD rec;
+         memcpy(&rec, &buf[0], sizeof(rec));
+         cout << "ORD " << satString(rec.sys, rec.prn)
+              << " " << printTime(PRSBinary::getTime(rec), timeFmt)
+              << fixed << setprecision(3)
+              << " " << setw(6) << rec.elev
+              << " " << setw(6) << rec.iono
+              << " " << setw(8) << rec.ORD1
+              << " " << setw(8) << rec.ORD2
+              << " " << setw(8) << rec.ord
+              << " " << setw(13) << rec.clk
+              << " " << descs.at(rec.desc)
+              << " " << rec.iret
+              << endl;
+      }
+   }
+   flushRMS();
+
+   if (verboseLevel)
+   {
+      cout << "# " << nrec << " records in " << descs.size()
+           << " solutions" << endl;
+   }
+   return true;
+}
+
+
+void PRSBinDump ::
+flushRMS()
+{
+   if (pendingRMS.empty())
+      return;
+   cout << pendingRMS << pendingValid << endl;
+   pendingRMS.clear();
+}
+
+
+string PRSBinDump ::
+validString(int64_t iret, int64_t flags)
+{
+      // the same meanings as PRSolution's
+   const char *meaning("unknown");
+   switch (iret)
+   {
+      case  1: meaning = "ok but perhaps degraded"; break;
+      case  0: meaning = "ok"; break;
+      case -1: meaning = "failed to converge"; break;
+      case -2: meaning = "singular solution"; break;
+      case -3: meaning = "not enough satellites"; break;
+      case -4: meaning = "no ephemeris"; break;
+   }
+   ostringstream oss;
+   oss << " (" << iret << " " << meaning << ") "
+       << ((flags & PRSBinary::ValidFlag) ? "V" : "NV");
+   return oss.str();
+}
+
+
+string PRSBinDump ::
+satString(int64_t sys, int64_t prn)
+{
+   return (prn < 0 ? "-" : "") + toSat(sys, prn).toString();
+}
+
+
+RinexSatID PRSBinDump ::
+toSat(int64_t sys, int64_t prn)
+{
+   return RinexSatID(string(1, char(sys))
+                     + StringUtils::asString(std::abs(prn)));
+}
+
+
+int main(int argc, char* argv[])
+{
+   try
+   {
+      PRSBinDump app(argv[0]);
+      if (!app.initialize(argc, argv))
+         return app.exitCode;
+      app.run();
+      return app.exitCode;
+   }
+   catch(Exception& e)
+   {
+      cout << e << endl;
+   }
+   catch(std::exception& e)
+   {
+      cout << e.what() << endl;
+   }
+   catch(...)
+   {
+      cout << "unknown error" << endl;
+   }
+      // only reach this point if an exception was caught
+   return BasicFramework::EXCEPTION_ERROR;
+}
@@ -0,0 +1,326 @@
+//==============================================================================
+//
+//  This file is part of GNSSTk, the ARL:UT GNSS Toolkit.
+//
+//  The GNSSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GNSSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GNSSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin.
+//  Copyright 2004-2022, The Board of Regents of The University of Texas System
+//
+//==============================================================================
+
+//==============================================================================
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin, under contract to an agency or agencies
+//  within the U.S. Department of Defense. The U.S. Government retains all
+//  rights to use, duplicate, distribute, disclose, or release this software.
+//
+//  Pursuant to DoD Directive 523024
+//
+//  DISTRIBUTION STATEMENT A: This software has been approved for public
+//                            release, distribution is unlimited.
+//
+//==============================================================================
+
+#ifndef VISIBILITYSWEEP_HPP
+#define VISIBILITYSWEEP_HPP
+
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <gnsstk/CommonTime.hpp>
+#include <gnsstk/Exception.hpp>
+#include <gnsstk/GNSSconstants.hpp>
+#include <gnsstk/NavLibrary.hpp>
+#include <gnsstk/OrbitData.hpp>
+#include <gnsstk/SatID.hpp>
+#include <gnsstk/Triple.hpp>
+#include <gnsstk/Xvt.hpp>
+
+/** Compute the positions of a set of satellites, and their elevation
+ * and azimuth as seen from an antenna, over a grid of epochs.
+ *
+ * The epochs are given a block at a time to compute().  For each
+ * satellite the ephemeris is found once per run of epochs that it
+ * covers rather than once per epoch: with NavSearchOrder::Nearest the
+ * epochs that select a given ephemeris are contiguous (as long as nav
+ * data issued later does not expire earlier), so when the same
+ * ephemeris is found at both ends of a range of epochs it is used for
+ * all of the epochs in between, and the range is bisected otherwise.
+ * Nav data made for the search time (e.g. interpolated from SP3) is
+ * never the same object twice, so it ends up being looked up at each
+ * epoch.  Satellites with no nav data at all are skipped.  Elevation and azimuth are then computed for a whole
+ * satellite at once in a loop without branches, using the same
+ * expressions as Triple::elvAngle() and Triple::azAngle().
+ *
+ * The satellites are shared among threads.  NavLibrary is not known to
+ * be safe to search from several threads at once, so the lookups are
+ * serialized; the positions, elevations and azimuths are computed
+ * concurrently. */
+class VisibilitySweep
+{
+public:
+      /** @param[in] nl the nav data to compute positions from.
+       * @param[in] satellites the satellites to compute.
+       * @param[in] useAlm use almanac rather than ephemeris data.
+       * @param[in] health the transmit health required of the nav
+       *   data, as for NavLibrary::getXvt(). */
+   VisibilitySweep(gnsstk::NavLibrary& nl,
+                   const std::vector<gnsstk::SatID>& satellites,
+                   bool useAlm, gnsstk::SVHealth health)
+         : navLib(nl), sats(satellites),
+           msgType(useAlm ? gnsstk::NavMessageType::Almanac
+                   : gnsstk::NavMessageType::Ephemeris),
+           xmitHealth(health), nthreads(1), saveXvt(false), haveAnt(false),
+           nepochs(0)
+   {
+      std::set<gnsstk::SatID> stored = navLib.getIndexSet(
+         gnsstk::CommonTime::BEGINNING_OF_TIME,
+         gnsstk::CommonTime::END_OF_TIME);
+      for (size_t s = 0; s < sats.size(); s++)
+         present.push_back(stored.count(sats[s]) != 0);
+   }
+
+      /** Set the antenna position (ECEF m) for elevation and azimuth.
+       * Without one only the positions are computed. */
+   void setAntenna(const gnsstk::Triple& ant)
+   {
+      haveAnt = true;
+      for (int i = 0; i < 3; i++)
+         antenna[i] = ant[i];
+   }
+
+      /// Compute on up to n threads.
+   void setThreads(unsigned n)
+   { nthreads = n; }
+
+      /** Keep the full Xvt (velocity, clock) of each satellite rather
+       * than only its position. */
+   void setSaveXvt(bool save)
+   { saveXvt = save; }
+
+      /// Compute the satellites at each of epochs, replacing the last block.
+   void compute(const std::vector<gnsstk::CommonTime>& epochs)
+   {
+      nepochs = epochs.size();
+      size_t n = sats.size() * nepochs;
+      found.assign(n, 0);
+      px.assign(n, 0.);
+      py.assign(n, 0.);
+      pz.assign(n, 0.);
+      if (haveAnt)
+      {
+         elev.assign(n, 0.);
+         azim.assign(n, 0.);
+      }
+      if (saveXvt)
+         xvts.assign(n, gnsstk::Xvt());
+      runParallel(nthreads, sats.size(), [&](size_t s)
+      { computeSat(s, epochs); });
+   }
+
+      /// @return the number of satellites.
+   size_t numSats() const
+   { return sats.size(); }
+      /// @return satellite s.
+   const gnsstk::SatID& sat(size_t s) const
+   { return sats[s]; }
+      /// @return true if satellite s has a position at epoch k.
+   bool have(size_t k, size_t s) const
+   { return found[index(k,s)] != 0; }
+      /// @return the position of satellite s at epoch k.
+   gnsstk::Triple position(size_t k, size_t s) const
+   {
+      size_t i = index(k,s);
+      return gnsstk::Triple(px[i], py[i], pz[i]);
+   }
+      /// @return the Xvt of satellite s at epoch k (see setSaveXvt()).
+   const gnsstk::Xvt& xvt(size_t k, size_t s) const
+   { return xvts[index(k,s)]; }
+      /// @return the elevation (degrees) of satellite s at epoch k.
+   double elevation(size_t k, size_t s) const
+   { return elev[index(k,s)]; }
+      /// @return the azimuth (degrees) of satellite s at epoch k.
+   double azimuth(size_t k, size_t s) const
+   { return azim[index(k,s)]; }
+
+      /** Call work(i) for i in [0,n) on up to nthreads threads.  Each
+       * i is done exactly once, in no particular order. */
+   static void runParallel(unsigned nthreads, size_t n,
+                           const std::function<void(size_t)>& work)
+   {
+      if (nthreads < 2 || n < 2)
+      {
+         for (size_t i = 0; i < n; i++)
+            work(i);
+         return;
+      }
+      std::atomic<size_t> next(0);
+      std::vector<std::thread> pool;
+      for (unsigned t = 0; t < nthreads && t < n; t++)
+      {
+         pool.push_back(std::thread([&]()
+         {
+            size_t i;
+            while ((i = next++) < n)
+               work(i);
+         }));
+      }
+      for (size_t t = 0; t < pool.size(); t++)
+         pool[t].join();
+   }
+
+private:
+      /// Results are stored by satellite, then epoch.
+   size_t index(size_t k, size_t s) const
+   { return s * nepochs + k; }
+
+      /// @return the nav data selected for nmid at time t, or null.
+   gnsstk::NavDataPtr lookup(const gnsstk::NavMessageID& nmid,
+                             const gnsstk::CommonTime& t)
+   {
+      gnsstk::NavDataPtr ndp;
+      std::lock_guard<std::mutex> lock(navMutex);
+      try
+      {
+         if (!navLib.find(nmid, t, ndp, xmitHealth,
+                          gnsstk::NavValidityType::ValidOnly,
+                          gnsstk::NavSearchOrder::Nearest))
+         {
+            ndp.reset();
+         }
+      }
+      catch (gnsstk::Exception&)
+      {
+         ndp.reset();
+      }
+      return ndp;
+   }
+
+      /** Fill in nav[a+1..b-1] given nav[a] and nav[b], looking up as
+       * few epochs as possible. */
+   void bisect(const gnsstk::NavMessageID& nmid,
+               const std::vector<gnsstk::CommonTime>& epochs,
+               std::vector<gnsstk::NavDataPtr>& nav, size_t a, size_t b)
+   {
+      if (b - a < 2)
+         return;
+         // no data at either end says nothing about the middle
+      if (nav[a] && nav[a] == nav[b])
+      {
+         for (size_t k = a+1; k < b; k++)
+            nav[k] = nav[a];
+         return;
+      }
+      size_t m = a + (b-a)/2;
+      nav[m] = lookup(nmid, epochs[m]);
+      bisect(nmid, epochs, nav, a, m);
+      bisect(nmid, epochs, nav, m, b);
+   }
+
+   void computeSat(size_t s, const std::vector<gnsstk::CommonTime>& epochs)
+   {
+      if (nepochs == 0 || !present[s])
+         return;
+      gnsstk::NavMessageID nmid(gnsstk::NavSatelliteID(sats[s]), msgType);
+      std::vector<gnsstk::NavDataPtr> nav(nepochs);
+      nav[0] = lookup(nmid, epochs[0]);
+      nav[nepochs-1] = lookup(nmid, epochs[nepochs-1]);
+      bisect(nmid, epochs, nav, 0, nepochs-1);
+
+      size_t i0 = index(0,s);
+      for (size_t k = 0; k < nepochs; k++)
+      {
+         gnsstk::OrbitData *orb =
+            dynamic_cast<gnsstk::OrbitData*>(nav[k].get());
+         if (orb == nullptr)
+            continue;
+         gnsstk::Xvt x;
+         try
+         {
+            if (!orb->getXvt(epochs[k], x))
+               continue;
+         }
+         catch (gnsstk::Exception&)
+         {
+            continue;
+         }
+         size_t i = i0 + k;
+         found[i] = 1;
+         px[i] = x.x[0];
+         py[i] = x.x[1];
+         pz[i] = x.x[2];
+         if (saveXvt)
+            xvts[i] = x;
+      }
+
+      if (!haveAnt)
+         return;
+         // Triple::elvAngle() and Triple::azAngle() of each position,
+         // as seen from the antenna
+      const double a0 = antenna[0], a1 = antenna[1], a2 = antenna[2];
+      const double ra = a0*a0 + a1*a1 + a2*a2;
+      const double xy = std::sqrt(a0*a0 + a1*a1);
+      const double xyz = std::sqrt(ra);
+      const double cosl = a0/xy, sinl = a1/xy, sint = a2/xyz;
+      const double xn1 = -sint*cosl, xn2 = -sint*sinl, xn3 = xy/xyz;
+      const double xe1 = -sinl, xe2 = cosl;
+      const double *sx = &px[i0], *sy = &py[i0], *sz = &pz[i0];
+      double *el = &elev[i0], *az = &azim[i0];
+      for (size_t k = 0; k < nepochs; k++)
+      {
+         double z0 = sx[k] - a0, z1 = sy[k] - a1, z2 = sz[k] - a2;
+         double rz = z0*z0 + z1*z1 + z2*z2;
+         double c = (z0*a0 + z1*a1 + z2*a2) / std::sqrt(rz*ra);
+         if (c > 1.0)             // rounding, as in Triple::cosVector()
+            c = 1.0;
+         else if (c < -1.0)
+            c = -1.0;
+         el[k] = 90.0 - std::acos(c) * gnsstk::RAD_TO_DEG;
+         double p1 = xn1*z0 + xn2*z1 + xn3*z2;
+         double p2 = xe1*z0 + xe2*z1;
+         double alpha = 90.0 - std::atan2(p1, p2) * gnsstk::RAD_TO_DEG;
+         az[k] = (alpha < 0 ? alpha + 360.0 : alpha);
+      }
+   }
+
+   gnsstk::NavLibrary& navLib;
+      /// Serializes the lookups in navLib.
+   std::mutex navMutex;
+   std::vector<gnsstk::SatID> sats;
+      /// Whether each of sats has any nav data.
+   std::vector<bool> present;
+   gnsstk::NavMessageType msgType;
+   gnsstk::SVHealth xmitHealth;
+   unsigned nthreads;
+   bool saveXvt;
+   bool haveAnt;
+   double antenna[3];
+      /// Number of epochs in the current block.
+   size_t nepochs;
+      /// Results of the current block, see index().
+   std::vector<char> found;
+   std::vector<double> px, py, pz, elev, azim;
+   std::vector<gnsstk::Xvt> xvts;
+};
+
+#endif
@@ -46,7 +46,7 @@
  *
  * \section wheresat_synopsis SYNOPSIS
  * <b>wheresat</b>  <b>-h</b> <br/>
- * <b>wheresat</b> <b>-e</b>&nbsp;\argarg{ARG} <b>[-d</b><b>]</b> <b>[-v</b><b>]</b> <b>[-i</b><b>]</b> <b>[-V</b><b>]</b> <b>[-u</b>&nbsp;\argarg{ARG}<b>]</b> <b>[\--start</b>&nbsp;\argarg{TIME}<b>]</b> <b>[\--end</b>&nbsp;\argarg{TIME}<b>]</b> <b>[-f</b>&nbsp;\argarg{ARG}<b>]</b> <b>[-s</b>&nbsp;\argarg{ARG}<b>]</b> <b>[-p</b>&nbsp;\argarg{NUM}<b>]</b> <b>[-t</b>&nbsp;\argarg{NUM}<b>]</b> <b>[-A</b><b>]</b>
+ * <b>wheresat</b> <b>-e</b>&nbsp;\argarg{ARG} <b>[\--navcache</b>&nbsp;\argarg{ARG}<b>]</b> <b>[-d</b><b>]</b> <b>[-v</b><b>]</b> <b>[-i</b><b>]</b> <b>[-V</b><b>]</b> <b>[-u</b>&nbsp;\argarg{ARG}<b>]</b> <b>[\--start</b>&nbsp;\argarg{TIME}<b>]</b> <b>[\--end</b>&nbsp;\argarg{TIME}<b>]</b> <b>[-f</b>&nbsp;\argarg{ARG}<b>]</b> <b>[-s</b>&nbsp;\argarg{ARG}<b>]</b> <b>[-p</b>&nbsp;\argarg{NUM}<b>]</b> <b>[-t</b>&nbsp;\argarg{NUM}<b>]</b> <b>[-A</b><b>]</b> <b>[\--threads</b>&nbsp;\argarg{NUM}<b>]</b>
  *
  * \section wheresat_description DESCRIPTION
  * This application uses input ephemeris to compute the estimated
@@ -98,6 +98,8 @@
  * \dictionary
  * \dicterm{-e, \--eph-files=\argarg{ARG}}
  * \dicdef{Ephemeris source file(s). Can be SP3a, SP3b, SP3c, SP3d, RINEX2, RINEX3, Yuma, SEM, RawNavCSV, NovAtel, MDP, FIC, MDH.}
+ * \dicterm{\--navcache=\argarg{ARG}}
+ * \dicdef{Ephemeris cache file(s) built by navcache, used with or in place of -e.}
  * \dicterm{-d, \--debug}
  * \dicdef{Increase debug level}
  * \dicterm{-v, \--verbose}
@@ -124,6 +126,8 @@
  * \dicdef{Time increment for ephemeris calculation. Enter increment in seconds. Default is 900 (15 min).}
  * \dicterm{-A, \--use-alm}
  * \dicdef{Use almanac to compute positions (default=ephemeris)}
+ * \dicterm{\--threads=\argarg{NUM}}
+ * \dicdef{Number of threads to compute positions on (default=1)}
  * \enddictionary
  *
  * \section wheresat_examples EXAMPLES
@@ -242,6 +246,13 @@
  * 07/20/2015 02:00:00.0  G13   12729578.198  -21752544.263    8434380.734  -0.133648   99.851   43.603    21818537.796
  * \endcode
  *
+ * \subsection wheresat_long_runs Long Runs
+ *
+ * Positions are computed a block of epochs at a time, looking each
+ * ephemeris up once per run of epochs that it is used for rather than
+ * at every epoch.  With \--threads the satellites are shared among
+ * several threads; the output is the same.
+ *
  * \section wheresat_exit_status EXIT STATUS
  * Abort/failure error codes given on return:
  * \dictable
@@ -269,6 +280,7 @@
 #include <iomanip>
 #include <fstream>
 #include <set>
+#include <vector>
 
 #include <gnsstk/BasicFramework.hpp>
 #include <gnsstk/CommonTime.hpp>
@@ -283,6 +295,8 @@
 #include <gnsstk/TimeString.hpp>
 #include <gnsstk/Xvt.hpp>
 #include "NewNavInc.h"
+#include "NavCache.hpp"
+#include "VisibilitySweep.hpp"
 
 using namespace std;
 using namespace gnsstk;
@@ -299,6 +313,8 @@ public:
    CommandOptionNoArg ignoreHealthOpt;
    CommandOptionNoArg velOpt;
    CommandOptionWithAnyArg ephFiles;
+   CommandOptionWithAnyArg navCacheOpt;
+   CommandOptionOneOf ephSourceOpt;
    CommandOptionWithAnyArg positionOpt;
    CommandOptionWithCommonTimeArg startTimeOpt;
    CommandOptionWithCommonTimeArg endTimeOpt;
@@ -307,6 +323,7 @@ public:
    CommandOptionWithNumberArg prnOpt;
    CommandOptionWithNumberArg incrementOpt;
    CommandOptionNoArg almOpt;
+   CommandOptionWithNumberArg threadsOpt;
       /// High level nav store interface.
    NavLibrary navLib;
       /// nav data file reader
@@ -320,7 +337,9 @@ WhereSat(const string& applName)
         ignoreHealthOpt('i',"noHealth","Ignore bad SV health."),
         velOpt('V',"velocity","Display velocity in addition to position"),
         ephFiles('e',"eph-files","Ephemeris source file(s). Can be RINEX nav,"
-                 " SP3, RawNavCSV, or FIC.",true),
+                 " SP3, RawNavCSV, or FIC."),
+        navCacheOpt('\0',"navcache","Ephemeris cache file(s) built by"
+                    " navcache, used with or in place of -e."),
         positionOpt('u',"position","Antenna position (m) in ECEF (x,y,z)"
                     " coordinates.  Format as a string: \"X Y Z\". Used to give"
                     " user-centered data (SV range, azimuth & elevation) when"
@@ -343,7 +362,9 @@ WhereSat(const string& applName)
         incrementOpt('t',"time","Time increment for ephemeris calculation. "
                      "Enter increment in seconds. Default is 900 (15 min)."),
         almOpt('A', "use-alm", "Use almanac to compute positions"
-               " (default=ephemeris)")
+               " (default=ephemeris)"),
+        threadsOpt('\0', "threads", "Number of threads to compute positions"
+                   " on (default=1)")
 {
       // Initialize these two items in here rather than in the
       // initializer list to guarantee execution order and avoid seg
@@ -351,6 +372,9 @@ WhereSat(const string& applName)
    ndfp = std::make_shared<gnsstk::MultiFormatNavDataFactory>();
    ephFiles.setDescription("Ephemeris source file(s). Can be " +
                            ndfp->getFactoryFormats() + ".");
+   ephSourceOpt.addOption(&ephFiles);
+   ephSourceOpt.addOption(&navCacheOpt);
+   threadsOpt.setMaxCount(1);
 }
 
 
@@ -447,6 +471,28 @@ process()
          cout << "File read by NavLibrary." << endl;
       }
    }
+   names = navCacheOpt.getValue();
+   for (size_t i=0; i<names.size(); i++)
+   {
+      try
+      {
+         NavCache::loadFile(names[i], navLib,
+                            {NavMessageType::Ephemeris,
+                             NavMessageType::Almanac, NavMessageType::Clock});
+         cout << "Cache read by NavLibrary." << endl;
+      }
+      catch (Exception& e)
+      {
+         cerr << "Unable to load \"" << names[i] << "\": "
+              << e.getText() << endl;
+         exitCode = BasicFramework::EXIST_ERROR;
+      }
+   }
+   string warn(NavCache::headerWarning(names, ephFiles.getCount()));
+   if (!warn.empty())
+   {
+      cerr << warn << endl;
+   }
 
       // Get the list of SatIDs that are available in the navigation message
       // store.  Convert this to a set that will be used later.
@@ -527,25 +573,55 @@ process()
    tE = tEnd;
    cout << tE << endl;
 
+      // epochs per VisibilitySweep block
+   const size_t blockSize = 1024;
+   unsigned nthreads = 1;
+   if (threadsOpt.getCount())
+   {
+      int n = asInt(threadsOpt.getValue()[0]);
+      if (n < 1)
+      {
+         cerr << "Warning - --threads must be positive; using 1" << endl;
+         n = 1;
+      }
+      nthreads = n;
+   }
+   VisibilitySweep sweep(navLib, vector<SatID>(satSet.begin(), satSet.end()),
+                         almOpt,
+                         (ignoreHealthOpt ? SVHealth::Any : SVHealth::Healthy));
+   sweep.setThreads(nthreads);
+   sweep.setSaveXvt(true);
+   bool haveAnt = !(abs(antXvt.x[0]) < 1);
+   if (haveAnt)
+      sweep.setAntenna(antXvt.x);
+
    CommonTime t = tStart;
    if (debugLevel)
    {
       cerr << "dump:" << endl;
       navLib.dump(std::cerr, gnsstk::DumpDetail::OneLine);
    }
+   WGS84Ellipsoid ellipsoid;
+   vector<CommonTime> epochs;
    while (t <= tEnd)
    {
-      for(set<SatID>::iterator i = satSet.begin(); i != satSet.end(); i++ )
+      epochs.clear();
+      while (t <= tEnd && epochs.size() < blockSize)
       {
-         SatID thisSat = *i;
-         RinexSatID rsid(thisSat);   // Used only for output formatting
-         Xvt xvt;
-         if (navLib.getXvt(
-                NavSatelliteID(thisSat),t,xvt, almOpt,
-                (ignoreHealthOpt ? SVHealth::Any : SVHealth::Healthy),
-                NavValidityType::ValidOnly, NavSearchOrder::Nearest))
+         epochs.push_back(t);
+         t += incr;
+      }
+      sweep.compute(epochs);
+
+      for (size_t k = 0; k < epochs.size(); k++)
+      {
+         for (size_t s = 0; s < sweep.numSats(); s++)
          {
-            cout << printTime(t,timeFormat)
+            if (!sweep.have(k,s))
+               continue;
+            RinexSatID rsid(sweep.sat(s));   // Used only for output formatting
+            const Xvt& xvt(sweep.xvt(k,s));
+            cout << printTime(epochs[k],timeFormat)
                  << right << fixed  << setprecision(3)
                  << " " << setw(4)  <<  rsid
                  << " " << setw(14) << xvt.x[0]
@@ -554,10 +630,9 @@ process()
                  << " " << setprecision(6) << setw(10)
                  << ((xvt.clkbias + xvt.relcorr)*1000);
 
-            WGS84Ellipsoid ellipsoid;
             double correction = 0;
 
-            if ( abs(antXvt.x[0]) < 1 || antXvt.x.elvAngle(xvt.x) < 0 )
+            if (!haveAnt || sweep.elevation(k,s) < 0)
             {
                cout << right
                     << " "  << setw(8) << "-"
@@ -567,8 +642,8 @@ process()
             else
             {
                cout << right << fixed << setprecision(3)
-                    << " "  << setw(8) << antXvt.x.azAngle(xvt.x)
-                    << " "  << setw(8) << antXvt.x.elvAngle(xvt.x)
+                    << " "  << setw(8) << sweep.azimuth(k,s)
+                    << " "  << setw(8) << sweep.elevation(k,s)
                     << " "  << setw(15)
                     << xvt.preciseRho(antXvt.x, ellipsoid, correction);
             }
@@ -582,8 +657,6 @@ process()
             cout << endl;
          }
       }
-
-      t += incr;
    }
 }
 
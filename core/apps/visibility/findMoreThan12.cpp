@@ -46,7 +46,7 @@
  *
  * \section findMoreThan12_synopsis SYNOPSIS
  * <b>findMoreThan12</b>  <b>-h</b> <br/>
- * <b>findMoreThan12</b> <b>-e</b>&nbsp;\argarg{ARG} <b>-p</b>&nbsp;\argarg{POSITION} <b>-m</b>&nbsp;\argarg{NUM} <b>[-d</b><b>]</b> <b>[-v</b><b>]</b> <b>[-T</b>&nbsp;\argarg{TIME}<b>]</b> <b>[-E</b>&nbsp;\argarg{TIME}<b>]</b>
+ * <b>findMoreThan12</b> <b>-e</b>&nbsp;\argarg{ARG} <b>[\--navcache</b>&nbsp;\argarg{ARG}<b>]</b> <b>-p</b>&nbsp;\argarg{POSITION} <b>-m</b>&nbsp;\argarg{NUM} <b>[-d</b><b>]</b> <b>[-v</b><b>]</b> <b>[-T</b>&nbsp;\argarg{TIME}<b>]</b> <b>[-E</b>&nbsp;\argarg{TIME}<b>]</b> <b>[\--sys</b>&nbsp;\argarg{ARG}<b>]</b> <b>[\--threads</b>&nbsp;\argarg{NUM}<b>]</b>
  *
  * \section findMoreThan12_description DESCRIPTION
  * This application finds when there are simultaneously more than 12
@@ -54,9 +54,18 @@
  * for 12-channel receivers to determine when such a receiver will not
  * be able to track all satellites in view.
  *
+ * By default GPS PRNs 1 through 32 are counted; \--sys counts the
+ * satellites of other systems, or of all systems, found in the
+ * ephemeris data instead.  The positions are computed a day of epochs
+ * at a time, looking each ephemeris up once per run of epochs that it
+ * is used for, and the satellites may be shared among several threads
+ * with \--threads without changing the output.
+ *
  * \dictionary
  * \dicterm{-e, \--eph-files=\argarg{ARG}}
  * \dicdef{Ephemeris source file(s). Can be RINEX nav, SP3.}
+ * \dicterm{\--navcache=\argarg{ARG}}
+ * \dicdef{Ephemeris cache file(s) built by navcache, used with or in place of -e.}
  * \dicterm{-p, \--position=\argarg{POSITION}}
  * \dicdef{Antenna position in ECEF meters (x y z)}
  * \dicterm{-m, \--min-elev=\argarg{NUM}}
@@ -71,6 +80,10 @@
  * \dicdef{start time of simulation (YYYY DOY SOD)}
  * \dicterm{-E, \--end-time=\argarg{TIME}}
  * \dicdef{end time of simulation (YYYY DOY SOD)}
+ * \dicterm{\--sys=\argarg{ARG}}
+ * \dicdef{Count the satellites of system(s) G,R,E,C,J,I,S, or 'all' (default=GPS PRNs 1-32)}
+ * \dicterm{\--threads=\argarg{NUM}}
+ * \dicdef{Number of threads to compute positions on (default=1)}
  * \enddictionary
  *
  * \section findMoreThan12_examples EXAMPLES
@@ -95,6 +108,8 @@
 
 #include <iostream>
 #include <iomanip>
+#include <set>
+#include <vector>
 
 #include <gnsstk/BasicFramework.hpp>
 #include <gnsstk/CommonTime.hpp>
@@ -104,7 +119,11 @@
 #include <gnsstk/TimeString.hpp>
 #include <gnsstk/NavLibrary.hpp>
 #include <gnsstk/MultiFormatNavDataFactory.hpp>
+#include <gnsstk/RinexSatID.hpp>
 #include "NewNavInc.h"
+#include "NavCache.hpp"
+#include "SatSystems.hpp"
+#include "VisibilitySweep.hpp"
 
 using namespace std;
 using namespace gnsstk;
@@ -126,6 +145,10 @@ public:
 
       /// Specify the location(s) of ephemeris data files
    CommandOptionWithAnyArg ephFiles;
+      /// Specify pre-indexed ephemeris cache file(s) (see navcache)
+   CommandOptionWithAnyArg navCacheOpt;
+      /// Require at least one of ephFiles or navCacheOpt
+   CommandOptionOneOf ephSourceOpt;
       /// Specify the reference antenna position
    CommandOptionWithPositionArg antennaPosition;
       /// Cut-off elevation at which point the user cares about >12 SVs in view
@@ -134,6 +157,10 @@ public:
    CommandOptionWithCommonTimeArg startTime;
       /// Allow the user to specify a time to stop processing
    CommandOptionWithCommonTimeArg endTime;
+      /// Satellite systems to count instead of GPS PRNs 1-MAX_PRN
+   CommandOptionWithAnyArg sysOpt;
+      /// Number of threads to compute positions on
+   CommandOptionWithNumberArg threadsOpt;
 
       /// User's requested elevation cut-off.
    int minEl;
@@ -143,6 +170,14 @@ public:
    gnsstk::NavDataFactoryPtr ndfp;
       /// Start and end times of processing
    CommonTime tstart, tend;
+      /// Systems from sysOpt.
+   std::set<SatelliteSystem> systems;
+      /// Count the satellites of every system.
+   bool allSystems;
+      /// Satellites to count.
+   std::vector<SatID> sats;
+      /// Number of threads to compute positions on.
+   unsigned nthreads;
 };
 
 
@@ -151,8 +186,9 @@ FindMoreThan12(const std::string& applName)
       : BasicFramework(applName, "Find when there are simultaneously more"
                        " than 12 SVs above a given elevation."),
         ephFiles('e', "eph-files",
-                 "If you see this, we failed.",
-                 true),
+                 "If you see this, we failed."),
+        navCacheOpt('\0', "navcache", "Ephemeris cache file(s) built by"
+                    " navcache, used with or in place of -e."),
         antennaPosition('p', "position", "%x %y %z",
                         "Antenna position in ECEF meters (x y z)",
                         true),
@@ -163,7 +199,12 @@ FindMoreThan12(const std::string& applName)
         startTime('T', "time", "%Y %j %s", "start time of simulation (YYYY DOY"
                   " SOD)"),
         endTime('E', "end-time", "%Y %j %s", "end time of simulation (YYYY DOY"
-                " SOD)")
+                " SOD)"),
+        sysOpt('\0', "sys", "Count the satellites of system(s) G,R,E,C,J,I,S,"
+               " or 'all' (default=GPS PRNs 1-32)"),
+        threadsOpt('\0', "threads", "Number of threads to compute positions on"
+                   " (default=1)"),
+        allSystems(false), nthreads(1)
 {
       // Initialize these two items in here rather than in the
       // initializer list to guarantee execution order and avoid seg
@@ -171,10 +212,13 @@ FindMoreThan12(const std::string& applName)
    ndfp = std::make_shared<gnsstk::MultiFormatNavDataFactory>();
    ephFiles.setDescription("Ephemeris source file(s). Can be " +
                            ndfp->getFactoryFormats() + ".");
+   ephSourceOpt.addOption(&ephFiles);
+   ephSourceOpt.addOption(&navCacheOpt);
    antennaPosition.setMaxCount(1);
    minElev.setMaxCount(1);
    startTime.setMaxCount(1);
    endTime.setMaxCount(1);
+   threadsOpt.setMaxCount(1);
 }
 
 
@@ -195,6 +239,24 @@ initialize( int argc,
       return false;
    }
 
+   string bad;
+   if (!parseSatSystems(sysOpt.getValue(), systems, allSystems, bad))
+   {
+      cerr << "Unknown satellite system \"" << bad << "\"" << endl;
+      return false;
+   }
+
+   if (threadsOpt.getCount())
+   {
+      int n = StringUtils::asInt(threadsOpt.getValue()[0]);
+      if (n < 1)
+      {
+         cerr << "Warning - --threads must be positive; using 1" << endl;
+         n = 1;
+      }
+      nthreads = n;
+   }
+
    navLib.addFactory(ndfp);
       // without clock, SP3 doesn't work.
    navLib.setTypeFilter({NavMessageType::Ephemeris, NavMessageType::Clock});
@@ -216,6 +278,26 @@ additionalSetup()
          exitCode = BasicFramework::EXIST_ERROR;            
       }
    }
+   names = navCacheOpt.getValue();
+   for (size_t i=0; i<names.size(); i++)
+   {
+      try
+      {
+         NavCache::loadFile(names[i], navLib,
+                            {NavMessageType::Ephemeris, NavMessageType::Clock});
+      }
+      catch (Exception& e)
+      {
+         cerr << "Unable to load \"" << names[i] << "\": "
+              << e.getText() << endl;
+         exitCode = BasicFramework::EXIST_ERROR;
+      }
+   }
+   string warn(NavCache::headerWarning(names, ephFiles.getCount()));
+   if (!warn.empty())
+   {
+      cerr << warn << endl;
+   }
 
    if (startTime.getCount())
    {
@@ -235,12 +317,30 @@ additionalSetup()
    {
       tend = navLib.getFinalTime();
    }
+
+   if (sysOpt.getCount())
+   {
+      std::set<SatID> stored = navLib.getIndexSet(
+         CommonTime::BEGINNING_OF_TIME, CommonTime::END_OF_TIME);
+      for (const auto& sat : stored)
+      {
+         if (allSystems || systems.count(sat.system))
+            sats.push_back(sat);
+      }
+   }
+   else
+   {
+      for (int prn=1; prn <= gnsstk::MAX_PRN; prn++)
+         sats.push_back(SatID(prn,SatelliteSystem::GPS));
+   }
 }
 
 
 void FindMoreThan12 ::
 process()
 {
+      // epochs per VisibilitySweep block, a day at 10 s
+   const size_t blockSize = 8640;
    CommonTime t = tstart;
 
    cout << "Start Time: " << printTime(tstart, "%02m/%02d/%04Y %02H:%02M:%02S")
@@ -249,67 +349,50 @@ process()
 
    Position antXYZ = antennaPosition.getPosition()[0];
 
+   VisibilitySweep sweep(navLib, sats, false, SVHealth::Any);
+   sweep.setAntenna(antXYZ.asECEF());
+   sweep.setThreads(nthreads);
+
+   vector<CommonTime> epochs;
    while (t < tend)
    {
-      short numSVsAboveElv = 0;
-      for (int prn=1; prn <= gnsstk::MAX_PRN; prn++)
+      epochs.clear();
+      while (t < tend && epochs.size() < blockSize)
       {
-         try
-         {
-            gnsstk::Xvt peXVT;
-            if (navLib.getXvt(
-                   NavSatelliteID(SatID(prn,SatelliteSystem::GPS)),t,peXVT,
-                   false, SVHealth::Any, NavValidityType::ValidOnly,
-                   NavSearchOrder::Nearest))
-            {
-               double elvAngle = antXYZ.elvAngle(peXVT.x);
-               if ( elvAngle > minEl )
-                  numSVsAboveElv++;
-            }
-         }
-         catch(gnsstk::Exception& e)
-         {
-            if (verboseLevel)
-               cout << e << endl;
-         }
+         epochs.push_back(t);
+         t += 10;
       }
+      sweep.compute(epochs);
 
-      if (numSVsAboveElv > 12)
+      for (size_t k = 0; k < epochs.size(); k++)
       {
+         short numSVsAboveElv = 0;
+         for (size_t s = 0; s < sweep.numSats(); s++)
+         {
+            if (sweep.have(k,s) && sweep.elevation(k,s) > minEl)
+               numSVsAboveElv++;
+         }
+         if (numSVsAboveElv <= 12)
+            continue;
+
          cout << "Found " << numSVsAboveElv << " SVs above " << minEl
               << " degrees at "
-              << printTime(t, "%02m/%02d/%04Y %02H:%02M:%02S") << endl;
+              << printTime(epochs[k], "%02m/%02d/%04Y %02H:%02M:%02S") << endl;
 
-         for (int prn = 1; prn <= gnsstk::MAX_PRN; prn++)
+         for (size_t s = 0; s < sweep.numSats(); s++)
          {
-            try
-            {
-               gnsstk::Xvt peXVT;
-               if (navLib.getXvt(
-                      NavSatelliteID(SatID(prn,SatelliteSystem::GPS)),t,peXVT,
-                      false, SVHealth::Any, NavValidityType::ValidOnly,
-                      NavSearchOrder::Nearest))
-               {
-                  double elvAngle = antXYZ.elvAngle(peXVT.x);
-                  if ( elvAngle > 0 )
-                  {
-                     double azAngle = antXYZ.azAngle(peXVT.x);
-                     cout << printTime(t, "%02m/%02d/%04Y %02H:%02M:%02S")
-                          << "  PRN " << setw(2) << prn
-                          << " : elev: " << elvAngle
-                          << "  azim: " << azAngle
-                          << " degrees" << endl;
-                  }
-               }
-            }
-            catch(gnsstk::Exception& e)
-            {
-               if (verboseLevel)
-                  cout << e << endl;
-            }
+            if (!sweep.have(k,s) || !(sweep.elevation(k,s) > 0))
+               continue;
+            cout << printTime(epochs[k], "%02m/%02d/%04Y %02H:%02M:%02S");
+            if (sweep.sat(s).system == SatelliteSystem::GPS)
+               cout << "  PRN " << setw(2) << sweep.sat(s).id;
+            else
+               cout << "  PRN " << RinexSatID(sweep.sat(s));
+            cout << " : elev: " << sweep.elevation(k,s)
+                 << "  azim: " << sweep.azimuth(k,s)
+                 << " degrees" << endl;
          }
       }
-      t += 10;
    }
 }
 
@@ -0,0 +1,79 @@
+# test that a file whose epochs are out of time order gives the same
+# differences as the same records in order.  The body of FILE2 is
+# appended to FILE1, after it (in order) and before it (out of order),
+# and each result is differenced with FILE3.  The out of order file is
+# differenced with a look-ahead of one epoch, which must fall back to
+# comparing the whole files, and with a look-ahead (WINDOW) longer than
+# FILE2, which must put the epochs back in order without the fallback.
+
+message(STATUS "running ${TEST_PROG} on ${SOURCEDIR}/${FILE1} and ${SOURCEDIR}/${FILE2} in and out of order, with ${SOURCEDIR}/${FILE3}")
+
+# Make sure windows knows where to find the DLLs
+if ( WIN32 )
+  set(ENV{PATH} "$ENV{PATH};${EXTPATH}")
+endif ( WIN32 )
+
+# split a file into its header, through the END OF HEADER line, and body
+function(split_rinex FILE HDR BODY)
+   file(READ ${FILE} CONTENTS)
+   string(FIND "${CONTENTS}" "END OF HEADER" POS)
+   if(POS EQUAL -1)
+      message(FATAL_ERROR "Test failed - no header in ${FILE}")
+   endif()
+   string(SUBSTRING "${CONTENTS}" ${POS} -1 REST)
+   string(FIND "${REST}" "\n" EOL)
+   math(EXPR POS "${POS} + ${EOL} + 1")
+   string(SUBSTRING "${CONTENTS}" 0 ${POS} H)
+   string(SUBSTRING "${CONTENTS}" ${POS} -1 B)
+   set(${HDR} "${H}" PARENT_SCOPE)
+   set(${BODY} "${B}" PARENT_SCOPE)
+endfunction()
+
+split_rinex(${SOURCEDIR}/${FILE1} HDR1 BODY1)
+split_rinex(${SOURCEDIR}/${FILE2} HDR2 BODY2)
+file(WRITE ${TARGETDIR}/${TESTBASE}_ordered.obs "${HDR1}${BODY1}${BODY2}")
+file(WRITE ${TARGETDIR}/${TESTBASE}_unordered.obs "${HDR1}${BODY2}${BODY1}")
+
+execute_process(COMMAND ${TEST_PROG} ${TARGETDIR}/${TESTBASE}_ordered.obs
+                ${SOURCEDIR}/${FILE3}
+                OUTPUT_FILE ${TARGETDIR}/${TESTBASE}_ordered.out
+                RESULT_VARIABLE RC1)
+execute_process(COMMAND ${TEST_PROG} -w 1
+                ${TARGETDIR}/${TESTBASE}_unordered.obs ${SOURCEDIR}/${FILE3}
+                OUTPUT_FILE ${TARGETDIR}/${TESTBASE}_unordered.out
+                ERROR_FILE ${TARGETDIR}/${TESTBASE}_unordered.err
+                RESULT_VARIABLE RC2)
+if(NOT RC1 EQUAL RC2)
+    message(FATAL_ERROR "Test failed - exit codes differ: ${RC1} ${RC2}")
+endif()
+
+execute_process(COMMAND ${TEST_PROG} -w ${WINDOW}
+                ${TARGETDIR}/${TESTBASE}_unordered.obs ${SOURCEDIR}/${FILE3}
+                OUTPUT_FILE ${TARGETDIR}/${TESTBASE}_window.out
+                ERROR_FILE ${TARGETDIR}/${TESTBASE}_window.err
+                RESULT_VARIABLE RC3)
+if(NOT RC1 EQUAL RC3)
+    message(FATAL_ERROR "Test failed - exit codes differ: ${RC1} ${RC3}")
+endif()
+
+# the out of order file must have taken the fallback, unless the
+# look-ahead covers the disorder
+file(READ ${TARGETDIR}/${TESTBASE}_unordered.err ERR)
+string(FIND "${ERR}" "not in time order" POS)
+if(POS EQUAL -1)
+    message(FATAL_ERROR "Test failed - out of order input was not detected")
+endif()
+file(READ ${TARGETDIR}/${TESTBASE}_window.err ERR)
+string(FIND "${ERR}" "not in time order" POS)
+if(NOT POS EQUAL -1)
+    message(FATAL_ERROR "Test failed - the look-ahead did not sort the input")
+endif()
+
+foreach(RUN unordered window)
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files
+        ${TARGETDIR}/${TESTBASE}_ordered.out ${TARGETDIR}/${TESTBASE}_${RUN}.out
+        RESULT_VARIABLE DIFFERENT)
+    if(DIFFERENT)
+        message(FATAL_ERROR "Test failed - files differ (${RUN}): ${DIFFERENT}")
+    endif()
+endforeach()
@@ -9,11 +9,20 @@
 # INFILE2: second input file
 # RINDIFF: location of RINEX diff tool for the format being tested
 # RINHEADDIFF: location of rinheaddiff application
+# ARGS: extra options for TEST_PROG (optional)
+# EXPBASE: the name of the reference file, if not TESTBASE (optional)
 #
 # TEST_PROG is expected to generate the output file
 # ${TARGETDIR}/${TESTBASE}.out
 #
-# Reference file is ${SOURCEDIR}/${TESTBASE}.exp
+# Reference file is ${SOURCEDIR}/${EXPBASE}.exp
+
+IF(NOT DEFINED EXPBASE)
+   set(EXPBASE ${TESTBASE})
+ENDIF(NOT DEFINED EXPBASE)
+IF(DEFINED ARGS)
+   string(REPLACE " " ";" ARG_LIST ${ARGS})
+ENDIF(DEFINED ARGS)
 
 # Make sure windows knows where to find the DLLs
 if ( WIN32 )
@@ -22,9 +31,9 @@ endif ( WIN32 )
 
 # Generate the merged file
 
-message(STATUS "running ${TEST_PROG} -o ${TARGETDIR}/${TESTBASE}.out ${SOURCEDIR}/${INFILE1} ${SOURCEDIR}/${INFILE2}")
+message(STATUS "running ${TEST_PROG} ${ARGS} -o ${TARGETDIR}/${TESTBASE}.out ${SOURCEDIR}/${INFILE1} ${SOURCEDIR}/${INFILE2}")
 
-execute_process(COMMAND ${TEST_PROG} -o ${TARGETDIR}/${TESTBASE}.out ${SOURCEDIR}/${INFILE1} ${SOURCEDIR}/${INFILE2}
+execute_process(COMMAND ${TEST_PROG} ${ARG_LIST} -o ${TARGETDIR}/${TESTBASE}.out ${SOURCEDIR}/${INFILE1} ${SOURCEDIR}/${INFILE2}
                 OUTPUT_QUIET
                 RESULT_VARIABLE HAD_ERROR)
 if(HAD_ERROR)
@@ -34,9 +43,9 @@ endif()
 
 # diff against reference
 
-message(STATUS "running ${RINDIFF} ${SOURCEDIR}/${TESTBASE}.exp ${TARGETDIR}/${TESTBASE}.out")
+message(STATUS "running ${RINDIFF} ${SOURCEDIR}/${EXPBASE}.exp ${TARGETDIR}/${TESTBASE}.out")
 
-execute_process(COMMAND ${RINDIFF} ${SOURCEDIR}/${TESTBASE}.exp ${TARGETDIR}/${TESTBASE}.out
+execute_process(COMMAND ${RINDIFF} ${SOURCEDIR}/${EXPBASE}.exp ${TARGETDIR}/${TESTBASE}.out
     OUTPUT_QUIET
     RESULT_VARIABLE DIFFERENT)
 if(DIFFERENT)
@@ -48,9 +57,9 @@ endif()
 
 set( EXCL1 "PGM / RUN BY / DATE" )
 
-message(STATUS "running ${RINHEADDIFF} -x ${EXCL1} ${SOURCEDIR}/${TESTBASE}.exp ${TARGETDIR}/${TESTBASE}.out")
+message(STATUS "running ${RINHEADDIFF} -x ${EXCL1} ${SOURCEDIR}/${EXPBASE}.exp ${TARGETDIR}/${TESTBASE}.out")
 
-execute_process(COMMAND ${RINHEADDIFF} -x ${EXCL1} ${SOURCEDIR}/${TESTBASE}.exp ${TARGETDIR}/${TESTBASE}.out
+execute_process(COMMAND ${RINHEADDIFF} -x ${EXCL1} ${SOURCEDIR}/${EXPBASE}.exp ${TARGETDIR}/${TESTBASE}.out
     RESULT_VARIABLE DIFFERENT)
 if(DIFFERENT)
     message(FATAL_ERROR "Test failed - headers differ: ${DIFFERENT}")
@@ -0,0 +1,79 @@
+# Run a program with two sets of options, e.g. serial and multi-threaded, and
+# check that the second run is faster, by the wallclock time that the program
+# itself prints. Each is run REPEAT times, and the fastest times are compared.
+# On a host with a single processor the test is skipped (passes).
+#
+# Expected variables (required unless otherwise noted):
+# TARGETDIR: the directory to store the outputs
+# TESTNAME: the name of the test, used to create the output files
+#   ${TESTNAME}_1.out and ${TESTNAME}_2.out (the last run of each)
+#
+# TEST_PROG: the program under test
+# ARGS: a space-separated argument list common to both runs (optional)
+# ARGS1: a space-separated argument list for the first run only (optional)
+# ARGS2: a space-separated argument list for the second run only (optional)
+# TIME_REGEX: a regular expression matching the time in the output, in
+#   seconds, as its first sub-expression
+# REPEAT: the number of times each is run (optional, default 3)
+
+# Make sure windows knows where to find the DLLs
+if ( WIN32 )
+  set(ENV{PATH} "$ENV{PATH};${EXTPATH}")
+endif ( WIN32 )
+
+IF(NOT DEFINED TESTNAME)
+   message(FATAL_ERROR "Test failed, TESTNAME is not set")
+ENDIF(NOT DEFINED TESTNAME)
+IF(NOT DEFINED TIME_REGEX)
+   message(FATAL_ERROR "Test failed, TIME_REGEX is not set")
+ENDIF(NOT DEFINED TIME_REGEX)
+IF(NOT DEFINED REPEAT)
+   set(REPEAT 3)
+ENDIF(NOT DEFINED REPEAT)
+
+cmake_host_system_information(RESULT NCORES QUERY NUMBER_OF_LOGICAL_CORES)
+if(NCORES LESS 2)
+    message(STATUS "Test skipped, only ${NCORES} processor")
+    return()
+endif()
+
+# Convert argument strings into cmake lists
+IF(DEFINED ARGS)
+   string(REPLACE " " ";" ARG_LIST ${ARGS})
+ENDIF(DEFINED ARGS)
+IF(DEFINED ARGS1)
+   string(REPLACE " " ";" ARG_LIST_1 ${ARGS1})
+ENDIF(DEFINED ARGS1)
+IF(DEFINED ARGS2)
+   string(REPLACE " " ";" ARG_LIST_2 ${ARGS2})
+ENDIF(DEFINED ARGS2)
+
+foreach(RUN 1 2)
+    set(out "${TARGETDIR}/${TESTNAME}_${RUN}.out")
+    message(STATUS "${TEST_PROG} ${ARGS} ${ARGS${RUN}}")
+    foreach(N RANGE 1 ${REPEAT})
+        execute_process(COMMAND ${TEST_PROG} ${ARG_LIST} ${ARG_LIST_${RUN}}
+            OUTPUT_FILE ${out}
+            RESULT_VARIABLE RC)
+        if(RC)
+            message(FATAL_ERROR "Test failed, run ${RUN} returned ${RC}")
+        endif()
+        file(STRINGS ${out} LINES REGEX "${TIME_REGEX}")
+        if(NOT LINES)
+            message(FATAL_ERROR "Test failed, no time in the output of run ${RUN}")
+        endif()
+        list(GET LINES 0 LINE)
+        string(REGEX REPLACE ".*${TIME_REGEX}.*" "\\1" T "${LINE}")
+        if(NOT DEFINED TIME_${RUN} OR T LESS TIME_${RUN})
+            set(TIME_${RUN} ${T})
+        endif()
+    endforeach()
+    message(STATUS "Run ${RUN}: fastest of ${REPEAT} took ${TIME_${RUN}} sec")
+endforeach()
+
+if(TIME_2 LESS TIME_1)
+    message(STATUS "Test passed")
+else()
+    message(FATAL_ERROR
+        "Test failed - run 2 (${TIME_2} sec) is not faster than run 1 (${TIME_1} sec)")
+endif()
@@ -0,0 +1,91 @@
+# Run a program twice with different options that must not change the
+# output (e.g. serial and multi-threaded), and compare the two outputs.
+#
+# Expected variables (required unless otherwise noted):
+# TARGETDIR: the directory to store the outputs
+# TESTNAME: the name of the test, used to create the output files
+#   ${TESTNAME}_1.out and ${TESTNAME}_2.out
+#
+# TEST_PROG: the program under test
+# ARGS: a space-separated argument list common to both runs (optional)
+# ARGS1: a space-separated argument list for the first run only (optional)
+# ARGS2: a space-separated argument list for the second run only (optional)
+# SPARG1: a single escaped argument common to both runs (optional)
+# SPARG2: a single escaped argument common to both runs (optional)
+# SPARG3: a single escaped argument common to both runs (optional)
+#
+# DIFF_PROG: if defined, use this for differencing the outputs
+# DIFF_ARGS: arguments to pass to ${DIFF_PROG}
+#
+# Flags:
+# OWNOUTPUT: if unset, stdout will be captured to ${TESTNAME}_N.out.  If
+#    set, it is expected that the application itself will produce
+#    ${TESTNAME}_N.out, as directed by ARGS1 and ARGS2.
+# OUT1, OUT2: with OWNOUTPUT, the files that the first and second runs
+#    produce, if not ${TESTNAME}_1.out and ${TESTNAME}_2.out (optional)
+
+# Make sure windows knows where to find the DLLs
+if ( WIN32 )
+  set(ENV{PATH} "$ENV{PATH};${EXTPATH}")
+endif ( WIN32 )
+
+IF(NOT DEFINED TESTNAME)
+   message(FATAL_ERROR "Test failed, TESTNAME is not set")
+ENDIF(NOT DEFINED TESTNAME)
+
+# Convert argument strings into cmake lists
+IF(DEFINED ARGS)
+   string(REPLACE " " ";" ARG_LIST ${ARGS})
+ENDIF(DEFINED ARGS)
+IF(DEFINED ARGS1)
+   string(REPLACE " " ";" ARG_LIST_1 ${ARGS1})
+ENDIF(DEFINED ARGS1)
+IF(DEFINED ARGS2)
+   string(REPLACE " " ";" ARG_LIST_2 ${ARGS2})
+ENDIF(DEFINED ARGS2)
+IF(DEFINED DIFF_ARGS)
+   string(REPLACE " " ";" DIFF_ARG_LIST ${DIFF_ARGS})
+ENDIF(DEFINED DIFF_ARGS)
+
+foreach(RUN 1 2)
+    set(out "${TARGETDIR}/${TESTNAME}_${RUN}.out")
+    message(STATUS "${TEST_PROG} ${ARGS} ${SPARG1} ${SPARG2} ${SPARG3} ${ARGS${RUN}}")
+    IF(NOT DEFINED OWNOUTPUT)
+        execute_process(COMMAND ${TEST_PROG} ${ARG_LIST}
+            ${SPARG1} ${SPARG2} ${SPARG3} ${ARG_LIST_${RUN}}
+            OUTPUT_FILE ${out}
+            RESULT_VARIABLE RC)
+    ELSE(NOT DEFINED OWNOUTPUT)
+        execute_process(COMMAND ${TEST_PROG} ${ARG_LIST}
+            ${SPARG1} ${SPARG2} ${SPARG3} ${ARG_LIST_${RUN}}
+            OUTPUT_QUIET
+            RESULT_VARIABLE RC)
+    ENDIF(NOT DEFINED OWNOUTPUT)
+    if(RC)
+        message(FATAL_ERROR "Test failed, run ${RUN} returned ${RC}")
+    endif()
+endforeach()
+
+set(out1 "${TARGETDIR}/${TESTNAME}_1.out")
+set(out2 "${TARGETDIR}/${TESTNAME}_2.out")
+IF(DEFINED OWNOUTPUT AND DEFINED OUT1)
+    set(out1 "${OUT1}")
+ENDIF()
+IF(DEFINED OWNOUTPUT AND DEFINED OUT2)
+    set(out2 "${OUT2}")
+ENDIF()
+if(DEFINED DIFF_PROG)
+    message(STATUS         "${DIFF_PROG} ${DIFF_ARG_LIST} -1 ${out1} -2 ${out2}")
+    execute_process(COMMAND ${DIFF_PROG} ${DIFF_ARG_LIST} -1 ${out1} -2 ${out2}
+        RESULT_VARIABLE DIFFERENT)
+else()
+    message(STATUS "diff ${out1} ${out2}")
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${out1} ${out2}
+        RESULT_VARIABLE DIFFERENT)
+endif()
+
+if(DIFFERENT)
+    message(FATAL_ERROR "Test failed - files differ: ${DIFFERENT}")
+else()
+    message(STATUS "Test passed")
+endif(DIFFERENT)
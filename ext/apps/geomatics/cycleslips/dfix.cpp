@@ -42,13 +42,19 @@
 //------------------------------------------------------------------------------------
 // system includes
 #include "NewNavInc.h"
+#include "NavCache.hpp"
 #include <ctime>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
 #include <string>
 #include <vector>
 #include <map>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <exception>
 // GNSSTk
 #include <gnsstk/Exception.hpp>
 #include <gnsstk/StringUtils.hpp>
@@ -69,6 +75,10 @@
 #include <gnsstk/SatPass.hpp>
 #include <gnsstk/SatPassUtilities.hpp>
 #include <gnsstk/Rinex3ObsFileLoader.hpp>
+#include <gnsstk/Rinex3ObsStream.hpp>
+#include <gnsstk/Rinex3ObsHeader.hpp>
+#include <gnsstk/Rinex3ObsData.hpp>
+#include <gnsstk/GPSWeekSecond.hpp>
 // dfix
 #include <gnsstk/CommandLine.hpp>
 #include <gnsstk/gdc.hpp>
@@ -101,10 +111,20 @@ int ReadRinexFiles(void);
 /// @throw Exception
 int PreProcess(void);
 
+/// Mark data in one pass below the elevation limit bad
+/// @throw Exception
+void MarkLowElevation(SatPass& SP);
+
 /// Call GDC for each pass and output
 /// @throw Exception
 int Process(void);
 
+/// Read RINEX file(s) one epoch at a time (--stream), building the SatPasses and
+/// correcting each one as soon as it ends, so only the open passes are in memory
+/// @return 0 success, <0 error code
+/// @throw Exception
+int StreamRinexFiles(void);
+
 //------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------
 /// Class GlobalData (a singleton) encapsulates global static data as well as
@@ -139,6 +159,7 @@ public:
 
    Epoch startTime, stopTime;    ///< start and stop times for data
    double decdt;                 ///< decimate data to this timestep (sec)
+   bool stream;                  ///< read the data incrementally (--stream)
    map<RinexSatID,int> GLOfreqCh;///< input freq channel - overrides eph input
 
    vector<string> DCcmds;        ///< GDC editing cmds - written to cmdout
@@ -151,9 +172,11 @@ public:
    // ephemeris and refpos input
    vector<string> SP3files;      ///< SP3 ephemeris file names
    vector<string> RNavfiles;     ///< RINEX nav file names
+   vector<string> NavCaches;     ///< nav cache file names (see navcache)
    string ephpath;               ///< path for nav/ephemeris files
    NavLibrary navLib;            ///< High level nav store interface.
    NavDataFactoryPtr ndfp;       ///< nav data file reader
+   size_t nNavCache;             ///< number of records loaded from NavCaches
    Position Rx;                  ///< Receiver position provided by user
    double elevLimit;             ///< Elevation angle lower limit (deg)
    bool doElev;                  ///< set true if elevation screening is to be done
@@ -184,8 +207,14 @@ public:
    Rinex3ObsHeader header;       ///< save for RINEX output
 
    gdc GDC;                      ///< the GDC object
-
-   vector<string> EditCmds;      ///< editing commands returned by GDC - write cmdout
+   int nthreads;                 ///< number of threads for the GDC (--threads)
+   int nthreadsUsed;             ///< number of threads actually used
+   int nPassesDC;                ///< number of passes given to the GDC
+   double DCseconds;             ///< wall time spent in the GDC (sec)
+
+   /// editing commands returned by GDC, by pass number - write cmdout; with
+   /// --stream the passes end out of order, so they are written in pass order
+   map<int, vector<string> > EditCmds;
    string longfmt;               ///< times in loader, error messages, etc.
 
 private:
@@ -216,17 +245,24 @@ private:
 
       // editing
       decdt = -1.0;
+      stream = false;
       fixMS = doElev = false;
       elevLimit = 0.0;
+      nNavCache = 0;
 
       // output
       DChelp = DChelpall = typehelp = validate = false;
+      nthreads = 1;
       timefmt = string("%4F %10.3g");
       //timefmt = string("%.6Q");         // 1.5/86400 = 1.7e-5
 
       // end command line input ---------------------------------------
 
       longfmt = string("%04F %10.3g %04Y/%02m/%02d %02H:%02M:%06.3f %P");
+
+      nthreadsUsed = 1;
+      nPassesDC = 0;
+      DCseconds = 0.0;
    }
 
 }; // end class GlobalData
@@ -285,17 +321,24 @@ try {
       iret = Initialize();
       if(iret) break;
 
-      // read files into SatPassList
-      iret = ReadRinexFiles();
-      if(iret) break;
+      if(GD.stream) {
+         // read the files by epoch, correcting each pass as it ends
+         iret = StreamRinexFiles();
+         if(iret) break;
+      }
+      else {
+         // read files into SatPassList
+         iret = ReadRinexFiles();
+         if(iret) break;
 
-      // preprocess the data - millisec fix,
-      iret = PreProcess();
-      if(iret) break;
+         // preprocess the data - millisec fix,
+         iret = PreProcess();
+         if(iret) break;
 
-      // do it
-      iret = Process();
-      if(iret) break;
+         // do it
+         iret = Process();
+         if(iret) break;
+      }
 
    }  // end loop once
 
@@ -339,6 +382,14 @@ try {
       oss << PrgmName << " timing: " << fixed << setprecision(3)
          << double(totaltime)/double(CLOCKS_PER_SEC)
          << " seconds. (" << (wallend - wallbegin) << " sec)";
+      if(GD.nPassesDC > 0) {
+         oss << " " << GD.nPassesDC << " passes in " << GD.DCseconds << " sec";
+         if(GD.DCseconds > 0.0)
+            oss << " = " << setprecision(1) << GD.nPassesDC/GD.DCseconds
+                << " passes/s";
+         oss << " on " << GD.nthreadsUsed << " thread"
+             << (GD.nthreadsUsed > 1 ? "s" : "") << ".";
+      }
       LOG(INFO) << oss.str();
       if(pLOGstrm != &cout) cout << oss.str() << endl;
    }
@@ -413,6 +464,8 @@ try {
    // Data input and config
    opts.Add(0, "dt", "name", false, req, &GD.decdt, "\n# Data input and config:",
             "Decimate timestep of the data to this in seconds");
+   opts.Add(0, "stream", "", false, req, &GD.stream, "",
+            "Read data by epoch, correcting each pass when it ends (no --obsout)");
    opts.Add(0, "DC", "cmd=val", true, req, &GD.DCcmds,"",
             "Set algorithm configuration parameter (see --DChelp)");
    opts.Add(0, "exSat", "sat", true, req, &GD.exSat, "\n# Editing:",
@@ -437,6 +490,8 @@ try {
             "Input Ephemeris+clock (SP3 format) file name");
    opts.Add(0, "nav", "fn", true, req, &GD.RNavfiles, "",
             "Input RINEX nav file name(s)");
+   opts.Add(0, "navcache", "fn", true, req, &GD.NavCaches, "",
+            "Input nav cache file name(s), built by navcache (cf. --nav)");
    opts.Add(0, "ephpath", "path", false, req, &GD.ephpath, "",
             "Path for input SP3 or RINEX ephemeris file(s)");
 
@@ -451,6 +506,8 @@ try {
             "Tell DC to output 'label' data (or 'all') to log - cf. DChelpall");
    opts.Add(0, "timefmt", "fmt", false, req, &GD.timefmt, "",
             "Output timetags with this format [cf. class Epoch]");
+   opts.Add(0, "threads", "n", false, req, &GD.nthreads, "",
+            "Correct passes concurrently on n threads (not with --dump, debug)");
    // Help
    opts.Add(0, "DChelp", "", false, req, &GD.DChelp, "\n# Help",
             "Print list of DC parameters and their defaults, then quit");
@@ -490,6 +547,23 @@ try {
       oss << " End of unrecognized arguments\n";
    }
 
+   // threads
+   if(GD.nthreads < 1)
+      oss << "Error - invalid --threads " << GD.nthreads
+          << " : must be at least 1" << endl;
+   else if(GD.nthreads > 1 && (GD.debug > -1 || GD.outlabels.size() > 0))
+      ossx << "   Warning - --threads is ignored with --dump and debug;"
+           << " passes are corrected serially." << endl;
+
+   // streaming
+   if(GD.stream) {
+      if(!GD.obsout.empty())
+         oss << "Error - --obsout needs all the passes at once, and cannot be used"
+             << " with --stream; use --cmdout and RinEdit instead" << endl;
+      if(GD.fixMS)
+         ossx << "   Warning - --fixMS is ignored with --stream" << endl;
+   }
+
    // configure the DC
    if(GD.debug > -1) GD.GDC.setParameter("debug",GD.debug);
    if(GD.verbose) GD.GDC.setParameter("verbose",1);
@@ -828,6 +902,10 @@ try {
          include_path(GD.ephpath,GD.RNavfiles[i]);
          expand_filename(GD.RNavfiles[i]);
       }
+      for(i=0; i<GD.NavCaches.size(); i++) {
+         include_path(GD.ephpath,GD.NavCaches[i]);
+         expand_filename(GD.NavCaches[i]);
+      }
    }
 
    if(GD.validate) {
@@ -859,15 +937,29 @@ try {
             return -5;
       }
    }
-   else if(GD.RNavfiles.size() > 0) {
+   else if(GD.RNavfiles.size() > 0 || GD.NavCaches.size() > 0) {
       for (size_t i = 0; i < GD.RNavfiles.size(); i++)
       {
          if (!GD.ndfp->addDataSource(GD.RNavfiles[i]))
             return -5;
       }
+      for (size_t i = 0; i < GD.NavCaches.size(); i++)
+      {
+         try {
+            GD.nNavCache += NavCache::loadFile(GD.NavCaches[i], GD.navLib,
+                         {NavMessageType::Ephemeris, NavMessageType::Clock});
+         }
+         catch(Exception& e) {
+            LOG(ERROR) << " Error - " << e.getText();
+            return -5;
+         }
+      }
+      string warn(NavCache::headerWarning(GD.NavCaches, GD.RNavfiles.size()));
+      if(!warn.empty()) LOG(WARNING) << " " << warn;
    }
 
-   if(GD.SP3files.size() > 0 && GD.RNavfiles.size() > 0)
+   if(GD.SP3files.size() > 0 && (GD.RNavfiles.size() > 0
+                                 || GD.NavCaches.size() > 0))
       LOG(WARNING) << " Warning - SP3 ephemeris used; RINEX nav ignored.";
 
       // guaranteed success if we haven't somehow managed to already
@@ -875,7 +967,7 @@ try {
    MultiFormatNavDataFactory *ndfp = dynamic_cast<MultiFormatNavDataFactory*>(
       GD.ndfp.get());
 
-   if(ndfp->size() > 0) {
+   if(ndfp->size() > 0 || GD.nNavCache > 0) {
          /// @todo Determine if this block of code needs to be handled in newnav
 #if 0
       // set gap and interval checking, based on nominal timestep
@@ -906,7 +998,7 @@ try {
    }
 
    // is it there?
-   if (ndfp->size() != 0) {
+   if (ndfp->size() != 0 || GD.nNavCache != 0) {
       if(GD.Rx.getCoordinateSystem() != Position::Unknown && GD.elevLimit > 0.0)
          GD.doElev = true;
       else if(GD.Rx.getCoordinateSystem() != Position::Unknown) {
@@ -960,13 +1052,109 @@ int findIndex(const vector<string>& allR3ObsID, const char sys,
    return ind;
 }
 
+//------------------------------------------------------------------------------------
+/// Utility for use by StreamRinexFiles()
+/// true if the 4-char R3 obs ID oid matches one of GD.wantedObsIDs ('*' = any)
+bool isWantedObsID(const string& oid)
+{
+   GlobalData& GD=GlobalData::Instance();
+   for(size_t i=0; i<GD.wantedObsIDs.size(); i++) {
+      const string& w(GD.wantedObsIDs[i]);
+      if(w.size() != 4 || oid.size() != 4) continue;
+      bool ok(true);
+      for(size_t k=0; ok && k<4; k++)
+         if(w[k] != '*' && w[k] != oid[k]) ok = false;
+      if(ok) return true;
+   }
+   return false;
+}
+
+//------------------------------------------------------------------------------------
+// Utility for use by ReadRinexFiles() and StreamRinexFiles()
+// Choose the R3ObsIDs for each system and SatPass obstype, and fill GD.SPsysobs and
+// GD.R3sysobs; indexes[sys][i] = index in loadR3ObsIDs for GD.obstypes[i]
+int AssignObsTypes(const vector<string>& loadR3ObsIDs, const vector<int>& totcounts,
+                   map<char, vector<int> >& indexes)
+{
+try {
+   int n;
+   unsigned int i,j;
+   GlobalData& GD=GlobalData::Instance();
+
+   // loop over all systems, all obstypes: find corresponding R3 ObsID in loader's
+   // output, and construct a new obstype for SatPass.
+   for(i=0; i<GD.Syss.size(); i++) {
+      char sys(GD.Syss[i][0]);         // Syss[i] is 1-char string
+
+      string codes(GD.Codes[i]);       // users prioritized list
+      vector<int> v;
+      indexes[sys] = v;          // initialize indexes[sys] with empty vector
+      vector<string> SPot;       // SatPass obstype P: P-code PR, C: C/A PR, L: phase
+      vector<string> R3ot;       // R3 obstype from loader for SPot
+      for(j=0; j<GD.obstypes.size(); j++) {
+         // find the R3ObsID in loader
+         n = findIndex(loadR3ObsIDs,sys,GD.obstypes[j],codes,totcounts);
+         if(n == -1) {
+            LOG(ERROR) << " Error - loader found no R3ObsID for system " << sys
+                           << " obstype " << GD.obstypes[j] << ". Abort.";
+            return -2;
+         }
+         indexes[sys].push_back(n);
+
+         // add to map SPsysobs, use the tracking code to decide on pseudorange P|C
+         // for purposes of determining when to apply differential code biases.
+         string ot(GD.obstypes[j]);
+         if(ot[0] == 'P') {                  // obstypes above and findIndex() use 'P'
+            char tc(loadR3ObsIDs[n][3]);     // tracking code
+            if(sys=='G') {                   // GPS
+               switch(tc) {
+                  case 'P': case 'Y': case 'W':
+                  case 'I': case 'M': case 'Q': case 'D':      // all P-code, right?
+                     ot[0] = 'P'; break;
+                  case 'C': case 'L': case 'X': case 'S':      // all C/A
+                     ot[0] = 'C'; break;
+                  default: break;
+               }
+            }
+            if(sys=='R') {                   // GLO
+               ot[0] = tc;                   // P or C are only choices
+            }
+         }
+         SPot.push_back(n >= 0 ? ot : GD.obstypes[j]);
+         R3ot.push_back(n >= 0 ? loadR3ObsIDs[n] : "-NA-");
+      }
+
+      GD.SPsysobs[sys] = SPot;
+      GD.R3sysobs[sys] = R3ot;
+   }
+
+   // print obs types assignment SP <=> R3
+   LOG(INFO) << " Assign RINEX3-ObsIDs to SatPass obstypes for each system :";
+   ostringstream oss;
+
+   map<char, vector<string> >::const_iterator rit = GD.R3sysobs.begin();
+   while(rit != GD.R3sysobs.end()) {
+      oss.str("");
+      oss << " System " << rit->first << " ("
+        << RinexObsID::map1to3sys[string(1,rit->first)] << "): SatPass obstypes = [";
+      for(i=0; i<rit->second.size(); i++)
+         oss << (i==0 ? "":",") << rit->second[i];
+      LOG(INFO) << oss.str() << "]";
+      rit++;
+   }
+
+   return 0;
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
+
 //------------------------------------------------------------------------------------
 // Reads RINEX 2|3 Obs file(s) into SatPass list SPList
 int ReadRinexFiles(void)
 {
 try {
    int n,iret;
-   unsigned int i,j;
+   unsigned int i;
    string str,msg;
    GlobalData& GD=GlobalData::Instance();
 
@@ -1031,68 +1219,8 @@ try {
    const vector<int> totcounts(rofl.getTotalObsCounts());
    // indexes[sys][i] = index in loadR3ObsIDs for GD.obstypes[i] in system sys
    map<char, vector<int> > indexes;
-
-   // loop over all systems, all obstypes: find corresponding R3 ObsID in loader's
-   // output, and construct a new obstype for SatPass.
-   for(i=0; i<GD.Syss.size(); i++) {
-      char sys(GD.Syss[i][0]);         // Syss[i] is 1-char string
-
-      string codes(GD.Codes[i]);       // users prioritized list
-      vector<int> v;
-      indexes[sys] = v;          // initialize indexes[sys] with empty vector
-      vector<string> SPot;       // SatPass obstype P: P-code PR, C: C/A PR, L: phase
-      vector<string> R3ot;       // R3 obstype from loader for SPot
-      for(j=0; j<GD.obstypes.size(); j++) {
-         // find the R3ObsID in loader
-         n = findIndex(loadR3ObsIDs,sys,GD.obstypes[j],codes,totcounts);
-         if(n == -1) {
-            LOG(ERROR) << " Error - loader found no R3ObsID for system " << sys
-                           << " obstype " << GD.obstypes[j] << ". Abort.";
-            return -2;
-         }
-         indexes[sys].push_back(n);
-
-         // add to map SPsysobs, use the tracking code to decide on pseudorange P|C
-         // for purposes of determining when to apply differential code biases.
-         string ot(GD.obstypes[j]);
-         if(ot[0] == 'P') {                  // obstypes above and findIndex() use 'P'
-            char tc(loadR3ObsIDs[n][3]);     // tracking code
-            if(sys=='G') {                   // GPS
-               switch(tc) {
-                  case 'P': case 'Y': case 'W':
-                  case 'I': case 'M': case 'Q': case 'D':      // all P-code, right?
-                     ot[0] = 'P'; break;
-                  case 'C': case 'L': case 'X': case 'S':      // all C/A
-                     ot[0] = 'C'; break;
-                  default: break;
-               }
-            }
-            if(sys=='R') {                   // GLO
-               ot[0] = tc;                   // P or C are only choices
-            }
-         }
-         SPot.push_back(n >= 0 ? ot : GD.obstypes[j]);
-         R3ot.push_back(n >= 0 ? loadR3ObsIDs[n] : "-NA-");
-      }
-
-      GD.SPsysobs[sys] = SPot;
-      GD.R3sysobs[sys] = R3ot;
-   }
-
-   // print obs types assignment SP <=> R3
-   LOG(INFO) << " Assign RINEX3-ObsIDs to SatPass obstypes for each system :";
-   ostringstream oss;
-
-   map<char, vector<string> >::const_iterator rit = GD.R3sysobs.begin();
-   while(rit != GD.R3sysobs.end()) {
-      oss.str("");
-      oss << " System " << rit->first << " ("
-        << RinexObsID::map1to3sys[string(1,rit->first)] << "): SatPass obstypes = [";
-      for(i=0; i<rit->second.size(); i++)
-         oss << (i==0 ? "":",") << rit->second[i];
-      LOG(INFO) << oss.str() << "]";
-      rit++;
-   }
+   iret = AssignObsTypes(loadR3ObsIDs, totcounts, indexes);
+   if(iret) return iret;
 
    // define dt
    GD.nomdt = rofl.getDT();
@@ -1120,7 +1248,7 @@ catch(Exception& e) { GNSSTK_RETHROW(e); }
 int PreProcess(void)
 {
 try {
-   unsigned int i,j;
+   unsigned int i;
    string msg;
    GlobalData& GD=GlobalData::Instance();
 
@@ -1135,139 +1263,289 @@ try {
 
    // mark low elevation data bad
    if(GD.doElev) {
-      CorrectedEphemerisRange CER;
-      for(i=0; i<GD.SPList.size(); i++) {
-         if(GD.SPList[i].status() == -1) continue;
+      for(i=0; i<GD.SPList.size(); i++)
+         MarkLowElevation(GD.SPList[i]);
+   }
 
-         RinexSatID sat = GD.SPList[i].getSat();
-         for(j=0; j<GD.SPList[i].size(); j++) {
-            Epoch ttag = GD.SPList[i].time(j);
-            try {
-               //double ER =
-               CER.ComputeAtReceiveTime(ttag, GD.Rx, sat, GD.navLib);
-               if(CER.elevation >= GD.elevLimit) continue;
-            }
-            catch(InvalidRequest&) {
-               // do not exclude the sat here; PRSolution will...
-               LOG(DEBUG) << "CER did not find ephemeris for "
-                  << sat << " at time " << ttag.printf(GD.timefmt);
-               // fall through
-            }
+   return 0;
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
 
-            // mark it bad
-            GD.SPList[i].setFlag(j,SatPass::BAD);
+//------------------------------------------------------------------------------------
+void MarkLowElevation(SatPass& SP)
+{
+try {
+   GlobalData& GD=GlobalData::Instance();
+   if(SP.status() == -1) return;
 
-         }  // end loop over data in SPList[i]
-      }  // end loop over SatPasses
-   }  // end if elev mask
+   CorrectedEphemerisRange CER;
+   RinexSatID sat = SP.getSat();
+   for(unsigned int j=0; j<SP.size(); j++) {
+      Epoch ttag = SP.time(j);
+      try {
+         //double ER =
+         CER.ComputeAtReceiveTime(ttag, GD.Rx, sat, GD.navLib);
+         if(CER.elevation >= GD.elevLimit) continue;
+      }
+      catch(InvalidRequest&) {
+         // do not exclude the sat here; PRSolution will...
+         LOG(DEBUG) << "CER did not find ephemeris for "
+            << sat << " at time " << ttag.printf(GD.timefmt);
+         // fall through
+      }
 
-   return 0;
+      // mark it bad
+      SP.setFlag(j,SatPass::BAD);
+
+   }  // end loop over data in SP
 }
 catch(Exception& e) { GNSSTK_RETHROW(e); }
 }
 
 //------------------------------------------------------------------------------------
-int Process(void)
+/// One SatPass to be corrected by the GDC, with everything that is logged about
+/// it; filled in pass order by PreparePass(), corrected (possibly concurrently)
+/// by CorrectPasses(), then logged in pass order by LogPasses().
+struct PassJob {
+   int index;                    ///< pass number - 1
+   SatPass *SP;                  ///< the pass, in GD.SPList or the stream
+   RinexSatID sat;               ///< satellite of the pass
+   bool run;                     ///< if false the pass was excluded
+   int GLOn;                     ///< GLONASS frequency channel
+   /// log lines (level,line) written before the GDC output
+   vector< pair<LogLevel,string> > notes;
+   int iret;                     ///< return value of DiscontinuityCorrector
+   int unique;                   ///< unique number of the call (== index+1)
+   string retmsg;                ///< message returned by the GDC
+   vector<string> cmds;          ///< editing commands returned by the GDC
+};
+
+//------------------------------------------------------------------------------------
+/// Apply the exclusions to pass number i+1 and find its GLONASS channel;
+/// GLOn is the channel found for the previous pass (cf. getGLOchannel).
+PassJob PreparePass(SatPass& SP, int i, int& GLOn)
 {
 try {
-   int iret=-666,i=-666,GLOn=-666;
    string msg;
    ostringstream oss;
    map<RinexSatID,int>::const_iterator gloit;
    GlobalData& GD=GlobalData::Instance();
 
-   // dump the configuration
-   LOG(INFO) << "\n# GDC configuration:";
-   GD.GDC.DisplayParameterUsage(LOGstrm, "#", true);
-   LOG(INFO) << "# End of GDC configuration.\n";
+   // configure SatPass SP
+   SP.setOutputFormat(GD.timefmt);       // nround?
+
+   RinexSatID sat(SP.getSat());
+   PassJob job;
+   job.index = i;
+   job.SP = &SP;
+   job.sat = sat;
+   job.run = false;
+   job.GLOn = GLOn;
+   job.iret = -666;
+   job.unique = i+1;
+
+   oss << "DFX " << setw(3) << i+1 << " " << sat;
+   msg = oss.str();
+
+   // exclude sats
+   if(vectorindex(GD.exSat,sat) != -1) {
+      job.notes.push_back(make_pair(VERBOSE, msg + " sat excluded."));
+      return job;
+   }
+   if(GD.onlySat.size() > 0 && vectorindex(GD.onlySat,sat) == -1) {
+      job.notes.push_back(make_pair(VERBOSE, msg + " not only sat."));
+      return job;
+   }
 
-   // call the GDC
-   string retmsg;
-   for(i=0; i<GD.SPList.size(); i++) {
-      // configure SatPass SPList[i]
-      GD.SPList[i].setOutputFormat(GD.timefmt);       // nround?
+   // exclude passes
+   if(GD.onlyPass.size() > 0 && vectorindex(GD.onlyPass,i+1) == -1) {
+      job.notes.push_back(make_pair(VERBOSE, msg + " pass excluded."));
+      return job;
+   }
 
-      RinexSatID sat(GD.SPList[i].getSat());
+   // no good data
+   if(SP.getNgood() == 0) {
+      job.notes.push_back(make_pair(VERBOSE, msg + " no good data."));
+      return job;
+   }
 
-      // exclude sats
-      if(vectorindex(GD.exSat,sat) != -1) {
-         LOG(VERBOSE) << "DFX " << setw(3) << i+1 << " " << sat << " sat excluded.";
-         continue;
+   // get the GLOn
+   if(sat.system == SatelliteSystem::Glonass) {
+      gloit = GD.GLOfreqCh.find(sat);
+
+      // if GLONASS frequency channel not given, try to find it
+      if(gloit != GD.GLOfreqCh.end()) {
+         GLOn = gloit->second;
       }
-      if(GD.onlySat.size() > 0 && vectorindex(GD.onlySat,sat) == -1) {
-         LOG(VERBOSE) << "DFX " << setw(3) << i+1 << " " << sat << " not only sat.";
-         continue;
+      else {
+         if(!SP.getGLOchannel(GLOn, msg)) {
+            job.notes.push_back(make_pair(WARNING,
+               " Warning - unable to compute GLO channel for sat "
+               + sat.toString() + " - skip pass : " + msg));
+         }
+         else {
+            oss.str("");
+            oss << "# GLO frequency channel for " << sat
+                << " was computed from data, = " << GLOn << "; " << msg;
+            job.notes.push_back(make_pair(VERBOSE, oss.str()));
+            GD.GLOfreqCh[sat] = GLOn;
+         }
       }
+   }
 
-      // exclude passes
-      if(GD.onlyPass.size() > 0 && vectorindex(GD.onlyPass,i+1) == -1) {
-         LOG(VERBOSE) << "DFX " << setw(3) << i+1 << " " << sat << " pass excluded.";
-         continue;
-      }
+   job.GLOn = GLOn;
+   job.run = true;
+   return job;
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
 
-      // no good data
-      if(GD.SPList[i].getNgood() == 0) {
-         LOG(VERBOSE) << "DFX " << setw(3) << i+1 << " " << sat << " no good data.";
-         continue;
-      }
+//------------------------------------------------------------------------------------
+/// Call the GDC on one pass; GDC may be the global one or a copy per thread,
+/// and only touches the pass and the job.
+void CorrectPass(gdc& GDC, PassJob& job)
+{
+try {
+   // make the unique number == pass number == i+1, always
+   GDC.ForceUniqueNumber(job.index);   // NB it will be incremented in DC call
+   job.iret = GDC.DiscontinuityCorrector(*job.SP, job.retmsg, job.cmds, job.GLOn);
+   job.unique = GDC.getUniqueNumber();             // == i+1 here
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
 
-      // get the GLOn
-      if(sat.system == SatelliteSystem::Glonass) {
-         gloit = GD.GLOfreqCh.find(sat);
+//------------------------------------------------------------------------------------
+void CorrectPasses(vector<PassJob>& jobs)
+{
+try {
+   size_t i;
+   GlobalData& GD=GlobalData::Instance();
 
-         // if GLONASS frequency channel not given, try to find it
-         if(gloit != GD.GLOfreqCh.end()) {
-            GLOn = gloit->second;
-         }
-         else {
-            if(!GD.SPList[i].getGLOchannel(GLOn, msg)) {
-               LOG(WARNING) << " Warning - unable to compute GLO channel for sat "
-                  << sat << " - skip pass : " + msg;
-            }
-            else {
-               LOG(VERBOSE) << "# GLO frequency channel for " << sat
-                           << " was computed from data, = " << GLOn << "; " << msg;
-               GD.GLOfreqCh[sat] = GLOn;
+   // the --dump and debug output is written by the GDC itself, so in that case
+   // keep it serial
+   int nthreads(GD.nthreads);
+   if(GD.debug > -1 || GD.outlabels.size() > 0) nthreads = 1;
+   GD.nthreadsUsed = nthreads;
+
+   chrono::steady_clock::time_point timer(chrono::steady_clock::now());
+   if(nthreads <= 1) {
+      for(i=0; i<jobs.size(); i++)
+         if(jobs[i].run) CorrectPass(GD.GDC, jobs[i]);
+   }
+   else {
+      // each thread has its own copy of the GDC, and takes the next pass
+      atomic<size_t> next(0);
+      vector<exception_ptr> errors(nthreads);
+      vector<thread> workers;
+      for(int t=0; t<nthreads; t++) {
+         workers.push_back(thread([&jobs, &next, &errors, &GD, t]() {
+            try {
+               gdc GDC(GD.GDC);
+               size_t k;
+               while((k = next++) < jobs.size())
+                  if(jobs[k].run) CorrectPass(GDC, jobs[k]);
             }
-         }
+            catch(...) { errors[t] = current_exception(); }
+         }));
       }
+      for(i=0; i<workers.size(); i++) workers[i].join();
+      for(i=0; i<errors.size(); i++)
+         if(errors[i]) rethrow_exception(errors[i]);
+   }
+   GD.DCseconds +=
+      chrono::duration<double>(chrono::steady_clock::now()-timer).count();
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
+
+//------------------------------------------------------------------------------------
+void LogPasses(vector<PassJob>& jobs)
+{
+try {
+   string msg;
+   ostringstream oss;
+   GlobalData& GD=GlobalData::Instance();
 
-      // make the unique number == pass number == i+1, always
-      GD.GDC.ForceUniqueNumber(i);     // NB it will be incremented in DC call
+   for(size_t i=0; i<jobs.size(); i++) {
+      PassJob& job(jobs[i]);
+      for(size_t n=0; n<job.notes.size(); n++)
+         LOG(job.notes[n].first) << job.notes[n].second;
+      if(!job.run) continue;
+      GD.nPassesDC++;
 
-      // call GDC
-      iret = GD.GDC.DiscontinuityCorrector(GD.SPList[i], retmsg, GD.EditCmds, GLOn);
       // TD is iret<0 handled by retmsg?
-      int unique(GD.GDC.getUniqueNumber());        // == i+1 here
+      const RinexSatID& sat(job.sat);
 
       // save the GLO freq channel
       if(sat.system == SatelliteSystem::Glonass &&
          GD.GLOfreqCh.find(sat) == GD.GLOfreqCh.end())
-            GD.GLOfreqCh[sat] = GLOn;
+            GD.GLOfreqCh[sat] = job.GLOn;
+
+      // editing commands
+      GD.EditCmds[job.index+1] = job.cmds;
 
       // add tag to lines in the retmsg
-      oss.str(""); oss << "DFX " << setw(3) << unique << " " << sat;
+      oss.str(""); oss << "DFX " << setw(3) << job.unique << " " << sat;
       msg = oss.str();
       // add tag == msg to all the lines in retmsg
-      StringUtils::change(retmsg,"\n","\n"+msg+" ");
-      retmsg = msg + " " + retmsg;
-      LOG(INFO) << retmsg;
+      StringUtils::change(job.retmsg,"\n","\n"+msg+" ");
+      job.retmsg = msg + " " + job.retmsg;
+      LOG(INFO) << job.retmsg;
    }
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
 
-   // write editing commands
-   if(!GD.cmdout.empty()) {
-      ofstream ofs;
-      ofs.open(GD.cmdout.c_str(),ios_base::out);
-      if(!GD.oflog.is_open()) {
-         LOG(ERROR) << " Error - failed to open file " << GD.cmdout;
-         GD.cmdout = string();
-      }
-      else {
-         for(i=0; i<GD.EditCmds.size(); i++)
-            ofs << GD.EditCmds[i] << endl;
-         ofs.close();
-      }
+//------------------------------------------------------------------------------------
+void WriteEditCmds(void)
+{
+try {
+   GlobalData& GD=GlobalData::Instance();
+   if(GD.cmdout.empty()) return;
+
+   ofstream ofs;
+   ofs.open(GD.cmdout.c_str(),ios_base::out);
+   if(!ofs.is_open()) {
+      LOG(ERROR) << " Error - failed to open file " << GD.cmdout;
+      GD.cmdout = string();
+   }
+   else {
+      map<int, vector<string> >::const_iterator it;
+      for(it = GD.EditCmds.begin(); it != GD.EditCmds.end(); ++it)
+         for(size_t i=0; i<it->second.size(); i++)
+            ofs << it->second[i] << endl;
+      ofs.close();
    }
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
+
+//------------------------------------------------------------------------------------
+int Process(void)
+{
+try {
+   int i=-666,GLOn=-666;
+   map<RinexSatID,int>::const_iterator gloit;
+   GlobalData& GD=GlobalData::Instance();
+
+   // dump the configuration
+   LOG(INFO) << "\n# GDC configuration:";
+   GD.GDC.DisplayParameterUsage(LOGstrm, "#", true);
+   LOG(INFO) << "# End of GDC configuration.\n";
+
+   // choose the passes to correct, and their GLO channel, in pass order;
+   // the log lines are saved with the pass so they come out in order below
+   vector<PassJob> jobs;
+   for(i=0; i<GD.SPList.size(); i++)
+      jobs.push_back(PreparePass(GD.SPList[i], i, GLOn));
+
+   // call the GDC on each pass, then merge the results in pass order
+   CorrectPasses(jobs);
+   LogPasses(jobs);
+
+   // write editing commands
+   WriteEditCmds();
 
    // write to RINEX
    if(!GD.obsout.empty()) {
@@ -1292,5 +1570,283 @@ try {
 catch(Exception& e) { GNSSTK_RETHROW(e); }
 }
 
+//------------------------------------------------------------------------------------
+/// State of the --stream reader: the passes still open, by satellite, and the
+/// passes that have ended but are not yet corrected; each with its pass number.
+/// Passes are numbered as they start, in time order and by satellite within an
+/// epoch, as the loader numbers them, so --onlyPass selects the same passes.
+struct PassStream {
+   map<RinexSatID, pair<int,SatPass> > open;    ///< open passes
+   vector< pair<int,SatPass> > ended;           ///< ended, awaiting the GDC
+   int npass;                    ///< number of passes started
+   size_t maxOpen;               ///< most passes open at one time
+   long nepochs;                 ///< number of epochs read
+   int GLOn;                     ///< GLO channel carried between passes
+};
+
+//------------------------------------------------------------------------------------
+/// Correct, log and release the ended passes; unless final, wait until there are
+/// enough of them to keep the threads busy.
+void CorrectEndedPasses(PassStream& PS, bool final)
+{
+try {
+   GlobalData& GD=GlobalData::Instance();
+   if(PS.ended.empty()) return;
+   if(!final && PS.ended.size() < size_t(GD.nthreads)) return;
+
+   vector<PassJob> jobs;
+   for(size_t i=0; i<PS.ended.size(); i++) {
+      SatPass& SP(PS.ended[i].second);
+      if(GD.doElev) MarkLowElevation(SP);
+      jobs.push_back(PreparePass(SP, PS.ended[i].first-1, PS.GLOn));
+   }
+
+   CorrectPasses(jobs);
+   LogPasses(jobs);
+
+   PS.ended.clear();
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
+
+//------------------------------------------------------------------------------------
+/// Close the open pass at it, and queue it for the GDC
+void EndPass(PassStream& PS, map<RinexSatID, pair<int,SatPass> >::iterator it)
+{
+   LOG(INFO) << "SPL " << setw(3) << it->second.first << " " << it->second.second;
+   PS.ended.push_back(it->second);
+   PS.open.erase(it);
+}
+
+//------------------------------------------------------------------------------------
+/// Add one epoch of RINEX data to the open passes; indexes[sys][i] is the index in
+/// the header's obs types for GD.obstypes[i].
+void StreamEpoch(PassStream& PS, const Rinex3ObsData& rod,
+                 const map<char, vector<int> >& indexes)
+{
+try {
+   size_t j;
+   GlobalData& GD=GlobalData::Instance();
+   Epoch ttag(rod.time);
+   map<RinexSatID, pair<int,SatPass> >::iterator it;
+
+   // end the passes that have not had data for longer than the maximum gap
+   for(it = PS.open.begin(); it != PS.open.end(); ) {
+      SatPass& SP(it->second.second);
+      if(ttag - SP.getLastTime() > SP.getMaxGap())
+         EndPass(PS, it++);
+      else
+         ++it;
+   }
+
+   Rinex3ObsData::DataMap::const_iterator dit;
+   for(dit = rod.obs.begin(); dit != rod.obs.end(); ++dit) {
+      const RinexSatID sat(dit->first);
+      const char sys(sat.systemChar());
+      map<char, vector<int> >::const_iterator iit(indexes.find(sys));
+      if(iit == indexes.end()) continue;
+
+      // pull out the SatPass obs types
+      bool any(false), all(true);
+      vector<double> data;
+      vector<unsigned short> lli, ssi;
+      for(j=0; j<iit->second.size(); j++) {
+         int n(iit->second[j]);
+         if(n >= 0 && n < int(dit->second.size())) {
+            data.push_back(dit->second[n].data);
+            lli.push_back(dit->second[n].lli);
+            ssi.push_back(dit->second[n].ssi);
+         }
+         else {
+            data.push_back(0.0); lli.push_back(0); ssi.push_back(0);
+         }
+         if(data.back() == 0.0) all = false; else any = true;
+      }
+      if(!any) continue;
+
+      const vector<string>& ots(GD.SPsysobs[sys]);
+      unsigned short flag(all ? SatPass::OK : SatPass::BAD);
+      it = PS.open.find(sat);
+      for(int tries=0; tries<2; tries++) {
+         if(it == PS.open.end()) {
+            SatPass SP(sat, GD.nomdt, ots);
+            it = PS.open.insert(make_pair(sat, make_pair(++PS.npass,SP))).first;
+         }
+         int n(it->second.second.addData(ttag, ots, data, lli, ssi, flag));
+         if(n == -1) {                 // gap too large - end it and start another
+            EndPass(PS, it);
+            it = PS.open.end();
+            continue;
+         }
+         if(n == -2)
+            LOG(WARNING) << " Warning - time tag out of order for " << sat
+               << " at " << ttag.printf(GD.longfmt) << " - ignore data";
+         break;
+      }
+   }
+
+   if(PS.open.size() > PS.maxOpen) PS.maxOpen = PS.open.size();
+
+   CorrectEndedPasses(PS, false);
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
+
+//------------------------------------------------------------------------------------
+/// Smallest positive time step between a few epochs of data, or 1 if there is none
+double StepOfEpochs(const vector<Rinex3ObsData>& epochs)
+{
+   double dt(-1.0);
+   for(size_t i=1; i<epochs.size(); i++) {
+      double step(epochs[i].time - epochs[i-1].time);
+      if(step > 0.0 && (dt < 0.0 || step < dt)) dt = step;
+   }
+   return (dt > 0.0 ? dt : 1.0);
+}
+
+//------------------------------------------------------------------------------------
+int StreamRinexFiles(void)
+{
+try {
+   int iret;
+   size_t i,j,k;
+   GlobalData& GD=GlobalData::Instance();
+
+   LOG(INFO) << "\nStream the RINEX files, correcting each pass as it ends -------";
+
+   // dump the configuration
+   LOG(INFO) << "\n# GDC configuration:";
+   GD.GDC.DisplayParameterUsage(LOGstrm, "#", true);
+   LOG(INFO) << "# End of GDC configuration.\n";
+
+   PassStream PS;
+   PS.npass = 0;
+   PS.maxOpen = 0;
+   PS.nepochs = 0;
+   PS.GLOn = -666;
+
+   if(GD.decdt > 0.0) GD.nomdt = GD.decdt;
+   else GD.nomdt = -1.0;
+
+   for(i=0; i<GD.obsfiles.size(); i++) {
+      Rinex3ObsStream istrm;
+      Rinex3ObsHeader rhead;
+      Rinex3ObsData rod;
+
+      istrm.open(GD.obsfiles[i].c_str(),ios::in);
+      if(!istrm.is_open()) {
+         LOG(ERROR) << " Error - failed to open file " << GD.obsfiles[i];
+         return -1;
+      }
+      istrm.exceptions(ios::failbit);
+      try { istrm >> rhead; }
+      catch(Exception& e) {
+         LOG(ERROR) << " Error - failed to read header of file " << GD.obsfiles[i]
+            << " : " << e.getText(0);
+         return -1;
+      }
+
+      LOG(INFO) << "\nHeader for file " << GD.obsfiles[i];
+      rhead.dump(LOGstrm);
+      if(i == 0) GD.header = rhead;
+
+      // choose the obs IDs from this header; hdrIndex[k] is the position of
+      // R3ObsIDs[k] in the header's list for its system
+      vector<string> R3ObsIDs;
+      vector<int> hdrIndex;
+      map<string, vector<RinexObsID> >::const_iterator kt;
+      for(kt = rhead.mapObsTypes.begin(); kt != rhead.mapObsTypes.end(); ++kt) {
+         for(j=0; j<kt->second.size(); j++) {
+            string oid(kt->first + kt->second[j].asString());
+            if(!isWantedObsID(oid)) continue;
+            R3ObsIDs.push_back(oid);
+            hdrIndex.push_back(j);
+         }
+      }
+      // no counts in a stream - assume all are present
+      const map<char, vector<string> > prevSPsysobs(GD.SPsysobs);
+      map<char, vector<int> > indexes;
+      iret = AssignObsTypes(R3ObsIDs, vector<int>(R3ObsIDs.size(),1), indexes);
+      if(iret) return iret;
+
+      // a pass open across the file boundary keeps the SatPass obs types it was
+      // created with; if this file gives its system other types, end it here
+      map<RinexSatID, pair<int,SatPass> >::iterator pit;
+      for(pit = PS.open.begin(); pit != PS.open.end(); ) {
+         const char sys(pit->first.systemChar());
+         map<char, vector<string> >::const_iterator pt(prevSPsysobs.find(sys));
+         if(pt != prevSPsysobs.end() && pt->second != GD.SPsysobs[sys]) {
+            LOG(VERBOSE) << " SatPass obs types for system " << sys
+               << " change in file " << GD.obsfiles[i]
+               << " - end pass " << pit->second.first;
+            EndPass(PS, pit++);
+         }
+         else
+            ++pit;
+      }
+      map<char, vector<int> >::iterator it;
+      for(it = indexes.begin(); it != indexes.end(); ++it)
+         for(k=0; k<it->second.size(); k++)
+            if(it->second[k] >= 0) it->second[k] = hdrIndex[it->second[k]];
+
+      // nominal timestep: the header, or else the first few epochs
+      if(GD.nomdt <= 0.0 && (rhead.valid & Rinex3ObsHeader::validInterval))
+         GD.nomdt = rhead.interval;
+
+      vector<Rinex3ObsData> pending;
+      while(1) {
+         try { istrm >> rod; }
+         catch(Exception& e) {
+            LOG(WARNING) << " Warning - failed to read obs data in file "
+               << GD.obsfiles[i] << " (" << e.getText(0) << ")";
+            break;
+         }
+         if(!istrm.good() || istrm.eof()) break;     // normal EOF
+
+         if(rod.epochFlag > 1) continue;             // events and header records
+         if(rod.time < GD.startTime) continue;
+         if(rod.time > GD.stopTime) break;
+         if(GD.decdt > 0.0) {
+            double r(fmod(static_cast<GPSWeekSecond>(rod.time).sow, GD.decdt));
+            if(r > 0.001 && GD.decdt-r > 0.001) continue;
+         }
+
+         PS.nepochs++;
+         pending.push_back(rod);
+         if(GD.nomdt <= 0.0) {
+            if(pending.size() < 10) continue;
+            GD.nomdt = StepOfEpochs(pending);
+         }
+         for(k=0; k<pending.size(); k++)
+            StreamEpoch(PS, pending[k], indexes);
+         pending.clear();
+      }
+
+      if(!pending.empty()) {
+         if(GD.nomdt <= 0.0) GD.nomdt = StepOfEpochs(pending);
+         for(k=0; k<pending.size(); k++)
+            StreamEpoch(PS, pending[k], indexes);
+      }
+
+      istrm.close();
+   }
+
+   // end the passes still open, and correct the rest
+   while(!PS.open.empty()) EndPass(PS, PS.open.begin());
+   CorrectEndedPasses(PS, true);
+
+   LOG(VERBOSE) << fixed << setprecision(2)
+      << " The input data interval is " << GD.nomdt << " seconds.";
+   LOG(INFO) << " Streamed " << PS.nepochs << " epochs in " << PS.npass
+      << " passes, with at most " << PS.maxOpen << " passes open at once.";
+
+   // write editing commands
+   WriteEditCmds();
+
+   return 0;
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
+
 //------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------
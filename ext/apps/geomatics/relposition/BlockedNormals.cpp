@@ -0,0 +1,261 @@
+//==============================================================================
+//
+//  This file is part of GNSSTk, the ARL:UT GNSS Toolkit.
+//
+//  The GNSSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GNSSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GNSSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin.
+//  Copyright 2004-2022, The Board of Regents of The University of Texas System
+//
+//==============================================================================
+
+//==============================================================================
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin, under contract to an agency or agencies
+//  within the U.S. Department of Defense. The U.S. Government retains all
+//  rights to use, duplicate, distribute, disclose, or release this software.
+//
+//  Pursuant to DoD Directive 523024
+//
+//  DISTRIBUTION STATEMENT A: This software has been approved for public
+//                            release, distribution is unlimited.
+//
+//==============================================================================
+
+/// @file BlockedNormals.cpp
+/// Implement BlockedNormals - normal equations over the active states, eliminating
+/// biases as their series end; used by the blocked estimator of DDBase.
+
+//------------------------------------------------------------------------------------
+// GNSSTk
+#include <gnsstk/MatrixOperators.hpp>
+
+// DDBase
+#include "BlockedNormals.hpp"
+
+//------------------------------------------------------------------------------------
+using namespace std;
+
+namespace gnsstk {
+//------------------------------------------------------------------------------------
+void BlockedNormals::reset(int ns, int ng)
+{
+   nstate = ns;
+   nglobal = ng;
+   biasVar = 0.0;
+   state.clear();
+   slot.assign(nstate,-1);
+   cap = nglobal+64;
+   A.assign(cap*cap,0.0);
+   b.assign(cap,0.0);
+   elim.clear();
+   for(int i=0; i<nglobal; i++) add(i);
+}
+
+//------------------------------------------------------------------------------------
+size_t BlockedNormals::add(int k)
+{
+   size_t i,j,n(state.size());
+   if(n == cap) {
+      size_t ncap(2*cap);
+      vector<double> AA(ncap*ncap,0.0);
+      for(i=0; i<n; i++) for(j=0; j<n; j++) AA[i*ncap+j] = A[i*cap+j];
+      A.swap(AA);
+      b.resize(ncap,0.0);
+      cap = ncap;
+   }
+   for(i=0; i<=n; i++) A[i*cap+n] = A[n*cap+i] = 0.0;
+   b[n] = 0.0;
+   state.push_back(k);
+   slot[k] = n;
+   return n;
+}
+
+//------------------------------------------------------------------------------------
+void BlockedNormals::remove(size_t s)
+{
+   size_t i,n(state.size()-1);
+   slot[state[s]] = -1;
+   if(s != n) {
+      for(i=0; i<n; i++) if(i != s) A[s*cap+i] = A[i*cap+s] = A[n*cap+i];
+      A[s*cap+s] = A[n*cap+n];
+      b[s] = b[n];
+      state[s] = state[n];
+      slot[state[s]] = s;
+   }
+   state.pop_back();
+}
+
+//------------------------------------------------------------------------------------
+void BlockedNormals::addInformation(const Matrix<double>& info)
+{
+   for(size_t i=0; i<info.rows(); i++)
+      for(size_t j=0; j<info.cols(); j++)
+         at(i,j) += info(i,j);
+}
+
+//------------------------------------------------------------------------------------
+// Add P'*W*P and P'*W*f to the normal equations, where P is extended by the bias
+// partials; a bias is added, with its a priori, when it is first seen.
+void BlockedNormals::update(const Matrix<double>& P, const Vector<double>& f,
+                            const Matrix<double>& W,
+                            const vector<int>& bias, const vector<int>& sign)
+{
+   size_t i,j,m,n,ng(nglobal),nd(f.size());
+
+   Matrix<double> H(W*P);
+   Vector<double> Wf(W*f);
+   Matrix<double> PtWP(transpose(P)*H);
+   Vector<double> PtWf(transpose(P)*Wf);
+
+      // non-bias states
+   for(i=0; i<ng; i++) {
+      for(j=0; j<ng; j++) at(i,j) += PtWP(i,j);
+      b[i] += PtWf(i);
+   }
+   if(bias.empty()) return;
+
+      // bias states
+   vector<size_t> s(nd);
+   for(m=0; m<nd; m++) {
+      if(slot[bias[m]] == -1) {
+         s[m] = add(bias[m]);
+         at(s[m],s[m]) = 1.0/biasVar;
+      }
+      else
+         s[m] = slot[bias[m]];
+   }
+   for(m=0; m<nd; m++) {
+      for(i=0; i<ng; i++) {
+         at(i,s[m]) += sign[m] * H(m,i);
+         at(s[m],i) += sign[m] * H(m,i);
+      }
+      for(n=0; n<nd; n++)
+         at(s[m],s[n]) += sign[m] * sign[n] * W(m,n);
+      b[s[m]] += sign[m] * Wf(m);
+   }
+}
+
+//------------------------------------------------------------------------------------
+bool BlockedNormals::eliminate(int k)
+{
+   if(slot[k] == -1) return true;                  // never observed
+
+   size_t i,j,s(slot[k]),n(state.size());
+   double piv(at(s,s)),gi;
+   if(piv <= 0.0) return false;
+
+   Eliminated eb;
+   eb.state = k;
+   eb.d = 1.0/piv;
+   eb.z = b[s]/piv;
+   for(i=0; i<n; i++) {
+      if(i == s || at(i,s) == 0.0) continue;
+      gi = at(i,s)/piv;
+      eb.rest.push_back(state[i]);
+      eb.g.push_back(gi);
+      for(j=0; j<n; j++) if(j != s) at(i,j) -= gi * at(s,j);
+      b[i] -= gi * b[s];
+   }
+
+   remove(s);
+   elim.push_back(eb);
+   return true;
+}
+
+//------------------------------------------------------------------------------------
+// Variances are propagated back over T, the set of states still needed by an
+// earlier eliminated bias, so only a window of the covariance is ever formed.
+void BlockedNormals::solve(int nsol, Vector<double>& dX, Vector<double>& Var,
+                           Matrix<double>& Cov)
+{
+try {
+   int k;
+   size_t i,j,p,t,n(state.size());
+   double var;
+   Matrix<double> AA(n,n),C;
+
+   for(i=0; i<n; i++) for(j=0; j<n; j++) AA(i,j) = at(i,j);
+   C = inverse(AA);
+
+   dX = Vector<double>(nsol,0.0);
+   Var = Vector<double>(nsol,biasVar);             // biases never observed
+   for(i=0; i<n; i++) {
+      for(j=0; j<n; j++) dX(state[i]) += C(i,j) * b[j];
+      Var(state[i]) = C(i,i);
+   }
+   Cov = Matrix<double>(nglobal,nglobal);
+   for(i=0; i<size_t(nglobal); i++)
+      for(j=0; j<size_t(nglobal); j++)
+         Cov(i,j) = C(i,j);
+
+      // need[k] = first eliminated bias whose row refers to state k, or -1
+   vector<int> need(nstate,-1);
+   for(k=0; k<int(elim.size()); k++)
+      for(i=0; i<elim[k].rest.size(); i++)
+         if(need[elim[k].rest[i]] == -1) need[elim[k].rest[i]] = k;
+
+      // T starts as the active states, with covariance C
+   vector<int> T(state), pos(nstate,-1);
+   for(i=0; i<T.size(); i++) pos[T[i]] = i;
+
+   for(k=int(elim.size())-1; k>=0; k--) {
+      const Eliminated& eb(elim[k]);
+      t = T.size();
+
+         // solution, and v = Cov(T,rest)*g = -Cov(T,bias)
+      dX(eb.state) = eb.z;
+      vector<double> v(t,0.0);
+      for(i=0; i<eb.rest.size(); i++) {
+         p = pos[eb.rest[i]];
+         dX(eb.state) -= eb.g[i] * dX(eb.rest[i]);
+         for(j=0; j<t; j++) v[j] += eb.g[i] * C(p,j);
+      }
+      var = eb.d;
+      for(i=0; i<eb.rest.size(); i++) var += eb.g[i] * v[pos[eb.rest[i]]];
+      Var(eb.state) = var;
+
+         // new T: keep the non-bias states and what earlier biases need
+      vector<size_t> keep;
+      for(j=0; j<t; j++)
+         if(T[j] < nglobal || (need[T[j]] != -1 && need[T[j]] < k))
+            keep.push_back(j);
+      bool keepb(need[eb.state] != -1 && need[eb.state] < k);
+
+      Matrix<double> CC(keep.size()+(keepb ? 1 : 0),keep.size()+(keepb ? 1 : 0));
+      vector<int> TT;
+      for(i=0; i<keep.size(); i++) {
+         for(j=0; j<keep.size(); j++) CC(i,j) = C(keep[i],keep[j]);
+         if(keepb) CC(i,keep.size()) = CC(keep.size(),i) = -v[keep[i]];
+         TT.push_back(T[keep[i]]);
+      }
+      if(keepb) {
+         CC(keep.size(),keep.size()) = var;
+         TT.push_back(eb.state);
+      }
+
+      for(j=0; j<t; j++) pos[T[j]] = -1;
+      T.swap(TT);
+      for(j=0; j<T.size(); j++) pos[T[j]] = j;
+      C = CC;
+   }
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+}
+
+}  // end namespace gnsstk
+//------------------------------------------------------------------------------------
@@ -0,0 +1,127 @@
+//==============================================================================
+//
+//  This file is part of GNSSTk, the ARL:UT GNSS Toolkit.
+//
+//  The GNSSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GNSSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GNSSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin.
+//  Copyright 2004-2022, The Board of Regents of The University of Texas System
+//
+//==============================================================================
+
+//==============================================================================
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin, under contract to an agency or agencies
+//  within the U.S. Department of Defense. The U.S. Government retains all
+//  rights to use, duplicate, distribute, disclose, or release this software.
+//
+//  Pursuant to DoD Directive 523024
+//
+//  DISTRIBUTION STATEMENT A: This software has been approved for public
+//                            release, distribution is unlimited.
+//
+//==============================================================================
+/**
+ * @file BlockedNormals.hpp
+ * Include file defining BlockedNormals - normal equations of a least squares
+ * problem in which each bias is observed only over an interval, used by the
+ * blocked estimator of DDBase (--Blocked).
+ */
+
+#ifndef CLASS_BLOCKED_NORMALS_INCLUDE
+#define CLASS_BLOCKED_NORMALS_INCLUDE
+
+//------------------------------------------------------------------------------------
+// system includes
+#include <vector>
+
+// GNSSTk
+#include <gnsstk/Exception.hpp>
+#include <gnsstk/Vector.hpp>
+#include <gnsstk/Matrix.hpp>
+
+namespace gnsstk {
+//------------------------------------------------------------------------------------
+// Normal equations kept over the 'active' states only: the first nglobal (non-bias)
+// states, which are always active, plus the biases that are currently observed. A
+// bias becomes active, with its a priori variance, when it is first observed; when
+// its series ends it is eliminated (Schur complement) and the eliminated row is
+// saved. solve() solves for the states still active, then recovers the eliminated
+// biases in reverse order, along with their variances. The cost depends on the
+// number of biases active together, not on the total number.
+class BlockedNormals {
+public:
+      // start a problem of nstate states, the first nglobal of which are not biases
+   void reset(int nstate, int nglobal);
+
+      // set the a priori variance of the biases
+   void setBiasVariance(double var) { biasVar = var; }
+
+      // add the information matrix info (nglobal x nglobal) of the non-bias states
+   void addInformation(const Matrix<double>& info);
+
+      // add data f with partials P (nd x nglobal) of the non-bias states and
+      // information (inverse covariance) W (nd x nd); unless bias is empty, datum m
+      // also has partial sign[m] (+-1) of bias state bias[m]
+   void update(const Matrix<double>& P, const Vector<double>& f,
+               const Matrix<double>& W,
+               const std::vector<int>& bias, const std::vector<int>& sign);
+
+      // eliminate bias state k, if it is active; return false if singular
+   bool eliminate(int k);
+
+      // solve for the first n states (nglobal <= n <= nstate) and their variances,
+      // and the covariance of the non-bias states; biases never observed get zero
+      // and the a priori variance.
+      // @throw SingularMatrixException
+   void solve(int n, Vector<double>& dX, Vector<double>& Var, Matrix<double>& Cov);
+
+      // number of states currently active
+   size_t size(void) const { return state.size(); }
+
+private:
+      // A bias eliminated from the normal equations: bias = z - sum(g[i]*X(rest[i])),
+      // with variance d + g*Cov(rest,rest)*g.
+   class Eliminated {
+   public:
+      int state;
+      double d,z;
+      std::vector<int> rest;
+      std::vector<double> g;
+   };
+
+      // element of A in slots i,j
+   double& at(size_t i, size_t j) { return A[i*cap+j]; }
+
+      // add state index k in a new last slot, with zero row, column and b
+   size_t add(int k);
+
+      // remove slot s, moving the last slot into it
+   void remove(size_t s);
+
+   int nstate;                        // number of states
+   int nglobal;                       // number of non-bias states, first
+   double biasVar;                    // a priori variance of the biases
+   std::vector<int> state,slot;       // state[i] in slot i; slot[k] of state k, or -1
+   std::vector<double> A,b;           // symmetric A and b by slot, cap x cap
+   size_t cap;                        // capacity of A and b
+   std::vector<Eliminated> elim;      // biases, in the order eliminated
+};
+
+}  // end namespace gnsstk
+//------------------------------------------------------------------------------------
+#endif
@@ -82,6 +82,7 @@ try {
    Verbose = false;
    Screen = true;            // TD user input
    Validate = false;
+   nThreads = 1;
       // log file
    LogFile = string("ddbase.log");
       // input data files
@@ -125,10 +126,12 @@ try {
    RefSat = GSatID(-1,SatelliteSystem::GPS);
       // estimation
    noEstimate = false;                    // for Estimation()
+   noCache = false;                       // for Estimation()
    nIter = 5;                             // for Estimation()
    convergence = 5.0e-8;                  // TD convergence criterion input
    noRAIM = false;                        // turn off pseudorange solution (! -> clk?)
    FixBiases = false;
+   Blocked = false;
    // Don't implement default constraints - this needs more study
    TightConstraint = 1.e-4; // 1.e-5;
    LooseConstraint = 1.e-1; // 1.e-1;
@@ -283,6 +286,18 @@ try {
       "Perform an extra, last iteration that fixes the phase biases (don't)");
    dashfixbias.setMaxCount(1);
 
+   CommandOptionNoArg dashblocked(0, "Blocked", " --Blocked             "
+      "Estimate with blocked normal equations, eliminating each bias\n"
+      "                         when its DD series ends; for large networks (don't)");
+   dashblocked.setMaxCount(1);
+
+   CommandOptionNoArg dashnocache(0, "noCache", " --noCache             "
+      "Recompute data, covariance and satellite geometry on every\n"
+      "                         iteration, rather than caching them; the cache holds\n"
+      "                         at most 2^24 covariance elements (128MB), beyond\n"
+      "                         which covariances are recomputed anyway (don't)");
+   dashnocache.setMaxCount(1);
+
    // state
    CommandOption dashntrop(CommandOption::hasArgument, CommandOption::stdType,
       0,"RZDnIntervals","\n# Model, state elements, a priori constraints:\n"
@@ -461,6 +476,11 @@ try {
       "<x,y,z> are optional baseline coordinates\n                          "
       "for comparison [repeatable] ()");
 
+   CommandOption dashthreads(CommandOption::hasArgument, CommandOption::stdType,
+      0,"threads"," --threads <n>         Number of threads for computing and editing"
+      " double differences (" + asString(nThreads) + ")");
+   dashthreads.setMaxCount(1);
+
    CommandOptionNoArg dashvalid('0', "validate",
       " --validate            Read input and validate it, then quit (don't)");
    dashvalid.setMaxCount(1);
@@ -843,6 +863,14 @@ try {
       FixBiases = true;
       if(help) cout << " Input: Turn ON fixing of biases in last iteration" << endl;
    }
+   if(dashnocache.getCount()) {
+      noCache = true;
+      if(help) cout << " Input: Turn OFF caching of the model in Estimation" << endl;
+   }
+   if(dashblocked.getCount()) {
+      Blocked = true;
+      if(help) cout << " Input: Estimate with blocked normal equations" << endl;
+   }
    if(dashntrop.getCount()) {
       values = dashntrop.getValue();
       NRZDintervals = asInt(values[0]);
@@ -1059,6 +1087,12 @@ try {
       }
    }
 
+   if(dashthreads.getCount()) {
+      values = dashthreads.getValue();
+      nThreads = asInt(values[0]);
+      if(nThreads < 1) nThreads = 1;
+      if(help) cout << " Input: number of threads " << nThreads << endl;
+   }
    if(dashvalid.getCount()) {
       Validate = true;
       if(help) cout << " Input: validate -- read, test input and quit" << endl;
@@ -1373,6 +1407,7 @@ try {
       << "validating the input ---------" << endl;
    ofs << " Debug is " << (Debug ? "on":"off") << endl;
    ofs << " Verbose is " << (Verbose ? "on":"off") << endl;
+   if(nThreads > 1) ofs << " Use " << nThreads << " threads" << endl;
    ofs << " Log file name is " << LogFile << endl;
    if(!InputPath.empty()) ofs << " Path for input obs files is "
       << InputPath << endl;
@@ -1430,6 +1465,8 @@ try {
       << scientific << setprecision(3) << convergence << endl;
    ofs << " On last iteration," << (FixBiases ? "" : " do not")
       << " fix biases" << endl;
+   if(Blocked) ofs << " Estimate with blocked normal equations" << endl;
+   if(noCache) ofs << " Recompute the model on every iteration (no cache)" << endl;
    if(NRZDintervals > 0) {
       ofs << " Estimate " << NRZDintervals
          << " residual zenith delay intervals" << endl;
@@ -76,6 +76,7 @@ public:
    bool Verbose;
    bool Screen;
    bool Validate;
+   int nThreads;                          // threads for DD and editing
    std::string LogFile;
    std::string InputPath;
    std::string NavPath;
@@ -118,9 +119,11 @@ public:
    gnsstk::GSatID RefSat;
       // Estimation
    bool noEstimate;
+   bool noCache;                          // recompute model every iteration
    int nIter;
    double convergence;
    bool FixBiases;
+   bool Blocked;                          // blocked normal equations
    double TightConstraint,LooseConstraint;// in ppm (of baseline)
    double DefaultTemp,DefaultPress,DefaultRHumid;
       // output
@@ -48,6 +48,9 @@
 #include <gnsstk/TimeString.hpp>
 #include <gnsstk/CivilTime.hpp>
 #include <time.h>
+#include <thread>
+#include <atomic>
+#include <exception>
 
 // GNSSTk
 //#define RANGECHECK // throw on invalid ranges in Vector and Matrix
@@ -61,7 +64,10 @@ using namespace std;
 using namespace gnsstk;
 
 //------------------------------------------------------------------------------------
-string Version("4.8 5/13/11");
+string Version("4.11 10/17/26");
+// 4.11 10/17/26 Cache per-epoch data, covariance and geometry in Estimation; --noCache
+// 4.10 10/17/26 Add --Blocked: blocked normal equations that eliminate biases
+// 4.9 10/17/26 Add --threads: compute and edit DDs of baselines in parallel
 // 4.8  5/13/11 Timetable algorithm 'using' ave time btwn segments for a gap; bug213
 // 4.7b 6/23/10 Minor change so NewB trop. model works properly
 // 4.7 12/10/08 Fix empty buffers bug (131) in Timetable
@@ -332,6 +338,36 @@ catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_
 catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
 }
 
+//------------------------------------------------------------------------------------
+// Call work(i) for each i in [0,n), on CI.nThreads threads. The work items must be
+// independent; each should write to its own output, for the caller to merge in
+// order. After all threads finish, the first exception (in order of i) is rethrown.
+void RunParallel(size_t n, const function<void(size_t)>& work)
+{
+   size_t i, nt(min(size_t(CI.nThreads), n));
+   if(nt <= 1) {
+      for(i=0; i<n; i++) work(i);
+      return;
+   }
+
+   vector<exception_ptr> errors(n);
+   atomic<size_t> next(0);
+   vector<thread> workers;
+   for(i=0; i<nt; i++) {
+      workers.push_back(thread([&]() {
+         size_t k;
+         while((k = next++) < n) {
+            try { work(k); }
+            catch(...) { errors[k] = current_exception(); }
+         }
+      }));
+   }
+   for(i=0; i<nt; i++) workers[i].join();
+
+   for(i=0; i<n; i++)
+      if(errors[i]) rethrow_exception(errors[i]);
+}
+
 //------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------
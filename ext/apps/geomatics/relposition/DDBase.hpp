@@ -56,6 +56,7 @@
 #include <vector>
 #include <map>
 #include <ctime>
+#include <functional>
 
 // GNSSTk
 //#define RANGECHECK // if defined, Vector and Matrix will throw on invalid index.
@@ -131,6 +132,7 @@ int QueryTimeTable(gnsstk::SDid& sdid, gnsstk::CommonTime& tt);
  * @throw Exception
  */
 int QueryTimeTable(std::string bl, int& beg, int& end);
+void TimeTableTiming(void);      // Timetable.cpp
 /**
  * @throw Exception
  */
@@ -148,6 +150,11 @@ int Estimation(void);            // Estimation.cpp
  */
 gnsstk::Matrix<double> SingleAxisRotation(double angle, const int axis);
    // DDBase.cpp
+/**
+ * @throw Exception
+ */
+void RunParallel(size_t n, const std::function<void(size_t)>& work);
+   // DDBase.cpp
 
 //------------------------------------------------------------------------------------
 // Global data -- see DDBase.cpp where these are declared and documented
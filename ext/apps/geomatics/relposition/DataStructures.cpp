@@ -71,6 +71,74 @@ catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_
 catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
 }
 
+//------------------------------------------------------------------------------------
+// keep, in one pass, the elements of column v where mark is 1; columns that are
+// not parallel to mark (e.g. unused in single differences) are left alone
+template <class T> void CompactColumn(vector<T>& v, const vector<int>& mark)
+{
+   if(v.size() != mark.size()) return;
+   size_t i,n(0);
+   for(i=0; i<mark.size(); i++)
+      if(mark[i] == 1) v[n++] = v[i];
+   v.resize(n);
+}
+
+//------------------------------------------------------------------------------------
+void RawData::reserve(size_t n)
+{
+   count.reserve(n);
+   L1.reserve(n); L2.reserve(n);
+   P1.reserve(n); P2.reserve(n);
+   S1.reserve(n); S2.reserve(n);
+   ER.reserve(n); elev.reserve(n); az.reserve(n);
+}
+
+//------------------------------------------------------------------------------------
+void RawData::push_back(int cnt, const DataStruct& ds)
+{
+   count.push_back(cnt);
+   L1.push_back(ds.L1); L2.push_back(ds.L2);
+   P1.push_back(ds.P1); P2.push_back(ds.P2);
+   S1.push_back(ds.S1); S2.push_back(ds.S2);
+   ER.push_back(ds.ER); elev.push_back(ds.elev); az.push_back(ds.az);
+}
+
+//------------------------------------------------------------------------------------
+void RawData::compact(const vector<int>& mark)
+{
+   CompactColumn(L1,mark); CompactColumn(L2,mark);
+   CompactColumn(P1,mark); CompactColumn(P2,mark);
+   CompactColumn(S1,mark); CompactColumn(S2,mark);
+   CompactColumn(ER,mark); CompactColumn(elev,mark); CompactColumn(az,mark);
+   CompactColumn(count,mark);       // last, it defines the size
+}
+
+//------------------------------------------------------------------------------------
+void RawData::shrink(void)
+{
+   count.shrink_to_fit();
+   L1.shrink_to_fit(); L2.shrink_to_fit();
+   P1.shrink_to_fit(); P2.shrink_to_fit();
+   S1.shrink_to_fit(); S2.shrink_to_fit();
+   ER.shrink_to_fit(); elev.shrink_to_fit(); az.shrink_to_fit();
+}
+
+//------------------------------------------------------------------------------------
+void DDData::reserve(size_t n)
+{
+   count.reserve(n);
+   DDL1.reserve(n); DDL2.reserve(n);
+   DDP1.reserve(n); DDP2.reserve(n); DDER.reserve(n);
+}
+
+//------------------------------------------------------------------------------------
+void DDData::compact(const vector<int>& mark)
+{
+   CompactColumn(DDL1,mark); CompactColumn(DDL2,mark);
+   CompactColumn(DDP1,mark); CompactColumn(DDP2,mark); CompactColumn(DDER,mark);
+   CompactColumn(count,mark);
+}
+
 //------------------------------------------------------------------------------------
 Station::Station(void) noexcept
 {
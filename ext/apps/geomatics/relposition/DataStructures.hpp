@@ -74,7 +74,8 @@ typedef struct data_structure {
    double az;     // degrees
 } DataStruct;
 
-// structure for buffered raw good data
+// structure for buffered raw good data, one column per quantity; the columns
+// are parallel to count (single differences use only count,L1,L2,P1,P2,ER,elev)
 class RawData {
 public:
    std::vector<double> L1;      // cycles
@@ -87,6 +88,12 @@ public:
    std::vector<double> elev;    // deg
    std::vector<double> az;      // deg
    std::vector<int> count;      // epoch count since FirstEpoch
+
+   size_t size(void) const { return count.size(); }
+   void reserve(size_t n);                   // all columns
+   void push_back(int cnt, const DataStruct& ds);
+   void compact(const std::vector<int>& mark);  // keep points where mark == 1
+   void shrink(void);                        // free unused capacity
 };
 
 // structure for computing single differences -- just counts and min,max elevation
@@ -107,6 +114,9 @@ public:
    std::vector<int> resets;                        // collection of indexes into
                                                    //    count[] where bias is reset
    //DDData(void) : last_buffer_index(0) {};
+
+   void reserve(size_t n);                         // data and count
+   void compact(const std::vector<int>& mark);     // keep points where mark == 1
 };
 
 // both reference and unknown positions
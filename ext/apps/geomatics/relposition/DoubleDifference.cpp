@@ -47,6 +47,7 @@
 
 //------------------------------------------------------------------------------------
 // system includes
+#include <sstream>
 #include <gnsstk/TimeString.hpp>
 // GNSSTk
 
@@ -60,8 +61,12 @@ using namespace StringUtils;
 
 //------------------------------------------------------------------------------------
 // prototypes -- this module only
-void ComputeSingleDifferences(string baseline, map<SDid,RawData>& SDmap);
-int ComputeDoubleDifferences(map<SDid,RawData>& SDmap);
+int BaselineDoubleDifferences(const string& baseline, map<DDid,DDData>& DDmap,
+                              ostream& log);
+void ComputeSingleDifferences(string baseline, map<SDid,RawData>& SDmap,
+                              ostream& log);
+int ComputeDoubleDifferences(map<SDid,RawData>& SDmap, map<DDid,DDData>& DDmap,
+                             ostream& log);
 
 //------------------------------------------------------------------------------------
 // other prototypes
@@ -72,10 +77,7 @@ bool ElevationMask(double elevation, double azimuth);
 int DoubleDifference(void)
 {
 try {
-   int j,k;
-   size_t i,n;
-      // map to hold all buffered single differences for one baseline
-   map<SDid,RawData> SDmap;
+   size_t n;
 
    if(CI.Verbose) oflog << "BEGIN DoubleDifference()"
       << " at total time " << fixed << setprecision(3)
@@ -85,82 +87,119 @@ try {
       // clear any existing DDs
    DDDataMap.clear();
 
-      // loop over baselines
-   for(n=0; n<Baselines.size(); n++) {
-
-         // ----------------------------------------------------------
-         // for this baseline, compute all SDs, then DDs, and buffer them
-      if(CI.Verbose) oflog << "DoubleDifference() for baseline "
-         << Baselines[n] << endl;
-
-         // clear the SD map
-      SDmap.clear();
-
-         // ----------------------------------------------------------
-         // compute all single differences for this baseline
-         // give it same ordering as Baseline
-      ComputeSingleDifferences(Baselines[n],SDmap);
-
-         // loop over SD data, edit small ones and dump summary
-      if(CI.Verbose) oflog << "Single difference summary for baseline "
-          << Baselines[n] << endl;
-
-      vector<SDid> Remove;    // these will be small dataset to delete later
-
-      map<SDid,RawData>::const_iterator kt;
-      for(k=1,kt=SDmap.begin(); kt != SDmap.end(); k++,kt++) {
-
-         if(CI.Verbose) {
-            oflog << " " << setw(2) << k << " " << kt->first
-                  << " " << setw(5) << kt->second.count.size();
-            if(kt->second.count.size() > 0)
-               oflog << " " << setw(5) << kt->second.count.at(0) << " - "
-                     << setw(5) << kt->second.count.at(kt->second.count.size()-1);
-            else
-               oflog << "    na -    na";
-
-               // gaps - (count : number of pts)
-            if(kt->second.count.size() > 0) {      // gcc needs this ...
-               for(i=0; i<kt->second.count.size()-1; i++) {
-                  j = kt->second.count.at(i+1) - kt->second.count.at(i);
-                  if(j > 1) oflog
-                     << " (" << kt->second.count.at(i)+1 << ":" << j-1 << ")";
-               }
-            }
-         }
+      // compute the DDs of each baseline, with its own log, on CI.nThreads
+      // threads; then merge them, and the logs, in the order of Baselines
+   const size_t nb(Baselines.size());
+   vector< map<DDid,DDData> > DDmaps(nb);
+   vector<ostringstream> logs(nb);
+   vector<int> irets(nb,0);
+   for(n=0; n<nb; n++) logs[n].copyfmt(oflog);
+
+   RunParallel(nb, [&](size_t k)
+      { irets[k] = BaselineDoubleDifferences(Baselines[k], DDmaps[k], logs[k]); });
+
+   for(n=0; n<nb; n++) {
+      oflog << logs[n].str();
+      if(irets[n]) return 1;
+      map<DDid,DDData>::iterator it;
+      for(it=DDmaps[n].begin(); it != DDmaps[n].end(); it++)
+         DDDataMap[it->first] = std::move(it->second);
+      DDmaps[n].clear();
+   }
+
+   if(CI.Verbose) TimeTableTiming();
+
+   return 0;
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_THROW(E); }
+catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
+}   // end DoubleDifference()
+
+//------------------------------------------------------------------------------------
+// Compute, edit and buffer in DDmap all the single and double differences of one
+// baseline, writing to log; independent of all other baselines.
+int BaselineDoubleDifferences(const string& baseline, map<DDid,DDData>& DDmap,
+                              ostream& log)
+{
+try {
+   int j,k;
+   size_t i;
+      // map to hold all buffered single differences for the baseline
+   map<SDid,RawData> SDmap;
+
+      // ----------------------------------------------------------
+      // for this baseline, compute all SDs, then DDs, and buffer them
+   if(CI.Verbose) log << "DoubleDifference() for baseline "
+      << baseline << endl;
+
+      // clear the SD map
+   SDmap.clear();
+
+      // ----------------------------------------------------------
+      // compute all single differences for this baseline
+      // give it same ordering as Baseline
+   ComputeSingleDifferences(baseline,SDmap,log);
 
-            // ignore small datasets
-         if(kt->second.count.size() < 10) {   // TD make input parameter
-            Remove.push_back(kt->first);
-            if(CI.Verbose) oflog << " **Rejected";
+      // loop over SD data, edit small ones and dump summary
+   if(CI.Verbose) log << "Single difference summary for baseline "
+       << baseline << endl;
+
+   vector<SDid> Remove;    // these will be small dataset to delete later
+
+   map<SDid,RawData>::const_iterator kt;
+   for(k=1,kt=SDmap.begin(); kt != SDmap.end(); k++,kt++) {
+
+      if(CI.Verbose) {
+         log << " " << setw(2) << k << " " << kt->first
+               << " " << setw(5) << kt->second.count.size();
+         if(kt->second.count.size() > 0)
+            log << " " << setw(5) << kt->second.count.at(0) << " - "
+                  << setw(5) << kt->second.count.at(kt->second.count.size()-1);
+         else
+            log << "    na -    na";
+
+            // gaps - (count : number of pts)
+         if(kt->second.count.size() > 0) {      // gcc needs this ...
+            for(i=0; i<kt->second.count.size()-1; i++) {
+               j = kt->second.count.at(i+1) - kt->second.count.at(i);
+               if(j > 1) log
+                  << " (" << kt->second.count.at(i)+1 << ":" << j-1 << ")";
+            }
          }
+      }
 
-         if(CI.Verbose) oflog << endl;
+         // ignore small datasets
+      if(kt->second.count.size() < 10) {   // TD make input parameter
+         Remove.push_back(kt->first);
+         if(CI.Verbose) log << " **Rejected";
+      }
 
-      }  // end summary loop
+      if(CI.Verbose) log << endl;
 
-         // delete marked SD buffers
-      for(i=0; i<Remove.size(); i++) SDmap.erase(Remove[i]);
+   }  // end summary loop
 
-         // ----------------------------------------------------------
-         // now compute double differences - according to timetable
-      if(ComputeDoubleDifferences(SDmap)) return 1;
+      // delete marked SD buffers
+   for(i=0; i<Remove.size(); i++) SDmap.erase(Remove[i]);
 
-         // check that there are non-zero double differences
+      // ----------------------------------------------------------
+      // now compute double differences - according to timetable
+   if(ComputeDoubleDifferences(SDmap,DDmap,log)) return 1;
 
-   }  // end loop over baselines
+      // check that there are non-zero double differences
 
    return 0;
 }
 catch(Exception& e) { GNSSTK_RETHROW(e); }
 catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_THROW(E); }
 catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
-}   // end DoubleDifference()
+}   // end BaselineDoubleDifferences()
 
 //------------------------------------------------------------------------------------
 // Compute all single differences 'site1' - 'site2', using the RawDataBuffers in
 // Stations[site], and store the results in the given map<SDid,RawData>.
-void ComputeSingleDifferences(string baseline, map<SDid,RawData>& SDmap)
+void ComputeSingleDifferences(string baseline, map<SDid,RawData>& SDmap,
+                              ostream& log)
 {
 try {
    int beg,end;
@@ -173,65 +212,68 @@ try {
 
       // find the beginning and ending *counts* of good data for this baseline
    if(QueryTimeTable(baseline,beg,end)) {
-      oflog << "ERROR - baseline " << baseline
+      log << "ERROR - baseline " << baseline
          << " not found in timetable. No single differences computed." << endl;
       return;
    }
 
+      // find the stations; NB only read them, this may run in a thread
+   map<string,Station>::const_iterator st1,st2;
+   st1 = Stations.find(site1);
+   st2 = Stations.find(site2);
+   if(st1 == Stations.end() || st2 == Stations.end()) return;
+   const map<GSatID,RawData>& Buffers1(st1->second.RawDataBuffers);
+   const map<GSatID,RawData>& Buffers2(st2->second.RawDataBuffers);
+
       // find satellites in common
    map<GSatID,RawData>::const_iterator it1,it2;
 
       // loop over satellites at first site
-   for(it1 = Stations[site1].RawDataBuffers.begin();
-       it1 != Stations[site1].RawDataBuffers.end(); it1++) {
+   for(it1 = Buffers1.begin(); it1 != Buffers1.end(); it1++) {
 
       sat = it1->first;
       // it1->second is RawData={ L1,L2,P1,P2,elev,az,count buffers = vector<> }
 
          // does this sat have data at the other station?
-      it2 = Stations[site2].RawDataBuffers.find(sat);
-      if(it2 == Stations[site2].RawDataBuffers.end()) continue;    // no
+      it2 = Buffers2.find(sat);
+      if(it2 == Buffers2.end()) continue;    // no
 
          // compute single differences for this satellite
          // here is where you define the ordering of sites: first(1) - second(2)
       SDid sdid(site1,site2,sat);
       RawData sddata;
+      const RawData& rd1(it1->second), & rd2(it2->second);
 
          // loop over epochs, finding common data. start and stop the loop
          // at times determined by the timetable, NOT by the raw data buffers.
+         // First find the pairs of indexes (i,j) of common counts, then fill
+         // the columns from them.
+      vector<size_t> i1,i2;
+      i1.reserve(min(rd1.size(),rd2.size()));
+      i2.reserve(min(rd1.size(),rd2.size()));
       i = j = 0;
-      while(i < it1->second.count.size() && j < it2->second.count.size()) {
+      while(i < rd1.count.size() && j < rd2.count.size()) {
 
             // impose limits from timetable
-              if(it1->second.count[i] > end) break;
-         else if(it2->second.count[j] > end) break;
-         else if(it1->second.count[i] < beg) i++;
-         else if(it2->second.count[j] < beg) j++;
+              if(rd1.count[i] > end) break;
+         else if(rd2.count[j] > end) break;
+         else if(rd1.count[i] < beg) i++;
+         else if(rd2.count[j] < beg) j++;
             // i and j are the same count (epoch)
-         else if(it1->second.count[i] == it2->second.count[j]) {
+         else if(rd1.count[i] == rd2.count[j]) {
                // reject data below MinElevation here
-            //if(it1->second.elev[i] > CI.MinElevation &&
-               //it2->second.elev[j] > CI.MinElevation) {
-            if(ElevationMask(it1->second.elev[i],it1->second.az[i]) &&
-               ElevationMask(it2->second.elev[j],it2->second.az[j])) {
-
-                  // buffer the differences
-               sddata.count.push_back(it1->second.count[i]);
-               sddata.L1.push_back(it1->second.L1[i] - it2->second.L1[j]);
-               sddata.L2.push_back(it1->second.L2[i] - it2->second.L2[j]);
-               sddata.P1.push_back(it1->second.P1[i] - it2->second.P1[j]);
-               sddata.P2.push_back(it1->second.P2[i] - it2->second.P2[j]);
-               sddata.ER.push_back(it1->second.ER[i] - it2->second.ER[j]);
-               sddata.elev.push_back(it1->second.elev[i]);
-
-            }  // end if elevation is ok
+            if(ElevationMask(rd1.elev[i],rd1.az[i]) &&
+               ElevationMask(rd2.elev[j],rd2.az[j])) {
+               i1.push_back(i);
+               i2.push_back(j);
+            }
 
                // next epoch
             i++;
             j++;
          }
             // i is behind j in time(count)
-         else if(it1->second.count[i] < it2->second.count[j])
+         else if(rd1.count[i] < rd2.count[j])
             i++;
             // i is ahead of j in time(count)
          else
@@ -239,8 +281,24 @@ try {
 
       }  // end while
 
+         // buffer the differences
+      const size_t n(i1.size());
+      sddata.count.resize(n);
+      sddata.L1.resize(n); sddata.L2.resize(n);
+      sddata.P1.resize(n); sddata.P2.resize(n);
+      sddata.ER.resize(n); sddata.elev.resize(n);
+      for(size_t k=0; k<n; k++) {
+         sddata.count[k] = rd1.count[i1[k]];
+         sddata.L1[k] = rd1.L1[i1[k]] - rd2.L1[i2[k]];
+         sddata.L2[k] = rd1.L2[i1[k]] - rd2.L2[i2[k]];
+         sddata.P1[k] = rd1.P1[i1[k]] - rd2.P1[i2[k]];
+         sddata.P2[k] = rd1.P2[i1[k]] - rd2.P2[i2[k]];
+         sddata.ER[k] = rd1.ER[i1[k]] - rd2.ER[i2[k]];
+         sddata.elev[k] = rd1.elev[i1[k]];
+      }
+
          // save it in the map
-      SDmap[sdid] = sddata;
+      SDmap[sdid] = std::move(sddata);
 
    }  // end loop over satellites at first site
 
@@ -251,8 +309,9 @@ catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
 }
 
 //------------------------------------------------------------------------------------
-// Assume SDmap is all for the same baseline
-int ComputeDoubleDifferences(map<SDid,RawData>& SDmap)
+// Assume SDmap is all for the same baseline; buffer the DDs in DDmap
+int ComputeDoubleDifferences(map<SDid,RawData>& SDmap, map<DDid,DDData>& DDmap,
+                             ostream& log)
 {
 try {
    bool frst,ok;
@@ -291,19 +350,19 @@ try {
       if(tt > ttnext) {
          ttnext = tt;
          if(QueryTimeTable(ref, ttnext)) {         // error - timetable failed
-            oflog << "DD: Error - failed to find reference from timetable at "
+            log << "DD: Error - failed to find reference from timetable at "
                << printTime(tt,"%Y/%02m/%02d %2H:%02M:%6.3f=%F/%10.3g") << " count "
                << count << " for baseline " << ref.site1 << "-" << ref.site2 << endl;
             return 1;
          }
-         if(CI.Verbose) oflog << "DD: reference is set to " << ref << " at "
+         if(CI.Verbose) log << "DD: reference is set to " << ref << " at "
             << printTime(tt,"%Y/%02m/%02d %2H:%02M:%6.3f=%F/%10.3g")
             << " count " << count << endl;
       }
 
          // does reference satellite have data at this count?
       if(SDmap[ref].count[Inext[ref]] != count) {
-         oflog << "Error - failed to find reference data " << ref << " at "
+         log << "Error - failed to find reference data " << ref << " at "
             << printTime(tt,"%Y/%02m/%02d %2H:%02M:%6.3f=%F/%10.3g") << endl;
             // TD return here, or just skip the epoch?
             // question is do we allow 'holes' in ref sat's data?
@@ -336,7 +395,7 @@ try {
          map<DDid,DDData>::iterator jt;
          DDid ddid((ref.ssite == 1 ? ref.site1 : ref.site2),
                    (ref.ssite == 1 ? ref.site2 : ref.site1),sid.sat,ref.sat);
-         if(DDDataMap.find(ddid) == DDDataMap.end()) {
+         if(DDmap.find(ddid) == DDmap.end()) {
                // create a new DDData
             DDData tddb;
             dd = (-ddL1+ddER)/wl1;
@@ -345,21 +404,23 @@ try {
             dd = (-ddL2+ddER)/wl2;
             nn2 = int(dd + (dd > 0 ? 0.5 : -0.5));
             tddb.L2bias = wl2 * nn2;
-            oflog << " Phase bias (initial) on " << ddid
+            log << " Phase bias (initial) on " << ddid
                << " at " << setw(4) << count << " "
                << printTime(tt,"%Y/%02m/%02d %2H:%02M:%6.3f=%F/%10.3g");
-            if(CI.Frequency != 2) oflog << " L1: " << setw(10) << nn1;
-            if(CI.Frequency != 1) oflog << " L2: " << setw(10) << nn2;
-            oflog << endl;
+            if(CI.Frequency != 2) log << " L1: " << setw(10) << nn1;
+            if(CI.Frequency != 1) log << " L2: " << setw(10) << nn2;
+            log << endl;
             //tddb.lastresetcount = count;
             tddb.resets.push_back(tddb.count.size());    // always one at beginning
             tddb.prevL1 = (ddL1-ddER)+tddb.L1bias;
             tddb.prevL2 = (ddL2-ddER)+tddb.L2bias;
-            DDDataMap[ddid] = tddb;
+            DDmap[ddid] = tddb;
+               // at most the rest of this SD can be buffered in it
+            DDmap[ddid].reserve(SDmap[sid].count.size()-indx);
          }
 
             // get the current DDData structure, and relative sign
-         jt = DDDataMap.find(ddid); // never fail...
+         jt = DDmap.find(ddid); // never fail...
          ddsign = DDid::compare(ddid,jt->first);
          DDData& ddb=jt->second;
          ok = true;                 // if ok, buffer this DDData = ddb
@@ -371,12 +432,12 @@ try {
             (CI.Frequency != 1 && fabs(db2) > CI.PhaseBiasReset)) {
             long ndb1 = long(db1 + (db1 > 0 ? 0.5 : -0.5));
             long ndb2 = long(db2 + (db2 > 0 ? 0.5 : -0.5));
-            oflog << " Phase bias (reset  ) on " << ddid
+            log << " Phase bias (reset  ) on " << ddid
                << " at " << setw(4) << count << " "
                << printTime(tt,"%Y/%02m/%02d %2H:%02M:%6.3f=%F/%10.3g");
-            if(CI.Frequency != 2) oflog << " L1: " << setw(10) << ndb1;
-            if(CI.Frequency != 1) oflog << " L2: " << setw(10) << ndb2;
-            oflog << endl;
+            if(CI.Frequency != 2) log << " L1: " << setw(10) << ndb1;
+            if(CI.Frequency != 1) log << " L2: " << setw(10) << ndb2;
+            log << endl;
             ddb.L1bias -= wl1 * ndb1;
             ddb.L2bias -= wl2 * ndb2;
             //ddb.lastresetcount = count;
@@ -50,6 +50,7 @@
 #include <gnsstk/TimeString.hpp>
 // system
 #include <vector>
+#include <sstream>
 
 // GNSSTk
 #include <gnsstk/Matrix.hpp>
@@ -65,16 +66,28 @@ using namespace std;
 using namespace gnsstk;
 
 //------------------------------------------------------------------------------------
-static int ngood,nbad;           // number good data, number of data marked bad
-static vector<int> mark;         // parallel to count and data vectors, mark bad data
+// Editing state of one DD dataset. DD datasets are edited independently, perhaps
+// in parallel (--threads), so each keeps its marks and its output, which is
+// written to the log and TDD file afterwards in DDDataMap order.
+class DDEdit {
+public:
+   int ngood,nbad;               // number good data, number of data marked bad
+   vector<int> mark;             // parallel to count and data vectors, mark bad data
+   bool remove;                  // delete this DD dataset
+   ostringstream log;            // output for oflog
+   ostringstream tdd;            // output for tddofs
+   DDEdit(void) : ngood(0), nbad(0), remove(false) {}
+};
+
 static ofstream tddofs;          // output stream for OutputTDDFile
 
 //------------------------------------------------------------------------------------
 // prototypes -- this module only
-int EditDDResets(const DDid& ddid, DDData& dddata);
-int EditDDIsolatedPoints(const DDid& ddid, DDData& dddata);
-int EditDDSlips(const DDid& ddid, DDData& dddata, int frequency);
-int EditDDOutliers(const DDid& ddid, DDData& dddata, int frequency);
+void EditDD(const DDid& ddid, DDData& dddata, DDEdit& ed);
+int EditDDResets(const DDid& ddid, DDData& dddata, DDEdit& ed);
+int EditDDIsolatedPoints(const DDid& ddid, DDData& dddata, DDEdit& ed);
+int EditDDSlips(const DDid& ddid, DDData& dddata, int frequency, DDEdit& ed);
+int EditDDOutliers(const DDid& ddid, DDData& dddata, int frequency, DDEdit& ed);
 //void LSPolyFunc(Vector<double>& X, Vector<double>& f, Matrix<double>& P)
 //  ;
 // prototypes -- DataOutput.cpp
@@ -115,107 +128,53 @@ try {
    }
 
    int j,k;
-   size_t i;
+   size_t i,n;
    map<DDid,DDData>::iterator it;
 
       // -------------------------------------------------------------------
       // delete DD buffers that are too small, or that user wants to exclude
-      // also compute maxCount, the largest value of Count seen in all baselines
-   maxCount = 0;
-   vector<DDid> DDdelete;
-   for(it = DDDataMap.begin(); it != DDDataMap.end(); it++) {
-
-         // is it too small?
-      if(int(it->second.count.size()) < CI.MinDDSeg) {
-         DDdelete.push_back(it->first);
-         continue;
-      }
+      // edit each DD dataset, on CI.nThreads threads; then in order output,
+      // delete or compact them, and compute maxCount, the largest value of
+      // Count seen in all baselines
+   vector<map<DDid,DDData>::iterator> DDits;
+   for(it = DDDataMap.begin(); it != DDDataMap.end(); it++) DDits.push_back(it);
+   vector<DDEdit> edits(DDits.size());
+   for(n=0; n<edits.size(); n++) edits[n].log.copyfmt(oflog);
 
-         // prepare 'mark' vector
-      mark.assign(it->second.count.size(),1);
-      ngood = mark.size();
-      nbad = 0;
+   RunParallel(DDits.size(), [&](size_t m)
+      { EditDD(DDits[m]->first, DDits[m]->second, edits[m]); });
 
-         // remove points where bias had to be reset multiple times
-      k = EditDDResets(it->first, it->second);
-      if(k || ngood < CI.MinDDSeg) {
-         DDdelete.push_back(it->first);
-         continue;
-      }
+   maxCount = 0;
+   vector<DDid> DDdelete;
+   for(n=0; n<DDits.size(); n++) {
+      it = DDits[n];
+      DDEdit& ed(edits[n]);
+      oflog << ed.log.str();
+      if(tddofs.is_open()) tddofs << ed.tdd.str();
 
-         // remove isolated points
-      k = EditDDIsolatedPoints(it->first, it->second);
-      if(k || ngood < CI.MinDDSeg) {
+      if(ed.remove) {
          DDdelete.push_back(it->first);
          continue;
       }
 
-         // find and remove slips
-      if(CI.Frequency != 2) {                // L1
-         k = EditDDSlips(it->first, it->second,1);
-         if(k || ngood < CI.MinDDSeg) {
-            DDdelete.push_back(it->first);
-            continue;
-         }
-      }
-      if(CI.Frequency != 1) {                // L2
-         k = EditDDSlips(it->first, it->second,2);
-         if(k || ngood < CI.MinDDSeg) {
-            DDdelete.push_back(it->first);
-            continue;
-         }
-      }
-
-         // find and remove outliers
-      if(CI.Frequency != 2) {                // L1
-         k = EditDDOutliers(it->first, it->second,1);
-         if(k || ngood < CI.MinDDSeg) {
-            DDdelete.push_back(it->first);
-            continue;
-         }
-      }
-      if(CI.Frequency != 1) {                // L2
-         k = EditDDOutliers(it->first, it->second,2);
-         if(k || ngood < CI.MinDDSeg) {
-            DDdelete.push_back(it->first);
-            continue;
-         }
-      }
-
          // output raw data with mark
-      OutputRawDData(it->first, it->second, mark);
+      OutputRawDData(it->first, it->second, ed.mark);
 
          // use vector 'mark' to delete data
-      if(nbad > 0) {
-         vector<double> nDDL1,nDDL2,nDDP1,nDDP2,nDDER;
-         vector<int> ncount;
-         for(i=0; i<it->second.count.size(); i++) {
-            if(mark[i] == 1) {
-               nDDL1.push_back(it->second.DDL1[i]);
-               nDDL2.push_back(it->second.DDL2[i]);
-               nDDP1.push_back(it->second.DDP1[i]);
-               nDDP2.push_back(it->second.DDP2[i]);
-               nDDER.push_back(it->second.DDER[i]);
-               ncount.push_back(it->second.count[i]);
-            }
-         }
-         it->second.DDL1 = nDDL1;
-         it->second.DDL2 = nDDL2;
-         it->second.DDP1 = nDDP1;
-         it->second.DDP2 = nDDP2;
-         it->second.DDER = nDDER;
-         it->second.count = ncount;
+      if(ed.nbad > 0) {
+         it->second.compact(ed.mark);
          // ignore resets from now on...
       }
 
          // find the max count
       if(it->second.count[it->second.count.size()-1] > maxCount)
          maxCount = it->second.count[it->second.count.size()-1];
+
+      ed.mark = vector<int>();
    }
 
       // close the output file
    tddofs.close();
-   mark.clear();
 
       // now delete the ones that were marked
    for(i=0; i<DDdelete.size(); i++) {
@@ -275,12 +234,64 @@ catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_
 catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
 }   // end EditDDs()
 
+//------------------------------------------------------------------------------------
+// Edit one DD dataset: mark bad data in mark, fix slips in dddata, and set
+// ed.remove if the whole dataset should be deleted. Uses only ddid, dddata and ed.
+void EditDD(const DDid& ddid, DDData& dddata, DDEdit& ed)
+{
+try {
+   int k;
+
+      // is it too small?
+   if(int(dddata.count.size()) < CI.MinDDSeg) {
+      ed.remove = true;
+      return;
+   }
+
+      // prepare 'mark' vector
+   ed.mark.assign(dddata.count.size(),1);
+   ed.ngood = ed.mark.size();
+   ed.nbad = 0;
+
+      // remove points where bias had to be reset multiple times
+   k = EditDDResets(ddid, dddata, ed);
+   if(k || ed.ngood < CI.MinDDSeg) { ed.remove = true; return; }
+
+      // remove isolated points
+   k = EditDDIsolatedPoints(ddid, dddata, ed);
+   if(k || ed.ngood < CI.MinDDSeg) { ed.remove = true; return; }
+
+      // find and remove slips
+   if(CI.Frequency != 2) {                // L1
+      k = EditDDSlips(ddid, dddata, 1, ed);
+      if(k || ed.ngood < CI.MinDDSeg) { ed.remove = true; return; }
+   }
+   if(CI.Frequency != 1) {                // L2
+      k = EditDDSlips(ddid, dddata, 2, ed);
+      if(k || ed.ngood < CI.MinDDSeg) { ed.remove = true; return; }
+   }
+
+      // find and remove outliers
+   if(CI.Frequency != 2) {                // L1
+      k = EditDDOutliers(ddid, dddata, 1, ed);
+      if(k || ed.ngood < CI.MinDDSeg) { ed.remove = true; return; }
+   }
+   if(CI.Frequency != 1) {                // L2
+      k = EditDDOutliers(ddid, dddata, 2, ed);
+      if(k || ed.ngood < CI.MinDDSeg) { ed.remove = true; return; }
+   }
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_THROW(E); }
+catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
+}
+
 //------------------------------------------------------------------------------------
 // There is no provision in DDBase for resetting a bias. This would imply
 // solving for different biases (separated in time) for the same DDid.
 // Therefore, this routine simply deletes all but the largest unbroken segment
 // separated by resets.
-int EditDDResets(const DDid& ddid, DDData& dddata)
+int EditDDResets(const DDid& ddid, DDData& dddata, DDEdit& ed)
 {
 try {
    int j,iend;
@@ -289,13 +300,13 @@ try {
    // resets[0] will always be the initial count
    if(dddata.resets.size() <= 1) return 0;
 
-   oflog << " Warning - DD " << ddid << " had " << dddata.resets.size()-1
+   ed.log << " Warning - DD " << ddid << " had " << dddata.resets.size()-1
       << " resets between " << dddata.count[1]
       << " and " << dddata.count[dddata.count.size()-1] << " :";
    for(i=1; i<dddata.resets.size(); i++)
-      oflog << " " << dddata.count[dddata.resets[i]]
+      ed.log << " " << dddata.count[dddata.resets[i]]
          << "[" << dddata.resets[i] << "]";
-   oflog << endl;
+   ed.log << endl;
 
    //for(i=1; i<dddata.resets.size(); i++) {
    //   // difference in index
@@ -327,21 +338,21 @@ try {
       }
    }
 
-   if(CI.Verbose) oflog << " Delete data due to reset for DD " << ddid
+   if(CI.Verbose) ed.log << " Delete data due to reset for DD " << ddid
       << " in the range " << ibeg << " to " << iend << endl;
 
       // mark all points from beginning to just before the 'ibeg' reset
-   for(i=0; i<ibeg; i++) if(mark[i]==1) {
-      mark[i] = 0;
-      ngood--;
-      nbad++;
+   for(i=0; i<ibeg; i++) if(ed.mark[i]==1) {
+      ed.mark[i] = 0;
+      ed.ngood--;
+      ed.nbad++;
    }
 
       // mark all points from 'iend' reset to the end
-   for(i=iend; i<dddata.count.size(); i++) if(mark[i]==1) {
-      mark[i] = 0;
-      ngood--;
-      nbad++;
+   for(i=iend; i<dddata.count.size(); i++) if(ed.mark[i]==1) {
+      ed.mark[i] = 0;
+      ed.ngood--;
+      ed.nbad++;
    }
 
    return 0;
@@ -352,7 +363,7 @@ catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
 }
 
 //------------------------------------------------------------------------------------
-int EditDDIsolatedPoints(const DDid& ddid, DDData& dddata)
+int EditDDIsolatedPoints(const DDid& ddid, DDData& dddata, DDEdit& ed)
 {
 try {
    //if(CI.Verbose) oflog << "BEGIN EditDDIsolatedPoints()"
@@ -365,7 +376,7 @@ try {
 
    // loop over all counts
    // i is current (good) point, j is the next good point
-   i = 0; while(i<dddata.count.size() && mark[i]==0) i++;     // find first good pt
+   i = 0; while(i<dddata.count.size() && ed.mark[i]==0) i++;     // find first good pt
 
    gapfuture = CI.MaxGap;
    while(i < dddata.count.size()) {
@@ -373,17 +384,17 @@ try {
 
       // find next good pt
       j = i+1;
-      while(j < dddata.count.size() && mark[j]==0) j++;
+      while(j < dddata.count.size() && ed.mark[j]==0) j++;
 
       if(j < dddata.count.size()) gapfuture = dddata.count[j] - dddata.count[i];
       else                        gapfuture = CI.MaxGap;
 
       if(gappast >= CI.MaxGap && gapfuture >= CI.MaxGap) {
-         if(CI.Verbose) oflog << " Mark isolated " << ddid
+         if(CI.Verbose) ed.log << " Mark isolated " << ddid
             << " " << dddata.count[i] << endl;
-         mark[i] = 0;
-         ngood--;
-         nbad++;
+         ed.mark[i] = 0;
+         ed.ngood--;
+         ed.nbad++;
       }
 
       i = j;
@@ -397,7 +408,7 @@ catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
 }
 
 //------------------------------------------------------------------------------------
-int EditDDSlips(const DDid& ddid, DDData& dddata, int frequency)
+int EditDDSlips(const DDid& ddid, DDData& dddata, int frequency, DDEdit& ed)
 {
 try {
    int j,k,n,tddt,ii,iter;
@@ -428,7 +439,7 @@ try {
          // compute triple differences
          // j is the index of the previous good point
       for(k=0,j=-1,i=0; i<dddata.count.size(); i++) {
-         if(mark[i] == 0) {
+         if(ed.mark[i] == 0) {
             //oflog << "Data 1 marked at count " << dddata.count[i] << endl;
             continue;
          }
@@ -451,7 +462,7 @@ try {
             // look for slips
             // if frac > 0.2, call it a slip anyway and hope it will be combined
          if(fabs(slip) > tol) {  // || fslip > 0.2)
-            oflog << " Warning - DD " << ddid << " L" << frequency << fixed
+            ed.log << " Warning - DD " << ddid << " L" << frequency << fixed
                << " slip " << setprecision(3) << setw(8) << slip << " cycles, at "
                << printTime(tt," %4F %10.3g = %Y/%02m/%02d %2H:%02M:%6.3f")
                << " = count " << dddata.count[i] << " on iteration " << iter
@@ -464,12 +475,12 @@ try {
                slipsize[n-1] += slip;
                   // mark all points from old slip to pt before this as bad
                for(m=slipindex[n-1]; m<i; m++) {
-                  mark[m] = 0;
-                  ngood--;
-                  nbad++;
+                  ed.mark[m] = 0;
+                  ed.ngood--;
+                  ed.nbad++;
                }
                slipindex[n-1] = i;
-               oflog << " Warning - DD " << ddid << " L" << frequency << fixed
+               ed.log << " Warning - DD " << ddid << " L" << frequency << fixed
                      << " last two slips combined (iter " << iter << ")"
                      << endl;
             }
@@ -479,8 +490,8 @@ try {
             }
          }
 #endif
-         if(tddofs) {
-            tddofs << "TDS " << ddid << " L" << frequency << fixed
+         if(tddofs.is_open()) {
+            ed.tdd << "TDS " << ddid << " L" << frequency << fixed
                << " " << iter
                << " " << setw(4) << dddata.count[i]
                << " " << printTime(tt,"%4F %10.3g")
@@ -505,7 +516,7 @@ try {
          mad = Robust::MedianAbsoluteDeviation(&td[0], td.size(), median);
          mest = Robust::MEstimate(&td[0], td.size(), median, mad, &weights[0]);
 
-         oflog << " TUR " << ddid << " L" << frequency << fixed << setprecision(3)
+         ed.log << " TUR " << ddid << " L" << frequency << fixed << setprecision(3)
             << " " << iter
             << " " << setw(5) << tsstats.N()
             << " " << setw(7) << tsstats.AverageY()
@@ -534,7 +545,7 @@ try {
          // ii is slip count, k is current correction in cycles,
          // j is index of previous good point
       for(k=0,j=-1,ii=0,i=0; i<dddata.count.size(); i++) {
-         if(mark[i] == 0) {
+         if(ed.mark[i] == 0) {
             //oflog << "Data 2 marked at " << dddata.count[i] << endl;
             continue;
          }
@@ -542,7 +553,7 @@ try {
             // fix
          if((int)i == slipindex[ii]) {     // new slip on this count
             k += int(slipsize[ii] + (slipsize[ii]>0 ? 0.5 : -0.5));
-            if(CI.Verbose) oflog << " Fix L" << frequency << " slip at count "
+            if(CI.Verbose) ed.log << " Fix L" << frequency << " slip at count "
                << dddata.count[i]
                << " " << printTime(tt,"%4F %10.3g")
                << " total mag " << k << " iteration " << iter
@@ -555,8 +566,8 @@ try {
             else               dddata.DDL2[i] -= k * wl2;
          }
             // output the slip-edited DDs and TDs
-         if(tddofs) {
-            tddofs << "SED " << ddid << fixed
+         if(tddofs.is_open()) {
+            ed.tdd << "SED " << ddid << fixed
                << " L" << frequency
                << " " << iter
                << " " << setw(4) << dddata.count[i]
@@ -581,7 +592,7 @@ try {
    } // end for loop over iterations
 
       // failed - return non-zero to delete the whole segment
-   oflog << " Warning - Delete " << ddid << " L" << frequency
+   ed.log << " Warning - Delete " << ddid << " L" << frequency
       << ": unable to fix slips" << endl;
 
    return -1;
@@ -602,7 +613,7 @@ catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
 // ASWA CTRA G11 G14  T202B
 // ASWA CTRA G16 G25  T202D
 // ASWA CTRA G20 G25  T202D
-int EditDDOutliers(const DDid& ddid, DDData& dddata, int frequency)
+int EditDDOutliers(const DDid& ddid, DDData& dddata, int frequency, DDEdit& ed)
 {
 try {
    int i,j,n;
@@ -624,7 +635,7 @@ try {
 
          // pull out the good data, count it and ...
       for(M=0,i=0; i<len; i++) {
-         if(mark[i] == 0) continue;             // skip the bad points
+         if(ed.mark[i] == 0) continue;             // skip the bad points
 
          if(frequency == 1)
             dat[M] = dddata.DDL1[i] - dddata.DDER[i];
@@ -651,7 +662,7 @@ try {
 
          // print stats to log
       if(CI.Verbose) {
-         oflog << " SUR " << ddid << " L" << frequency << " " << iter
+         ed.log << " SUR " << ddid << " L" << frequency << " " << iter
             << fixed << setprecision(3)
             << " " << setw(5) << tsstats.N()
             << " " << setw(7) << tsstats.AverageY()
@@ -666,7 +677,7 @@ try {
          // only continue if the conditional sigma is high...
       if(tsstats.SigmaYX() <= tolsigyx) return 0; // success
 
-      oflog << " Warning - high sigma (" << iter << ") for "
+      ed.log << " Warning - high sigma (" << iter << ") for "
          << ddid << " L" << frequency << " : " << fixed
          << setprecision(3) << setw(7) << tsstats.SigmaYX() << endl;
 
@@ -675,7 +686,7 @@ try {
 
          // sigma stripping ... robust fit to quadratic is too slow...
       for(n=j=0,i=0; i<len; i++) {
-         if(mark[i] == 0) continue;              // skip the bad points
+         if(ed.mark[i] == 0) continue;              // skip the bad points
 
          //oflog << "HIS " << ddid
          //   << " L" << frequency << " " << setw(3) << i
@@ -685,15 +696,15 @@ try {
          //   << endl;
 
          if(fabs(dat[j]) > tolsigstrip*mad) {
-            if(CI.Verbose) oflog << " Warning - mark outlier " << ddid
+            if(CI.Verbose) ed.log << " Warning - mark outlier " << ddid
                << " L" << frequency << fixed << setprecision(3)
                << " count " << dddata.count[i]
                << " ddph " << dat[j]
                << " res/sig " << fabs(dat[j])/(tolsigstrip*mad)
                << endl;
-            mark[i] = 0;
-            ngood--;
-            nbad++;
+            ed.mark[i] = 0;
+            ed.ngood--;
+            ed.nbad++;
             n++;
          }
          j++;
@@ -702,7 +713,7 @@ try {
    }  // end iteration loop
 
       // failed - return non-zero to delete the whole segment
-   oflog << " Warning - Delete " << ddid << " L" << frequency
+   ed.log << " Warning - Delete " << ddid << " L" << frequency
       << " : unable to sigma strip" << endl;
 
    return -1;
@@ -728,7 +739,7 @@ try {
       // robust LS will return weights in data Vector = weights
    i = robfit.leastSquaresEstimation(weights,sol,cov,&LSPolyFunc);
    if(i) {
-      oflog << " Warning - outlier check: robust fit for " << ddid
+      ed.log << " Warning - outlier check: robust fit for " << ddid
          << " returned " << i << endl;
       if(i==-1) return i;     // underdetermined
       if(i==-2) return i;     // singular
@@ -750,11 +761,11 @@ try {
       // Loop over counts (epochs)
    for(j=0,i=0; i<len; i++) {
 
-      if(mark[i] == 0) continue;              // skip the bad points
+      if(ed.mark[i] == 0) continue;              // skip the bad points
 
       double resnorm = fabs(residuals[j]/stats.StdDev());
 
-      if(CI.Verbose) oflog << "FIT " << ddid    // TD debug?
+      if(CI.Verbose) ed.log << "FIT " << ddid    // TD debug?
          << " " << setw(3) << i
          << " " << setw(3) << dddata.count[i]
          << fixed << setprecision(3)
@@ -766,15 +777,15 @@ try {
          << endl;
 
       if(weights[j] <= 0.25 && resnorm > 4.0) {
-         if(CI.Verbose) oflog << " Warning - mark outlier " << ddid
+         if(CI.Verbose) ed.log << " Warning - mark outlier " << ddid
             << fixed << setprecision(3)
             << " count " << dddata.count[i]
             << " weight " << weights[j]
             << " res/sig " << resnorm
             << endl;
-         mark[i] = 0;
-         ngood--;
-         nbad++;
+         ed.mark[i] = 0;
+         ed.ngood--;
+         ed.nbad++;
       }
 
       j++;
@@ -91,65 +91,42 @@ try {
          st.RawDataBuffers.erase(Emptys[i]);    // erase map
 
          // remove isolated points (single points with gaps > CI.MaxGap on both sides
+         // gaps are measured to the previous point kept, and to the next point
       for(it=st.RawDataBuffers.begin(); it != st.RawDataBuffers.end(); it++) {
          RawData& rd=it->second;
-         vector<int>::iterator cit;
-         vector<double>::iterator ditL1=rd.L1.begin();
-         vector<double>::iterator ditL2=rd.L2.begin();
-         vector<double>::iterator ditP1=rd.P1.begin();
-         vector<double>::iterator ditP2=rd.P2.begin();
-         vector<double>::iterator ditS1=rd.S1.begin();
-         vector<double>::iterator ditS2=rd.S2.begin();
-         vector<double>::iterator ditER=rd.ER.begin();
-         vector<double>::iterator ditEL=rd.elev.begin();
-         vector<double>::iterator ditAZ=rd.az.begin();
-         cit = rd.count.begin();
-         while(cit != rd.count.end()) {
-            if(rd.count.size() == 1 ||       // single point
-                                             // or isolated point at begin
-               (cit == rd.count.begin() && *(cit+1) - *cit > CI.MaxGap) ||
-                                             // or isolated point at end
-               (cit+1 == rd.count.end() && *cit - *(cit-1) > CI.MaxGap) ||
-                                             // or isolated point not at either end
-               (cit+1 != rd.count.end() && cit != rd.count.begin() &&
-                  *(cit+1) - *cit > CI.MaxGap && *cit - *(cit-1) > CI.MaxGap))
+         const vector<int>& cnt(rd.count);
+         const size_t n(cnt.size());
+         vector<int> keep(n,1);
+         size_t k(0),nbad(0);
+         bool prev(false);                   // k is the previous point kept
+         for(i=0; i<n; i++) {
+            if((!prev || cnt[i] - cnt[k] > CI.MaxGap) &&
+               (i+1 == n || cnt[i+1] - cnt[i] > CI.MaxGap))
             {
                if(CI.Debug) {
                   oflog << "Found isolated point with ";
-                  if(cit != rd.count.begin())
-                     oflog << *cit - *(cit-1) << " pt gap before and ";
+                  if(prev)
+                     oflog << cnt[i] - cnt[k] << " pt gap before and ";
                   else
                      oflog << "begin pt before and ";
-                  if(cit+1 != rd.count.end())
-                     oflog << *(cit+1) - *cit << " pt gap after, ";
+                  if(i+1 != n)
+                     oflog << cnt[i+1] - cnt[i] << " pt gap after, ";
                   else
                      oflog << "end pt after, ";
-                  oflog << "at " << *cit << endl;
+                  oflog << "at " << cnt[i] << endl;
                }
-               cit = rd.count.erase(cit);    // cit now pts to the following element
-               ditL1 = rd.L1.erase(ditL1);
-               ditL2 = rd.L2.erase(ditL2);
-               ditP1 = rd.P1.erase(ditP1);
-               ditP2 = rd.P2.erase(ditP2);
-               ditS1 = rd.S1.erase(ditS1);
-               ditS2 = rd.S2.erase(ditS2);
-               ditER = rd.ER.erase(ditER);
-               ditEL = rd.elev.erase(ditEL);
-               ditAZ = rd.az.erase(ditAZ);
+               keep[i] = 0;
+               nbad++;
             }
             else {
-               cit++;
-               ditL1++;
-               ditL2++;
-               ditP1++;
-               ditP2++;
-               ditS1++;
-               ditS2++;
-               ditER++;
-               ditEL++;
-               ditAZ++;
+               k = i;
+               prev = true;
             }
          }
+         if(nbad > 0) rd.compact(keep);
+
+            // the buffers are complete; free the space left by their growth
+         rd.shrink();
       }
 
          // find the largest value of count
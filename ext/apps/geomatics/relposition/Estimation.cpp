@@ -51,6 +51,7 @@
 //------------------------------------------------------------------------------------
 // system includes
 #include <gnsstk/TimeString.hpp>
+#include <algorithm>
 
 // GNSSTk
 #include <gnsstk/Vector.hpp>
@@ -65,6 +66,7 @@
 
 // DDBase
 #include "DDBase.hpp"
+#include "BlockedNormals.hpp"
 #include "index.hpp"
 
 //------------------------------------------------------------------------------------
@@ -84,20 +86,33 @@ string ComposeName(const string& site1, const string& site2,
 string ComposeName(const DDid& ddid);
 void DecomposeName(const string& label, string& site1, string& site2,
                     GSatID& sat1, GSatID& sat2);
+int BiasStateIndex(const string& site1, const string& site2,
+                   const GSatID& sat1, const GSatID& sat2, int& sign);
    // called by Estimation() -- inside the loop
 int EditDDdata(int n);
 int ModifyState(int n);
 int InitializeEstimator(void);
 int aPrioriConstraints(void);
 int FillDataVector(int count);
+int EpochData(int count);
+void EpochCovariance(int count);
+double OneWayRange(int count, string& site, GSatID& sat, Position& SatR,
+                   double cosines[3], double& elev);
 void EvaluateLSEquation(int n, Vector<double>& X,Vector<double>& f,Matrix<double>& P);
 int MeasurementUpdate(Matrix<double>& P, Vector<double>& f, Matrix<double>& MC);
+int EliminateBiases(int count);
 int Solve(void);
 int UpdateNominalState(void);
 void OutputIterationResults(bool final);
 int IterationControl(int iter_n);
 void OutputFinalResults(int iret);
 double RMSResidualOfFit(int N, Vector<double>& dX, bool final=false);
+   // blocked estimator (--Blocked)
+void InitializeBlocked(void);
+int BlockedAPriori(Matrix<double>& apCov);
+int BlockedMeasurementUpdate(Matrix<double>& P, Vector<double>& f,
+                             Matrix<double>& W);
+int BlockedSolve(void);
 
 //------------------------------------------------------------------------------------
 // local data
@@ -105,10 +120,12 @@ static int N,M;                    // lengths of state and data
 static Namelist StateNL;           // state vector namelist
 static Vector<double> State;       // state vector
 static Vector<double> dX;          // update to state vector
-static Matrix<double> Cov;         // covariance matrix
+static Matrix<double> Cov;         // covariance matrix (non-bias states if Blocked)
+static Vector<double> Var;         // variances of the state = diagonal of Cov
 static Namelist DataNL;            // data vector namelist
 static Vector<double> Data;        // data vector
 static Matrix<double> MeasCov;     // measurement covariance matrix
+static Matrix<double> MeasInfo;    // inverse of MeasCov, if Blocked
 static Matrix<double> Partials;    // partials matrix
 static bool Biasfix;               // if true, fix estimated biases and solve for
                                    // position states only -- NB used widely!
@@ -117,9 +134,60 @@ static double small,big;           // condition number in inversion = big/small
 static int NEp,nDD;                // counters used in LS problem
 static int Mmax;                   // largest M (data size) encountered
 static int NState;                 // true length of the state vector
+static int NGlobal;                // number of non-bias states, first in the state
 static Vector<double> BiasState;   // save the solution for biases, before bias fixing
-static Matrix<double> BiasCov;     // save covariance for biases, before bias fixing
+static Vector<double> BiasVar;     // save variances for biases, before bias fixing
 static Vector<double> NominalState;// save the nominal state to output with solution
+static vector<int> DataBias;       // bias state index for each datum
+static vector<int> DataSign;       // sign (+-1) of that bias in each datum
+
+//------------------------------------------------------------------------------------
+// Cache of the per-epoch parts of the LS problem, filled on the first LLS iteration
+// and reused by later iterations and by RMSResidualOfFit(), unless --noCache.
+// Data, DataNL and MeasCov (or MeasInfo) do not depend on the state. MeasCov is
+// M x M, so only CacheCovMax elements of it, over all counts, are kept; for later
+// counts it is rebuilt on every iteration. The satellite position and clock at
+// transmit time depend on the station position only through the time of flight;
+// they are reused until the station has moved more than CacheMove meters, which
+// changes the range by less than 2e-5 of the move. The range, trop delay,
+// elevation and partials are always computed at the current station position.
+class OneWayCache
+{
+public:
+   bool set;               // SatR, clock and Rx have been computed
+   Position SatR;          // satellite position at transmit time (receive frame)
+   double clock;           // raw range minus corrected range
+   Position Rx;            // station position used to compute them
+   OneWayCache(void) : set(false) {}
+};
+
+class EpochCache
+{
+public:
+   bool filled;            // Data and DataNL are set
+   bool hasCov;            // MeasCov or MeasInfo is set
+   Vector<double> Data;
+   Namelist DataNL;
+   Matrix<double> MeasCov,MeasInfo;
+   map<OWid,OneWayCache> oneway;
+   EpochCache(void) : filled(false), hasCov(false) {}
+};
+
+static vector<EpochCache> Cache;   // indexed by count
+static const double CacheMove=1.0; // meters
+static const size_t CacheCovMax=16777216;  // elements of MeasCov cached (128MB)
+static size_t CacheCovSize;        // elements of MeasCov cached so far
+
+//------------------------------------------------------------------------------------
+// Blocked estimator (--Blocked). Rather than the SRI filter over the whole state,
+// accumulate normal equations (BlockedNormals) over the non-bias states plus the
+// biases of the DD series that are currently observed, eliminating each bias when
+// its DD series ends.
+
+static BlockedNormals Normals;           // normal equations of the active states
+static vector< pair<int,int> > BiasEnds; // (last count, bias state), sorted
+static size_t NextEnd;                   // next element of BiasEnds to eliminate
+static double BiasVar0;                  // a priori variance of the biases
 
 //------------------------------------------------------------------------------------
 // currently the estimation problem is designed like this:
@@ -206,15 +274,13 @@ try {
             // SolutionEpoch is needed by EvaluateLSEquation, and is used in output
          SolutionEpoch = FirstEpoch + curr*CI.DataInterval;
 
-            // get the data and the data namelist
-         M = FillDataVector(curr);
+            // get the data and the data namelist,
+            // and compute the measurement covariance matrix
+         M = EpochData(curr);
             // no data -- but don't assume this implies the last epoch
          if(M == 0) continue;
          nDD += M;
 
-            // compute the measurement covariance matrix
-         BuildStochasticModel(curr,DataNL,MeasCov);
-
             // get nominal data = NomData(nominal state) and partials
             // NB position components of state not used in here..
          EvaluateLSEquation(curr,State,NomData,Partials);
@@ -231,6 +297,9 @@ try {
             // update the SRI filter
          if((iret = MeasurementUpdate(Partials,RHS,MeasCov))) break;
 
+            // eliminate the biases of DD series that end here
+         if((iret = EliminateBiases(curr))) break;
+
          NEp++;
 
       }  // end while loop over data epochs
@@ -307,6 +376,11 @@ try {
       // define the initial State vector
    DefineStateVector();
 
+      // one (empty) cache entry per count
+   Cache.clear();
+   CacheCovSize = 0;
+   if(!CI.noCache) Cache.resize(maxCount+1);
+
       // initial value
    Biasfix = false;
 
@@ -347,6 +421,8 @@ try {
       }
    }
 
+   NGlobal = StateNL.size();
+
    // add bias states
    map<DDid,DDData>::iterator jt;
    for(jt=DDDataMap.begin(); jt != DDDataMap.end(); jt++) {
@@ -549,7 +625,10 @@ try {
          << N << ")" << endl;
    }
    dX.resize(N);
-   srif = SRIFilter(NL);
+   if(CI.Blocked)
+      InitializeBlocked();
+   else
+      srif = SRIFilter(NL);
 
       // save the nominal state for output with Solution (OutputIterationResults)
    NominalState = State;
@@ -574,8 +653,10 @@ int aPrioriConstraints(void)
 {
 try {
       // add initial constraints
-   Matrix<double> apCov(N,N,0.0);
-   Vector<double> apState(N,0.0);         // most states have apriori value = 0
+      // if Blocked, biases are constrained as they are added, in the estimator
+   int na(CI.Blocked ? NGlobal : N);
+   Matrix<double> apCov(na,na,0.0);
+   Vector<double> apState(na,0.0);        // most states have apriori value = 0
 
    int i,j,k;
    size_t n;
@@ -703,7 +784,8 @@ try {
       // TD need to constrain biases ... what is reasonable?
    if(!Biasfix) {
       ss = 0.25 * wave;
-      for(n=0; n<StateNL.size(); n++) {
+      BiasVar0 = ss*ss;
+      for(n=0; !CI.Blocked && n<StateNL.size(); n++) {
          string site1,site2;
          GSatID sat1,sat2;
          DecomposeName(StateNL.getName(n), site1, site2, sat1, sat2);
@@ -735,6 +817,8 @@ try {
    //}
 
       // add it to srif
+   if(CI.Blocked)
+      return BlockedAPriori(apCov);
    srif.addAPriori(apCov,apState);
 
    return 0;
@@ -757,7 +841,7 @@ try {
       // loop over the data
    map<DDid,DDData>::iterator it;
    for(i=0,it = DDDataMap.begin(); it != DDDataMap.end(); it++) {
-      j = index(it->second.count,count);
+      j = index_sorted(it->second.count,count);
       if(j == -1) continue;
       if(CI.Frequency == 1) Data(i) = it->second.DDL1[j];
       if(CI.Frequency == 2) Data(i) = it->second.DDL2[j];
@@ -786,6 +870,122 @@ catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_
 catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
 }
 
+//------------------------------------------------------------------------------------
+// called by Estimation() - inside the data loop, inside the iteration loop
+// Set Data, DataNL and MeasCov (and MeasInfo if Blocked) for this count, from the
+// cache if possible; return the number of data. If MeasCov is singular, MeasInfo
+// is left empty.
+int EpochData(int count)
+{
+try {
+   if(!CI.noCache && Cache[count].filled) {
+      EpochCache& ec(Cache[count]);
+      Data = ec.Data;
+      DataNL = ec.DataNL;
+      if(!ec.hasCov) {
+         if(Data.size() > 0) EpochCovariance(count);
+      }
+      else if(CI.Blocked) MeasInfo = ec.MeasInfo;
+      else                MeasCov = ec.MeasCov;
+      return Data.size();
+   }
+
+   int m = FillDataVector(count);
+   if(m > 0)
+      EpochCovariance(count);
+   else {
+      Data = Vector<double>();
+      DataNL.clear();
+   }
+
+   if(!CI.noCache) {
+      EpochCache& ec(Cache[count]);
+      ec.Data = Data;
+      ec.DataNL = DataNL;
+      ec.filled = true;
+      if(CacheCovSize + size_t(m*m) <= CacheCovMax) {
+         if(CI.Blocked) ec.MeasInfo = MeasInfo;
+         else           ec.MeasCov = MeasCov;
+         ec.hasCov = true;
+         CacheCovSize += size_t(m*m);
+      }
+   }
+
+   return m;
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_THROW(E); }
+catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
+}
+
+//------------------------------------------------------------------------------------
+// called by EpochData()
+// Build MeasCov (and MeasInfo if Blocked) for Data and DataNL at this count.
+void EpochCovariance(int count)
+{
+try {
+   BuildStochasticModel(count,DataNL,MeasCov);
+   if(CI.Blocked) {
+      try {
+         MeasInfo = inverse(MeasCov);
+      }
+      catch(SingularMatrixException& sme) {
+         MeasInfo = Matrix<double>();
+      }
+   }
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_THROW(E); }
+catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
+}
+
+//------------------------------------------------------------------------------------
+// called by EvaluateLSEquation()
+// Compute the corrected range from site to sat at SolutionEpoch (count), and return
+// the satellite position SatR, the direction cosines and the elevation.
+double OneWayRange(int count, string& site, GSatID& sat, Position& SatR,
+                   double cosines[3], double& elev)
+{
+try {
+   Station& st=Stations[site];
+
+   if(CI.noCache) {
+      CorrectedEphemerisRange CER;
+      double ER = CER.ComputeAtReceiveTime(SolutionEpoch,st.pos,sat,navLib,
+                                    NavSearchOrder::Nearest, SVHealth::Any,
+                                    NavValidityType::Any);
+      SatR.setECEF(CER.svPosVel.x[0],CER.svPosVel.x[1],CER.svPosVel.x[2]);
+      for(int i=0; i<3; i++) cosines[i] = CER.cosines[i];
+      elev = CER.elevation;
+      return ER;
+   }
+
+   OneWayCache& ow(Cache[count].oneway[OWid(site,sat)]);
+   if(!ow.set || range(ow.Rx,st.pos) > CacheMove) {
+      CorrectedEphemerisRange CER;
+      double ER = CER.ComputeAtReceiveTime(SolutionEpoch,st.pos,sat,navLib,
+                                    NavSearchOrder::Nearest, SVHealth::Any,
+                                    NavValidityType::Any);
+      ow.SatR.setECEF(CER.svPosVel.x[0],CER.svPosVel.x[1],CER.svPosVel.x[2]);
+      ow.clock = CER.rawrange - ER;
+      ow.Rx = st.pos;
+      ow.set = true;
+   }
+
+   SatR = ow.SatR;
+   double rawrange = range(st.pos,SatR);
+   cosines[0] = (st.pos.X()-SatR.X())/rawrange;
+   cosines[1] = (st.pos.Y()-SatR.Y())/rawrange;
+   cosines[2] = (st.pos.Z()-SatR.Z())/rawrange;
+   elev = st.pos.elevation(SatR);
+
+   return (rawrange - ow.clock);
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_THROW(E); }
+catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
+}
+
 //------------------------------------------------------------------------------------
 // called by Estimation() - inside the data loop, inside the iteration loop
 // Given a nominal state vector X, compute the function f(X) and the partials matrix
@@ -799,10 +999,9 @@ void EvaluateLSEquation(int count,              // count of current epoch
 try {
    int i,j,k,n,ntrop;
    size_t m;
-   double ER,trop,mapf;
+   double ER,trop,mapf,elev,cosines[3];
    string site1,site2;
    GSatID sat1,sat2;
-   CorrectedEphemerisRange CER;
    Position SatR;
 
    // Station.pos has been defined outside this routine in UpdateNominalState()
@@ -814,8 +1013,12 @@ try {
    }
 
       // loop over the data vector, computing f(X) and filling P
+      // if Blocked, P has no bias columns; DataBias and DataSign define them
+   int np(CI.Blocked ? NGlobal : N);
    f = Vector<double>(M,0.0);
-   P = Matrix<double>(M,N,0.0);
+   P = Matrix<double>(M,np,0.0);
+   DataBias.resize(M);
+   DataSign.resize(M);
    for(m=0; m<DataNL.size(); m++) {
 
          // break name into its parts
@@ -836,17 +1039,13 @@ try {
          }
       }
          // sat 1 -----------------------------------------------------
-         // should you use CER.rawrange here?
-      ER = CER.ComputeAtReceiveTime(SolutionEpoch,st1.pos,sat1,navLib,
-                                    NavSearchOrder::Nearest, SVHealth::Any,
-                                    NavValidityType::Any);
-      SatR.setECEF(CER.svPosVel.x[0],CER.svPosVel.x[1],CER.svPosVel.x[2]);
+      ER = OneWayRange(count,site1,sat1,SatR,cosines,elev);
       trop = st1.pTropModel->correction(st1.pos,SatR,SolutionEpoch);
       f(m) += ER+trop;
       if(!st1.fixed) {
-         P(m,i) += CER.cosines[0];
-         P(m,j) += CER.cosines[1];
-         P(m,k) += CER.cosines[2];
+         P(m,i) += cosines[0];
+         P(m,j) += cosines[1];
+         P(m,k) += cosines[2];
       }
          // trop rzd .. depends on site, sat and trop model
       if(CI.NRZDintervals > 0) {
@@ -856,26 +1055,23 @@ try {
                site1 + string("-RZD") + asString(ntrop));
             GNSSTK_THROW(e);
          }
-         mapf = st1.pTropModel->wet_mapping_function(CER.elevation);
+         mapf = st1.pTropModel->wet_mapping_function(elev);
          P(m,n) += mapf;
          f(m) += mapf * State(n);
       }
 
          // sat 2 -----------------------------------------------------
-      ER = CER.ComputeAtReceiveTime(SolutionEpoch,st1.pos,sat2,navLib,
-                                    NavSearchOrder::Nearest, SVHealth::Any,
-                                    NavValidityType::Any);
-      SatR.setECEF(CER.svPosVel.x[0],CER.svPosVel.x[1],CER.svPosVel.x[2]);
+      ER = OneWayRange(count,site1,sat2,SatR,cosines,elev);
       trop = st1.pTropModel->correction(st1.pos,SatR,SolutionEpoch);
       f(m) -= ER+trop;
       if(!st1.fixed) {
-         P(m,i) -= CER.cosines[0];
-         P(m,j) -= CER.cosines[1];
-         P(m,k) -= CER.cosines[2];
+         P(m,i) -= cosines[0];
+         P(m,j) -= cosines[1];
+         P(m,k) -= cosines[2];
       }
          // trop rzd .. depends on site, sat and trop model
       if(CI.NRZDintervals > 0) {
-         mapf = st1.pTropModel->wet_mapping_function(CER.elevation);
+         mapf = st1.pTropModel->wet_mapping_function(elev);
          P(m,n) += mapf;
          f(m) += mapf * State(n);
       }
@@ -892,16 +1088,13 @@ try {
          }
       }
          // sat 1 -----------------------------------------------------
-      ER = CER.ComputeAtReceiveTime(SolutionEpoch,st2.pos,sat1,navLib,
-                                    NavSearchOrder::Nearest, SVHealth::Any,
-                                    NavValidityType::Any);
-      SatR.setECEF(CER.svPosVel.x[0],CER.svPosVel.x[1],CER.svPosVel.x[2]);
+      ER = OneWayRange(count,site2,sat1,SatR,cosines,elev);
       trop = st2.pTropModel->correction(st2.pos,SatR,SolutionEpoch);
       f(m) -= ER+trop;
       if(!st2.fixed) {
-         P(m,i) -= CER.cosines[0];
-         P(m,j) -= CER.cosines[1];
-         P(m,k) -= CER.cosines[2];
+         P(m,i) -= cosines[0];
+         P(m,j) -= cosines[1];
+         P(m,k) -= cosines[2];
       }
          // trop rzd .. depends on site, sat and trop model
       if(CI.NRZDintervals > 0) {
@@ -911,55 +1104,40 @@ try {
                site2 + string("-RZD") + asString(ntrop));
             GNSSTK_THROW(e);
          }
-         mapf = st2.pTropModel->wet_mapping_function(CER.elevation);
+         mapf = st2.pTropModel->wet_mapping_function(elev);
          P(m,n) += mapf;
          f(m) += mapf * State(n);
       }
 
          // sat 2 -----------------------------------------------------
-      ER = CER.ComputeAtReceiveTime(SolutionEpoch,st2.pos,sat2,navLib,
-                                    NavSearchOrder::Nearest, SVHealth::Any,
-                                    NavValidityType::Any);
-      SatR.setECEF(CER.svPosVel.x[0],CER.svPosVel.x[1],CER.svPosVel.x[2]);
+      ER = OneWayRange(count,site2,sat2,SatR,cosines,elev);
       trop = st2.pTropModel->correction(st2.pos,SatR,SolutionEpoch);
       f(m) += ER+trop;
       if(!st2.fixed) {
-         P(m,i) += CER.cosines[0];
-         P(m,j) += CER.cosines[1];
-         P(m,k) += CER.cosines[2];
+         P(m,i) += cosines[0];
+         P(m,j) += cosines[1];
+         P(m,k) += cosines[2];
       }
          // trop rzd .. depends on site, sat and trop model
       if(CI.NRZDintervals > 0) {
-         mapf = st2.pTropModel->wet_mapping_function(CER.elevation);
+         mapf = st2.pTropModel->wet_mapping_function(elev);
          P(m,n) += mapf;
          f(m) += mapf * State(n);
       }
 
          // -----------------------------------------------------------
          // bias ------------------------------------------------------
-      j = 1;
-      i = StateNL.index(DataNL.getName(m));
-      if(i == -1) {
-         // but what if the bias is A-B_s-r and the data B-A_r-s?
-         // (Decompose was called at top of loop)
-         j = -1;
-         i = StateNL.index(ComposeName(site1,site2,sat2,sat1));      // most likely
-         if(i == -1) {
-            i = StateNL.index(ComposeName(site2,site1,sat1,sat2));
-            if(i == -1) {
-               j = 1;
-               i = StateNL.index(ComposeName(site2,site1,sat2,sat1));
-            }
-         }
-      }
+      i = BiasStateIndex(site1,site2,sat1,sat2,j);
       f(m) += j * State(i);
-      if(!Biasfix)
+      if(!Biasfix && !CI.Blocked)
          P(m,i) = j;
+      DataBias[m] = i;
+      DataSign[m] = j;
 
    }  // end loop over data
 
    f.resize(M);
-   P.resize(M,N);
+   P.resize(M,np);
 
 }
 catch(Exception& e) { GNSSTK_RETHROW(e); }
@@ -973,6 +1151,9 @@ int MeasurementUpdate(Matrix<double>& P, Vector<double>& f, Matrix<double>& MC)
 {
 try {
 
+   if(CI.Blocked)
+      return BlockedMeasurementUpdate(P,f,MeasInfo);
+
    srif.measurementUpdate(P,f,MC);
 
    return 0;
@@ -988,6 +1169,9 @@ int Solve(void)
 {
 try {
 
+   if(CI.Blocked)
+      return BlockedSolve();
+
    try {
       srif.getStateAndCovariance(dX,Cov,&small,&big);
    }
@@ -996,6 +1180,9 @@ try {
       return -2;                 // TD handle singular problems in Solve()
    }
 
+   Var = Vector<double>(N);
+   for(int i=0; i<N; i++) Var(i) = Cov(i,i);
+
    return 0;
 }
 catch(Exception& e) { GNSSTK_RETHROW(e); }
@@ -1020,7 +1207,7 @@ try {
    else {                  // regular update, save for when Biasfix is set
       State += dX;
       BiasState = State;
-      BiasCov = Cov;
+      BiasVar = Var;
    }
       // redefine the nominal position
       // set all floating position states to zero
@@ -1072,7 +1259,7 @@ try {
             << " " << f166 << NominalState[j]
             << " " << f166 << dX[j]
             << " " << f166 << State[j]
-            << " " << f166 << SQRT(Cov(j,j))
+            << " " << f166 << SQRT(Var(j))
             << endl;
    }
 
@@ -1252,6 +1439,37 @@ catch(Exception& e) { GNSSTK_RETHROW(e); }
 catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_THROW(E); }
 catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
 }
+//------------------------------------------------------------------------------------
+// Find the index in StateNL of the bias state for DD data site1-site2_sat1-sat2,
+// and the sign of that bias in the data.
+int BiasStateIndex(const string& site1,
+                   const string& site2,
+                   const GSatID& sat1,
+                   const GSatID& sat2,
+                   int& sign)
+{
+try {
+   int i;
+   sign = 1;
+   i = StateNL.index(ComposeName(site1,site2,sat1,sat2));
+   if(i == -1) {
+      // but what if the bias is A-B_s-r and the data B-A_r-s?
+      sign = -1;
+      i = StateNL.index(ComposeName(site1,site2,sat2,sat1));      // most likely
+      if(i == -1) {
+         i = StateNL.index(ComposeName(site2,site1,sat1,sat2));
+         if(i == -1) {
+            sign = 1;
+            i = StateNL.index(ComposeName(site2,site1,sat2,sat1));
+         }
+      }
+   }
+   return i;
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_THROW(E); }
+catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
+}
 
 //------------------------------------------------------------------------------------
 void OutputFinalResults(int iret)
@@ -1286,7 +1504,7 @@ try {
          if(site2.size() ==0 || sat1.id == -1 || sat2.id == -1) continue;
          oflog << StateNL.getName(k)
             << " " << f133 << BiasState(k)/wl1
-            << " " << f133 << SQRT(BiasCov(k,k))/wl1
+            << " " << f133 << SQRT(BiasVar(k))/wl1
             << endl;
       }
       oflog << endl;
@@ -1425,22 +1643,29 @@ try {
    while(1) {
       cnt++;
       if(cnt > maxCount) break;
-      Data = Vector<double>(Mmax,0.0);
-      DataNL.clear();
-      for(i=0,it=DDDataMap.begin(); it != DDDataMap.end(); it++) {
-         j = index(it->second.count,cnt);
-         if(j == -1) continue;
-         if(CI.Frequency == 1) Data(i) = it->second.DDL1[j];
-         if(CI.Frequency == 2) Data(i) = it->second.DDL2[j];
-         if(CI.Frequency == 3)      // ionosphere-free phase
-            Data(i) = if1p * it->second.DDL1[j] + if2p * it->second.DDL2[j];
-         lab = ComposeName(it->first);
-         DataNL += lab;
-         i++;
+      if(!CI.noCache) {       // Data and DataNL are cached
+         SolutionEpoch = FirstEpoch + cnt*CI.DataInterval;
+         M = EpochData(cnt);
+         if(M == 0) continue;
+      }
+      else {
+         Data = Vector<double>(Mmax,0.0);
+         DataNL.clear();
+         for(i=0,it=DDDataMap.begin(); it != DDDataMap.end(); it++) {
+            j = index_sorted(it->second.count,cnt);
+            if(j == -1) continue;
+            if(CI.Frequency == 1) Data(i) = it->second.DDL1[j];
+            if(CI.Frequency == 2) Data(i) = it->second.DDL2[j];
+            if(CI.Frequency == 3)      // ionosphere-free phase
+               Data(i) = if1p * it->second.DDL1[j] + if2p * it->second.DDL2[j];
+            lab = ComposeName(it->first);
+            DataNL += lab;
+            i++;
+         }
+         if(i==0) continue;      // no data -- don't assume this is the end
+         M = i;
+         Data.resize(M);
       }
-      if(i==0) continue;      // no data -- don't assume this is the end
-      M = i;
-      Data.resize(M);
 
       // SolutionEpoch is needed by EvaluateLSEquation
       SolutionEpoch = FirstEpoch + cnt*CI.DataInterval;
@@ -1479,5 +1704,143 @@ catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_
 catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
 }
 
+//------------------------------------------------------------------------------------
+// Blocked estimator (--Blocked)
+//------------------------------------------------------------------------------------
+// called by InitializeEstimator()
+// the non-bias states are always active, in the first NGlobal slots; find the
+// count at which each bias is last observed.
+void InitializeBlocked(void)
+{
+try {
+   int i,sign;
+   string site1,site2;
+   GSatID sat1,sat2;
+
+   Normals.reset(NState, NGlobal);
+   BiasEnds.clear();
+   NextEnd = 0;
+   if(Biasfix) return;
+
+      // more than one DDid may map to the same bias; use the latest count
+   map<int,int> ends;
+   map<DDid,DDData>::const_iterator it;
+   for(it=DDDataMap.begin(); it != DDDataMap.end(); it++) {
+      if(it->second.count.size() == 0) continue;
+      DecomposeName(ComposeName(it->first), site1, site2, sat1, sat2);
+      i = BiasStateIndex(site1,site2,sat1,sat2,sign);
+      if(i == -1) continue;
+      if(ends.find(i) == ends.end() || ends[i] < it->second.count.back())
+         ends[i] = it->second.count.back();
+   }
+   map<int,int>::const_iterator jt;
+   for(jt=ends.begin(); jt != ends.end(); jt++)
+      BiasEnds.push_back(make_pair(jt->second,jt->first));
+   sort(BiasEnds.begin(),BiasEnds.end());
+
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_THROW(E); }
+catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
+}
+
+//------------------------------------------------------------------------------------
+// called by aPrioriConstraints(); apCov covers the non-bias states only
+int BlockedAPriori(Matrix<double>& apCov)
+{
+try {
+   Matrix<double> apInfo;
+
+   try {
+      apInfo = inverse(apCov);
+   }
+   catch(SingularMatrixException& sme) {
+      oflog << "Problem is singular " << endl;
+      return -2;
+   }
+
+   Normals.setBiasVariance(BiasVar0);
+   Normals.addInformation(apInfo);
+
+   return 0;
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_THROW(E); }
+catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
+}
+
+//------------------------------------------------------------------------------------
+// called by MeasurementUpdate(); P holds the partials of the non-bias states, and
+// DataBias and DataSign the bias partials; W is the inverse of the measurement
+// covariance (MeasInfo). Add P'*W*P and P'*W*f to the normal equations, adding a
+// bias (with a priori) when it is first seen.
+int BlockedMeasurementUpdate(Matrix<double>& P, Vector<double>& f,
+                             Matrix<double>& W)
+{
+try {
+   if(W.rows() != f.size()) {             // MeasCov was singular
+      oflog << "Problem is singular " << endl;
+      return -2;
+   }
+
+   if(Biasfix)
+      Normals.update(P, f, W, vector<int>(), vector<int>());
+   else
+      Normals.update(P, f, W, DataBias, DataSign);
+
+   return 0;
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_THROW(E); }
+catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
+}
+
+//------------------------------------------------------------------------------------
+// called by Estimation() - inside the data loop, inside the iteration loop
+// If Blocked, eliminate from the normal equations the biases whose DD series end
+// at or before count, saving the eliminated rows for BlockedSolve().
+int EliminateBiases(int count)
+{
+try {
+   if(!CI.Blocked || Biasfix) return 0;
+
+   while(NextEnd < BiasEnds.size() && BiasEnds[NextEnd].first <= count) {
+      if(!Normals.eliminate(BiasEnds[NextEnd++].second)) {
+         oflog << "Problem is singular " << endl;
+         return -2;
+      }
+   }
+
+   return 0;
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_THROW(E); }
+catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
+}
+
+//------------------------------------------------------------------------------------
+// called by Solve()
+// Solve for the states still in the normal equations, then recover the eliminated
+// biases in reverse order. Variances are propagated back over T, the set of states
+// still needed by an earlier eliminated bias, so only a window of the covariance
+// is ever formed. Cov is left with the non-bias states; Var has all variances.
+int BlockedSolve(void)
+{
+try {
+   try {
+      Normals.solve(N, dX, Var, Cov);
+   }
+   catch(SingularMatrixException& sme) {
+      oflog << "Problem is singular " << endl;
+      return -2;
+   }
+
+   return 0;
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_THROW(E); }
+catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
+}
+
 //------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------
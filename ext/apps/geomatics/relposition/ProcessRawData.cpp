@@ -355,16 +355,7 @@ try {
       }
 
       // buffer the data -- keep parallel with count
-      jt->second.count.push_back(Count);
-      jt->second.L1.push_back(it->second.L1);
-      jt->second.L2.push_back(it->second.L2);
-      jt->second.P1.push_back(it->second.P1);
-      jt->second.P2.push_back(it->second.P2);
-      jt->second.ER.push_back(it->second.ER);
-      jt->second.S1.push_back(it->second.S1);
-      jt->second.S2.push_back(it->second.S2);
-      jt->second.elev.push_back(it->second.elev);
-      jt->second.az.push_back(it->second.az);
+      jt->second.push_back(Count, it->second);
    }
 
       // buffer the clock solution and the timetag offset, and
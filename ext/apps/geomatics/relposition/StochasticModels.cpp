@@ -137,7 +137,7 @@ try {
    int j;
    double cosine;
 
-   j = index(Stations[owid.site].RawDataBuffers[owid.sat].count,count);
+   j = index_sorted(Stations[owid.site].RawDataBuffers[owid.sat].count,count);
    if(j == -1) {
       ostringstream oss;
       oss << "Error -- count " << count << " not found in buffer for " << owid;
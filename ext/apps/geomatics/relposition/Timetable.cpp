@@ -45,6 +45,8 @@
 //------------------------------------------------------------------------------------
 // includes
 // system
+#include <algorithm>
+#include <atomic>
 #include <gnsstk/TimeString.hpp>
 #include <gnsstk/GPSWeekSecond.hpp>
 
@@ -93,9 +95,35 @@ public:
    friend bool startSort(const TTSegment& left, const TTSegment& right);
 };
 
+//------------------------------------------------------------------------------------
+// Interval index of the time table, used by QueryTimeTable(). For each baseline
+// the segments are sorted on usestart, with the running maximum of usestop, so the
+// segments containing a count are found by a binary search and a short backward
+// scan. order is the position in TimeTable, which breaks ties as did the linear
+// search of TimeTable; beg,end are the range of counts for the baseline.
+class TTEntry {
+public:
+   int usestart,usestop;   // counts used, as in TTSegment
+   int maxstop;            // maximum usestop of this and all earlier entries
+   size_t order;           // position in TimeTable
+   const TTSegment *seg;
+   bool operator<(const TTEntry& right) const
+      { return (usestart < right.usestart); }
+};
+
+class TTBaseline {
+public:
+   int beg,end;
+   vector<TTEntry> entries;
+   TTBaseline(void) : beg(-1), end(-1) {}
+};
+
 //------------------------------------------------------------------------------------
 // local data
 list<TTSegment> TimeTable;    // satellite time table
+map<string,TTBaseline> TTIndex; // index of TimeTable by baseline (TTKey())
+atomic<long> TTQueries;       // number of calls to QueryTimeTable(SDid,tt)
+atomic<long> TTQueryTime;     // clock() time spent in them, when CI.Verbose
 map<SDid,SDData> SDmap;       // map of SD data - not full single differences
 
 //------------------------------------------------------------------------------------
@@ -104,6 +132,8 @@ int ReadTimeTable(void);
 int ComputeBaselineTimeTable(const string& bl);
 int TTComputeSingleDifferences(const string& bl, const double ElevLimit);
 int TimeTableAlgorithm(list<TTSegment>& TTS, list<TTSegment>& TTab);
+string TTKey(const string& site1, const string& site2);
+void BuildTimeTableIndex(void);
 bool startSort(const TTSegment& left, const TTSegment& right);
 bool increasingMetricSort(const TTSegment& left, const TTSegment& right);
 bool decreasingMetricSort(const TTSegment& left, const TTSegment& right);
@@ -116,21 +146,36 @@ bool decreasingMetricSort(const TTSegment& left, const TTSegment& right);
 int QueryTimeTable(SDid& sdid, CommonTime& tt)
 {
 try {
+   clock_t qtime(CI.Verbose ? clock() : 0);
    int ntt(static_cast<int>(0.5+(tt-FirstEpoch)/CI.DataInterval));
-      // loop over the timetable, looking for a match : baseline and time
-   list<TTSegment>::iterator ttit;
-   for(ttit=TimeTable.begin(); ttit != TimeTable.end(); ttit++) {
-      if(((ttit->site1 == sdid.site1 && ttit->site2 == sdid.site2) ||
-          (ttit->site1 == sdid.site2 && ttit->site2 == sdid.site1)   ) &&
-          ttit->usestart <= ntt && ttit->usestop  >= ntt)
-      {                                                  // success
-         sdid.sat = ttit->sat;
-         tt = FirstEpoch+CI.DataInterval*ttit->usestop;
-         return 0;
+   const TTEntry *found(0);
+   TTQueries++;
+
+      // find the baseline, then the first (in TimeTable) segment containing ntt
+   map<string,TTBaseline>::const_iterator bit;
+   bit = TTIndex.find(TTKey(sdid.site1,sdid.site2));
+   if(bit != TTIndex.end()) {
+      const vector<TTEntry>& entries(bit->second.entries);
+      TTEntry key;
+      key.usestart = ntt;
+         // entries before it start at or before ntt
+      vector<TTEntry>::const_iterator it;
+      it = upper_bound(entries.begin(), entries.end(), key);
+      while(it != entries.begin()) {
+         --it;
+         if(it->maxstop < ntt) break;     // nothing earlier reaches ntt
+         if(it->usestop >= ntt && (!found || it->order < found->order))
+            found = &(*it);
       }
    }
 
-   return 1;      // failure
+   if(found) {                                           // success
+      sdid.sat = found->seg->sat;
+      tt = FirstEpoch+CI.DataInterval*found->usestop;
+   }
+   if(CI.Verbose) TTQueryTime += long(clock()-qtime);
+
+   return (found ? 0 : 1);
 }
 catch(Exception& e) { GNSSTK_RETHROW(e); }
 catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_THROW(E); }
@@ -145,15 +190,11 @@ try {
    string site1=word(baseline,0,'-');
    string site2=word(baseline,1,'-');
    beg = end = -1;
-      // loop over the timetable, looking for a match in baseline
-   list<TTSegment>::iterator ttit;
-   for(ttit=TimeTable.begin(); ttit != TimeTable.end(); ttit++) {
-      if((ttit->site1 == site1 && ttit->site2 == site2) ||
-         (ttit->site1 == site2 && ttit->site2 == site1)   )
-      {                                                  // success
-         if(beg == -1 || ttit->usestart < beg) beg = ttit->usestart;
-         if(end == -1 || ttit->usestop  > end) end = ttit->usestop;
-      }
+   map<string,TTBaseline>::const_iterator bit;
+   bit = TTIndex.find(TTKey(site1,site2));
+   if(bit != TTIndex.end()) {
+      beg = bit->second.beg;
+      end = bit->second.end;
    }
    return 0;
 }
@@ -162,6 +203,60 @@ catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_
 catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
 }
 
+//------------------------------------------------------------------------------------
+// Key of a baseline in TTIndex; the same for either order of the sites
+string TTKey(const string& site1, const string& site2)
+{
+   return (site1 < site2 ? site1 + "-" + site2 : site2 + "-" + site1);
+}
+
+//------------------------------------------------------------------------------------
+// Build TTIndex from TimeTable
+void BuildTimeTableIndex(void)
+{
+try {
+   size_t order(0);
+   list<TTSegment>::const_iterator ttit;
+   map<string,TTBaseline>::iterator bit;
+
+   TTIndex.clear();
+   TTQueries = 0;
+   TTQueryTime = 0;
+   for(ttit=TimeTable.begin(); ttit != TimeTable.end(); ttit++, order++) {
+      TTBaseline& tb(TTIndex[TTKey(ttit->site1,ttit->site2)]);
+      if(tb.beg == -1 || ttit->usestart < tb.beg) tb.beg = ttit->usestart;
+      if(tb.end == -1 || ttit->usestop  > tb.end) tb.end = ttit->usestop;
+
+      TTEntry te;
+      te.usestart = ttit->usestart;
+      te.usestop = te.maxstop = ttit->usestop;
+      te.order = order;
+      te.seg = &(*ttit);
+      tb.entries.push_back(te);
+   }
+
+   for(bit=TTIndex.begin(); bit != TTIndex.end(); bit++) {
+      vector<TTEntry>& entries(bit->second.entries);
+      stable_sort(entries.begin(), entries.end());
+      for(size_t i=1; i<entries.size(); i++)
+         entries[i].maxstop = max(entries[i].usestop, entries[i-1].maxstop);
+   }
+}
+catch(Exception& e) { GNSSTK_RETHROW(e); }
+catch(std::exception& e) { Exception E("std except: "+string(e.what())); GNSSTK_THROW(E); }
+catch(...) { Exception e("Unknown exception"); GNSSTK_THROW(e); }
+}
+
+//------------------------------------------------------------------------------------
+// Write the number of time table queries, and the time spent in them, to the log
+void TimeTableTiming(void)
+{
+   oflog << "Time table: " << TTQueries.load() << " queries on " << TimeTable.size()
+      << " segments and " << TTIndex.size() << " baselines took "
+      << fixed << setprecision(3)
+      << double(TTQueryTime.load())/double(CLOCKS_PER_SEC) << " seconds." << endl;
+}
+
 //------------------------------------------------------------------------------------
 int Timetable(void)
 {
@@ -202,6 +297,13 @@ try {
    }
 
    if(iret == 0) {
+      clock_t itime(clock());
+      BuildTimeTableIndex();
+      if(CI.Verbose) oflog << "Time table index of " << TimeTable.size()
+         << " segments on " << TTIndex.size() << " baselines built in "
+         << fixed << setprecision(3)
+         << double(clock()-itime)/double(CLOCKS_PER_SEC) << " seconds." << endl;
+
       // write out timetable to log
       // REF site site sat week use_start use_stop data_start data_stop
       CommonTime tt;
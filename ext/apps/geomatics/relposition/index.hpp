@@ -44,10 +44,13 @@
 #ifndef INDEX_ROUTINE_INCLUDE
 #define INDEX_ROUTINE_INCLUDE
 
+#include <vector>
+#include <algorithm>
+
 //------------------------------------------------------------------------------------
 // find the index of first occurance of item t (of type T) in vector<T> v;
 // i.e. j = index(v,t); implies v[j] == t. Return -1 if t is not found.
-template<class T> int index(const std::vector<T> v, const T& t)
+template<class T> int index(const std::vector<T>& v, const T& t)
 {
    for(size_t i=0; i<v.size(); i++) {
       if(v[i] == t) return i;
@@ -55,6 +58,15 @@ template<class T> int index(const std::vector<T> v, const T& t)
    return -1;
 }
 
+// same as index(), but for a vector<T> v that is sorted in increasing order;
+// uses a binary search.
+template<class T> int index_sorted(const std::vector<T>& v, const T& t)
+{
+   typename std::vector<T>::const_iterator it = std::lower_bound(v.begin(),v.end(),t);
+   if(it == v.end() || !(*it == t)) return -1;
+   return int(it - v.begin());
+}
+
 /*
 // find the index of first occurance of item t (of type T) in vector<T> v;
 // i.e. j = index(v,t); implies v[j] == t. Return -1 if t is not found.
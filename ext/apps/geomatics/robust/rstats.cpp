@@ -50,6 +50,10 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <complex>
+#include <cstring>
+#include <cstdlib>
 // GNSSTk
 #include <gnsstk/Exception.hpp>
 #include <gnsstk/StringUtils.hpp>
@@ -77,6 +81,7 @@ using namespace StringUtils;
 
 //------------------------------------------------------------------------------------
 // prototypes
+class QuantileSketch;
 /**
  * @throw Exception
  */
@@ -89,6 +94,14 @@ int Prepare(void);
  * @throw Exception
  */
 int ReadAndCompute(void);
+void ReadText(istream& is, unsigned int& nd, unsigned int& nxd);
+void ReadBinary(istream& is);
+void AddDatum(double d, double x, double w);
+void ParseLine(const char *b, const char *e, vector<const char *>& wbeg,
+               vector<const char *>& wend, unsigned int& nd, unsigned int& nxd);
+void StreamDatum(double d, double x, double w);
+void StreamReport(const string& tag, const Stats<double>& stats,
+                  const QuantileSketch& qs);
 
 /**
  * @throw Exception
@@ -152,6 +165,117 @@ int Outliers(void);
  */
 int DumpData(string msg=string("DUMP"));
 
+//------------------------------------------------------------------------------------
+// Mergeable quantile sketch, for --stream. Level h holds items of weight 2^h; when
+// a level reaches k items it is sorted and every other item (alternating offset)
+// is promoted to level h+1, so memory is O(k log2(n/k)) for n data. A compaction
+// at level h changes the rank of any value by at most 2^h; these are summed, so
+// RankError() is a hard bound on |rank error|/n of every quantile, about
+// log2(n/k)/k (0.2% for k=4096 and n=3e6, 0.5% for n=1e9), and zero (exact)
+// while n < k; actual errors are typically much smaller.
+// MAD() is the median of |x-med| over the items, so its rank error is within
+// twice that of the quantiles.
+class QuantileSketch {
+public:
+   QuantileSketch(size_t k=4096) : K(k), N(0), err(0.0) {}
+
+   void Add(double x)
+   {
+      if(levels.empty()) Grow(1);
+      levels[0].push_back(x);
+      N++;
+      if(levels[0].size() >= K) Compact(0);
+   }
+
+   // add the items of another sketch; the error bounds add
+   void Merge(const QuantileSketch& qs)
+   {
+      if(levels.size() < qs.levels.size()) Grow(qs.levels.size());
+      for(size_t h=0; h<qs.levels.size(); h++)
+         levels[h].insert(levels[h].end(), qs.levels[h].begin(), qs.levels[h].end());
+      N += qs.N;
+      err += qs.err;
+      for(size_t h=0; h<levels.size(); h++)
+         if(levels[h].size() >= K) Compact(h);
+   }
+
+   void Clear(void) { levels.clear(); flip.clear(); N = 0; err = 0.0; }
+
+   unsigned long Count(void) const { return N; }
+
+   double RankError(void) const { return (N > 0 ? err/double(N) : 0.0); }
+
+   // quantile q in [0,1], interpolated between ranks as Robust::Median()
+   double Quantile(double q) const
+   {
+      vector<pair<double,double> > items;
+      Items(items, false, 0.0);
+      return RankValue(items, q*double(N-1));
+   }
+
+   // median absolute deviation about med
+   double MAD(double med) const
+   {
+      vector<pair<double,double> > items;
+      Items(items, true, med);
+      return RankValue(items, 0.5*double(N-1));
+   }
+
+private:
+   size_t K;                           // capacity of each level
+   unsigned long N;                    // number of data added
+   double err;                         // bound on rank error (count)
+   vector< vector<double> > levels;    // items at each level
+   vector<unsigned char> flip;         // offset of the next compaction
+
+   void Grow(size_t n) { levels.resize(n); flip.resize(n, 0); }
+
+   void Compact(size_t h)
+   {
+      if(levels.size() == h+1) Grow(h+2);
+      vector<double>& v(levels[h]), &up(levels[h+1]);
+      sort(v.begin(), v.end());
+      const size_t n(v.size() & ~size_t(1));    // an odd item stays
+      for(size_t i=flip[h]; i<n; i+=2) up.push_back(v[i]);
+      v.erase(v.begin(), v.begin()+n);
+      flip[h] ^= 1;
+      err += ldexp(1.0, int(h));
+      if(up.size() >= K) Compact(h+1);
+   }
+
+   // all (value, weight) sorted by value; if dev, value is |value-med|
+   void Items(vector<pair<double,double> >& items, bool dev, double med) const
+   {
+      double w(1.0);
+      for(size_t h=0; h<levels.size(); h++, w *= 2.0)
+         for(size_t i=0; i<levels[h].size(); i++)
+            items.push_back(make_pair(dev ? fabs(levels[h][i]-med)
+                                          : levels[h][i], w));
+      sort(items.begin(), items.end());
+   }
+
+   // value at (fractional, 0-based) rank r of sorted weighted items
+   static double RankValue(const vector<pair<double,double> >& items, double r)
+   {
+      if(items.empty()) return 0.0;
+      const double r0(floor(r)), f(r-r0);
+      const double v0(AtRank(items, r0));
+      if(f == 0.0) return v0;
+      return v0 + f*(AtRank(items, r0+1.0)-v0);
+   }
+
+   static double AtRank(const vector<pair<double,double> >& items, double k)
+   {
+      double cum(0.0);
+      for(size_t i=0; i<items.size(); i++) {
+         cum += items[i].second;
+         if(cum > k) return items[i].first;
+      }
+      return items.back().first;
+   }
+
+}; // end class QuantileSketch
+
 //------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------
 // Class GlobalData encapsulates global static data.
@@ -176,6 +300,9 @@ public:
 
    // input
    int col,xcol,wcol;
+   int binary;                         // input is binary doubles, this many per row
+   bool doStream;                      // single pass, constant memory
+   int streamN;                        // --stream: report every streamN data
    double xbeg,xend,dmin,dmax;
    bool doxbeg,doxend,dodmin,dodmax;
    string begstr,endstr,minstr,maxstr; // use strings so no default shows
@@ -217,6 +344,9 @@ public:
    bool doWNJ,doFFT;                   // white noise jerk, FFT
    double wnjpom;                      // WNJ process/measurement noise ratio
    double dtfft;                       // dt for FFT
+   bool doDFT;                         // use the DFT, not the FFT (reference)
+   int welchN;                         // Welch segment length, 0 for none
+   string fftwin;                      // window for FFT: rect,hann,hamming,blackman
 
    // output
    bool quiet;                         // suppress title, timing and other output
@@ -245,6 +375,9 @@ public:
    TwoSampleStats<double> tsstats;
    // robust
    double median,mad,mest,Q1,Q3,KS;
+   // --stream: sketch of all data, and stats and sketch of the current interval
+   QuantileSketch sketch,intsketch;
+   Stats<double> intstats;
 
    // results
    std::string msg;                    // msg for output
@@ -262,6 +395,9 @@ private:
       // input
       col = 1;
       xcol = wcol = -1;
+      binary = 0;
+      doStream = false;
+      streamN = 0;
       doxbeg = doxend = dodmin = dodmax = false;
       begstr = endstr = minstr = maxstr = string("");
       debstr = string("");
@@ -302,6 +438,10 @@ private:
          fixlim = 0.8;
          fixsig = 0.2;
       }
+      // other
+      doDFT = false;
+      welchN = 0;
+      fftwin = string("rect");
       // output
       outstr = string("");
       dostdout = quiet = nostats = doKS = doOuts = false;
@@ -490,6 +630,11 @@ try {
             "also read 'x' data in this column [-x]");
    opts.Add(0, "wt", "c", false, req, &GD.wcol, "",
             "weight with fabs() of data in this column [-wt]");
+   opts.Add(0, "binary", "n", false, req, &GD.binary, "",
+            "input is binary (native) doubles, n per row; columns are -y -x --wt");
+   opts.Add(0, "stream", "n", false, req, &GD.streamN, "",
+            "read in one pass and constant memory, with approximate robust stats;\n"
+            +pad+"  also output stats of every n data (0: at end only)");
 
    // modify input
    opts.Add(0, "beg", "xb", false, req, &GD.begstr, "\n# modify input:",
@@ -548,6 +693,13 @@ try {
             "compute FFT with dt [dt=0 => compute dt from xdata] NB beware -p\n"
             +pad+"  e.g. rstats testfft.data -x 1 -y 9 --fft 0.0034722 |\n"
             +pad+"       plotrfft -o2 'set xr [0:25]'");
+   opts.Add(0, "window", "w", false, req, &GD.fftwin, "",
+            "taper the --fft data with window w (rect,hann,hamming,blackman)");
+   opts.Add(0, "welch", "n", false, req, &GD.welchN, "",
+            "--fft: average the spectra of segments of n points, overlapping n/2;"
+            " n must be less than the number of points");
+   opts.Add(0, "dft", "", false, req, &GD.doDFT, "",
+            "--fft: use the (slow) discrete Fourier transform, for reference");
    opts.Add(0, "KS", "", false, req, &GD.doKS, "",
             "also output the Anderson-Darling statistic, a KS-test,\n"
             +pad+"  where AD > 0.752 implies non-normal");
@@ -737,6 +889,36 @@ try {
       }
    }
 
+   // binary input
+   if(opts.count("binary") > 0) {
+      if(GD.binary < 1)
+         oss << " Error - invalid argument to --binary " << GD.binary << "\n";
+      else if(GD.col > GD.binary || GD.xcol > GD.binary || GD.wcol > GD.binary)
+         oss << " Error - --binary " << GD.binary
+            << " has too few columns for -y, -x or --wt\n";
+   }
+
+   // stream - only the stats
+   GD.doStream = (opts.count("stream") > 0);
+   if(GD.doStream) {
+      if(GD.streamN < 0)
+         oss << " Error - invalid argument to --stream " << GD.streamN << "\n";
+      if(GD.doStemLeaf || GD.doQplot || GD.doBin || GD.doSum || GD.doSumPlus
+            || GD.doFit || GD.doSeq || GD.doDisc || GD.doFDF || GD.doFDF2
+            || GD.doWF || GD.doXWF || GD.doFixF || GD.doWNJ || GD.doFFT
+            || GD.doKS || GD.doOuts || GD.nostats)
+         oss << " Error - --stream keeps no data, and allows only the stats output\n";
+   }
+
+   // fft
+   if(GD.doFFT) {
+      if(GD.fftwin != "rect" && GD.fftwin != "hann" && GD.fftwin != "hamming"
+            && GD.fftwin != "blackman")
+         oss << " Error - invalid argument to --window " << GD.fftwin << "\n";
+      if(opts.count("welch") > 0 && GD.welchN < 2)
+         oss << " Error - invalid argument to --welch " << GD.welchN << "\n";
+   }
+
    // window filters
    if(GD.doWF || GD.doXWF) {
       fields = split((GD.doWF ? GD.windstr : GD.xwindstr),',');
@@ -762,6 +944,8 @@ try {
       if(GD.wcol > -1) GD.bw = true;
       if(GD.xcol > -1) GD.b2 = true;
    }
+   // --stream keeps no data, so there are no robust weights
+   if(GD.doStream) GD.brw = false;
 
    // set quiet when brief
    GD.quiet = (GD.quiet || GD.brief || GD.bc || GD.br || GD.bw || GD.brw || GD.b2);
@@ -846,7 +1030,7 @@ try {
    // open input file -------------------------------------------
    istream *pin;
    if(GD.inputfile != string("stdin")) {
-      pin = new ifstream(GD.inputfile.c_str());
+      pin = new ifstream(GD.inputfile.c_str(), ios::in | ios::binary);
       if(pin->fail()) {
          delete pin;
          cout << "Could not open file " << GD.inputfile << " .. abort.\n";
@@ -859,92 +1043,54 @@ try {
 
    // read input file -------------------------------------------
    unsigned int i,nd(0),nxd(0);
-   {
-      int j;                              // not unsigned!
-      double d,x(-1.0),w(-1.0),bias;
-      string line;
-      vector<string> words;
-      while(1) {
-         getline(*pin,line);
-         if(pin->eof() || !pin->good()) break;
-
-         StringUtils::stripLeading(line," ");
-         if(line[0] == '#') continue;
-
-         StringUtils::stripTrailing(line,"\n");
-         StringUtils::stripTrailing(line,"\r");
-         StringUtils::stripTrailing(line," ");
-         StringUtils::change(line,"\t"," ");
-
-         if(line.empty()) continue;
-
-         words = StringUtils::split(line,' ');
-         j = words.size();
-
-         //cout << "LINE (" << j << ") " << line << endl;
-
-         // check input   NB col numbers start at 1, indexes start at 0
-         if(j == 0) continue;
-         if(GD.col > j) { nd++; continue; }
-         if(GD.xcol > j) { nxd++; continue; }
-         if(GD.wcol > j) continue;
-         if(!(isScientificString(words[GD.col-1]))) { nd++; continue; }
-         if(GD.xcol > -1 && !(isScientificString(words[GD.xcol-1])))
-               { nd++; continue; }
-         if(GD.wcol > -1 && !(isScientificString(words[GD.wcol-1]))) continue;
-
-         // user limits on data
-         d = asDouble(words[GD.col-1]);
-         if(GD.dodmin && d < GD.dmin) continue;
-         if(GD.dodmax && d > GD.dmax) continue;
-
-         if(GD.xcol > -1) {
-            x = asDouble(words[GD.xcol-1]);
-            // user limits on x
-            if(GD.doxbeg && x < GD.xbeg) continue;
-            if(GD.doxend && x > GD.xend) continue;
-         }
-         if(GD.wcol > -1)
-            w = asDouble(words[GD.wcol-1]);
-
-         // debias
-         if(GD.debias0 && GD.data.size() == 0) { GD.debias = d; GD.dodebias = true; }
-         if(GD.dodebias) d -= GD.debias;
-
-         //cout << "READ " << i << " " << d << " " << x << endl;
-         GD.data.push_back(d);
-         if(GD.xcol > -1) GD.xdata.push_back(x);
-         if(GD.wcol > -1) GD.wdata.push_back(w);
+   if(GD.binary > 0) ReadBinary(*pin);
+   else              ReadText(*pin, nd, nxd);
 
-      }
+   if(pin != &cin) {
+      ((ifstream *)pin)->close();
+      delete pin;
+   }
 
-      if(pin != &cin) {
-         ((ifstream *)pin)->close();
-         delete pin;
-      }
+   // stream: stats were accumulated as read; report the last interval
+   if(GD.doStream && GD.intsketch.Count() > 0) {
+      StreamReport("int", GD.intstats, GD.intsketch);
+      GD.sketch.Merge(GD.intsketch);
+      GD.intsketch.Clear();
+      GD.intstats.Reset();
    }
 
    // check that input is good ----------------------------------
-   if(GD.data.size() < 2) {
-      cout << "Abort: not enough data: " << GD.data.size() << " data read";
+   const unsigned N(GD.doStream ? GD.cstats.N() : GD.data.size());
+   const unsigned NX(GD.doStream ? GD.tsstats.N() : GD.xdata.size());
+   if(N < 2) {
+      cout << "Abort: not enough data: " << N << " data read";
       if(nd > 0) cout << " [data(col) not found on " << nd << " lines]";
       if(nxd > 0) cout << " [data(xcol) not found on " << nxd << " lines]";
       cout << endl;
       return 5;
    }
-   if(GD.xcol != -1 && GD.xdata.size() == 0) {
+   if(GD.xcol != -1 && NX == 0) {
       cout << "Abort: No data found in 'x' column." << endl;
       return 5;
    }
-   if(nd > GD.data.size()/2)
+   if(nd > N/2)
       cout << "Warning: data(col) not found on " << nd << " lines" << endl;
-   if(nxd > GD.xdata.size()/2)
+   if(nxd > NX/2)
       cout << "Warning: data(xcol) not found on " << nxd << " lines" << endl;
 
-   if(GD.verbose) cout << "Found " << GD.data.size() << " data.\n";
+   if(GD.verbose) cout << "Found " << N << " data.\n";
+
+   // stream: approximate robust stats from the sketch ----------
+   if(GD.doStream) {
+      GD.median = GD.sketch.Quantile(0.5);
+      GD.mad = GD.sketch.MAD(GD.median);
+      GD.Q1 = GD.sketch.Quantile(0.25);
+      GD.Q3 = GD.sketch.Quantile(0.75);
+      GD.mest = GD.median;
+      return 0;
+   }
 
    // compute stats ---------------------------------------------
-   const unsigned N(GD.data.size());
    for(i=0; i<N; i++) {
       GD.cstats.Add(GD.data[i]);
       if(GD.xcol > -1) GD.tsstats.Add(GD.xdata[i],GD.data[i]);
@@ -974,6 +1120,212 @@ try {
 catch(Exception& e) { GNSSTK_RETHROW(e); }
 }
 
+//------------------------------------------------------------------------------------
+// apply the user limits and debias to data d (with x and weight w), and save it
+void AddDatum(double d, double x, double w)
+{
+   GlobalData& GD=GlobalData::Instance();
+
+   // user limits on data
+   if(GD.dodmin && d < GD.dmin) return;
+   if(GD.dodmax && d > GD.dmax) return;
+
+   // user limits on x
+   if(GD.xcol > -1) {
+      if(GD.doxbeg && x < GD.xbeg) return;
+      if(GD.doxend && x > GD.xend) return;
+   }
+
+   // debias
+   if(GD.debias0 && (GD.doStream ? GD.cstats.N() : GD.data.size()) == 0)
+      { GD.debias = d; GD.dodebias = true; }
+   if(GD.dodebias) d -= GD.debias;
+
+   if(GD.doStream) { StreamDatum(d, x, w); return; }
+
+   GD.data.push_back(d);
+   if(GD.xcol > -1) GD.xdata.push_back(x);
+   if(GD.wcol > -1) GD.wdata.push_back(w);
+}
+
+//------------------------------------------------------------------------------------
+// --stream: accumulate datum d (x, w) without saving it; every GD.streamN data
+// output the stats of the interval and merge its sketch into the total
+void StreamDatum(double d, double x, double w)
+{
+   GlobalData& GD=GlobalData::Instance();
+
+   GD.cstats.Add(d);
+   if(GD.xcol > -1) GD.tsstats.Add(x,d);
+   if(GD.wcol > -1) GD.wstats.Add(d,w);
+
+   if(GD.streamN == 0) { GD.sketch.Add(d); return; }
+
+   GD.intstats.Add(d);
+   GD.intsketch.Add(d);
+   if(GD.intstats.N() >= (unsigned int)(GD.streamN)) {
+      StreamReport("int", GD.intstats, GD.intsketch);
+      GD.sketch.Merge(GD.intsketch);
+      GD.intsketch.Clear();
+      GD.intstats.Reset();
+   }
+}
+
+//------------------------------------------------------------------------------------
+// --stream: one line of conventional and (approximate) robust stats; RErr is the
+// bound on the rank error of the quantiles, as a fraction of N
+void StreamReport(const string& tag, const Stats<double>& stats,
+                  const QuantileSketch& qs)
+{
+   GlobalData& GD=GlobalData::Instance();
+   string label(GD.label.empty() ? "" : " "+GD.label);
+   const double med(qs.Quantile(0.5));
+
+   cout << fixed << setprecision(GD.prec);
+   cout << "rstats(" << tag << "):" << label
+      << " N " << setw(GD.width) << stats.N()
+      << "  Ave " << setw(GD.width) << stats.Average()
+      << "  Std " << setw(GD.width) << stats.StdDev()
+      << "  Min " << setw(GD.width) << stats.Minimum()
+      << "  Max " << setw(GD.width) << stats.Maximum()
+      << "  Med " << setw(GD.width) << med << "  MAD " << qs.MAD(med)
+      << "  Q1 " << setw(GD.width) << qs.Quantile(0.25)
+      << "  Q3 " << setw(GD.width) << qs.Quantile(0.75)
+      << "  RErr " << scientific << setprecision(1) << qs.RankError();
+   if(GD.dodebias) cout << "  Bias " << fixed << setprecision(GD.prec) << GD.debias;
+   cout << fixed << setprecision(GD.prec) << endl;
+}
+
+//------------------------------------------------------------------------------------
+// if the word [b,e) is a number (cf. isScientificString()), set v to its value
+// (as asDouble()) and return true
+bool ScientificWord(const char *b, const char *e, double& v)
+{
+   const char *p(b), *x(b);
+   while(x < e && *x != 'e' && *x != 'E' && *x != 'd' && *x != 'D') x++;
+
+   // mantissa: sign, digits and at most one '.'
+   bool dot(false);
+   if(p < x && (*p == '+' || *p == '-')) p++;
+   for( ; p < x; p++) {
+      if(*p == '.') { if(dot) return false; dot = true; }
+      else if(!isdigit(*p)) return false;
+   }
+   // exponent: sign and digits
+   if(x < e) {
+      p = x+1;
+      if(p < e && (*p == '+' || *p == '-')) p++;
+      for( ; p < e; p++) if(!isdigit(*p)) return false;
+   }
+
+   v = strtod(b, 0);          // stops at the white space that ends the word
+   return true;
+}
+
+//------------------------------------------------------------------------------------
+// read text input, in blocks, parsing only the wanted columns of each line in
+// place. Lines are treated as by getline(), strip, split and asDouble(): '#'
+// lines are comments, words are separated by blanks and tabs; nd and nxd count
+// lines without data in col or xcol. As with getline() a final line with no
+// newline is not read. With --stream read a line at a time, so that data from a
+// live pipe is used as it arrives.
+void ReadText(istream& is, unsigned int& nd, unsigned int& nxd)
+{
+   GlobalData& GD=GlobalData::Instance();
+   const size_t BLOCK(1<<20);
+   const int ncol(max(GD.col, max(GD.xcol, GD.wcol)));
+   vector<const char *> wbeg(ncol), wend(ncol);
+   vector<char> buf;
+   size_t have(0);
+
+   if(GD.doStream) {
+      string line;
+      while(getline(is,line) && !is.eof())
+         ParseLine(line.data(), line.data()+line.size(), wbeg, wend, nd, nxd);
+      return;
+   }
+
+   while(1) {
+      buf.resize(have+BLOCK);
+      is.read(&buf[have], BLOCK);
+      size_t got(is.gcount());
+      if(got == 0) break;
+      have += got;
+
+      // parse each complete line
+      const char *p(&buf[0]), *end(&buf[0]+have), *nl;
+      for( ; (nl = (const char *)memchr(p, '\n', end-p)) != 0; p = nl+1)
+         ParseLine(p, nl, wbeg, wend, nd, nxd);
+
+      // keep the partial line
+      have = end-p;
+      memmove(&buf[0], p, have);
+      if(!is.good()) break;
+   }
+}
+
+//------------------------------------------------------------------------------------
+// parse the line [b,e) (no newline) in place, using wbeg,wend (size ncol) to hold
+// the words, and add its datum; see ReadText()
+void ParseLine(const char *b, const char *e, vector<const char *>& wbeg,
+               vector<const char *>& wend, unsigned int& nd, unsigned int& nxd)
+{
+   GlobalData& GD=GlobalData::Instance();
+   const int ncol(wbeg.size());
+
+   while(b < e && *b == ' ') b++;
+   if(b < e && *b == '#') return;
+   while(e > b && e[-1] == '\r') e--;
+   while(e > b && e[-1] == ' ') e--;
+
+   // find the first ncol words
+   int j(0);
+   for(const char *q(b); j < ncol; j++) {
+      while(q < e && (*q == ' ' || *q == '\t')) q++;
+      if(q == e) break;
+      wbeg[j] = q;
+      while(q < e && *q != ' ' && *q != '\t') q++;
+      wend[j] = q;
+   }
+
+   // check input   NB col numbers start at 1, indexes start at 0
+   if(j == 0) return;
+   if(GD.col > j) { nd++; return; }
+   if(GD.xcol > j) { nxd++; return; }
+   if(GD.wcol > j) return;
+
+   double d, x(-1.0), w(-1.0);
+   if(!ScientificWord(wbeg[GD.col-1], wend[GD.col-1], d)) { nd++; return; }
+   if(GD.xcol > -1 && !ScientificWord(wbeg[GD.xcol-1], wend[GD.xcol-1], x))
+      { nd++; return; }
+   if(GD.wcol > -1 && !ScientificWord(wbeg[GD.wcol-1], wend[GD.wcol-1], w))
+      return;
+
+   AddDatum(d, x, w);
+}
+
+//------------------------------------------------------------------------------------
+// read binary input: rows of GD.binary native doubles
+void ReadBinary(istream& is)
+{
+   GlobalData& GD=GlobalData::Instance();
+   const size_t n(GD.binary), ROWS(1<<16);
+   vector<double> buf(n*ROWS);
+   double x(-1.0), w(-1.0);
+
+   while(1) {
+      is.read(reinterpret_cast<char *>(&buf[0]), buf.size()*sizeof(double));
+      size_t nrows(is.gcount()/(n*sizeof(double)));
+      for(size_t i=0; i<nrows; i++) {
+         const double *row(&buf[i*n]);
+         if(GD.xcol > -1) x = row[GD.xcol-1];
+         if(GD.wcol > -1) w = row[GD.wcol-1];
+         AddDatum(row[GD.col-1], x, w);
+      }
+      if(!is.good()) break;
+   }
+}
+
 //------------------------------------------------------------------------------------
 int OutputStats(void)
 {
@@ -1009,7 +1361,7 @@ try {
    if(GD.xcol > -1) {
       if(GD.b2) {
          cout << "rstats(two):" << label
-            << " N " << setw(GD.width) << GD.data.size()
+            << " N " << setw(GD.width) << GD.cstats.N()
             //<< " VarX " << setprecision(GD.prec) << GD.tsstats.VarianceX()
             //<< " VarY " << setprecision(GD.prec) << GD.tsstats.VarianceY()
             << "  Int " << setprecision(GD.prec) << GD.tsstats.Intercept()
@@ -1059,7 +1411,7 @@ try {
       if(GD.dodebias) cout << " Bias " << GD.debias;
       cout << endl;
    }
-   else if(!GD.quiet) {
+   else if(!GD.quiet && !GD.doStream) {
       cout << "Conventional statistics with robust weighting: " << GD.msg << ":\n"
          << fixed << setprecision(GD.prec) << GD.robwtstats << endl;
       if(GD.dodebias) cout << " Bias    = " << GD.debias << endl;
@@ -1067,7 +1419,7 @@ try {
 
    if(GD.br) {
       cout << "rstats(rob):" << label
-         << " N " << setw(GD.width) << GD.data.size()
+         << " N " << setw(GD.width) << GD.cstats.N()
          << "  Med " << setw(GD.width) << GD.median << "  MAD " << GD.mad
          << "  Min " << setw(GD.width) << GD.cstats.Minimum()
          << "  Max " << setw(GD.width) << GD.cstats.Maximum()
@@ -1075,19 +1427,27 @@ try {
          << "  Q1 " << setw(GD.width) << GD.Q1 << "  Q3 " << setw(GD.width)<< GD.Q3
          << "  QL " << setw(GD.width) << 2.5*GD.Q1-1.5*GD.Q3
          << "  QH " << setw(GD.width) << 2.5*GD.Q3-1.5*GD.Q1;
+      if(GD.doStream)
+         cout << "  RErr " << scientific << setprecision(1) << GD.sketch.RankError()
+            << fixed << setprecision(GD.prec);
       if(GD.dodebias) cout << "  Bias " << GD.debias;
       cout << endl;
    }
    else if(!GD.quiet) {
       cout << "Robust statistics: " << GD.msg << ":\n";
-	   cout << " Number    = " << GD.data.size() << endl;
+	   cout << " Number    = " << GD.cstats.N() << endl;
 	   cout << " Quartiles = " << setw(11) << setprecision(GD.prec) << GD.Q1
                      << "(1) " << setw(11) << GD.Q3
                      << "(3) " << setw(11) << 2.5*GD.Q3-1.5*GD.Q1
                      << "(H) " << setw(11) << 2.5*GD.Q1-1.5*GD.Q3
                      << "(L)" << endl;
-	   cout << " Median = " << GD.median << "   MEstimate = " << GD.mest
-	        << "   MAD = " << GD.mad << endl;
+      if(GD.doStream)
+	      cout << " Median = " << GD.median << "   MAD = " << GD.mad
+            << "   (stream: rank error <= " << scientific << setprecision(1)
+            << GD.sketch.RankError() << fixed << setprecision(GD.prec) << ")" << endl;
+      else
+	      cout << " Median = " << GD.median << "   MEstimate = " << GD.mest
+	           << "   MAD = " << GD.mad << endl;
       if(GD.dodebias) cout << " Bias      = " << GD.debias << endl;
    }
 
@@ -1839,6 +2199,144 @@ void invDFT(const vector<double>& ampcos, const vector<double>& ampsin, const in
    }
 }
 
+// in-place complex FFT, N a power of 2; forward is exp(-i...), inverse is not
+// normalized.
+void FFT2(vector< complex<double> >& a, bool inverse)
+{
+   const double TWO_PI(8.0*::atan(1.0));
+   size_t i,j,k,len,N(a.size());
+
+   // bit reversal permutation
+   for(j=0,i=1; i<N; i++) {
+      size_t bit(N >> 1);
+      for( ; j & bit; bit >>= 1) j ^= bit;
+      j ^= bit;
+      if(i < j) swap(a[i],a[j]);
+   }
+
+   // twiddle factors, computed directly for accuracy
+   vector< complex<double> > tw(N/2);
+   for(k=0; k<N/2; k++)
+      tw[k] = polar(1.0, (inverse ? TWO_PI : -TWO_PI)*double(k)/double(N));
+
+   // butterflies
+   for(len=2; len<=N; len <<= 1) {
+      size_t half(len/2), step(N/len);
+      for(i=0; i<N; i+=len) {
+         for(j=0; j<half; j++) {
+            complex<double> t(a[i+j+half]*tw[j*step]);
+            a[i+j+half] = a[i+j] - t;
+            a[i+j] += t;
+         }
+      }
+   }
+}
+
+// in-place forward complex FFT for any N; Bluestein's algorithm, using FFT2(),
+// when N is not a power of 2.
+void FFT(vector< complex<double> >& a)
+{
+   const double PI(4.0*::atan(1.0));
+   size_t k,N(a.size()),M(1);
+   if(N < 2) return;
+   if((N & (N-1)) == 0) { FFT2(a,false); return; }
+
+   while(M < 2*N-1) M <<= 1;
+
+   // chirp w[k] = exp(-i pi k^2/N); k^2 mod 2N keeps the argument small
+   vector< complex<double> > w(N), A(M), B(M);
+   for(k=0; k<N; k++) {
+      unsigned long long kk((static_cast<unsigned long long>(k)*k) % (2*N));
+      w[k] = polar(1.0, -PI*double(kk)/double(N));
+      A[k] = a[k] * w[k];
+   }
+   B[0] = conj(w[0]);
+   for(k=1; k<N; k++)
+      B[k] = B[M-k] = conj(w[k]);
+
+   // convolve
+   FFT2(A,false);
+   FFT2(B,false);
+   for(k=0; k<M; k++) A[k] *= B[k];
+   FFT2(A,true);
+
+   for(k=0; k<N; k++)
+      a[k] = w[k] * A[k] / double(M);
+}
+
+// fast Fourier transform of real data; output and scaling as DFT()
+void RealFFT(const vector<double>& data, vector<double>& ampcos,
+   vector<double>& ampsin)
+{
+   const double TWO_PI(8.0*::atan(1.0));
+   size_t i,N(data.size());
+   double oon(1.0/double(N)),ton(2.0/double(N));
+   vector< complex<double> > X;
+   ampsin = vector<double>(1+N/2);
+   ampcos = vector<double>(1+N/2);
+
+   if(N % 2 == 0 && N > 2) {
+      // pack the real data into N/2 complex points, transform, and unpack
+      size_t H(N/2);
+      vector< complex<double> > z(H);
+      for(i=0; i<H; i++) z[i] = complex<double>(data[2*i],data[2*i+1]);
+      FFT(z);
+      X.resize(H+1);
+      for(i=0; i<=H; i++) {
+         complex<double> zk(z[i%H]), zc(conj(z[(H-i)%H]));
+         complex<double> even(0.5*(zk+zc)), odd(complex<double>(0.0,-0.5)*(zk-zc));
+         X[i] = even + polar(1.0, -TWO_PI*double(i)/double(N)) * odd;
+      }
+   }
+   else {
+      X = vector< complex<double> >(data.begin(), data.end());
+      FFT(X);
+   }
+
+   // DFT() sums data * cos and data * sin(+), for i < N/2
+   for(i=0; i<N/2; i++) {
+      ampcos[i] = X[i].real() * (i==0 ? oon : ton);
+      ampsin[i] = -X[i].imag() * ton;
+   }
+}
+
+// window function w applied to n points; return the window
+vector<double> FFTWindow(const string& w, size_t n)
+{
+   const double TWO_PI(8.0*::atan(1.0));
+   vector<double> win(n,1.0);
+   for(size_t i=0; i<n; i++) {
+      double x(TWO_PI*double(i)/double(n));
+      if(w == "hann") win[i] = 0.5 - 0.5*::cos(x);
+      else if(w == "hamming") win[i] = 0.54 - 0.46*::cos(x);
+      else if(w == "blackman") win[i] = 0.42 - 0.5*::cos(x) + 0.08*::cos(2*x);
+   }
+   return win;
+}
+
+// amplitude spectrum of data, tapered by the --window and with amplitudes
+// corrected for its coherent gain; by --dft or FFT.
+void Spectrum(const vector<double>& data, vector<double>& amp)
+{
+   GlobalData& GD=GlobalData::Instance();
+   size_t i,N(data.size());
+   vector<double> ampcos,ampsin,tapered(data);
+
+   double gain(1.0);
+   if(GD.fftwin != "rect") {
+      vector<double> win(FFTWindow(GD.fftwin,N));
+      for(gain=0.0,i=0; i<N; i++) { tapered[i] *= win[i]; gain += win[i]; }
+      gain /= double(N);
+   }
+
+   if(GD.doDFT) DFT(tapered, ampcos, ampsin);
+   else RealFFT(tapered, ampcos, ampsin);
+
+   amp = vector<double>(1+N/2);
+   for(i=0; i<amp.size(); i++)
+      amp[i] = ::sqrt(ampsin[i]*ampsin[i]+ampcos[i]*ampcos[i])/gain;
+}
+
 //------------------------------------------------------------------------------------
 int ComputeFFT(void)
 {
@@ -1890,12 +2388,45 @@ try {
 
    unsigned N(vdata.size());
 
-   // get the DFT (not fast) of real valued data
-   vector<double> ampsin(1+N/2),ampcos(1+N/2);
-   //vector<double> reform(N);
+   // Welch: average the power of segments of welchN points, overlapping by half
+   if(GD.welchN > 0 && unsigned(GD.welchN) >= N) {
+      cout << "Error - --welch " << GD.welchN << " is not less than the"
+         << " number of points " << N << endl;
+      return -1;
+   }
+   if(GD.welchN > 0) {
+      const unsigned L(GD.welchN), step(L > 1 ? L/2 : 1);
+      unsigned nseg(0);
+      vector<double> seg(L), amp, power(1+L/2,0.0);
+      for(unsigned beg=0; beg+L<=N; beg+=step, nseg++) {
+         copy(vdata.begin()+beg, vdata.begin()+beg+L, seg.begin());
+         Spectrum(seg, amp);
+         for(i=0; i<amp.size(); i++) power[i] += amp[i]*amp[i];
+      }
+
+      double ftot(0.0);
+      cout << "#FFT Welch average of " << nseg << " segments of N=" << L
+         << " overlapping " << step << ", window " << GD.fftwin
+         << fixed << setprecision(GD.prec) << ", dx is " << GD.dtfft
+         << " Nyquist = 1/2dx = " << 1.0/(2*GD.dtfft)
+         << ", freq at i is i * " << scientific << 1.0/(L*GD.dtfft) << endl;
+      cout << "#FFT i freq |ampfft| wl " << endl;
+      for(i=0; i<power.size(); i++) {
+         power[i] /= double(nseg);
+         cout << "FFT " << fixed << setprecision(GD.prec) << i
+            << " " << i/(L*GD.dtfft) << " " << ::sqrt(power[i])
+            << " " << (i==0 ? 0 : (L*GD.dtfft)/i) << endl;
+         ftot += power[i];
+      }
+      cout << "#FFT Total power sum(fft^2) = " << scientific
+         << setprecision(GD.prec) << ftot << " " << GD.label << endl;
+
+      return 0;
+   }
 
-   DFT(vdata, ampcos, ampsin);             // data is unchanged
-   //invDFT(ampcos, ampsin, N, reform);     // amps unchanged
+   // get the spectrum of real valued data
+   vector<double> vamp;
+   Spectrum(vdata, vamp);                  // data is unchanged
 
    // output
    double amp, dtot(0.0), ftot(0.0), fact(2.0/N);
@@ -1905,7 +2436,7 @@ try {
       << ", WL at i is N*dx/i = " << N*GD.dtfft << " / i " << endl;
    cout << "#FFT i xd(i*dx) data freq |ampfft| xdata wl " << endl;
    for(i=0; i<N; i++) {
-      amp = (i < 1+N/2 ? ::sqrt(ampsin[i]*ampsin[i]+ampcos[i]*ampcos[i]) : 0.0);
+      amp = (i < 1+N/2 ? vamp[i] : 0.0);
       cout << "FFT " << fixed << setprecision(GD.prec) << i
          << " " << double(i)*GD.dtfft << " " << vdata[i]
          << " " << i/(N*GD.dtfft) << " " << amp
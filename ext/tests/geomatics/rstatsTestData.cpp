@@ -0,0 +1,138 @@
+//==============================================================================
+//
+//  This file is part of GNSSTk, the ARL:UT GNSS Toolkit.
+//
+//  The GNSSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GNSSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GNSSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin.
+//  Copyright 2004-2022, The Board of Regents of The University of Texas System
+//
+//==============================================================================
+
+//==============================================================================
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin, under contract to an agency or agencies
+//  within the U.S. Department of Defense. The U.S. Government retains all
+//  rights to use, duplicate, distribute, disclose, or release this software.
+//
+//  Pursuant to DoD Directive 523024
+//
+//  DISTRIBUTION STATEMENT A: This software has been approved for public
+//                            release, distribution is unlimited.
+//
+//==============================================================================
+
+/**
+ * @file rstatsTestData.cpp
+ * Write input for the rstats tests, as text and as the same data in binary
+ * (--binary n), so the two readers can be compared.
+ *   rstatsTestData <text> <n> <binary>
+ *      convert the first n columns of each data line of a text file to binary,
+ *      skipping the lines rstats skips (comments, too few or non-numeric words)
+ *   rstatsTestData --gen <nlines> <text> <binary>
+ *      generate nlines of 3 columns (x, data, weight) as text, with comment and
+ *      blank lines and CR-LF endings mixed in, and the same data as binary; make
+ *      nlines large for text that spans several of the blocks rstats reads.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// append the numeric value of each of the first n words of line to row; return
+// false if there are fewer than n, or one is not a number
+static bool ParseRow(const string& line, size_t n, vector<double>& row)
+{
+   istringstream iss(line);
+   string word;
+   row.clear();
+   while(row.size() < n && iss >> word) {
+      char *end;
+      double v(strtod(word.c_str(), &end));
+      if(end == word.c_str() || *end != '\0') return false;
+      row.push_back(v);
+   }
+   return row.size() == n;
+}
+
+static void WriteRow(ofstream& bin, const vector<double>& row)
+{
+   bin.write(reinterpret_cast<const char *>(&row[0]), row.size()*sizeof(double));
+}
+
+int main(int argc, char **argv)
+{
+   if(argc == 4) {
+      ifstream text(argv[1]);
+      int n(atoi(argv[2]));
+      ofstream bin(argv[3], ios::out | ios::binary);
+      if(!text || n < 1 || !bin) {
+         cerr << "Error - cannot convert " << argv[1] << " to " << argv[3] << endl;
+         return 1;
+      }
+      string line;
+      vector<double> row;
+      while(getline(text, line)) {
+         while(!line.empty() && line[line.size()-1] == '\r')
+            line.erase(line.size()-1);
+         if(line.find_first_not_of(" \t") != string::npos
+               && line[line.find_first_not_of(" \t")] == '#') continue;
+         if(ParseRow(line, n, row)) WriteRow(bin, row);
+      }
+      return 0;
+   }
+
+   if(argc == 5 && string(argv[1]) == "--gen") {
+      long nlines(atol(argv[2]));
+      ofstream text(argv[3], ios::out | ios::binary);
+      ofstream bin(argv[4], ios::out | ios::binary);
+      if(nlines < 1 || !text || !bin) {
+         cerr << "Error - cannot generate " << argv[3] << endl;
+         return 1;
+      }
+      // a deterministic LCG, so the data is the same on every platform
+      unsigned long long seed(20221017ULL);
+      auto uniform = [&seed]() -> double {
+         seed = seed*6364136223846793005ULL + 1442695040888963407ULL;
+         return double(seed >> 11) / 9007199254740992.0;
+      };
+      vector<double> row(3);
+      text << "# rstats test data: x, data, weight" << "\n";
+      for(long i=0; i<nlines; i++) {
+         if(i % 1000 == 999) text << "# comment " << i << "\n\n";
+         row[0] = i * 0.5;
+         row[1] = 10.0*(uniform() + uniform() + uniform() - 1.5)
+                + (i % 5000 == 0 ? 1000.0 : 0.0);         // outliers
+         row[2] = 0.5 + uniform();
+         // full precision, so text and binary hold the same values
+         text << setprecision(17) << row[0] << " " << row[1] << "\t" << row[2]
+              << (i % 7 == 0 ? "\r\n" : "\n");
+         WriteRow(bin, row);
+      }
+      return 0;
+   }
+
+   cerr << "Usage: rstatsTestData <text> <n> <binary>\n"
+        << "       rstatsTestData --gen <nlines> <text> <binary>" << endl;
+   return 1;
+}
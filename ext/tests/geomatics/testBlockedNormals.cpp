@@ -0,0 +1,173 @@
+//==============================================================================
+//
+//  This file is part of GNSSTk, the ARL:UT GNSS Toolkit.
+//
+//  The GNSSTk is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation; either version 3.0 of the License, or
+//  any later version.
+//
+//  The GNSSTk is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with GNSSTk; if not, write to the Free Software Foundation,
+//  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin.
+//  Copyright 2004-2022, The Board of Regents of The University of Texas System
+//
+//==============================================================================
+
+//==============================================================================
+//
+//  This software was developed by Applied Research Laboratories at the
+//  University of Texas at Austin, under contract to an agency or agencies
+//  within the U.S. Department of Defense. The U.S. Government retains all
+//  rights to use, duplicate, distribute, disclose, or release this software.
+//
+//  Pursuant to DoD Directive 523024
+//
+//  DISTRIBUTION STATEMENT A: This software has been approved for public
+//                            release, distribution is unlimited.
+//
+//==============================================================================
+
+/**
+ * @file testBlockedNormals.cpp
+ * Solve a small synthetic problem, with biases that are each observed over an
+ * interval, with the blocked normal equations used by DDBase --Blocked, and again
+ * with the square root information filter over the whole state, as DDBase does
+ * without --Blocked; compare the solutions and variances.
+ */
+
+//------------------------------------------------------------------------------------
+// system includes
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+
+// GNSSTk
+#include <gnsstk/Exception.hpp>
+#include <gnsstk/Vector.hpp>
+#include <gnsstk/Matrix.hpp>
+#include <gnsstk/Namelist.hpp>
+#include <gnsstk/SRIFilter.hpp>
+
+// DDBase
+#include "BlockedNormals.hpp"
+
+//------------------------------------------------------------------------------------
+using namespace std;
+using namespace gnsstk;
+
+//------------------------------------------------------------------------------------
+// deterministic uniform deviate in [-1,1), so the test is the same everywhere
+static unsigned long Seed(12345);
+static double Random(void)
+{
+   Seed = (1103515245UL * Seed + 12345UL) % 2147483648UL;
+   return 2.0*double(Seed)/2147483648.0 - 1.0;
+}
+
+//------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+try {
+   const int NG(4);                       // non-bias states
+   const int NB(8);                       // biases; the last is never observed
+   const int NE(30);                      // epochs
+   const int NS(NG+NB);
+   const double BiasVar(100.0);
+   const double Tol(1.e-9);
+   int i,j,k,m,e,nbad(0);
+
+      // bias k is observed from epoch Beg[k] through epoch End[k]
+   const int Beg[NB] = {  0,  0,  3, 10, 12, 18, 25, NE };
+   const int End[NB] = {  9, 29, 15, 20, 29, 26, 40, -1 };
+
+   BlockedNormals Normals;
+   Normals.reset(NS,NG);
+   Normals.setBiasVariance(BiasVar);
+
+   SRIFilter srif(Namelist(NS));
+
+      // a priori: information on the non-bias states, variance on the biases
+   Matrix<double> apInfo(NG,NG,0.0),apCov(NS,NS,0.0);
+   for(i=0; i<NG; i++) apInfo(i,i) = 0.01;
+   apInfo(0,1) = apInfo(1,0) = 0.002;
+   Matrix<double> apGCov(inverse(apInfo));
+   for(i=0; i<NG; i++) for(j=0; j<NG; j++) apCov(i,j) = apGCov(i,j);
+   for(k=0; k<NB; k++) apCov(NG+k,NG+k) = BiasVar;
+   Normals.addInformation(apInfo);
+   srif.addAPriori(apCov,Vector<double>(NS,0.0));
+
+   for(e=0; e<NE; e++) {
+      vector<int> bias,sign;
+      for(k=0; k<NB; k++) {
+         if(e < Beg[k] || e > End[k]) continue;
+         bias.push_back(NG+k);
+         sign.push_back(Random() < 0.0 ? -1 : 1);
+      }
+      int nd(bias.size());
+
+      Matrix<double> P(nd,NG),L(nd,nd),C;
+      Vector<double> f(nd);
+      for(m=0; m<nd; m++) {
+         for(i=0; i<NG; i++) P(m,i) = Random();
+         for(i=0; i<nd; i++) L(m,i) = 0.3*Random();
+         f(m) = Random();
+      }
+      C = L*transpose(L);                 // measurement covariance, positive definite
+      for(m=0; m<nd; m++) C(m,m) += 1.0;
+
+         // blocked
+      Normals.update(P,f,inverse(C),bias,sign);
+      for(k=0; k<NB; k++) if(End[k] == e && !Normals.eliminate(NG+k)) {
+         cout << "Blocked problem is singular at epoch " << e << endl;
+         return -1;
+      }
+
+         // dense
+      Matrix<double> PP(nd,NS,0.0);
+      for(m=0; m<nd; m++) {
+         for(i=0; i<NG; i++) PP(m,i) = P(m,i);
+         PP(m,bias[m]) = sign[m];
+      }
+      Vector<double> ff(f);
+      srif.measurementUpdate(PP,ff,C);
+   }
+
+   Vector<double> dX,Var,X;
+   Matrix<double> Cov,XCov;
+   Normals.solve(NS,dX,Var,Cov);
+   srif.getStateAndCovariance(X,XCov);
+
+   cout << "state   blocked solution      dense solution   blocked sigma"
+        << "     dense sigma\n" << scientific << setprecision(6);
+   for(i=0; i<NS; i++) {
+      bool bad(fabs(dX(i)-X(i)) > Tol*(1.0+fabs(X(i)))
+               || fabs(Var(i)-XCov(i,i)) > Tol*(1.0+XCov(i,i)));
+      if(bad) nbad++;
+      cout << setw(5) << i << setw(19) << dX(i) << setw(19) << X(i)
+           << setw(16) << sqrt(Var(i)) << setw(16) << sqrt(XCov(i,i))
+           << (bad ? " Failure" : "") << endl;
+   }
+   for(i=0; i<NG; i++) for(j=0; j<NG; j++)
+      if(fabs(Cov(i,j)-XCov(i,j)) > Tol*(1.0+fabs(XCov(i,j)))) {
+         cout << "Covariance (" << i << "," << j << ") differs: " << Cov(i,j)
+              << " " << XCov(i,j) << " Failure" << endl;
+         nbad++;
+      }
+
+   return (nbad ? 1 : 0);
+}
+catch(Exception& e) { cerr << e; }
+catch(std::exception& e) { cerr << "std exception: " << e.what() << endl; }
+catch(...) { cerr << "Unknown exception" << endl; }
+   return -1;
+}